@@ -5,12 +5,14 @@
 #ifndef IMSERVER_CONVERSATIONINFO_H
 #define IMSERVER_CONVERSATIONINFO_H
 
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <regex>
 #include <json/json.h>
 #include <jdbc/cppconn/resultset.h>
 
+#include "const.h"
 #include "common/utils/ConversationConvert.h"
 
 enum class ConvType : int8_t {
@@ -22,8 +24,9 @@ struct ConversationInfo {
     mutable int uid = -1;           // 发起申请人
     int friendId = -1;      // 好友 ID
     int unreadCount = -1;   // 未读消息计数
-    int lastMsgId = -1;     // 最新消息 ID
-    int lastReadMsgId = -1; // 最新已读消息 ID
+    int64_t lastMsgId = -1;     // 最新消息的服务端 ID
+    int64_t lastReadMsgId = -1; // 最新已读消息的服务端 ID
+    int ownerUid = -1;      // 群主 ID，仅群聊
     int8_t convType = -1;   // 会话类型 1-私聊；2-群聊
     int8_t status = -1;     // 状态 0-正常；1-已解散
     int8_t isTop = -1;      // 置顶
@@ -32,6 +35,7 @@ struct ConversationInfo {
     std::optional<std::string> lastMsgContent; // 最新消息摘要，最大 15 个字符
     std::optional<std::string> lastTime; // 最新消息时间
     std::optional<std::string> title;
+    std::optional<std::string> avatarUrl; // 单聊对方头像，会话列表中与 title 一同下发
     std::optional<std::string> createTime;
     std::optional<std::string> updateTime;
 
@@ -74,10 +78,10 @@ inline void ConversationInfo::fromJson(Json::Value &value) {
         lastMsgContent = value["last_msg_content"].asString();
     }
     if (value.isMember("last_msg_id")) {
-        lastMsgId = value["last_msg_id"].asInt();
+        lastMsgId = value["last_msg_id"].asInt64();
     }
     if (value.isMember("last_read_msg_id")) {
-        lastReadMsgId = value["last_read_msg_id"].asInt();
+        lastReadMsgId = value["last_read_msg_id"].asInt64();
     }
     if (value.isMember("last_time")) {
         lastTime = value["last_time"].asString();
@@ -100,9 +104,18 @@ inline void ConversationInfo::fromJson(Json::Value &value) {
     if (value.isMember("createTime")) {
         createTime = value["createTime"].asString();
     }
+    else if (value.isMember("create_time")) {
+        createTime = value["create_time"].asString();
+    }
     if (value.isMember("title")) {
         title = value["title"].asString();
     }
+    if (value.isMember("avatar_url")) {
+        avatarUrl = value["avatar_url"].asString();
+    }
+    if (value.isMember("owner_uid")) {
+        ownerUid = std::stoi(value["owner_uid"].asString());
+    }
 }
 
 inline void ConversationInfo::toJson(Json::Value &value) const {
@@ -128,10 +141,10 @@ inline void ConversationInfo::toJson(Json::Value &value) const {
         value["conv_type"] = convType;
     }
     if (lastMsgId >= 0) {
-        value["last_msg_id"] = lastMsgId;
+        value["last_msg_id"] = static_cast<Json::Int64>(lastMsgId);
     }
     if (lastReadMsgId >= 0) {
-        value["last_read_msg_id"] = lastReadMsgId;
+        value["last_read_msg_id"] = static_cast<Json::Int64>(lastReadMsgId);
     }
     if (lastMsgContent.has_value()) {
         value["last_msg_content"] = lastMsgContent.value();
@@ -148,13 +161,19 @@ inline void ConversationInfo::toJson(Json::Value &value) const {
     if (title.has_value()) {
         value["title"] = title.value();
     }
+    if (avatarUrl.has_value()) {
+        value["avatar_url"] = avatarUrl.value();
+    }
+    if (ownerUid >= 0) {
+        value["owner_uid"] = std::to_string(ownerUid);
+    }
 }
 
 inline ConversationInfo ConversationInfo::fromConversationListSearch(const std::shared_ptr<sql::ResultSet> &result) {
     ConversationInfo info;
     info.convId = result->getString("conv_id");
     info.convType = static_cast<int8_t>(result->getUInt("conv_type"));
-    info.lastMsgId = result->getInt("last_msg_id");
+    info.lastMsgId = result->getInt64("last_msg_id");
     info.lastMsgContent = result->getString("last_msg_content");
     info.lastTime = result->getString("last_time");
     info.updateTime = result->getString("update_time");
@@ -162,6 +181,9 @@ inline ConversationInfo ConversationInfo::fromConversationListSearch(const std::
     info.unreadCount = result->getInt("unread_count");
     info.isTop = static_cast<int8_t>(result->getUInt("is_top"));
     info.isMute = static_cast<int8_t>(result->getUInt("is_mute"));
+    if (const std::string title = result->getString("title"); !title.empty()) {
+        info.title = title;
+    }
     return info;
 }
 
@@ -179,7 +201,8 @@ inline void ConversationInfo::generateConvId() {
             break;
         }
         case ConvType::GROUP_CHAT: {
-            convId = std::string("group_") + std::to_string(uid);
+            // 同一用户可以创建多个群，附加创建时间区分
+            convId = std::string("group_") + std::to_string(uid) + "_" + std::to_string(get_current_ms());
             break;
         }
         default: {
@@ -5,6 +5,9 @@
 #ifndef IMSERVER_MESSAGEINFO_H
 #define IMSERVER_MESSAGEINFO_H
 
+#include <limits>
+#include <map>
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <json/json.h>
@@ -25,7 +28,7 @@ enum class MessageStatus : uint8_t {
 };
 
 struct MessageInfo {
-    int servId = -1;        // 服务端消息 ID
+    int64_t servId = -1;    // 服务端消息 ID，由 MessageIdGenerator 在收到消息时分配
     int fromUid = -1;
     int toUid = -1;
     int msgId = -1;
@@ -41,11 +44,16 @@ struct MessageInfo {
 
     void fromJson(Json::Value& value);
     void toJson(Json::Value& value) const;
+    /// 会话列表中显示的最新消息摘要
+    [[nodiscard]] std::string summary() const;
 
     static MessageInfo fromMessageListSearch(const std::shared_ptr<sql::ResultSet>& result);
 };
 
 inline void MessageInfo::fromJson(Json::Value &value) {
+    if (value.isMember("server_id") && !value["server_id"].isNull()) {
+        servId = value["server_id"].asInt64();
+    }
     if (value.isMember("from_uid") && !value["from_uid"].isNull()) {
         fromUid = std::stoi(value["from_uid"].asString());
     }
@@ -72,9 +80,18 @@ inline void MessageInfo::fromJson(Json::Value &value) {
     }
 }
 
+inline std::string MessageInfo::summary() const {
+    switch (type) {
+        case 2: return "[图片]";
+        case 3: return "[文件]";
+        case 4: return "[视频]";
+        default: return content.value_or("").substr(0, 100);
+    }
+}
+
 inline void MessageInfo::toJson(Json::Value &value) const {
     if (servId >= 0) {
-        value["server_id"] = servId;
+        value["server_id"] = static_cast<Json::Int64>(servId);
     }
     if (fromUid >= 0) {
         value["from_uid"] = std::to_string(fromUid);
@@ -104,7 +121,8 @@ inline void MessageInfo::toJson(Json::Value &value) const {
 
 inline MessageInfo MessageInfo::fromMessageListSearch(const std::shared_ptr<sql::ResultSet> &result) {
     MessageInfo info;
-    info.msgId = result->getInt("id");
+    info.servId = result->getInt64("id");
+    info.msgId = result->getInt("msg_id");
     info.convId = result->getString("conv_id");
     info.fromUid = result->getInt("sender_uid");
     info.toUid = getOtherUid(info.convId.value(), info.fromUid);
@@ -118,7 +136,7 @@ inline MessageInfo MessageInfo::fromMessageListSearch(const std::shared_ptr<sql:
 struct MessageStatusInfo {
     int uid = -1;
     int count = -1;
-    int lastMsgId = -1;
+    int64_t lastMsgId = -1;     // 服务端消息 ID
     int8_t status = -1;
     int8_t pad[3] = {0};
     std::optional<std::string> convId;
@@ -131,7 +149,7 @@ inline void MessageStatusInfo::fromJson(Json::Value &value) {
         count = value["count"].asInt();
     }
     if (value.isMember("last_msg_id") && !value["last_msg_id"].isNull()) {
-        lastMsgId= value["last_msg_id"].asInt();
+        lastMsgId = value["last_msg_id"].asInt64();
     }
     if (value.isMember("status") && !value["status"].isNull()) {
         status = static_cast<int8_t>(value["status"].asInt());
@@ -144,4 +162,43 @@ inline void MessageStatusInfo::fromJson(Json::Value &value) {
     }
 }
 
+/**
+ * @brief 合并后的消息状态水位：同一 (uid, 会话, 状态) 只保留最大消息 ID，批量刷写。
+ */
+struct MessageStatusWatermark {
+    int uid = -1;
+    int64_t lastMsgId = -1;     // 本次刷写的水位
+    int64_t flushedMsgId = 0;   // 上次已刷写的水位，作为更新消息状态的下界
+    // 已计入未读增量的最大消息 ID，重算未读数的上界，之后的消息由增量累加
+    int64_t countedMsgId = std::numeric_limits<int64_t>::max();
+    int8_t status = -1;
+    std::string convId;
+};
+
+/**
+ * @brief 会话在一段时间内落库的消息计数，成员的未读增量 = total - 自己发送的条数。
+ */
+struct ConvUnreadDelta {
+    std::string convId;
+    int total = 0;
+    int64_t maxMsgId = 0;       // 已计入的最大消息 ID，对账时作为上界
+    int64_t minMsgId = std::numeric_limits<int64_t>::max();  // 最小消息 ID，写回前已读水位重算的上界
+    std::map<int, int> sent;    // 发送方 uid -> 条数
+
+    [[nodiscard]] int unreadFor(const int uid) const {
+        const auto it = sent.find(uid);
+        return total - (it == sent.end() ? 0 : it->second);
+    }
+};
+
+/**
+ * @brief 对账时修正的未读数。
+ */
+struct UnreadCountFix {
+    int uid = -1;
+    std::string convId;
+    int unreadCount = 0;        // 按消息表重新计算的值
+    int drift = 0;              // 修正前的值 - 修正后的值
+};
+
 #endif //IMSERVER_MESSAGEINFO_H
@@ -22,4 +22,8 @@ inline int getOtherUid(const std::string &convId, const int uid) {
     return (u1 == uid) ? u2 : u1;
 }
 
+inline bool isGroupConvId(const std::string &convId) {
+    return convId.compare(0, 6, "group_") == 0;
+}
+
 #endif //IMSERVER_CONVERSATIONCONVERT_H
\ No newline at end of file
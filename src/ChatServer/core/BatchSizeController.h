@@ -0,0 +1,122 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_BATCHSIZECONTROLLER_H
+#define IMSERVER_BATCHSIZECONTROLLER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief 消息批量写入的 AIMD 批次大小控制器。
+ *
+ * 每次批量提交后由写入线程调用 onCommit 反馈本批条数、提交耗时和死锁重试次数：
+ *   - 加性增：耗时不超过目标 (BatchTargetLatencyMs) 且本批用满了当前批次时，批次 +batchStep；
+ *     本批至少有一个满块时分块 +chunkStep。负载低、批次由刷写间隔触发时不增长；
+ *   - 乘性减：出现死锁重试，或耗时超过目标的 SPIKE_FACTOR 倍时，批次和分块减半。
+ *     按旧的较大批次切分、减半后才提交的批次不再重复减半；
+ *   - 介于目标和尖刺之间保持不变。
+ * 批次和分块都限制在配置的 [min, max] 内，min == max 时大小固定，等同关闭自适应。
+ *
+ * batchSize / chunkSize 是原子量，IO 线程判断按量刷写和写入线程切分批次时无锁读取。
+ */
+class BatchSizeController {
+public:
+    static constexpr double SPIKE_FACTOR = 2.0;
+
+    struct Bounds {
+        size_t minBatch = 1;
+        size_t maxBatch = 1;
+        size_t initBatch = 1;
+        size_t batchStep = 1;
+        size_t minChunk = 1;
+        size_t maxChunk = 1;
+        size_t initChunk = 1;
+        size_t chunkStep = 1;
+        std::chrono::microseconds targetLatency{0};
+    };
+
+    struct Stats {
+        size_t batchSize = 0;
+        size_t chunkSize = 0;
+        uint64_t increases = 0;
+        uint64_t decreases = 0;
+        uint64_t deadlocks = 0;
+    };
+
+    explicit BatchSizeController(const Bounds& bounds)
+        : bounds_(normalize(bounds))
+        , batch_size_(bounds_.initBatch)
+        , chunk_size_(bounds_.initChunk) {
+    }
+
+    [[nodiscard]] size_t batchSize() const { return batch_size_.load(std::memory_order_relaxed); }
+    [[nodiscard]] size_t chunkSize() const { return chunk_size_.load(std::memory_order_relaxed); }
+
+    void onCommit(const size_t batch, const std::chrono::microseconds latency, const int deadlocks) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deadlocks_ += deadlocks;
+        const size_t curBatch = batch_size_.load(std::memory_order_relaxed);
+        const size_t curChunk = chunk_size_.load(std::memory_order_relaxed);
+
+        if (deadlocks > 0 || latency.count() > bounds_.targetLatency.count() * SPIKE_FACTOR) {
+            if (batch > curBatch) {
+                return;
+            }
+            batch_size_.store(std::max(bounds_.minBatch, curBatch / 2), std::memory_order_relaxed);
+            chunk_size_.store(std::max(bounds_.minChunk, curChunk / 2), std::memory_order_relaxed);
+            decreases_++;
+            return;
+        }
+        if (latency > bounds_.targetLatency) {
+            return;
+        }
+        bool grew = false;
+        if (batch >= curBatch && curBatch < bounds_.maxBatch) {
+            batch_size_.store(std::min(bounds_.maxBatch, curBatch + bounds_.batchStep), std::memory_order_relaxed);
+            grew = true;
+        }
+        if (batch >= curChunk && curChunk < bounds_.maxChunk) {
+            chunk_size_.store(std::min(bounds_.maxChunk, curChunk + bounds_.chunkStep), std::memory_order_relaxed);
+            grew = true;
+        }
+        if (grew) {
+            increases_++;
+        }
+    }
+
+    [[nodiscard]] Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {batchSize(), chunkSize(), increases_, decreases_, deadlocks_};
+    }
+
+private:
+    static Bounds normalize(Bounds b) {
+        b.minBatch = std::max<size_t>(1, b.minBatch);
+        b.maxBatch = std::max(b.minBatch, b.maxBatch);
+        b.initBatch = std::clamp(b.initBatch, b.minBatch, b.maxBatch);
+        b.batchStep = std::max<size_t>(1, b.batchStep);
+        b.minChunk = std::max<size_t>(1, b.minChunk);
+        b.maxChunk = std::max(b.minChunk, b.maxChunk);
+        b.initChunk = std::clamp(b.initChunk, b.minChunk, b.maxChunk);
+        b.chunkStep = std::max<size_t>(1, b.chunkStep);
+        return b;
+    }
+
+    const Bounds bounds_;
+    std::atomic<size_t> batch_size_;
+    std::atomic<size_t> chunk_size_;
+
+    mutable std::mutex mutex_;
+    uint64_t increases_ = 0;
+    uint64_t decreases_ = 0;
+    uint64_t deadlocks_ = 0;
+};
+
+
+#endif //IMSERVER_BATCHSIZECONTROLLER_H
@@ -8,11 +8,34 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <iterator>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 #include "net/Session.h"
 #include "db/mysql/MysqlMgr.h"
 #include "const.h"
+#include "ConfigMgr.h"
+
+namespace {
+constexpr size_t DEFAULT_BATCH_FLUSH_SIZE = 256;
+constexpr int DEFAULT_BATCH_FLUSH_INTERVAL_MS = 50;
+constexpr size_t DEFAULT_BATCH_MIN_SIZE = 32;
+constexpr size_t DEFAULT_BATCH_MAX_SIZE = 2048;
+constexpr size_t DEFAULT_BATCH_CHUNK_SIZE = 50;
+constexpr size_t DEFAULT_BATCH_CHUNK_MIN = 10;
+constexpr size_t DEFAULT_BATCH_CHUNK_MAX = 500;
+constexpr int DEFAULT_BATCH_TARGET_LATENCY_MS = 20;
+constexpr size_t BATCH_SIZE_STEP = 16;
+constexpr size_t BATCH_CHUNK_STEP = 5;
+constexpr size_t DEFAULT_BATCH_MEMORY_SOFT_MB = 64;
+constexpr size_t DEFAULT_BATCH_MEMORY_HARD_MB = 128;
+constexpr int DEFAULT_BATCH_BUSY_RETRY_AFTER_MS = 500;
+constexpr const char* DEFAULT_WAL_DIR = "wal";
+constexpr int DEFAULT_WAL_GROUP_COMMIT_US = 1000;
+constexpr size_t DEFAULT_WAL_SEGMENT_MB = 64;
+}
 
 // ──────────────────────────────────────────────────────────────
 // Construction / Lifecycle
@@ -20,12 +43,98 @@
 
 BatchWriter::BatchWriter(size_t num_shards, size_t num_writers)
     : buffers_(num_shards)
+    , queued_(std::make_unique<std::atomic<bool>[]>(num_shards))
+    , flush_interval_(DEFAULT_BATCH_FLUSH_INTERVAL_MS)
     , num_writers_(num_writers)
     , last_metric_time_(std::chrono::steady_clock::now())
 {
     for (auto& b : buffers_) {
         b = std::make_unique<FlushBuffer>();
     }
+    for (size_t i = 0; i < num_shards; i++) {
+        queued_[i].store(false, std::memory_order_relaxed);
+    }
+    num_writers_ = std::clamp<size_t>(num_writers_, 1, num_shards);
+    for (size_t i = 0; i < num_writers_; i++) {
+        task_queues_.push_back(std::make_unique<TaskQueue>());
+    }
+
+    auto& config = ConfigMgr::getInstance();
+    const auto readSize = [&config](const std::string& key, const size_t fallback) -> size_t {
+        const auto& value = config["ChatServer"][key];
+        return value.empty() ? fallback : std::max<size_t>(1, std::stoul(value));
+    };
+    BatchSizeController::Bounds bounds;
+    bounds.initBatch = readSize("BatchFlushSize", DEFAULT_BATCH_FLUSH_SIZE);
+    bounds.initChunk = DEFAULT_BATCH_CHUNK_SIZE;
+    bounds.batchStep = BATCH_SIZE_STEP;
+    bounds.chunkStep = BATCH_CHUNK_STEP;
+    if (config["ChatServer"]["BatchAdaptive"] == "true") {
+        bounds.minBatch = readSize("BatchMinSize", DEFAULT_BATCH_MIN_SIZE);
+        bounds.maxBatch = readSize("BatchMaxSize", DEFAULT_BATCH_MAX_SIZE);
+        bounds.minChunk = readSize("BatchChunkMin", DEFAULT_BATCH_CHUNK_MIN);
+        bounds.maxChunk = readSize("BatchChunkMax", DEFAULT_BATCH_CHUNK_MAX);
+        bounds.targetLatency = std::chrono::milliseconds(
+            readSize("BatchTargetLatencyMs", DEFAULT_BATCH_TARGET_LATENCY_MS));
+    }
+    else {
+        // 上下限相同，大小固定
+        bounds.minBatch = bounds.maxBatch = bounds.initBatch;
+        bounds.minChunk = bounds.maxChunk = bounds.initChunk;
+    }
+    sizer_ = std::make_unique<BatchSizeController>(bounds);
+    if (!config["ChatServer"]["BatchFlushIntervalMs"].empty()) {
+        flush_interval_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["BatchFlushIntervalMs"]));
+    }
+    notify_persisted_ = config["ChatServer"]["NotifyPersisted"] == "true";
+
+    // 硬上限配置为 0 时不限制
+    const auto readMb = [&config](const std::string& key, const size_t fallback) -> size_t {
+        const auto& value = config["ChatServer"][key];
+        return value.empty() ? fallback : std::stoul(value);
+    };
+    memory_ = std::make_unique<MemoryBudget>(readMb("BatchMemorySoftMB", DEFAULT_BATCH_MEMORY_SOFT_MB) << 20,
+        readMb("BatchMemoryHardMB", DEFAULT_BATCH_MEMORY_HARD_MB) << 20);
+    busy_retry_after_ms_ = DEFAULT_BATCH_BUSY_RETRY_AFTER_MS;
+    if (!config["ChatServer"]["BatchBusyRetryAfterMs"].empty()) {
+        busy_retry_after_ms_ = std::stoi(config["ChatServer"]["BatchBusyRetryAfterMs"]);
+    }
+
+    DeadLetterQueue::Options dlqOptions;
+    if (!config["ChatServer"]["DlqDir"].empty()) {
+        dlqOptions.dir = config["ChatServer"]["DlqDir"];
+    }
+    dlqOptions.memoryBytes = readSize("DlqMemoryMB", dlqOptions.memoryBytes >> 20) << 20;
+    dlqOptions.retryBase = std::chrono::milliseconds(readSize("DlqRetryBaseMs", dlqOptions.retryBase.count()));
+    dlqOptions.retryMax = std::chrono::milliseconds(readSize("DlqRetryMaxMs", dlqOptions.retryMax.count()));
+    dlqOptions.maxAttempts = static_cast<int>(readSize("DlqMaxAttempts", dlqOptions.maxAttempts));
+    // 溢出消息按正常批次大小读回
+    dlqOptions.reloadBatchSize = bounds.initBatch;
+    dlq_ = std::make_unique<DeadLetterQueue>(dlqOptions,
+        [this](DeadLetterQueue::Batch& batch) {
+            if (!writeBatch(batch)) {
+                return false;
+            }
+            releaseMemory(batch);
+            return true;
+        },
+        [this](const std::shared_ptr<ChatMsgNode>& node) { handlePoison(node); });
+
+    if (config["ChatServer"]["WalEnabled"] == "true") {
+        std::string dir = DEFAULT_WAL_DIR;
+        int groupCommitUs = DEFAULT_WAL_GROUP_COMMIT_US;
+        size_t segmentMb = DEFAULT_WAL_SEGMENT_MB;
+        if (!config["ChatServer"]["WalDir"].empty()) {
+            dir = config["ChatServer"]["WalDir"];
+        }
+        if (!config["ChatServer"]["WalGroupCommitUs"].empty()) {
+            groupCommitUs = std::stoi(config["ChatServer"]["WalGroupCommitUs"]);
+        }
+        if (!config["ChatServer"]["WalSegmentMB"].empty()) {
+            segmentMb = std::max<size_t>(1, std::stoul(config["ChatServer"]["WalSegmentMB"]));
+        }
+        wal_ = std::make_unique<MessageWal>(dir, std::chrono::microseconds(groupCommitUs), segmentMb << 20);
+    }
 }
 
 BatchWriter::~BatchWriter() {
@@ -33,20 +142,160 @@ BatchWriter::~BatchWriter() {
 }
 
 void BatchWriter::start() {
-    running_ = true;
+    if (running_.exchange(true)) {
+        return;
+    }
+    if (!dlq_->start()) {
+        std::cout << "[BatchWriter] open DLQ dir failed, failed batches stay in memory only" << std::endl;
+    }
+    if (wal_) {
+        std::vector<MessageWal::Record> records;
+        if (wal_->open(records)) {
+            replayWal(records);
+            wal_->start();
+        }
+        else {
+            std::cout << "[BatchWriter] open WAL failed, running without WAL" << std::endl;
+            wal_.reset();
+        }
+    }
     // 启动写入线程
     for (size_t i = 0; i < num_writers_; i++) {
-        writers_.emplace_back([this] { writerLoop(); });
+        writers_.emplace_back([this, i] { writerLoop(i); });
     }
     timer_thread_ = std::thread([this] { timerLoop(); });
 }
 
 void BatchWriter::stop() {
-    running_ = false;
+    if (!running_.exchange(false)) {
+        return;
+    }
+    // 先让 WAL 中已追加的消息落盘并推入缓冲区，随后一并刷写
+    if (wal_) {
+        wal_->stop();
+    }
+    {
+        // 持锁通知，避免等待线程检查完 running_ 后才进入等待而错过唤醒
+        std::lock_guard lk(deadline_mtx_);
+        deadline_cv_.notify_all();
+    }
+    for (auto& queue : task_queues_) {
+        std::lock_guard lk(queue->mtx);
+        queue->cv.notify_all();
+    }
     if (timer_thread_.joinable()) timer_thread_.join();
     for (auto& w : writers_) {
         if (w.joinable()) w.join();
     }
+    writers_.clear();
+
+    // 刷写剩余消息
+    for (size_t i = 0; i < buffers_.size(); i++) {
+        if (buffers_[i]->hasData()) {
+            flushShard(i);
+        }
+    }
+    // 仍未写入的死信消息落到溢出文件，重启后继续重投
+    dlq_->stop();
+}
+
+size_t BatchWriter::shardOf(const std::string& convId) const {
+    return std::hash<std::string>{}(convId) % buffers_.size();
+}
+
+MemoryBudget::Admission BatchWriter::admit(const std::shared_ptr<ChatMsgNode>& node) {
+    const size_t bytes = node->estimateBytes();
+    const auto admission = memory_->tryAcquire(bytes);
+    if (admission != MemoryBudget::Admission::REJECT) {
+        node->mem_bytes = bytes;
+    }
+    return admission;
+}
+
+void BatchWriter::submit(size_t shard_idx, std::shared_ptr<ChatMsgNode> node) {
+    const size_t size = buffers_[shard_idx]->push(std::move(node));
+    if (size >= sizer_->batchSize()) {
+        if (scheduleFlush(shard_idx)) {
+            metrics_.size_trigger_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    if (size == 1) {
+        // 批次第一条消息：登记截止时间，最晚在一个刷写间隔后落库
+        Deadline deadline{std::chrono::steady_clock::now() + flush_interval_, shard_idx,
+            buffers_[shard_idx]->generation()};
+        bool earliest = false;
+        {
+            std::lock_guard lk(deadline_mtx_);
+            earliest = deadlines_.empty() || deadline.when < deadlines_.top().when;
+            deadlines_.push(deadline);
+        }
+        if (earliest) {
+            deadline_cv_.notify_one();
+        }
+    }
+}
+
+void BatchWriter::submit(size_t shard_idx, std::shared_ptr<ChatMsgNode> node,
+    const std::function<void()>& onDurable) {
+    if (!wal_) {
+        submit(shard_idx, std::move(node));
+        onDurable();
+        return;
+    }
+    Json::Value payload;
+    node->msg.toJson(payload);
+    wal_->append(Json::FastWriter().write(payload), [this, shard_idx, node, onDurable](const uint64_t lsn) {
+        // 写 WAL 失败时仍按无 WAL 的方式写入 MySQL
+        node->wal_lsn = lsn;
+        submit(shard_idx, node);
+        onDurable();
+    });
+}
+
+bool BatchWriter::scheduleFlush(size_t shard_idx) {
+    if (queued_[shard_idx].exchange(true, std::memory_order_acq_rel)) {
+        return false;
+    }
+    auto& queue = *task_queues_[shard_idx % num_writers_];
+    {
+        std::lock_guard lk(queue.mtx);
+        queue.tasks.push_back(shard_idx);
+    }
+    queue.cv.notify_one();
+    return true;
+}
+
+void BatchWriter::replayWal(std::vector<MessageWal::Record>& records) {
+    if (records.empty()) {
+        return;
+    }
+    // 记录中带有收到消息时分配的 server_id，崩溃前已落库的消息重放时主键冲突，不会重复插入
+    std::vector<std::shared_ptr<ChatMsgNode>> batch;
+    size_t replayed = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        Json::Value payload;
+        MessageInfo info;
+        if (Json::Reader reader; reader.parse(records[i].payload, payload)) {
+            info.fromJson(payload);
+        }
+        if (info.servId <= 0) {
+            std::cout << "[BatchWriter] skip invalid WAL record, lsn=" << records[i].lsn << std::endl;
+            wal_->release(records[i].lsn);
+        }
+        else {
+            auto node = std::make_shared<ChatMsgNode>(info, nullptr);
+            node->wal_lsn = records[i].lsn;
+            batch.push_back(std::move(node));
+        }
+        if (batch.size() >= sizer_->batchSize() || (i + 1 == records.size() && !batch.empty())) {
+            replayed += batch.size();
+            // 重放失败的消息留在 WAL 中，下次启动继续重放
+            flushBatch(batch);
+            batch.clear();
+        }
+    }
+    std::cout << "[BatchWriter] replayed " << replayed << " WAL records" << std::endl;
 }
 
 // ──────────────────────────────────────────────────────────────
@@ -54,15 +303,35 @@ void BatchWriter::stop() {
 // ──────────────────────────────────────────────────────────────
 
 void BatchWriter::timerLoop() {
+    std::unique_lock lk(deadline_mtx_);
     while (running_) {
-        size_t flushed = 0;
-        for (size_t i = 0; i < buffers_.size(); i++) {
-            if (buffers_[i]->hasData()) {
-                task_queue_.push(i);
-                flushed++;
+        if (deadlines_.empty()) {
+            deadline_cv_.wait(lk, [this] { return !running_ || !deadlines_.empty(); });
+            continue;
+        }
+        // 睡到最早的截止时间，期间登记了更早的截止时间会被唤醒重新计算
+        const auto when = deadlines_.top().when;
+        if (deadline_cv_.wait_until(lk, when, [this, when] {
+                return !running_ || (!deadlines_.empty() && deadlines_.top().when < when);
+            })) {
+            continue;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<Deadline> due;
+        while (!deadlines_.empty() && deadlines_.top().when <= now) {
+            due.push_back(deadlines_.top());
+            deadlines_.pop();
+        }
+        lk.unlock();
+        for (const auto& d : due) {
+            // 该批次已被按量刷写时跳过，新批次会登记自己的截止时间
+            if (buffers_[d.shard_idx]->generation() == d.generation && buffers_[d.shard_idx]->hasData()
+                && scheduleFlush(d.shard_idx)) {
+                metrics_.deadline_trigger_count.fetch_add(1, std::memory_order_relaxed);
             }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        lk.lock();
     }
 }
 
@@ -70,14 +339,22 @@ void BatchWriter::timerLoop() {
 // Writer Thread
 // ──────────────────────────────────────────────────────────────
 
-void BatchWriter::writerLoop() {
-    while (running_) {
+void BatchWriter::writerLoop(size_t writer_idx) {
+    auto& queue = *task_queues_[writer_idx];
+    while (true) {
         size_t shard_idx;
-        if (task_queue_.pop(shard_idx)) {
-            flushShard(shard_idx);
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        {
+            std::unique_lock lk(queue.mtx);
+            queue.cv.wait(lk, [this, &queue] { return !running_ || !queue.tasks.empty(); });
+            if (!running_) {
+                return;
+            }
+            shard_idx = queue.tasks.front();
+            queue.tasks.pop_front();
         }
+        // 先清除标记再 swap，swap 之后到达的消息可以再次触发刷写；再次推入的仍是本线程的队列，不会并发刷写
+        queued_[shard_idx].store(false, std::memory_order_release);
+        flushShard(shard_idx);
     }
 }
 
@@ -88,12 +365,25 @@ void BatchWriter::flushShard(size_t shard_idx) {
     auto nodes = buffers_[shard_idx]->swap();
     if (nodes.empty()) return;
 
-    // 批量写入
-    try {
-        flushBatch(nodes);
-    } catch (const std::exception& e) {
-        std::cout << "[BatchWriter] flushBatch exception: " << e.what() << std::endl;
-        handleFailed(std::move(nodes));
+    // 批量写入；积压超过当前批次时切分，单个事务不超过控制器给出的大小
+    const auto flushSlice = [this](std::vector<std::shared_ptr<ChatMsgNode>>& batch) {
+        try {
+            flushBatch(batch);
+        } catch (const std::exception& e) {
+            std::cout << "[BatchWriter] flushBatch exception: " << e.what() << std::endl;
+            handleFailed(std::move(batch));
+        }
+    };
+    const size_t total = nodes.size();
+    if (const size_t batch_size = sizer_->batchSize(); total <= batch_size) {
+        flushSlice(nodes);
+    }
+    else {
+        for (size_t offset = 0; offset < total; offset += batch_size) {
+            std::vector<std::shared_ptr<ChatMsgNode>> batch(nodes.begin() + offset,
+                nodes.begin() + std::min(offset + batch_size, total));
+            flushSlice(batch);
+        }
     }
 
     // 记录耗时
@@ -101,7 +391,7 @@ void BatchWriter::flushShard(size_t shard_idx) {
     uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
     metrics_.flush_latency_us.fetch_add(latency, std::memory_order_relaxed);
     metrics_.flush_count.fetch_add(1, std::memory_order_relaxed);
-    metrics_.flush_msg_count.fetch_add(nodes.size(), std::memory_order_relaxed);
+    metrics_.flush_msg_count.fetch_add(total, std::memory_order_relaxed);
 }
 
 // ──────────────────────────────────────────────────────────────
@@ -118,29 +408,71 @@ void BatchWriter::flushBatch(std::vector<std::shared_ptr<ChatMsgNode>>& nodes) {
         metrics_.node_lifetime_count.fetch_add(1, std::memory_order_relaxed);
     }
 
-    // 调用 DAO 层批量写入
-    std::unordered_map<int64_t, int> id_mapping;
-    if (!MysqlMgr::getInstance()->batchCreateMessages(nodes, id_mapping)) {
+    if (!writeBatch(nodes)) {
         handleFailed(std::move(nodes));
         return;
     }
+    releaseMemory(nodes);
+    dlq_->onWriteSucceeded();
+}
 
-    // 回推 serverId 映射给客户端
-    for (auto& n : nodes) {
-        int64_t key = static_cast<int64_t>(std::hash<std::string>{}(n->msg.convId.value_or(""))) * 1000000000LL + n->msg.msgId;
-        auto it = id_mapping.find(key);
-        if (it == id_mapping.end()) continue;
+bool BatchWriter::writeBatch(std::vector<std::shared_ptr<ChatMsgNode>>& nodes) {
+    // 调用 DAO 层批量写入
+    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+    int deadlocks = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = MysqlMgr::getInstance()->batchCreateMessages(nodes, duplicates, sizer_->chunkSize(), deadlocks);
+    // 失败的提交同样反馈：MySQL 变慢或死锁时及时缩小批次
+    sizer_->onCommit(nodes.size(), std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start), deadlocks);
+    if (!ok) {
+        return false;
+    }
+    if (wal_) {
+        for (const auto& n : nodes) {
+            wal_->release(n->wal_lsn);
+        }
+    }
+    if (persisted_handler_) {
+        if (duplicates.empty()) {
+            persisted_handler_(nodes);
+        }
+        else {
+            // 重发、重放的消息在第一次落库时已交给回调
+            std::unordered_set<const ChatMsgNode*> resent;
+            for (const auto& n : duplicates) {
+                resent.insert(n.get());
+            }
+            std::vector<std::shared_ptr<ChatMsgNode>> fresh;
+            std::copy_if(nodes.begin(), nodes.end(), std::back_inserter(fresh), [&resent](const auto& n) {
+                return resent.count(n.get()) == 0;
+            });
+            persisted_handler_(fresh);
+        }
+    }
+    if (duplicate_handler_) {
+        std::for_each(duplicates.begin(), duplicates.end(), duplicate_handler_);
+    }
 
+    // serverId 已随 ACK 下发；客户端重发的消息以已存储的 serverId 为准，回推更正
+    const auto notify = [](const std::shared_ptr<ChatMsgNode>& n) {
         if (auto sess = n->sender_session.lock()) {
             Json::Value rsp;
             rsp["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
             rsp["msg_id"] = n->msg.msgId;
-            rsp["server_id"] = it->second;
+            rsp["server_id"] = static_cast<Json::Int64>(n->msg.servId);
             rsp["conv_id"] = n->msg.convId.value_or("");
             sess->asyncSend(rsp.toStyledString(),
                 static_cast<uint16_t>(MessageID::ID_NOTIFY_MSG_RESULT));
         }
+    };
+    if (notify_persisted_) {
+        std::for_each(nodes.begin(), nodes.end(), notify);
+    }
+    else {
+        std::for_each(duplicates.begin(), duplicates.end(), notify);
     }
+    return true;
 }
 
 // ──────────────────────────────────────────────────────────────
@@ -148,23 +480,53 @@ void BatchWriter::flushBatch(std::vector<std::shared_ptr<ChatMsgNode>>& nodes) {
 // ──────────────────────────────────────────────────────────────
 
 void BatchWriter::handleFailed(std::vector<std::shared_ptr<ChatMsgNode>> failed) {
-    auto now_us = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::steady_clock::now().time_since_epoch()).count();
+    // 交给死信队列退避重投，重投成功后照常回推 serverId，判定为毒消息时才通知客户端失败
+    metrics_.dead_letter_count.fetch_add(failed.size(), std::memory_order_relaxed);
+    // 移交后仍计入预算，重投成功或判定为毒消息时才归还：MySQL 故障期间预算耗尽，新消息回复忙，
+    // 死信队列的磁盘溢出也不会无限增长
+    dlq_->add(std::move(failed));
+}
 
-    std::lock_guard lk(dlm_mtx_);
-    for (auto& n : failed) {
-        // 通知客户端写入失败
-        if (auto sess = n->sender_session.lock()) {
-            Json::Value err;
-            err["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
-            err["msg_id"] = n->msg.msgId;
-            err["conv_id"] = n->msg.convId.value_or("");
-            sess->asyncSend(err.toStyledString(),
-                static_cast<uint16_t>(MessageID::ID_CHAT_MSG_RSP));
-        }
-        dead_letter_queue_.push_back(std::move(n));
+void BatchWriter::releaseMemory(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes) {
+    size_t bytes = 0;
+    for (const auto& n : nodes) {
+        // 重放和死信重投的消息未计入或已归还，mem_bytes 为 0
+        bytes += std::exchange(n->mem_bytes, 0);
+    }
+    if (bytes > 0) {
+        memory_->release(bytes);
     }
-    metrics_.dead_letter_count.fetch_add(failed.size(), std::memory_order_relaxed);
+}
+
+void BatchWriter::handlePoison(const std::shared_ptr<ChatMsgNode>& node) {
+    if (auto sess = node->sender_session.lock()) {
+        Json::Value err;
+        err["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
+        err["msg_id"] = node->msg.msgId;
+        err["conv_id"] = node->msg.convId.value_or("");
+        sess->asyncSend(err.toStyledString(),
+            static_cast<uint16_t>(MessageID::ID_CHAT_MSG_RSP));
+    }
+    releaseMemory({node});
+    // 已记入 poison.log，不再从 WAL 重放
+    if (wal_) {
+        wal_->release(node->wal_lsn);
+    }
+    if (poison_handler_) {
+        poison_handler_(node);
+    }
+}
+
+DeadLetterQueue::Stats BatchWriter::deadLetterStats() const {
+    return dlq_->stats();
+}
+
+BatchSizeController::Stats BatchWriter::batchSizing() const {
+    return sizer_->stats();
+}
+
+MemoryBudget::Stats BatchWriter::memoryUsage() const {
+    return memory_->stats();
 }
 
 // ──────────────────────────────────────────────────────────────
@@ -182,19 +544,37 @@ void BatchWriter::printMetrics() {
     uint64_t nl = metrics_.node_lifetime_us.exchange(0, std::memory_order_relaxed);
     uint64_t nc = metrics_.node_lifetime_count.exchange(0, std::memory_order_relaxed);
     uint64_t dl = metrics_.dead_letter_count.load(std::memory_order_relaxed);
+    uint64_t sc = metrics_.size_trigger_count.exchange(0, std::memory_order_relaxed);
+    uint64_t dc = metrics_.deadline_trigger_count.exchange(0, std::memory_order_relaxed);
 
     double avg_latency = fc > 0 ? static_cast<double>(fl) / fc : 0;
     double avg_batch = fc > 0 ? static_cast<double>(fm) / fc : 0;
     double avg_lifetime = nc > 0 ? static_cast<double>(nl) / nc : 0;
     double flush_per_sec = elapsed > 0 ? fc / elapsed : 0;
     double msg_per_sec = elapsed > 0 ? fm / elapsed : 0;
+    if (wal_) {
+        wal_->printMetrics();
+    }
+    dlq_->printMetrics();
+    const auto sizing = sizer_->stats();
+    const auto memory = memory_->stats();
 
     std::cout << "[batch_metrics] "
               << "flush/s=" << std::fixed << std::setprecision(1) << flush_per_sec
               << " msg/s=" << std::setprecision(0) << msg_per_sec
+              << " size=" << sc
+              << " deadline=" << dc
               << " avg_latency=" << std::setprecision(0) << avg_latency << "us"
               << " avg_batch=" << std::setprecision(1) << avg_batch
               << " avg_queue_wait=" << std::setprecision(0) << avg_lifetime << "us"
               << " dead_letters=" << dl
+              << " batch_size=" << sizing.batchSize
+              << " chunk=" << sizing.chunkSize
+              << " aimd=+" << sizing.increases << "/-" << sizing.decreases
+              << " deadlocks=" << sizing.deadlocks
+              << " mem_kb=" << (memory.usedBytes >> 10)
+              << " peak_kb=" << (memory.peakBytes >> 10)
+              << " soft=" << memory.softAdmits
+              << " rejected=" << memory.rejects
               << std::endl;
 }
@@ -8,28 +8,69 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <queue>
+#include <string>
 #include <vector>
 
-#include <boost/lockfree/queue.hpp>
-
+#include "BatchSizeController.h"
+#include "DeadLetterQueue.h"
 #include "FlushBuffer.h"
+#include "MemoryBudget.h"
+#include "MessageWal.h"
 
 /**
  * @brief 聊天消息批量异步写入管理器。
  *
- * 架构：
- *   - 全局定时器 (200ms): 轮询所有 shard，将有数据的 shard 索引推入 task queue
- *   - DB 写入线程池 (shard_count/4): 从 task queue 取 shard 索引，swap 缓冲区，批量写 MySQL
+ * 架构（事件驱动，按量或按时刷写）：
+ *   - 按会话路由：消息按 conv_id 哈希到 shard（shardOf），同一会话的消息只进入一个 shard；
+ *   - 按量：shard 缓冲区达到 BatchFlushSize 条时立即把 shard 索引推入所属写入线程的任务队列；
+ *   - 按时：shard 缓冲区由空变为非空时登记截止时间（BatchFlushIntervalMs），
+ *     定时线程睡到最早的截止时间，到期且该批次尚未刷写时推入任务队列；
+ *   - DB 写入线程池 (shard_count/4): shard 固定归属 shard % 写入线程数 的线程，每个线程只在
+ *     自己的任务队列上等待，取 shard 索引，swap 缓冲区，批量写 MySQL。
+ * 一个 shard 同一时刻只有一个线程在刷写，同一会话的 conversation / user_conversation 行不会被
+ * 两个批次事务同时更新，批次之间不再有行锁冲突；死锁重试只剩已读水位刷写、死信重投等并发写入。
+ * 空闲时定时线程和写入线程都阻塞等待，不轮询；单条消息最多等待一个刷写间隔。
+ *
+ * 开启 BatchAdaptive 时按量刷写的阈值和每条 INSERT 的行数由 BatchSizeController 按提交耗时
+ * (BatchTargetLatencyMs) 和死锁次数 AIMD 调整，范围为 [BatchMinSize, BatchMaxSize] 和
+ * [BatchChunkMin, BatchChunkMax]；缓冲区积压超过当前批次时切分成多个事务写入。
+ *
+ * 消息的 serverId 在收到时已分配并随 ACK 下发，写入不回查；开启 NotifyPersisted 时落库后再回推
+ * ID_NOTIFY_MSG_RESULT 作为持久化确认，否则只回推客户端重发消息的 serverId 更正。
+ *
+ * 内存预算：收到的消息由 admit 按估算字节数计入 MemoryBudget，写入 MySQL 或判定为毒消息后释放，
+ * 覆盖 WAL 待落盘、缓冲区、正在刷写和死信队列中（内存或磁盘溢出）的消息。MySQL 变慢或不可用时
+ * 积压超过 BatchMemorySoftMB 仍接收但在 ACK 中要求客户端降速，超过 BatchMemoryHardMB 直接拒绝，
+ * 进程内存和死信溢出文件都不再随故障时长无限增长。
+ *
+ * 开启 WalEnabled 时消息先组提交写入本地 WAL，落盘后才推入缓冲区并回调调用方发送 ACK，
+ * 写入 MySQL 成功后确认 WAL 记录；启动时先把上次遗留的 WAL 记录重放到 MySQL。
+ *
+ * 写入 MySQL 成功后把本批新落库的消息（不含客户端重发）交给 setPersistedHandler 登记的回调，
+ * 在写入线程中执行，用于维护本地搜索索引等派生数据。客户端重发的消息改为已存储的 serverId 后交给
+ * setDuplicateHandler 登记的回调，判定为毒消息的交给 setPoisonHandler 登记的回调，收到消息时
+ * 就写入的缓存据此修正。
  *
  * 监控 (Metrics):
  *   - flush/s              : 每秒刷写次数
  *   - msg/s                : 每秒写入消息数
+ *   - size / deadline      : 按量 / 按时触发的刷写次数
  *   - avg_latency_us       : 单次刷写耗时
  *   - avg_batch            : 每批消息数
  *   - avg_queue_wait_us    : 消息排队等待时间
- *   - dead_letter_count    : 死信消息数
+ *   - dead_letter_count    : 累计进入死信队列的消息数，重投状态见 DeadLetterQueue 的 [dlq] 指标
+ *   - batch_size / chunk   : 当前的批次大小 / 每条 INSERT 行数
+ *   - aimd                 : 累计增长 / 减半次数
+ *   - deadlocks            : 累计死锁重试次数
+ *   - mem_kb / peak_kb     : 未落库消息的估算内存 / 峰值
+ *   - soft / rejected      : 累计超过软上限接收 / 超过硬上限拒绝的消息数
  */
 class BatchWriter {
 public:
@@ -37,9 +78,36 @@ public:
     ~BatchWriter();
 
     void start();
+    /// 停止并刷写缓冲区中剩余的消息
     void stop();
 
-    FlushBuffer* bufferAt(size_t shard_idx) { return buffers_[shard_idx].get(); }
+    /// 会话所属的 shard，同一会话的消息必须推入同一个 shard
+    [[nodiscard]] size_t shardOf(const std::string& convId) const;
+
+    /// 按估算字节数申请内存预算，ACCEPT / SOFT 时已计入，消息必须随后 submit；REJECT 时未计入，消息应丢弃
+    MemoryBudget::Admission admit(const std::shared_ptr<ChatMsgNode>& node);
+    /// 拒绝或降速时建议客户端重发的等待时间
+    [[nodiscard]] int busyRetryAfterMs() const { return busy_retry_after_ms_; }
+
+    /// 消息推入 shard 缓冲区，按量或登记截止时间触发刷写
+    void submit(size_t shard_idx, std::shared_ptr<ChatMsgNode> node);
+    /// 开启 WAL 时消息落盘后再推入缓冲区，并在 WAL 提交线程调用 onDurable；未开启时立即推入并调用
+    void submit(size_t shard_idx, std::shared_ptr<ChatMsgNode> node, const std::function<void()>& onDurable);
+
+    using PersistedHandler = std::function<void(const std::vector<std::shared_ptr<ChatMsgNode>>&)>;
+    /// 落库回调，须在 start 之前设置
+    void setPersistedHandler(PersistedHandler handler) { persisted_handler_ = std::move(handler); }
+
+    using NodeHandler = std::function<void(const std::shared_ptr<ChatMsgNode>&)>;
+    /// 客户端重发的消息已改为存储的 serverId，须在 start 之前设置
+    void setDuplicateHandler(NodeHandler handler) { duplicate_handler_ = std::move(handler); }
+    /// 消息判定为毒消息，不会落库，须在 start 之前设置
+    void setPoisonHandler(NodeHandler handler) { poison_handler_ = std::move(handler); }
+
+    [[nodiscard]] bool walEnabled() const { return wal_ != nullptr; }
+    [[nodiscard]] DeadLetterQueue::Stats deadLetterStats() const;
+    [[nodiscard]] BatchSizeController::Stats batchSizing() const;
+    [[nodiscard]] MemoryBudget::Stats memoryUsage() const;
 
     //=== 监控指标 ============================================================
     void printMetrics();
@@ -47,29 +115,71 @@ public:
 private:
     //=== 线程函数 ============================================================
     void timerLoop();
-    void writerLoop();
+    void writerLoop(size_t writer_idx);
 
     //=== 核心逻辑 ============================================================
+    /// shard 推入所属写入线程的任务队列，已在队列中时忽略并返回 false
+    bool scheduleFlush(size_t shard_idx);
+    /// 重放上次运行遗留的 WAL 记录
+    void replayWal(std::vector<MessageWal::Record>& records);
     void flushShard(size_t shard_idx);
     void flushBatch(std::vector<std::shared_ptr<ChatMsgNode>>& nodes);
+    /// 写入 MySQL，成功后确认 WAL 并回推落库结果；刷写和死信重投共用
+    bool writeBatch(std::vector<std::shared_ptr<ChatMsgNode>>& nodes);
     void handleFailed(std::vector<std::shared_ptr<ChatMsgNode>> failed);
+    /// 消息落库或判定为毒消息，归还内存预算
+    void releaseMemory(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes);
+    void handlePoison(const std::shared_ptr<ChatMsgNode>& node);
 
     //=== 数据结构 ============================================================
+    struct Deadline {
+        std::chrono::steady_clock::time_point when;
+        size_t shard_idx;
+        uint64_t generation;    ///< 登记时缓冲区的 swap 次数，不一致说明该批次已被刷写
+
+        bool operator>(const Deadline& other) const { return when > other.when; }
+    };
+
     std::vector<std::unique_ptr<FlushBuffer>> buffers_;
-    boost::lockfree::queue<size_t> task_queue_{4096};
+    /// shard 是否已在任务队列中，避免按量和按时重复推入
+    std::unique_ptr<std::atomic<bool>[]> queued_;
+
+    std::unique_ptr<BatchSizeController> sizer_;
+    std::unique_ptr<MemoryBudget> memory_;
+    int busy_retry_after_ms_ = 0;
+    std::chrono::milliseconds flush_interval_;
+    /// 落库后对每条消息回推 ID_NOTIFY_MSG_RESULT；关闭时只回推重发消息的 serverId 更正
+    bool notify_persisted_ = false;
+    PersistedHandler persisted_handler_;
+    NodeHandler duplicate_handler_;
+    NodeHandler poison_handler_;
+
+    /// 写入线程各自的任务队列，shard 固定归属一个写入线程
+    struct TaskQueue {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::deque<size_t> tasks;
+    };
+    std::vector<std::unique_ptr<TaskQueue>> task_queues_;
+
+    std::mutex deadline_mtx_;
+    std::condition_variable deadline_cv_;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> deadlines_;
 
     std::atomic<bool> running_{false};
     std::thread timer_thread_;
     size_t num_writers_ = 0;
     std::vector<std::thread> writers_;
 
-    // 死信队列
-    std::mutex dlm_mtx_;
-    std::vector<std::shared_ptr<ChatMsgNode>> dead_letter_queue_;
+    std::unique_ptr<MessageWal> wal_;
+
+    std::unique_ptr<DeadLetterQueue> dlq_;
 
     //=== 监控指标 ============================================================
     struct alignas(64) Metrics {
         std::atomic<uint64_t> flush_count{0};
+        std::atomic<uint64_t> size_trigger_count{0};
+        std::atomic<uint64_t> deadline_trigger_count{0};
         std::atomic<uint64_t> flush_latency_us{0};
         std::atomic<uint64_t> flush_msg_count{0};
         std::atomic<uint64_t> dead_letter_count{0};
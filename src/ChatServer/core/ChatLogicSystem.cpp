@@ -2,6 +2,8 @@
 // Created by Fan on 2026/5/12.
 //
 
+#include <charconv>
+#include <limits>
 #include <regex>
 
 #include <json/value.h>
@@ -9,17 +11,30 @@
 
 #include "ChatLogicSystem.h"
 
-#include "StatusGrpcClient.h"
+#include "TokenAuth.h"
 #include "Session.h"
 #include "RedisMgr.h"
 #include "UserMgr.h"
 #include "ChatGrpcClient.h"
 #include "LogicWorker.h"
 #include "BatchWriter.h"
+#include "CounterService.h"
+#include "UserRouteCache.h"
+#include "GroupMemberCache.h"
+#include "OfflineInbox.h"
+#include "PresenceWriter.h"
+#include "ReadWatermarkTable.h"
+#include "RecentMessageCache.h"
+#include "ConversationListCache.h"
+#include "HistoryPage.h"
+#include "MessageSearchIndex.h"
+#include "LoginAdmission.h"
+#include "ConfigMgr.h"
 
 #include "db/mysql/MysqlMgr.h"
 #include "db/cache/UserInfoCache.h"
 #include "db/cache/FriendCache.h"
+#include "db/cache/ConversationCache.h"
 #include "common/model/ConversationInfo.h"
 #include "common/model/MessageInfo.h"
 
@@ -135,6 +150,19 @@ void ChatLogicSystem::close() {
     if (batch_writer_) {
         batch_writer_->stop();
     }
+    // 在 BatchWriter 之后停止，最后一批落库的消息也进入索引、写回未读数
+    if (search_index_) {
+        search_index_->stop();
+    }
+    CounterService::getInstance()->stop();
+    if (read_watermarks_) {
+        read_watermarks_->stop();
+    }
+    if (login_admission_) {
+        login_admission_->stop();
+    }
+    PresenceWriter::getInstance()->stop();
+    ConversationCache::getInstance()->stop();
 }
 
 void ChatLogicSystem::setServerName(const std::string &name) {
@@ -162,12 +190,18 @@ size_t ChatLogicSystem::getShardIndex(const std::shared_ptr<LogicNode> &msg) con
     return hash % shards_.size();
 }
 
+DeadLetterQueue::Stats ChatLogicSystem::deadLetterStats() const {
+    return batch_writer_ ? batch_writer_->deadLetterStats() : DeadLetterQueue::Stats{};
+}
+
 void ChatLogicSystem::notifyOnlineUserMsg(const int uid, const std::string &msg, MessageID msgId,
     const notifyOnlineUserCallback &callback) {
-    const auto toServiceName = RedisMgr::getInstance()->hGet(
-        USER_ONLINE_INFO_PREFIX + std::to_string(uid), USER_ONLINE_SERVER_NAME);
+    // 优先查本地路由表，登录/下线通过 Redis 频道通知失效
+    const auto toServiceName = UserRouteCache::getInstance()->getServerName(uid);
     if (toServiceName.empty()) {
-        return;// 用户不在线直接返回，等到上线直接从数据库拉取
+        // 用户不在线，写入离线收件箱，重连后一次同步补齐
+        OfflineInbox::getInstance()->append(uid, static_cast<uint16_t>(msgId), msg);
+        return;
     }
 
     // 同一服务器直接发送申请消息
@@ -175,6 +209,10 @@ void ChatLogicSystem::notifyOnlineUserMsg(const int uid, const std::string &msg,
         if (const auto toSession = UserMgr::getInstance()->getSession(uid)) {
             toSession->asyncSend(msg, static_cast<std::uint16_t>(msgId));
         }
+        else {
+            UserRouteCache::getInstance()->invalidate(uid);  // 本地已无会话，路由过期
+            OfflineInbox::getInstance()->append(uid, static_cast<uint16_t>(msgId), msg);
+        }
         return;
     }
 
@@ -182,7 +220,25 @@ void ChatLogicSystem::notifyOnlineUserMsg(const int uid, const std::string &msg,
 }
 
 ChatLogicSystem::ChatLogicSystem()
-    : stop_(false), workerPool_() {
+    : stop_(false), groupMaxMembers_(DEFAULT_GROUP_MAX_MEMBERS), workerPool_() {
+    // 机器号区分集群内各服务器生成的消息 ID，必须各不相同；配置非法时在启动任何线程前抛出，拒绝启动
+    {
+        const auto& workerId = ConfigMgr::getInstance()["ChatServer"]["WorkerId"];
+        try {
+            msg_id_gen_ = std::make_unique<MessageIdGenerator>(workerId.empty() ? 0 : std::stoll(workerId));
+        }
+        catch (const std::exception& e) {
+            std::cout << "[ChatLogicSystem] invalid WorkerId '" << workerId << "', expect [0, "
+                << MessageIdGenerator::MAX_WORKER_ID << "]: " << e.what() << std::endl;
+            throw;
+        }
+        if (workerId.empty()) {
+            std::cout << "[ChatLogicSystem] WorkerId not configured, using 0" << std::endl;
+        }
+    }
+    if (const auto maxMembers = ConfigMgr::getInstance()["ChatServer"]["GroupMaxMembers"]; !maxMembers.empty()) {
+        groupMaxMembers_ = std::stoul(maxMembers);
+    }
     initHandlers();
     // 创建 N 个 shard，每个 shard 拥有独立的 lockfree 队列和 condvar
     int numWorkers = getIoWorkerNum();
@@ -196,13 +252,106 @@ ChatLogicSystem::ChatLogicSystem()
     }
     workerPool_.start();
 
+    UserRouteCache::getInstance()->start();
+    TokenAuth::getInstance()->start();
+    PresenceWriter::getInstance()->start();
+    CounterService::getInstance()->start();
+    GroupMemberCache::getInstance()->start();
+    // 对端回报接收方已下线，本地路由表项失效
+    ChatGrpcClient::getInstance()->setPeerOfflineHandler([](const int uid) {
+        UserRouteCache::getInstance()->invalidate(uid);
+    });
+
+    // 关闭全文索引时不处理搜索请求，落库不再分词
+    if (auto& config = ConfigMgr::getInstance(); config["ChatServer"]["SearchIndexEnabled"] != "false") {
+        MessageSearchIndex::Options options;
+        options.dir = config["ChatServer"]["SearchIndexDir"].empty()
+            ? DEFAULT_SEARCH_INDEX_DIR : config["ChatServer"]["SearchIndexDir"];
+        if (!config["ChatServer"]["SearchSealDocs"].empty()) {
+            options.sealDocs = std::max<size_t>(1, std::stoul(config["ChatServer"]["SearchSealDocs"]));
+        }
+        if (!config["ChatServer"]["SearchSealIntervalMs"].empty()) {
+            options.sealInterval = std::chrono::milliseconds(std::stoi(config["ChatServer"]["SearchSealIntervalMs"]));
+        }
+        if (!config["ChatServer"]["SearchMaxSegments"].empty()) {
+            options.maxSegments = std::max<size_t>(1, std::stoul(config["ChatServer"]["SearchMaxSegments"]));
+        }
+        search_index_ = std::make_unique<MessageSearchIndex>(options);
+        if (!search_index_->start()) {
+            std::cout << "[ChatLogicSystem] start search index failed, message search disabled" << std::endl;
+            search_index_.reset();
+        }
+    }
+
+    // 关闭最近消息缓存时每次拉取历史都查询 MySQL，用于压测对比
+    if (auto& config = ConfigMgr::getInstance(); config["ChatServer"]["RecentMsgCacheEnabled"] != "false") {
+        RecentMessageCache::Options options;
+        if (!config["ChatServer"]["RecentMsgRingSize"].empty()) {
+            options.ringSize = std::stoul(config["ChatServer"]["RecentMsgRingSize"]);
+        }
+        if (!config["ChatServer"]["RecentMsgCacheMB"].empty()) {
+            options.maxBytes = std::stoul(config["ChatServer"]["RecentMsgCacheMB"]) << 20;
+        }
+        if (!config["ChatServer"]["RecentMsgTtlMs"].empty()) {
+            options.ttl = std::chrono::milliseconds(std::stoi(config["ChatServer"]["RecentMsgTtlMs"]));
+        }
+        recent_msgs_ = std::make_unique<RecentMessageCache>(options,
+            [](const std::string& convId, const int limit, std::vector<MessageInfo>& result) {
+                return MysqlMgr::getInstance()->selectRecentMessages(convId, limit, result);
+            });
+    }
+
     // 初始化批量写入管理器
     {
         size_t numShards = shards_.size();
         size_t numWriters = std::max<size_t>(1, numShards / 4);
         batch_writer_ = std::make_unique<BatchWriter>(numShards, numWriters);
+        batch_writer_->setPersistedHandler([index = search_index_.get()](const auto& nodes) {
+            // 未读数不再随消息插入逐批更新，由计数服务合并后写回
+            CounterService::getInstance()->onMessagesPersisted(nodes);
+            if (index) {
+                for (const auto& n : nodes) {
+                    index->add(n->msg);
+                }
+            }
+        });
+        // 未按分配的 serverId 落库的重发消息：修正最近消息环，并向接收方推送更正（发送方由 BatchWriter 推送）
+        batch_writer_->setDuplicateHandler([this](const auto& node) {
+            if (recent_msgs_) {
+                recent_msgs_->correct(node->msg);
+            }
+            notifyResentCorrection(node->msg);
+        });
+        if (recent_msgs_) {
+            batch_writer_->setPoisonHandler([cache = recent_msgs_.get()](const auto& node) {
+                cache->remove(node->msg.convId.value_or(""), node->msg.servId);
+            });
+        }
         batch_writer_->start();
     }
+    read_watermarks_ = std::make_unique<ReadWatermarkTable>();
+    read_watermarks_->start();
+    // 关闭会话列表缓存时每次拉取都查询 MySQL 并逐个查询对方资料，用于压测对比
+    if (auto& config = ConfigMgr::getInstance(); config["ChatServer"]["ConvListCacheEnabled"] != "false") {
+        ConversationListCache::Options options;
+        if (!config["ChatServer"]["ConvListMaxUsers"].empty()) {
+            options.maxUsers = std::stoul(config["ChatServer"]["ConvListMaxUsers"]);
+        }
+        if (!config["ChatServer"]["ConvListTtlMs"].empty()) {
+            options.ttl = std::chrono::milliseconds(std::stoi(config["ChatServer"]["ConvListTtlMs"]));
+        }
+        conv_lists_ = std::make_unique<ConversationListCache>(options, &ChatLogicSystem::loadConversationList);
+        ConversationCache::getInstance()->start();
+        // 对账修正的未读数同步到 Redis 层，其他服务器冷加载时读到修正后的值
+        CounterService::getInstance()->setUnreadFixHandler([](const UnreadCountFix& fix) {
+            ConversationCache::getInstance()->applyRead(fix.uid, fix.convId, fix.unreadCount, 0);
+        });
+    }
+    // 关闭准入控制时登录仍在 worker 线程同步执行，用于压测对比
+    if (ConfigMgr::getInstance()["ChatServer"]["LoginAdmissionEnabled"] != "false") {
+        login_admission_ = std::make_unique<LoginAdmission>();
+        login_admission_->start();
+    }
 
     // 触发一次打印以初始化 stats_ 的内部时间戳（避免首条消息 elapsed 极大）
     stats_.printStats(std::chrono::steady_clock::now());
@@ -219,7 +368,11 @@ int ChatLogicSystem::getIoWorkerNum() {
 void ChatLogicSystem::initHandlers() {
     registerHandler(static_cast<uint16_t>(MessageID::ID_CHAT_LOGIN),
         [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
-            return loginHandle(session, msgId, data);
+            return admitLogin(session, msgId, data);
+        });
+    registerHandler(static_cast<uint16_t>(MessageID::ID_CHAT_LOGOUT_REQ),
+        [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
+            return logoutHandle(session, msgId, data);
         });
     registerHandler(static_cast<uint16_t>(MessageID::ID_FIRST_PAGE_REQ),
         [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
@@ -265,6 +418,22 @@ void ChatLogicSystem::initHandlers() {
         [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
             return conversationListFetchHandle(session, msgId, data);
         });
+    registerHandler(static_cast<uint16_t>(MessageID::ID_GROUP_CREATE_REQ),
+        [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
+            return groupCreateHandle(session, msgId, data);
+        });
+    registerHandler(static_cast<uint16_t>(MessageID::ID_GROUP_MEMBER_UPDATE_REQ),
+        [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
+            return groupMemberUpdateHandle(session, msgId, data);
+        });
+    registerHandler(static_cast<uint16_t>(MessageID::ID_INBOX_SYNC_REQ),
+        [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
+            return inboxSyncHandle(session, msgId, data);
+        });
+    registerHandler(static_cast<uint16_t>(MessageID::ID_MSG_SEARCH_REQ),
+        [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
+            return messageSearchHandle(session, msgId, data);
+        });
 
     registerHandler(static_cast<uint16_t>(MessageID::ID_CHAT_MSG_REQ),
         [this](const std::shared_ptr<Session> &session, const uint16_t msgId, const std::string& data) {
@@ -331,6 +500,16 @@ void ChatLogicSystem::dealMsg(size_t shard_idx) {
             if (stats_.elapsedSinceReport(now) >= 1.0 || stats_.totalMessages() % 10000 == 0) {
                 stats_.printStats(now);
                 if (batch_writer_) batch_writer_->printMetrics();
+                if (read_watermarks_) read_watermarks_->printMetrics();
+                if (recent_msgs_) recent_msgs_->printMetrics();
+                if (conv_lists_) conv_lists_->printMetrics();
+                if (search_index_) search_index_->printMetrics();
+                CounterService::getInstance()->printMetrics();
+                ConversationCache::getInstance()->printMetrics();
+                if (login_admission_) login_admission_->printMetrics();
+                PresenceWriter::getInstance()->printMetrics();
+                TokenAuth::getInstance()->printMetrics();
+                ChatGrpcClient::getInstance()->printPeerStats();
             }
             continue;
         }
@@ -402,11 +581,11 @@ void ChatLogicSystem::handleMsgNode(const std::shared_ptr<LogicNode> &node) {
     }
 }
 
-void ChatLogicSystem::kickOnlineUser(const int uid) const {
+bool ChatLogicSystem::kickOnlineUser(const int uid) const {
     const std::string serverName = RedisMgr::getInstance()->hGet(
         USER_ONLINE_INFO_PREFIX + std::to_string(uid),USER_ONLINE_SERVER_NAME);
     if (serverName.empty()) {
-        return;
+        return false;
     }
     if (selfServerName_ == serverName) {// 用户在本服务器
         if (const auto oldSession = UserMgr::getInstance()->getSession(uid)) {
@@ -416,6 +595,27 @@ void ChatLogicSystem::kickOnlineUser(const int uid) const {
     else {// 用户在其他服务器，通知对端离线
         ChatGrpcClient::getInstance()->NotifyOffline(serverName, uid);
     }
+    // 路由变更随新会话的上线操作一并发布
+    return true;
+}
+
+void ChatLogicSystem::admitLogin(const std::shared_ptr<Session> &session, const uint16_t msgId,
+                                 const std::string &data) const {
+    if (!login_admission_) {
+        return loginHandle(session, msgId, data);
+    }
+    login_admission_->submit([this, session, msgId, data]() {
+        // 排队期间客户端可能已断开重连，不再为旧连接登录
+        if (session->isClosed()) {
+            return;
+        }
+        loginHandle(session, msgId, data);
+    }, [session](const int retryAfterMs) {
+        Json::Value root;
+        root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_BUSY);
+        root["retry_after_ms"] = retryAfterMs;
+        session->asyncSend(root.toStyledString(), static_cast<uint16_t>(MessageID::ID_CHAT_LOGIN_RSP));
+    });
 }
 
 void ChatLogicSystem::loginHandle(const std::shared_ptr<Session> &session, const uint16_t msgId,
@@ -434,10 +634,9 @@ void ChatLogicSystem::loginHandle(const std::shared_ptr<Session> &session, const
     root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
     const auto uid = srcRoot["uid"].asString();
     const int userid = std::stoi(uid);
-    const auto reply = StatusGrpcClient::getInstance()->Login(userid, srcRoot["token"].asString());
-    if (reply.error() != static_cast<int32_t>(ErrorCodes::SUCCESS)
-        || reply.token() != srcRoot["token"].asString()) {
-        std::cout << "Login token error, expect: " << reply.token() << std::endl;
+    const auto token = srcRoot["token"].asString();
+    // token 由 StatusServer 签名，本地验签即可，不再访问 StatusServer
+    if (!TokenAuth::getInstance()->verify(userid, token)) {
         root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_TOKEN_ERROR);
         return;
     }
@@ -451,31 +650,50 @@ void ChatLogicSystem::loginHandle(const std::shared_ptr<Session> &session, const
     }
 
     userInfo.toJson(root);
-    root["token"] = reply.token();
+    root["token"] = token;
 
     // 服务端踢人逻辑，将其他在线客户端下线
-    kickOnlineUser(userid);
+    if (kickOnlineUser(userid)) {
+        // 被踢下线的客户端不能再用原 token 重新登录，本次登录的 token 不受影响
+        TokenAuth::getInstance()->revokeOlder(token);
+    }
     // Session 与 uid 绑定
     session->setUserId(userid);
+    session->setToken(token);
     UserMgr::getInstance()->setUserSession(userid, session);
     session->updateState(SessionState::ONLINE);
 }
 
-int ChatLogicSystem::getApplyFriendCount(const int uid) {
-    int count = 0;
-    if (FriendCache::getInstance()->getFriendApplyCount(uid, count)) {
-        return count;
+void ChatLogicSystem::logoutHandle(const std::shared_ptr<Session> &session, const uint16_t msgId,
+                                   const std::string &data) const {
+    Json::Value root;
+    Json::Value srcRoot;
+    Defer defer([&root, session]() {
+        const std::string jsonStr = root.toStyledString();
+        session->asyncSend(jsonStr, static_cast<uint16_t>(MessageID::ID_CHAT_LOGOUT_RSP));
+    });
+    if (Json::Reader reader; !reader.parse(data, srcRoot)) {
+        std::cout << "Failed to parse JSON data" << std::endl;
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
     }
-
-    if (!MysqlMgr::getInstance()->getFriendApplyCount(uid, count)) {
-        return 0;
+    root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
+    // 只能登出当前会话绑定的用户
+    const int uid = session->getUserId();
+    const std::string token = session->getToken();
+    if (token.empty() || srcRoot["uid"].asString() != std::to_string(uid)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_UID_ERROR);
+        return;
     }
-
-    if (!FriendCache::getInstance()->updateFriendApplyCount(uid, count)) {
-        std::cout << "Friend apply count error" << std::endl;
+    // Redis 不可用时吊销只在本服务生效
+    if (!TokenAuth::getInstance()->revoke(token)) {
+        std::cout << "Logout [uid: " << uid << "] publish revoke failed" << std::endl;
     }
+    session->setToken("");
+}
 
-    return count < 0 ? 0 : count;
+int ChatLogicSystem::getApplyFriendCount(const int uid) {
+    return CounterService::getInstance()->friendApplyCount(uid);
 }
 
 void ChatLogicSystem::firstPageInfoHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
@@ -660,6 +878,44 @@ bool ChatLogicSystem::searchUserBaseInfo(UserBaseInfo& userInfo) {
     return true;
 }
 
+bool ChatLogicSystem::getUserBaseInfos(const std::vector<int>& uids, std::vector<UserBaseInfo>& result) {
+    if (!UserInfoCache::getBaseInfos(uids, result)) {
+        // Redis 不可用时全部按未命中处理，由 MySQL 返回
+        result.assign(uids.size(), UserBaseInfo{});
+    }
+    // 未命中的 uid 去重后一次查询 MySQL
+    std::unordered_map<int, std::vector<size_t>> missing;
+    std::vector<int> missUids;
+    for (size_t i = 0; i < uids.size(); i++) {
+        if (uids[i] < 0 || result[i].uid >= 0) {
+            continue;
+        }
+        auto& slots = missing[uids[i]];
+        if (slots.empty()) {
+            missUids.push_back(uids[i]);
+        }
+        slots.push_back(i);
+    }
+    if (missUids.empty()) {
+        return true;
+    }
+    std::vector<UserBaseInfo> rows;
+    if (!MysqlMgr::getInstance()->selectUserBaseInfos(missUids, rows)) {
+        return false;
+    }
+    for (const auto& row : rows) {
+        if (const auto it = missing.find(row.uid); it != missing.end()) {
+            for (const size_t i : it->second) {
+                result[i] = row;
+            }
+        }
+    }
+    if (!UserInfoCache::updateBaseInfos(rows)) {
+        std::cout << "Failed to update " << rows.size() << " user infos" << std::endl;
+    }
+    return true;
+}
+
 void ChatLogicSystem::searchUserHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
                                        const std::string &data) {
     Json::Value root;
@@ -777,16 +1033,26 @@ void ChatLogicSystem::friendApplyHandle(const std::shared_ptr<Session> &session,
     if (srcRoot.isMember("message")) {
         msg = srcRoot["message"].asString();
     }
-    if (!MysqlMgr::getInstance()->updateFriendApply(from, to, 0, msg)) {
+    int affected = 0;
+    if (!MysqlMgr::getInstance()->updateFriendApply(from, to, 0, msg, affected)) {
         root["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
         return;
     }
-    FriendCache::getInstance()->clearFriendApplyCount(to);
+    // 新建的申请计数加一；重复申请时原申请可能已过期或被拒绝，由下次读取重新计算
+    if (affected == 1) {
+        CounterService::getInstance()->addFriendApply(to, 1);
+    }
+    else {
+        CounterService::getInstance()->invalidateFriendApply(to);
+    }
 
     // 通知在线用户
     notifyOnlineUserMsg(to, data, MessageID::ID_NOTIFY_FRIEND_APPLY,
             [from, to, &data](const std::string& serverName) {
         // 不同服务器调用 grpc 请求
+        if (ChatGrpcClient::getInstance()->DeliverToPeer(serverName, to, MessageID::ID_NOTIFY_FRIEND_APPLY, data)) {
+            return;
+        }
         ChatServiceReq request;
         request.set_from_uid(from);
         request.set_to_uid(to);
@@ -824,20 +1090,26 @@ void ChatLogicSystem::friendAuthHandle(const std::shared_ptr<Session> &session,
         return;
     }
     if (const auto result = srcRoot["result"].asInt(); result != 1) {
-        // 已拒绝好友，直接更新数据库删除缓存
-        MysqlMgr::getInstance()->updateFriendApply(applyInfo.uid, applyInfo.friendId,
-            static_cast<int>(FriendApplyStatus::REJECT));
-        FriendCache::getInstance()->clearFriendApplyCount(applyInfo.friendId);
+        // 拒绝好友：只有确实拒绝了一条待处理且未过期的申请时，被申请人的计数减一
+        int affected = 0;
+        if (MysqlMgr::getInstance()->resolvePendingFriendApply(applyInfo.uid, applyInfo.friendId,
+                static_cast<int>(FriendApplyStatus::REJECT), affected) && affected == 1) {
+            CounterService::getInstance()->addFriendApply(applyInfo.friendId, -1);
+        }
         return;
     }
 
     // 更新好友申请状态，并同步创建双向好友关系
-    if (!MysqlMgr::getInstance()->createFriendRelation(applyInfo)) {
+    int applyUpdated = 0;
+    if (!MysqlMgr::getInstance()->createFriendRelation(applyInfo, applyUpdated)) {
         root["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
         return;
     }
-    // 清除被申请人的未读计数
-    FriendCache::getInstance()->clearFriendApplyCount(applyInfo.friendId);
+    // 确实处理了一条待处理申请时，被申请人的未处理申请数减一
+    if (applyUpdated == 1) {
+        CounterService::getInstance()->addFriendApply(applyInfo.friendId, -1);
+    }
+    invalidateConversationLists({applyInfo.uid, applyInfo.friendId});
 
     // 推送好友请求信息
     notifyOnlineUserMsg(applyInfo.uid, data, MessageID::ID_NOTIFY_FRIEND_AUTH,
@@ -877,6 +1149,7 @@ void ChatLogicSystem::updateFriendHandle(const std::shared_ptr<Session> &session
         // 单方面删除好友关系
         FriendCache::getInstance()->deleteFriendSet(uid, info.friendId);
     }
+    invalidateConversationLists({uid});
 }
 
 void ChatLogicSystem::updateUserInfoHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
@@ -919,6 +1192,19 @@ void ChatLogicSystem::updateUserInfoHandle(const std::shared_ptr<Session> &sessi
         || !RedisMgr::getInstance()->del(UID_INDEX_MAP_PREFIX + oldInfo.name.value())) {
         std::cout << "Failed to delete user info, waiting to add delay task" << std::endl;
     }
+
+    // 昵称、头像内联在单聊对方的会话列表中，丢弃这些列表
+    if (conv_lists_ && (info.name.has_value() || info.avatarUrl.has_value())) {
+        if (std::vector<ConversationInfo> convs; MysqlMgr::getInstance()->selectUserConversations(uid, convs)) {
+            std::vector<int> peers;
+            for (const auto& conv : convs) {
+                if (const int other = conv.getOtherUid(); other >= 0 && other != uid) {
+                    peers.push_back(other);
+                }
+            }
+            invalidateConversationLists(peers);
+        }
+    }
 }
 
 // todo 后续优化性能
@@ -981,6 +1267,8 @@ void ChatLogicSystem::conversationCreateHandle(const std::shared_ptr<Session> &s
         return;
     }
 
+    invalidateConversationLists({convInfo.uid, convInfo.friendId});
+
     // 入库成功后生成回复消息内容
     convInfo.status = 0;
     convInfo.isTop = 0;
@@ -991,22 +1279,82 @@ void ChatLogicSystem::conversationCreateHandle(const std::shared_ptr<Session> &s
     convInfo.toJson(root);
 }
 
-void ChatLogicSystem::getConversationTitleInfo(const ConversationInfo& convInfo, Json::Value &root) {
-    const auto otherUid = convInfo.getOtherUid();
-    if (otherUid < 0) {
-        std::cout << "getConversationTitleInfo get other uid error" << std::endl;
+void ChatLogicSystem::fillConversationTitleInfos(std::vector<ConversationInfo>& convs) {
+    // 群聊标题即群名称，已在会话信息中；单聊收集对方 uid 一次批量查询
+    std::vector<int> others;
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < convs.size(); i++) {
+        if (convs[i].convType == static_cast<int8_t>(ConvType::GROUP_CHAT)) {
+            continue;
+        }
+        const auto otherUid = convs[i].getOtherUid();
+        if (otherUid < 0) {
+            std::cout << "fillConversationTitleInfos get other uid error: " << convs[i].convId << std::endl;
+            continue;
+        }
+        others.push_back(otherUid);
+        positions.push_back(i);
+    }
+    std::vector<UserBaseInfo> users;
+    if (!getUserBaseInfos(others, users)) {
         return;
     }
-    UserBaseInfo userBaseInfo;
-    userBaseInfo.uid = otherUid;
-    if (!searchUserBaseInfo(userBaseInfo)) {
+    for (size_t i = 0; i < positions.size(); i++) {
+        if (users[i].uid < 0) {
+            continue;
+        }
+        auto& convInfo = convs[positions[i]];
+        if (users[i].name.has_value()) {
+            convInfo.title = users[i].name.value();
+        }
+        if (users[i].avatarUrl.has_value()) {
+            convInfo.avatarUrl = users[i].avatarUrl.value();
+        }
+    }
+}
+
+bool ChatLogicSystem::loadConversationList(const int uid, std::vector<ConversationInfo>& result) {
+    if (ConversationCache::getInstance()->loadList(uid, result)) {
+        return true;
+    }
+    if (!MysqlMgr::getInstance()->selectUserConversations(uid, result)) {
+        return false;
+    }
+    // 对方资料只在冷加载时批量查询一次，之后内联在列表中
+    fillConversationTitleInfos(result);
+    // 快照可能缺少尚未写回 MySQL 的消息和已读，有未应用的更新时 Redis 只短暂缓存
+    ConversationCache::getInstance()->storeList(uid, result);
+    return true;
+}
+
+void ChatLogicSystem::updateConversationLists(const MessageInfo& info) const {
+    if (!conv_lists_) {
         return;
     }
-    if (userBaseInfo.name.has_value()) {
-        root["title"] = userBaseInfo.name.value();
+    const auto apply = [this, &info](const std::vector<int>& members) {
+        for (const int uid : members) {
+            conv_lists_->onMessage(uid, info);
+        }
+        ConversationCache::getInstance()->applyMessage(members, info);
+    };
+    if (isGroupConvId(info.convId.value_or(""))) {
+        apply(*GroupMemberCache::getInstance()->getMembers(info.convId.value()));
+    }
+    else if (info.fromUid == info.toUid) {
+        apply({info.fromUid});
+    }
+    else {
+        apply({info.fromUid, info.toUid});
+    }
+}
+
+void ChatLogicSystem::invalidateConversationLists(const std::vector<int>& uids) const {
+    if (!conv_lists_) {
+        return;
     }
-    if (userBaseInfo.avatarUrl.has_value()) {
-        root["avatar_url"] = userBaseInfo.avatarUrl.value();
+    for (const int uid : uids) {
+        conv_lists_->invalidate(uid);
+        ConversationCache::getInstance()->invalidate(uid);
     }
 }
 
@@ -1029,19 +1377,298 @@ void ChatLogicSystem::conversationListFetchHandle(const std::shared_ptr<Session>
     if (sinceTime.empty()) {
         sinceTime = "0000-00-00 00:00:00";
     }
-    const std::vector<ConversationInfo> searchResult = MysqlMgr::getInstance()->selectConversationList(uid, sinceTime);
-    if (searchResult.empty()) {
+
+    // 增量同步（或关闭缓存时）查询 MySQL
+    if (!conv_lists_ || sinceTime != "0000-00-00 00:00:00") {
+        std::vector<ConversationInfo> searchResult = MysqlMgr::getInstance()->selectConversationList(uid, sinceTime);
+        if (searchResult.empty()) {
+            root["error"] = static_cast<int32_t>(ErrorCodes::FRIEND_APPLY_NOT_EXISTS);
+            return;
+        }
+
+        for (auto& searchInfo : searchResult) {
+            searchInfo.uid = uid;
+        }
+        fillConversationTitleInfos(searchResult);
+        for (const auto& searchInfo : searchResult) {
+            Json::Value info;
+            searchInfo.toJson(info);
+            root["data"].append(info);
+        }
+        return;
+    }
+
+    const auto cursor = srcRoot["cursor"].asString();
+    int64_t cursorActivity = 0;
+    if (std::string cursorConv; !cursor.empty()
+        && !ConversationListCache::decodeCursor(cursor, cursorActivity, cursorConv)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+    const int limit = srcRoot.isMember("limit")
+        ? std::clamp(srcRoot["limit"].asInt(), 1, MAX_CONV_LIST_PAGE) : DEFAULT_CONV_LIST_PAGE;
+    std::vector<ConversationInfo> page;
+    std::string nextCursor;
+    if (!conv_lists_->fetch(uid, cursor, limit, page, nextCursor)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
+        return;
+    }
+    if (page.empty() && cursor.empty()) {
         root["error"] = static_cast<int32_t>(ErrorCodes::FRIEND_APPLY_NOT_EXISTS);
         return;
     }
 
-    for (auto& searchInfo : searchResult) {
+    for (const auto& conv : page) {
         Json::Value info;
-        searchInfo.toJson(info);
-        searchInfo.uid = uid;
-        getConversationTitleInfo(searchInfo, info);
+        conv.toJson(info);
         root["data"].append(info);
     }
+    root["next_cursor"] = nextCursor;
+    root["has_more"] = nextCursor.empty() ? 0 : 1;
+}
+
+bool ChatLogicSystem::parseUids(const Json::Value &array, std::vector<int> &uids) {
+    if (!array.isNull() && !array.isArray()) {
+        return false;
+    }
+    uids.reserve(array.size());
+    for (const auto& item : array) {
+        if (!item.isString() && !item.isInt()) {
+            return false;
+        }
+        const std::string value = item.asString();
+        int uid = 0;
+        const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), uid);
+        if (ec != std::errc() || end != value.data() + value.size() || uid < 0) {
+            return false;
+        }
+        uids.push_back(uid);
+    }
+    return true;
+}
+
+void ChatLogicSystem::groupCreateHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
+    const std::string &data) {
+    Json::Value root;
+    Json::Value srcRoot;
+    Defer defer([&root, session]() {
+        const std::string jsonStr = root.toStyledString();
+        session->asyncSend(jsonStr, static_cast<uint16_t>(MessageID::ID_GROUP_CREATE_RSP));
+    });
+    if (Json::Reader reader; !reader.parse(data, srcRoot)) {
+        std::cout << "Failed to parse JSON data" << std::endl;
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+    root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
+
+    ConversationInfo convInfo;
+    convInfo.fromJson(srcRoot);
+    std::vector<int> members;
+    if (convInfo.uid < 0 || !parseUids(srcRoot["members"], members)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+    // 只能以本会话登录用户的身份建群，群主即创建者
+    if (convInfo.uid != session->getUserId()) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_UID_ERROR);
+        return;
+    }
+    if (members.size() + 1 > groupMaxMembers_) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::GROUP_MEMBER_LIMIT);
+        return;
+    }
+    // 与单聊建会话的规则一致：只能拉好友或允许陌生人私聊的用户入群
+    for (const auto member : members) {
+        if (!checkConversationValid(convInfo.uid, member)) {
+            root["error"] = static_cast<int32_t>(ErrorCodes::GROUP_NO_PERMISSION);
+            root["friend_id"] = std::to_string(member);
+            return;
+        }
+    }
+
+    convInfo.convType = static_cast<int8_t>(ConvType::GROUP_CHAT);
+    convInfo.generateConvId();
+    convInfo.ownerUid = convInfo.uid;
+
+    std::string result;
+    if (!MysqlMgr::getInstance()->createGroup(convInfo, members, result)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
+        return;
+    }
+    GroupMemberCache::getInstance()->publishMembersChanged(convInfo.convId);
+    members.push_back(convInfo.uid);
+    invalidateConversationLists(members);
+
+    convInfo.status = 0;
+    convInfo.isTop = 0;
+    convInfo.isMute = 0;
+    convInfo.lastMsgContent = "";
+    convInfo.lastTime = "";
+    convInfo.updateTime = result;
+    convInfo.toJson(root);
+}
+
+void ChatLogicSystem::groupMemberUpdateHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
+    const std::string &data) {
+    Json::Value root;
+    Json::Value srcRoot;
+    Defer defer([&root, session]() {
+        const std::string jsonStr = root.toStyledString();
+        session->asyncSend(jsonStr, static_cast<uint16_t>(MessageID::ID_GROUP_MEMBER_UPDATE_RSP));
+    });
+    if (Json::Reader reader; !reader.parse(data, srcRoot)) {
+        std::cout << "Failed to parse JSON data" << std::endl;
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+    root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
+
+    // 操作者即本会话登录用户，请求中的 uid 只用于校验
+    const int uid = session->getUserId();
+    if (srcRoot["uid"].asString() != std::to_string(uid)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_UID_ERROR);
+        return;
+    }
+    const auto convId = srcRoot["conv_id"].asString();
+    const auto op = srcRoot["op"].asInt();   // 1-邀请成员；2-移除成员（移除自己即退群）
+    root["conv_id"] = convId;
+    root["op"] = op;
+    std::vector<int> targets;
+    if (!parseUids(srcRoot["members"], targets)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+
+    int ownerUid = -1;
+    if (!isGroupConvId(convId) || !MysqlMgr::getInstance()->selectGroupOwner(convId, ownerUid)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::GROUP_NOT_EXISTS);
+        return;
+    }
+    const auto members = GroupMemberCache::getInstance()->getMembers(convId);
+    if (!std::binary_search(members->begin(), members->end(), uid)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::GROUP_NOT_MEMBER);
+        return;
+    }
+
+    if (op == 1) {
+        if (members->size() + targets.size() > groupMaxMembers_) {
+            root["error"] = static_cast<int32_t>(ErrorCodes::GROUP_MEMBER_LIMIT);
+            return;
+        }
+        for (const auto member : targets) {
+            if (!checkConversationValid(uid, member)) {
+                root["error"] = static_cast<int32_t>(ErrorCodes::GROUP_NO_PERMISSION);
+                root["friend_id"] = std::to_string(member);
+                return;
+            }
+        }
+        if (!MysqlMgr::getInstance()->addGroupMembers(convId, targets)) {
+            root["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
+            return;
+        }
+    }
+    else if (op == 2) {
+        // 群主可以移除其他人但不能退出（群不能没有群主），普通成员只能退出
+        for (const auto member : targets) {
+            if ((member != uid && uid != ownerUid) || member == ownerUid) {
+                root["error"] = static_cast<int32_t>(ErrorCodes::GROUP_NO_PERMISSION);
+                root["friend_id"] = std::to_string(member);
+                return;
+            }
+        }
+        // 一个事务内移除，失败时成员不变，不发布变更
+        if (!MysqlMgr::getInstance()->removeGroupMembers(convId, targets)) {
+            root["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
+            return;
+        }
+    }
+    else {
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+    GroupMemberCache::getInstance()->publishMembersChanged(convId);
+    invalidateConversationLists(targets);
+}
+
+void ChatLogicSystem::fanoutGroupMsg(const std::string &convId, const int fromUid, MessageID msgId,
+    const std::string &data) const {
+    const auto members = GroupMemberCache::getInstance()->getMembers(convId);
+
+    // 本机在线成员直接推送，所有会话共享同一帧
+    std::shared_ptr<SendNode> frame;
+    std::vector<int> remote;
+    for (const int uid : *members) {
+        if (uid == fromUid) {
+            continue;
+        }
+        if (const auto toSession = UserMgr::getInstance()->getSession(uid)) {
+            if (!frame) {
+                frame = std::make_shared<SendNode>(data.data(), static_cast<uint16_t>(data.size()),
+                    static_cast<uint16_t>(msgId));
+            }
+            toSession->asyncSend(frame);
+            continue;
+        }
+        remote.push_back(uid);
+    }
+    if (remote.empty()) {
+        return;
+    }
+
+    // 其余成员按所在服务器分组，每台对端一次调用
+    // 离线成员合并为一次流水线写入收件箱
+    for (auto& [serverName, uids] : UserRouteCache::getInstance()->groupByServer(remote)) {
+        if (serverName.empty()) {
+            OfflineInbox::getInstance()->appendBatch(uids, static_cast<uint16_t>(msgId), data);
+            continue;
+        }
+        if (serverName == selfServerName_) {
+            for (const int uid : uids) {
+                UserRouteCache::getInstance()->invalidate(uid);  // 本地已无会话，路由过期
+            }
+            OfflineInbox::getInstance()->appendBatch(uids, static_cast<uint16_t>(msgId), data);
+            continue;
+        }
+        auto request = std::make_shared<FanOutReq>();
+        request->set_conv_id(convId);
+        request->set_from_uid(fromUid);
+        request->set_msg_id(static_cast<int32_t>(msgId));
+        request->set_json(data);
+        request->mutable_to_uids()->Add(uids.begin(), uids.end());
+        // 对端回报的离线成员由对端写入收件箱，这里只失效路由；调用失败则由本端转存
+        ChatGrpcClient::getInstance()->FanOutAsync(serverName, request, [](const std::vector<int>& offlineUids) {
+            for (const int uid : offlineUids) {
+                UserRouteCache::getInstance()->invalidate(uid);
+            }
+        }, [request](const std::vector<int>& failedUids) {
+            OfflineInbox::getInstance()->appendBatch(failedUids, static_cast<uint16_t>(request->msg_id()),
+                request->json());
+        });
+    }
+}
+
+void ChatLogicSystem::notifyResentCorrection(const MessageInfo& stored) {
+    // 与发送方收到的 ID_NOTIFY_MSG_RESULT 相同，另带 from_uid 供接收方定位消息
+    Json::Value rsp;
+    rsp["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
+    rsp["msg_id"] = stored.msgId;
+    rsp["from_uid"] = stored.fromUid;
+    rsp["server_id"] = static_cast<Json::Int64>(stored.servId);
+    rsp["conv_id"] = stored.convId.value_or("");
+    const std::string data = Json::FastWriter().write(rsp);
+
+    if (isGroupConvId(stored.convId.value_or(""))) {
+        fanoutGroupMsg(stored.convId.value(), stored.fromUid, MessageID::ID_NOTIFY_MSG_RESULT, data);
+        return;
+    }
+    notifyOnlineUserMsg(stored.toUid, data, MessageID::ID_NOTIFY_MSG_RESULT,
+        [toUid = stored.toUid, &data](const std::string& serverName) {
+            if (!ChatGrpcClient::getInstance()->DeliverToPeer(serverName, toUid,
+                MessageID::ID_NOTIFY_MSG_RESULT, data)) {
+                OfflineInbox::getInstance()->append(toUid, static_cast<uint16_t>(MessageID::ID_NOTIFY_MSG_RESULT), data);
+            }
+        });
 }
 
 void ChatLogicSystem::chatMsgHandle(const std::shared_ptr<Session> &session, uint16_t msgId, const std::string &data) {
@@ -1053,7 +1680,11 @@ void ChatLogicSystem::chatMsgHandle(const std::shared_ptr<Session> &session, uin
         session->asyncSend(err.toStyledString(), static_cast<uint16_t>(MessageID::ID_CHAT_MSG_RSP));
         return;
     }
-    Defer defer([&root, &session]() {
+    bool ackAfterDurable = false;
+    Defer defer([&root, &session, &ackAfterDurable]() {
+        if (ackAfterDurable) {
+            return;
+        }
         session->asyncSend(root.toStyledString(), static_cast<uint16_t>(MessageID::ID_CONV_LIST_RSP));
     });
 
@@ -1062,28 +1693,148 @@ void ChatLogicSystem::chatMsgHandle(const std::shared_ptr<Session> &session, uin
     info.fromJson(srcRoot);
     info.status = static_cast<uint8_t>(MessageStatus::SENDING);
 
-    // 推入批量写入队列
-    size_t shard_idx = std::hash<std::string>{}(session->getSessionId()) % shards_.size();
-    auto node = std::make_shared<ChatMsgNode>(info, session);
-    batch_writer_->bufferAt(shard_idx)->push(std::move(node));
+    // 群消息只校验发送方是否为成员，接收方由扇出决定
+    const bool isGroup = isGroupConvId(info.convId.value_or(""));
+    if (isGroup) {
+        if (!GroupMemberCache::getInstance()->isMember(info.convId.value(), info.fromUid)) {
+            root["error"] = static_cast<int32_t>(ErrorCodes::GROUP_NOT_MEMBER);
+            root["msg_id"] = info.msgId;
+            root["conv_id"] = info.convId.value();
+            return;
+        }
+        info.toUid = -1;
+    }
+
+    // 分配 serverId，随确认下发，落库时不再回查；客户端重发且第一次的消息仍在最近消息环中时沿用原 serverId，
+    // 接收方收到的通知与发送方的确认一致，环中已淘汰的重发在落库时由重复回调向双方更正
+    if (int64_t stored = 0; recent_msgs_ && recent_msgs_->findResent(info, stored)) {
+        info.servId = stored;
+    }
+    else {
+        info.servId = msg_id_gen_->next();
+    }
+    srcRoot["server_id"] = static_cast<Json::Int64>(info.servId);
+    const std::string notifyData = Json::FastWriter().write(srcRoot);
 
-    // 立即返回成功确认 (不含 serverId)
-    root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
     root["msg_id"] = info.msgId;
     root["conv_id"] = info.convId.value_or("");
 
-    // 通知接收方 (不依赖 serverId)
-    notifyOnlineUserMsg(info.toUid, data, MessageID::ID_NOTIFY_CHAT_MSG,
-        [&info, data](const std::string& serverName) {
+    // 未落库消息的内存超过硬上限时拒绝，不扇出，客户端按 retry_after_ms 重发；超过软上限时照常接收，
+    // ACK 带上 retry_after_ms 要求客户端降速
+    auto node = std::make_shared<ChatMsgNode>(info, session);
+    const auto admission = batch_writer_->admit(node);
+    if (admission == MemoryBudget::Admission::REJECT) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_MSG_BUSY);
+        root["retry_after_ms"] = batch_writer_->busyRetryAfterMs();
+        return;
+    }
+    if (admission == MemoryBudget::Admission::SOFT) {
+        root["retry_after_ms"] = batch_writer_->busyRetryAfterMs();
+    }
+    root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
+    root["server_id"] = static_cast<Json::Int64>(info.servId);
+
+    // 推入批量写入队列，开启 WAL 时确认在消息落盘后由 WAL 提交线程发送
+    // 按会话路由，同一会话的消息由同一个写入线程串行刷写
+    const size_t shard_idx = batch_writer_->shardOf(info.convId.value_or(""));
+    if (batch_writer_->walEnabled()) {
+        ackAfterDurable = true;
+        batch_writer_->submit(shard_idx, std::move(node), [session, ack = root.toStyledString()]() {
+            session->asyncSend(ack, static_cast<uint16_t>(MessageID::ID_CONV_LIST_RSP));
+        });
+    }
+    else {
+        batch_writer_->submit(shard_idx, std::move(node));
+    }
+    // 尚未落库的消息也能从最近消息缓存中拉到
+    if (recent_msgs_) {
+        recent_msgs_->append(info);
+    }
+    updateConversationLists(info);
+
+    if (isGroup) {
+        fanoutGroupMsg(info.convId.value(), info.fromUid, MessageID::ID_NOTIFY_CHAT_MSG, notifyData);
+        return;
+    }
+
+    // 通知接收方，消息带上 serverId
+    notifyOnlineUserMsg(info.toUid, notifyData, MessageID::ID_NOTIFY_CHAT_MSG,
+        [&info, &notifyData](const std::string& serverName) {
+            // 优先走服务器间批量投递流，不可用时退回单次 RPC
+            if (ChatGrpcClient::getInstance()->DeliverToPeer(serverName, info.toUid,
+                MessageID::ID_NOTIFY_CHAT_MSG, notifyData)) {
+                return;
+            }
             ChatServiceReq request;
             request.set_from_uid(info.fromUid);
             request.set_to_uid(info.toUid);
-            request.set_json(data);
-            ChatGrpcClient::getInstance()->SendChatMsg(serverName, request);
+            request.set_json(notifyData);
+            ChatGrpcClient::getInstance()->SendChatMsgAsync(serverName, request, [toUid = info.toUid, notifyData]() {
+                OfflineInbox::getInstance()->append(toUid, static_cast<uint16_t>(MessageID::ID_NOTIFY_CHAT_MSG), notifyData);
+            });
         });
 }
 
 
+bool ChatLogicSystem::fetchHistoryAfter(const std::string& convId, const int64_t since, const int limit,
+                                        std::vector<MessageInfo>& result) const {
+    // 最新的页由缓存返回；更早的页查询 MySQL，不满一页时用缓存补上尚未落库的消息
+    if (recent_msgs_ && recent_msgs_->fetch(convId, since, limit, result)) {
+        return true;
+    }
+    result = MysqlMgr::getInstance()->selectMessageList(convId, since, limit);
+    if (std::vector<MessageInfo> tail; recent_msgs_ && static_cast<int>(result.size()) < limit
+        && recent_msgs_->fetch(convId, result.empty() ? since : result.back().servId,
+            limit - static_cast<int>(result.size()), tail)) {
+        result.insert(result.end(), tail.begin(), tail.end());
+    }
+    return true;
+}
+
+bool ChatLogicSystem::fetchHistoryBefore(const std::string& convId, const int64_t before, const int limit,
+                                         std::vector<MessageInfo>& result) const {
+    if (recent_msgs_ && recent_msgs_->fetchBefore(convId, before, limit, result)) {
+        return true;
+    }
+    if (!MysqlMgr::getInstance()->selectMessagesBefore(convId, before, limit, result)) {
+        return false;
+    }
+    // 尚未落库的消息比已落库的新，补到末尾后只保留游标之前最新的 limit 条
+    if (std::vector<MessageInfo> tail; recent_msgs_ && !result.empty()
+        && recent_msgs_->fetch(convId, result.back().servId, limit, tail)) {
+        for (auto& msg : tail) {
+            if (before > 0 && msg.servId >= before) {
+                break;
+            }
+            result.push_back(std::move(msg));
+        }
+        if (static_cast<int>(result.size()) > limit) {
+            result.erase(result.begin(), result.end() - limit);
+        }
+    }
+    return true;
+}
+
+bool ChatLogicSystem::fetchHistoryAround(const std::string& convId, const int64_t anchor, const int older,
+                                         const int newer, std::vector<MessageInfo>& result) const {
+    if (std::vector<MessageInfo> tail; recent_msgs_ && recent_msgs_->fetchBefore(convId, anchor, older, result)
+        && recent_msgs_->fetch(convId, anchor - 1, newer, tail)) {
+        result.insert(result.end(), tail.begin(), tail.end());
+        return true;
+    }
+    if (!MysqlMgr::getInstance()->selectMessagesAround(convId, anchor, older, newer, result)) {
+        return false;
+    }
+    const auto newerCount = result.end() - std::lower_bound(result.begin(), result.end(), anchor,
+        [](const MessageInfo& m, const int64_t id) { return m.servId < id; });
+    if (std::vector<MessageInfo> tail; recent_msgs_ && newerCount < newer
+        && recent_msgs_->fetch(convId, newerCount > 0 ? result.back().servId : anchor - 1,
+            newer - static_cast<int>(newerCount), tail)) {
+        result.insert(result.end(), tail.begin(), tail.end());
+    }
+    return true;
+}
+
 void ChatLogicSystem::historyChatMsgFetchHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
     const std::string &data) {
     Json::Value root;
@@ -1100,21 +1851,86 @@ void ChatLogicSystem::historyChatMsgFetchHandle(const std::shared_ptr<Session> &
     root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
 
     const auto convId = srcRoot["conv_id"].asString();
-    const auto sinceMsgId = srcRoot["since_msg_id"].asInt();
-    const auto limit = srcRoot["limit"].asInt();
-    const std::vector<MessageInfo> searchResult = MysqlMgr::getInstance()->selectMessageList(convId, sinceMsgId, limit);
-    if (searchResult.empty()) {
-        root["has_more"] = 0;
+    auto direction = HistoryPage::Direction::AFTER;
+    if (srcRoot.isMember("direction") && !HistoryPage::parseDirection(srcRoot["direction"].asString(), direction)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+    const int limit = srcRoot.isMember("limit")
+        ? std::clamp(srcRoot["limit"].asInt(), 1, MAX_HISTORY_PAGE) : DEFAULT_HISTORY_PAGE;
+    size_t maxBytes = MAX_HISTORY_BYTES;
+    if (const auto requested = srcRoot["max_bytes"].asInt64(); requested > 0) {
+        maxBytes = std::min(maxBytes, static_cast<size_t>(requested));
+    }
+
+    // 每个方向多取一条，判断该方向是否还有更多
+    const auto [older, newer] = HistoryPage::split(direction, limit);
+    int64_t cursor = 0;
+    std::vector<MessageInfo> searchResult;
+    bool ok = false;
+    switch (direction) {
+        case HistoryPage::Direction::AFTER:
+            cursor = srcRoot["since_msg_id"].asInt64();   // serverId
+            ok = fetchHistoryAfter(convId, cursor, newer + 1, searchResult);
+            break;
+        case HistoryPage::Direction::BEFORE:
+            cursor = srcRoot["before_msg_id"].asInt64();
+            ok = fetchHistoryBefore(convId, cursor, older + 1, searchResult);
+            break;
+        case HistoryPage::Direction::AROUND:
+            cursor = srcRoot["around_msg_id"].asInt64();
+            ok = cursor > 0 && fetchHistoryAround(convId, cursor, older + 1, newer + 1, searchResult);
+            break;
+    }
+    if (!ok) {
+        root["error"] = static_cast<int32_t>(cursor > 0 || direction != HistoryPage::Direction::AROUND
+            ? ErrorCodes::MYSQL_ERROR : ErrorCodes::ERROR_REQUEST_JSON);
         return;
     }
 
-    for (auto& searchInfo : searchResult) {
+    // pivot 为第一条不早于游标的消息；去掉两侧的探测条
+    const auto pivot = direction == HistoryPage::Direction::BEFORE ? searchResult.size()
+        : static_cast<size_t>(std::lower_bound(searchResult.begin(), searchResult.end(), cursor,
+            [](const MessageInfo& m, const int64_t id) { return m.servId < id; }) - searchResult.begin());
+    bool hasOlder = direction == HistoryPage::Direction::AFTER ? cursor > 0 : pivot > static_cast<size_t>(older);
+    bool hasNewer = direction == HistoryPage::Direction::BEFORE ? cursor > 0
+        : searchResult.size() - pivot > static_cast<size_t>(newer);
+    const size_t first = hasOlder && direction != HistoryPage::Direction::AFTER ? 1 : 0;
+    const size_t last = searchResult.size() - (hasNewer && direction != HistoryPage::Direction::BEFORE ? 1 : 0);
+
+    // 响应帧长度为 uint16，按序列化后的字节数裁剪，被裁掉的一侧由下一页继续
+    std::vector<Json::Value> items;
+    std::vector<size_t> sizes;
+    items.reserve(last - first);
+    sizes.reserve(last - first);
+    for (size_t i = first; i < last; i++) {
         Json::Value info;
-        searchInfo.toJson(info);
-        root["data"].append(info);
+        searchResult[i].toJson(info);
+        // 响应中每行比单独序列化多两层缩进
+        const std::string styled = info.toStyledString();
+        sizes.push_back(styled.size() + HISTORY_ITEM_INDENT * std::count(styled.begin(), styled.end(), '\n'));
+        items.push_back(std::move(info));
+    }
+    const auto [keepFirst, keepLast] = HistoryPage::fit(sizes, direction, pivot - std::min(pivot, first), maxBytes);
+    hasOlder = hasOlder || keepFirst > 0;
+    hasNewer = hasNewer || keepLast < items.size();
+    for (size_t i = keepFirst; i < keepLast; i++) {
+        root["data"].append(std::move(items[i]));
+    }
+
+    root["has_older"] = hasOlder ? 1 : 0;
+    root["has_newer"] = hasNewer ? 1 : 0;
+    switch (direction) {
+        case HistoryPage::Direction::AFTER:
+            root["has_more"] = hasNewer ? 1 : 0;
+            break;
+        case HistoryPage::Direction::BEFORE:
+            root["has_more"] = hasOlder ? 1 : 0;
+            break;
+        case HistoryPage::Direction::AROUND:
+            root["has_more"] = hasOlder || hasNewer ? 1 : 0;
+            break;
     }
-
-    root["has_more"] = searchResult.size() < limit ? 0 : 1;
 }
 
 void ChatLogicSystem::msgStatusUpdateHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
@@ -1134,10 +1950,138 @@ void ChatLogicSystem::msgStatusUpdateHandle(const std::shared_ptr<Session> &sess
 
     MessageStatusInfo info;
     info.fromJson(srcRoot);
-    if (!MysqlMgr::getInstance()->updateConvMessagesStatus(info)) {
+    if (!info.convId.has_value() || info.uid < 0 || info.lastMsgId < 0 || info.status < 0) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+    // 只能推进自己的水位，否则可以替他人标记已读并以其名义发送回执
+    if (info.uid != session->getUserId()) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_UID_ERROR);
+        return;
+    }
+    // 只合并到内存水位，由后台批量刷写并通知对方
+    read_watermarks_->update(info);
+    // 会话列表的未读数原地更新
+    if (conv_lists_ && info.status == static_cast<int8_t>(MessageStatus::IS_READ)) {
+        const int unread = conv_lists_->onRead(info.uid, info.convId.value(), info.lastMsgId, info.count);
+        ConversationCache::getInstance()->applyRead(info.uid, info.convId.value(), unread, info.count);
+    }
+}
+
+void ChatLogicSystem::inboxSyncHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
+    const std::string &data) {
+    Json::Value root;
+    Json::Value srcRoot;
+    Defer defer([&root, session]() {
+        const std::string jsonStr = root.toStyledString();
+        session->asyncSend(jsonStr, static_cast<uint16_t>(MessageID::ID_INBOX_SYNC_RSP));
+    });
+    if (Json::Reader reader; !reader.parse(data, srcRoot)) {
+        std::cout << "Failed to parse JSON data" << std::endl;
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+
+    // 只能同步本会话登录用户的收件箱
+    const auto uid = std::stoi(srcRoot["uid"].asString());
+    if (uid != session->getUserId()) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_UID_ERROR);
+        return;
+    }
+    const auto cursor = srcRoot["cursor"].asString();
+    const int maxLimit = std::max(1, static_cast<int>(OfflineInbox::getInstance()->maxSyncLimit()));
+    const int limit = srcRoot.isMember("limit") ? std::clamp(srcRoot["limit"].asInt(), 1, maxLimit) : maxLimit;
+
+    OfflineInbox::SyncResult result;
+    if (!OfflineInbox::getInstance()->sync(uid, cursor, limit, result)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::REDIS_ERROR);
+        return;
+    }
+    root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
+    root["data"] = Json::arrayValue;
+    for (const auto& entry : result.entries) {
+        Json::Value item;
+        item["id"] = entry.id;
+        item["msg_id"] = entry.msgId;
+        item["json"] = entry.json;
+        root["data"].append(item);
+    }
+    root["cursor"] = result.cursor;
+    root["has_more"] = result.hasMore ? 1 : 0;
+    root["truncated"] = result.truncated ? 1 : 0;
+}
+
+void ChatLogicSystem::messageSearchHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
+    const std::string &data) {
+    Json::Value root;
+    Json::Value srcRoot;
+    Defer defer([&root, session]() {
+        const std::string jsonStr = root.toStyledString();
+        session->asyncSend(jsonStr, static_cast<uint16_t>(MessageID::ID_MSG_SEARCH_RSP));
+    });
+    if (Json::Reader reader; !reader.parse(data, srcRoot)) {
+        std::cout << "Failed to parse JSON data" << std::endl;
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+
+    // 只能搜索本会话登录用户所在的会话
+    const auto uid = std::stoi(srcRoot["uid"].asString());
+    if (uid != session->getUserId()) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_UID_ERROR);
+        return;
+    }
+    if (!search_index_) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::REQUEST_NOT_FOUND);
+        return;
+    }
+    const auto query = srcRoot["query"].asString();
+    const auto convId = srcRoot["conv_id"].asString();
+    const auto before = srcRoot["before_msg_id"].asInt64();   // serverId
+    const int limit = srcRoot.isMember("limit")
+        ? std::clamp(srcRoot["limit"].asInt(), 1, MAX_SEARCH_PAGE) : DEFAULT_SEARCH_PAGE;
+
+    std::vector<ConversationInfo> convs;
+    std::string nextCursor;
+    const bool loaded = conv_lists_
+        ? conv_lists_->fetch(uid, "", std::numeric_limits<int>::max(), convs, nextCursor)
+        : loadConversationList(uid, convs);
+    if (!loaded) {
         root["error"] = static_cast<int32_t>(ErrorCodes::MYSQL_ERROR);
         return;
     }
+    std::vector<std::string> convIds;
+    for (const auto& conv : convs) {
+        if (convId.empty() || conv.convId == convId) {
+            convIds.push_back(conv.convId);
+        }
+    }
+    if (!convId.empty() && convIds.empty()) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::RESOURCE_ACCESS_DENIED);
+        return;
+    }
+
+    // 多取一条判断是否还有下一页
+    std::vector<MessageSearchIndex::Hit> hits;
+    if (!search_index_->search(convIds, query, before, limit + 1, hits)) {
+        root["error"] = static_cast<int32_t>(ErrorCodes::ERROR_REQUEST_JSON);
+        return;
+    }
+    const bool hasMore = hits.size() > static_cast<size_t>(limit);
+    if (hasMore) {
+        hits.resize(limit);
+    }
+    root["error"] = static_cast<int32_t>(ErrorCodes::SUCCESS);
+    root["data"] = Json::arrayValue;
+    for (const auto& hit : hits) {
+        Json::Value item;
+        item["server_id"] = static_cast<Json::Int64>(hit.msgId);
+        item["conv_id"] = hit.convId;
+        item["sender_uid"] = std::to_string(hit.senderUid);
+        item["snippet"] = hit.snippet;
+        root["data"].append(item);
+    }
+    root["has_more"] = hasMore ? 1 : 0;
 }
 
 void ChatLogicSystem::heartbeatHandle(const std::shared_ptr<Session> &session, uint16_t msgId,
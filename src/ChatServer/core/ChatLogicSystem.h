@@ -27,6 +27,8 @@
 #include "ThreadPool.h"
 #include "common/model/UserBaseInfo.h"
 #include "core/ChatMsgNode.h"
+#include "core/DeadLetterQueue.h"
+#include "core/MessageIdGenerator.h"
 
 /**
  * @brief ChatLogicSystem 的性能统计聚合。
@@ -71,6 +73,11 @@ private:
 typedef std::function<void(std::shared_ptr<Session> session, const uint16_t msgId, const std::string& data)> msgHandler;
 
 class BatchWriter;
+class ReadWatermarkTable;
+class RecentMessageCache;
+class ConversationListCache;
+class MessageSearchIndex;
+class LoginAdmission;
 typedef std::function<void(const std::string& serviceName)> notifyOnlineUserCallback;
 
 /**
@@ -116,6 +123,9 @@ public:
 
     void notifyOnlineUserMsg(int uid, const std::string& msg, MessageID msgId, const notifyOnlineUserCallback &callback);
 
+    /// 消息写库死信队列的积压，供运维查询
+    DeadLetterQueue::Stats deadLetterStats() const;
+
 private:
     friend class Singleton<ChatLogicSystem>;
 
@@ -133,10 +143,17 @@ private:
     /// 根据 Session ID 哈希选择目标 shard
     size_t getShardIndex(const std::shared_ptr<LogicNode>& msg) const;
 
-    // 客户端踢人逻辑
-    void kickOnlineUser(int uid) const;
+    // 客户端踢人逻辑，返回用户是否有在线路由
+    bool kickOnlineUser(int uid) const;
+    /**
+     * @brief 登录准入：登录经并发许可和等待队列后在登录线程执行，
+     * 过载时立即回复 CHAT_LOGIN_BUSY 和带抖动的 retry_after_ms。
+     */
+    void admitLogin(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data) const;
     // 登录逻辑
     void loginHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data) const;
+    // 登出，吊销当前会话的 token
+    void logoutHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data) const;
 
     static int getApplyFriendCount(int uid);
     void firstPageInfoHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
@@ -155,6 +172,12 @@ private:
     // 搜索好友用户
     static std::string getSearchKey(UserBaseInfo& userInfo);
     static bool searchUserBaseInfo(UserBaseInfo& userInfo);
+    /**
+     * @brief 批量查询用户基础信息：Redis 一次 MGET，未命中的 uid 一次 IN 查询 MySQL 并流水线回填 Redis。
+     * @param result 与 uids 一一对应（保持输入顺序），查不到的用户 uid 为 -1
+     * @return MySQL 查询失败时返回 false
+     */
+    static bool getUserBaseInfos(const std::vector<int>& uids, std::vector<UserBaseInfo>& result);
     void searchUserHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
 
     // 获取好友申请列表
@@ -175,13 +198,69 @@ private:
     static bool checkConversationValid(int uid, int other);
     void conversationCreateHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
 
-    static void getConversationTitleInfo(const ConversationInfo& convInfo, Json::Value& root);
+    /// 单聊会话以对方昵称、头像作为标题（批量查询对方资料），群聊标题即群名称
+    static void fillConversationTitleInfos(std::vector<ConversationInfo>& convs);
+    /// 冷加载用户的会话列表：先读 Redis，未命中再查 MySQL 并回填 Redis
+    static bool loadConversationList(int uid, std::vector<ConversationInfo>& result);
+    /// 新消息原地更新各成员的会话列表（本地 + Redis）
+    void updateConversationLists(const MessageInfo& info) const;
+    /// 丢弃用户的会话列表（本地 + Redis），下次拉取重新加载
+    void invalidateConversationLists(const std::vector<int>& uids) const;
+    // 群聊
+    /// 解析请求中的 uid 数组，有元素不是整数时返回 false
+    static bool parseUids(const Json::Value& array, std::vector<int>& uids);
+    void groupCreateHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
+    void groupMemberUpdateHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
+    /**
+     * @brief 群消息扇出：本机在线成员共享同一编码帧，其余成员按所在服务器分组，每台对端一次 RPC。
+     *
+     * 成员列表和路由均读本地缓存，未命中时整群/整批回源，不按成员访问 Redis 或 MySQL。
+     */
+    void fanoutGroupMsg(const std::string& convId, int fromUid, MessageID msgId, const std::string& data) const;
+    /**
+     * @brief 会话列表：按最近活跃时间倒序分页，由会话列表缓存返回。
+     *
+     * 请求 {uid, cursor, limit}，响应 {data, next_cursor, has_more}，首页 cursor 为空，limit 默认 50；
+     * 带 since_update_time 的增量同步仍查询 MySQL。
+     */
     void conversationListFetchHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
 
     // 聊天消息
     void chatMsgHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
+    /// 重发消息以已存储的 serverId 落库时，向接收方（群聊为其余成员）推送 ID_NOTIFY_MSG_RESULT 更正
+    void notifyResentCorrection(const MessageInfo& stored);
+    /// serverId 大于 since 的最早 limit 条，按 ID 升序
+    bool fetchHistoryAfter(const std::string& convId, int64_t since, int limit, std::vector<MessageInfo>& result) const;
+    /// serverId 小于 before 的最新 limit 条（before 为 0 时为最新一页），按 ID 升序
+    bool fetchHistoryBefore(const std::string& convId, int64_t before, int limit, std::vector<MessageInfo>& result) const;
+    /// anchor 之前的 older 条加上 anchor 及之后的 newer 条，按 ID 升序
+    bool fetchHistoryAround(const std::string& convId, int64_t anchor, int older, int newer,
+                            std::vector<MessageInfo>& result) const;
+    /**
+     * @brief 历史消息：按 serverId 游标双向翻页，或以某条消息为中心取一页（跳转到搜索结果）。
+     *
+     * 请求 {conv_id, direction, since_msg_id | before_msg_id | around_msg_id, limit, max_bytes}，
+     * direction 为 after（默认，兼容原请求）/ before / around，before_msg_id 为 0 时取最新一页；
+     * limit 默认 50、最多 200，max_bytes 为客户端可接收的字节数，不超过响应帧上限。
+     * 响应 {data, has_more, has_older, has_newer}，data 按 ID 升序，下一页以首条或末条的 ID 为游标。
+     */
     void historyChatMsgFetchHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
     void msgStatusUpdateHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
+    /**
+     * @brief 离线收件箱同步：返回游标之后的推送帧，重连时一次往返补齐离线期间的推送。
+     *
+     * 请求 {uid, cursor, limit}，响应 {data: [{id, msg_id, json}], cursor, has_more, truncated}，
+     * truncated 表示游标之后有推送已被裁剪，客户端需退回首页 + 会话列表的全量拉取。
+     */
+    void inboxSyncHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
+    /**
+     * @brief 聊天记录搜索：在用户所在的会话（或指定的一个会话）中查找包含全部关键词的消息，只查本地索引。
+     *
+     * 请求 {uid, query, conv_id, before_msg_id, limit}，conv_id 为空时搜索全部会话，before_msg_id 为上一页
+     * 最后一条的 serverId，limit 默认 20、最多 100。响应 {data: [{server_id, conv_id, sender_uid, snippet}], has_more}，
+     * 按 serverId 倒序；点击结果后以 around_msg_id 拉取历史消息定位上下文。
+     */
+    void messageSearchHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
 
     // 心跳包处理
     void heartbeatHandle(const std::shared_ptr<Session>& session, uint16_t msgId, const std::string& data);
@@ -195,6 +274,17 @@ private:
     std::vector<std::thread> workers_;
 
     std::string selfServerName_;
+    static constexpr size_t DEFAULT_GROUP_MAX_MEMBERS = 5000;
+    static constexpr int DEFAULT_CONV_LIST_PAGE = 50;
+    static constexpr int MAX_CONV_LIST_PAGE = 200;
+    static constexpr int DEFAULT_HISTORY_PAGE = 50;
+    static constexpr int MAX_HISTORY_PAGE = 200;
+    static constexpr size_t MAX_HISTORY_BYTES = 60000;  ///< 帧长度字段为 uint16，留出包头与响应外层字段
+    static constexpr size_t HISTORY_ITEM_INDENT = 6;
+    static constexpr int DEFAULT_SEARCH_PAGE = 20;
+    static constexpr int MAX_SEARCH_PAGE = 100;
+    static constexpr const char* DEFAULT_SEARCH_INDEX_DIR = "search_index";
+    size_t groupMaxMembers_;
 
     // 多队列分片：每个 shard 拥有独立的 lockfree 队列和 condvar
     std::vector<std::unique_ptr<WorkerShard>> shards_;
@@ -204,7 +294,13 @@ private:
     ThreadPool workerPool_;
 
     // 批量异步写入
+    std::unique_ptr<MessageIdGenerator> msg_id_gen_;    ///< 收到聊天消息时分配 serverId
     std::unique_ptr<BatchWriter> batch_writer_;
+    std::unique_ptr<ReadWatermarkTable> read_watermarks_;
+    std::unique_ptr<RecentMessageCache> recent_msgs_;   ///< 最新一页历史消息由内存返回，关闭时为空
+    std::unique_ptr<ConversationListCache> conv_lists_; ///< 会话列表由内存按游标分页返回，关闭时为空
+    std::unique_ptr<MessageSearchIndex> search_index_;  ///< 落库的消息加入本地全文索引，关闭时为空
+    std::unique_ptr<LoginAdmission> login_admission_;
 
     std::unordered_map<uint16_t, msgHandler> handlers_;
 };
@@ -6,8 +6,10 @@
 #define IMSERVER_CHATMSG_NODE_H
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "common/model/MessageInfo.h"
@@ -25,6 +27,8 @@ struct ChatMsgNode {
     MessageInfo              msg;
     std::weak_ptr<Session>   sender_session;
     int64_t                  enqueue_time_us;  ///< 入队时间戳 (steady_clock μs)
+    uint64_t                 wal_lsn = 0;      ///< WAL 序号，0 表示未写入 WAL
+    size_t                   mem_bytes = 0;    ///< 计入 BatchWriter 内存预算的字节数，0 表示未计入
 
     ChatMsgNode() = default;
 
@@ -34,6 +38,15 @@ struct ChatMsgNode {
         , enqueue_time_us(std::chrono::duration_cast<std::chrono::microseconds>(
               std::chrono::steady_clock::now().time_since_epoch()).count())
     {}
+
+    /// 估算节点占用的内存：节点本身、make_shared 控制块、缓冲区链表节点，以及超出 SSO 的字符串堆内存
+    [[nodiscard]] size_t estimateBytes() const {
+        const auto heap = [](const std::optional<std::string>& s) -> size_t {
+            return s && s->capacity() > std::string().capacity() ? s->capacity() + 1 : 0;
+        };
+        return sizeof(ChatMsgNode) + 2 * sizeof(std::shared_ptr<ChatMsgNode>) + sizeof(void*)
+            + heap(msg.convId) + heap(msg.content) + heap(msg.createTime);
+    }
 };
 
 #endif //IMSERVER_CHATMSG_NODE_H
@@ -0,0 +1,271 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "ConversationListCache.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "const.h"
+#include "MessageIdGenerator.h"
+
+ConversationListCache::ConversationListCache(const Options& options, loadHandler loader)
+    : options_{std::max<size_t>(1, options.maxUsers), options.ttl}
+    , stripe_users_(std::max<size_t>(1, options.maxUsers / STRIPES))
+    , loader_(std::move(loader))
+    , stripes_(std::make_unique<Stripe[]>(STRIPES)) {
+}
+
+bool ConversationListCache::fetch(const int uid, const std::string& cursor, const int limit,
+                                  std::vector<ConversationInfo>& result, std::string& nextCursor) {
+    Key after{0, ""};
+    if (!cursor.empty() && !decodeCursor(cursor, after.activity, after.convId)) {
+        return false;
+    }
+    const auto serve = [&](const Entry& entry) {
+        auto it = cursor.empty() ? entry.items.begin() : entry.items.upper_bound(after);
+        result.clear();
+        nextCursor.clear();
+        for (; it != entry.items.end() && static_cast<int>(result.size()) < limit; ++it) {
+            result.push_back(it->second);
+        }
+        if (it != entry.items.end() && !result.empty()) {
+            const auto& last = std::prev(it)->first;
+            nextCursor = encodeCursor(last.activity, last.convId);
+        }
+        return true;
+    };
+
+    auto& stripe = stripeOf(uid);
+    std::unique_lock<std::mutex> lock(stripe.mutex);
+    while (true) {
+        const auto it = stripe.index.find(uid);
+        if (it == stripe.index.end()) {
+            break;
+        }
+        if (it->second->loaded && std::chrono::steady_clock::now() - it->second->loadedAt < options_.ttl) {
+            metrics_.hits.fetch_add(1, std::memory_order_relaxed);
+            return serve(touchLocked(stripe, uid));
+        }
+        if (!it->second->loading) {
+            break;
+        }
+        stripe.cond.wait(lock);
+    }
+
+    // 未加载或已过期：不持锁加载，期间的更新只标记 stale
+    {
+        auto& entry = touchLocked(stripe, uid);
+        entry.loading = true;
+        entry.stale = false;
+    }
+    lock.unlock();
+    std::vector<ConversationInfo> rows;
+    metrics_.loads.fetch_add(1, std::memory_order_relaxed);
+    const bool ok = loader_(uid, rows);
+    lock.lock();
+
+    // 加载期间列表可能已被淘汰或丢弃，touchLocked 重新建立
+    auto& entry = touchLocked(stripe, uid);
+    entry.loading = false;
+    stripe.cond.notify_all();
+    if (!ok) {
+        metrics_.loadFailures.fetch_add(1, std::memory_order_relaxed);
+        dropLocked(stripe, uid);
+        return false;
+    }
+    entry.items.clear();
+    entry.activity.clear();
+    for (auto& row : rows) {
+        const int64_t activity = activityOf(row);
+        entry.activity[row.convId] = activity;
+        entry.items.emplace(Key{activity, row.convId}, std::move(row));
+    }
+    entry.loaded = true;
+    // 加载期间有更新时结果可能已旧，本次照常返回，下次读取重新加载
+    entry.loadedAt = entry.stale ? std::chrono::steady_clock::time_point{} : std::chrono::steady_clock::now();
+    entry.stale = false;
+    evictLocked(stripe);
+    return serve(entry);
+}
+
+void ConversationListCache::onMessage(const int uid, const MessageInfo& msg) {
+    if (!msg.convId.has_value() || msg.servId <= 0) {
+        return;
+    }
+    auto& stripe = stripeOf(uid);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto* entry = loadedLocked(stripe, uid);
+    if (entry == nullptr) {
+        return;
+    }
+    const auto pos = entry->activity.find(msg.convId.value());
+    if (pos == entry->activity.end()) {
+        // 新建的会话没有对方资料，整表重新加载
+        dropLocked(stripe, uid);
+        return;
+    }
+    const auto node = entry->items.find(Key{pos->second, pos->first});
+    auto& info = node->second;
+    if (msg.servId > info.lastMsgId) {
+        info.lastMsgId = msg.servId;
+        info.lastMsgContent = msg.summary();
+        info.lastTime = ms_to_datetime(MessageIdGenerator::timestampOf(msg.servId));
+    }
+    if (msg.fromUid != uid) {
+        info.unreadCount = std::max(0, info.unreadCount) + 1;
+    }
+    if (const int64_t activity = activityOf(info); activity != pos->second) {
+        auto moved = entry->items.extract(node);
+        moved.key().activity = activity;
+        entry->items.insert(std::move(moved));
+        pos->second = activity;
+    }
+    metrics_.updates.fetch_add(1, std::memory_order_relaxed);
+}
+
+int ConversationListCache::onRead(const int uid, const std::string& convId, const int64_t lastReadMsgId,
+                                  const int count) {
+    auto& stripe = stripeOf(uid);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto* entry = loadedLocked(stripe, uid);
+    if (entry == nullptr) {
+        return -1;
+    }
+    const auto pos = entry->activity.find(convId);
+    if (pos == entry->activity.end()) {
+        return -1;
+    }
+    auto& info = entry->items.find(Key{pos->second, pos->first})->second;
+    info.lastReadMsgId = std::max(info.lastReadMsgId, lastReadMsgId);
+    // 读到最新一条即清零，否则按本次已读条数扣减
+    info.unreadCount = lastReadMsgId >= info.lastMsgId ? 0 : std::max(0, info.unreadCount - std::max(0, count));
+    metrics_.updates.fetch_add(1, std::memory_order_relaxed);
+    return info.unreadCount;
+}
+
+void ConversationListCache::invalidate(const int uid) {
+    auto& stripe = stripeOf(uid);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (const auto it = stripe.index.find(uid); it != stripe.index.end()) {
+        if (it->second->loading) {
+            it->second->stale = true;
+            return;
+        }
+        dropLocked(stripe, uid);
+    }
+}
+
+int64_t ConversationListCache::activityOf(const ConversationInfo& info) {
+    if (info.lastMsgId > 0) {
+        return MessageIdGenerator::timestampOf(info.lastMsgId);
+    }
+    if (info.updateTime.has_value()) {
+        if (const auto ms = datetime_to_ms(info.updateTime.value()); ms > 0) {
+            return ms;
+        }
+    }
+    return info.createTime.has_value() ? datetime_to_ms(info.createTime.value()) : 0;
+}
+
+std::string ConversationListCache::encodeCursor(const int64_t activity, const std::string& convId) {
+    return std::to_string(activity) + ":" + convId;
+}
+
+bool ConversationListCache::decodeCursor(const std::string& cursor, int64_t& activity, std::string& convId) {
+    const auto sep = cursor.find(':');
+    if (sep == std::string::npos || sep == 0) {
+        return false;
+    }
+    try {
+        size_t used = 0;
+        activity = std::stoll(cursor.substr(0, sep), &used);
+        if (used != sep) {
+            return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    convId = cursor.substr(sep + 1);
+    return true;
+}
+
+ConversationListCache::Stripe& ConversationListCache::stripeOf(const int uid) {
+    return stripes_[static_cast<size_t>(uid) % STRIPES];
+}
+
+ConversationListCache::Entry& ConversationListCache::touchLocked(Stripe& stripe, const int uid) {
+    if (const auto it = stripe.index.find(uid); it != stripe.index.end()) {
+        stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+        return *it->second;
+    }
+    stripe.lru.emplace_front();
+    stripe.lru.front().uid = uid;
+    stripe.index.emplace(uid, stripe.lru.begin());
+    return stripe.lru.front();
+}
+
+ConversationListCache::Entry* ConversationListCache::loadedLocked(Stripe& stripe, const int uid) {
+    const auto it = stripe.index.find(uid);
+    if (it == stripe.index.end()) {
+        return nullptr;
+    }
+    if (it->second->loading) {
+        it->second->stale = true;
+        return nullptr;
+    }
+    return it->second->loaded ? &*it->second : nullptr;
+}
+
+void ConversationListCache::dropLocked(Stripe& stripe, const int uid) {
+    const auto it = stripe.index.find(uid);
+    if (it == stripe.index.end() || it->second->loading) {
+        return;
+    }
+    stripe.lru.erase(it->second);
+    stripe.index.erase(it);
+    metrics_.drops.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ConversationListCache::evictLocked(Stripe& stripe) {
+    // 正在加载的列表有读者等待，不淘汰
+    auto it = stripe.lru.end();
+    while (stripe.index.size() > stripe_users_ && it != stripe.lru.begin()) {
+        --it;
+        if (it->loading) {
+            continue;
+        }
+        stripe.index.erase(it->uid);
+        it = stripe.lru.erase(it);
+        metrics_.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+ConversationListCache::Stats ConversationListCache::stats() const {
+    Stats stats;
+    for (size_t i = 0; i < STRIPES; i++) {
+        std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+        stats.users += stripes_[i].index.size();
+    }
+    stats.hits = metrics_.hits.load(std::memory_order_relaxed);
+    stats.loads = metrics_.loads.load(std::memory_order_relaxed);
+    stats.loadFailures = metrics_.loadFailures.load(std::memory_order_relaxed);
+    stats.updates = metrics_.updates.load(std::memory_order_relaxed);
+    stats.drops = metrics_.drops.load(std::memory_order_relaxed);
+    stats.evictions = metrics_.evictions.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ConversationListCache::printMetrics() const {
+    const auto s = stats();
+    std::cout << "[conv_list_cache] "
+              << "hits=" << s.hits
+              << " loads=" << s.loads
+              << " load_failures=" << s.loadFailures
+              << " updates=" << s.updates
+              << " drops=" << s.drops
+              << " users=" << s.users
+              << " evictions=" << s.evictions
+              << std::endl;
+}
@@ -0,0 +1,147 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_CONVERSATIONLISTCACHE_H
+#define IMSERVER_CONVERSATIONLISTCACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/model/ConversationInfo.h"
+#include "common/model/MessageInfo.h"
+
+/**
+ * @brief 用户会话列表的本地缓存：uid → 按最近活跃时间倒序的全部会话，单聊对方的昵称、头像已内联。
+ *
+ * 打开应用时拉取会话列表不再逐次 JOIN 查询并逐个会话查询对方资料：
+ *   - 读未命中填充：列表未加载或已过期时由 loadHandler 一次加载用户的全部会话（先 Redis，冷启动再查 MySQL），
+ *     同一用户同时只有一个加载，其余读者等待加载完成；
+ *   - 原地更新：本机处理的新消息、已读水位直接修改缓存中的会话并调整顺序；
+ *     会话不在列表中（新建的会话）或好友、群成员变更时丢弃整个列表，下次读取重新加载；
+ *   - 按游标分页：游标为 (活跃时间, conv_id)，每页在有序表中二分定位，与会话总数无关，不再限制 50 条；
+ *   - 其他服务器处理的消息不会修改本地列表，加载后超过 ConvListTtlMs 重新加载；
+ *   - 按 uid 分段加锁，每段按用户数上限 LRU 淘汰。
+ *
+ * 监控 (Metrics):
+ *   - hits / loads     : 由内存返回的拉取次数 / 加载列表的次数
+ *   - load_failures    : 加载失败，调用方回退到 MySQL 分页查询
+ *   - updates / drops  : 原地更新的次数 / 因无法原地更新而丢弃列表的次数
+ *   - users / evictions: 缓存的用户数 / 累计淘汰的用户数
+ */
+class ConversationListCache {
+public:
+    /// 加载用户的全部会话，顺序不限；加载失败返回 false
+    typedef std::function<bool(int uid, std::vector<ConversationInfo>& result)> loadHandler;
+
+    struct Options {
+        size_t maxUsers = 100000;
+        std::chrono::milliseconds ttl{2000};
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t loads = 0;
+        uint64_t loadFailures = 0;
+        uint64_t updates = 0;
+        uint64_t drops = 0;
+        uint64_t evictions = 0;
+        size_t users = 0;
+    };
+
+    ConversationListCache(const Options& options, loadHandler loader);
+
+    /**
+     * @brief 按最近活跃时间倒序拉取一页会话。
+     * @param cursor 上一页返回的 nextCursor，首页传空串
+     * @param nextCursor 还有更多会话时为下一页的游标，否则为空串
+     * @return 加载失败或游标不合法时返回 false
+     */
+    bool fetch(int uid, const std::string& cursor, int limit,
+               std::vector<ConversationInfo>& result, std::string& nextCursor);
+
+    /// 会话成员 uid 所在会话收到新消息，uid 不是发送方时未读数加一
+    void onMessage(int uid, const MessageInfo& msg);
+    /**
+     * @brief uid 的已读水位推进到 lastReadMsgId，本次已读 count 条。
+     * @return 更新后的未读数；列表不在缓存中返回 -1
+     */
+    int onRead(int uid, const std::string& convId, int64_t lastReadMsgId, int count);
+    /// 丢弃用户的列表，下次读取重新加载
+    void invalidate(int uid);
+
+    /// 会话的活跃时间（毫秒）：最新消息 ID 中的时间戳，没有消息时取更新时间
+    static int64_t activityOf(const ConversationInfo& info);
+    static std::string encodeCursor(int64_t activity, const std::string& convId);
+    static bool decodeCursor(const std::string& cursor, int64_t& activity, std::string& convId);
+
+    [[nodiscard]] Stats stats() const;
+    void printMetrics() const;
+
+private:
+    struct Key {
+        int64_t activity;
+        std::string convId;
+    };
+
+    /// 活跃时间倒序，相同时按 conv_id 倒序，与 Redis ZREVRANGE 的顺序一致
+    struct Newer {
+        bool operator()(const Key& a, const Key& b) const {
+            return a.activity != b.activity ? a.activity > b.activity : a.convId > b.convId;
+        }
+    };
+
+    struct Entry {
+        int uid = -1;
+        std::map<Key, ConversationInfo, Newer> items;
+        std::unordered_map<std::string, int64_t> activity;   ///< conv_id → 在 items 中的活跃时间
+        bool loaded = false;
+        bool loading = false;       ///< 正在加载，其余读者在段的 cond 上等待
+        bool stale = false;         ///< 加载期间收到更新，加载结果只使用一次
+        std::chrono::steady_clock::time_point loadedAt;
+    };
+
+    struct Stripe {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::list<Entry> lru;       ///< 队首最近使用
+        std::unordered_map<int, std::list<Entry>::iterator> index;
+    };
+
+    Stripe& stripeOf(int uid);
+    /// 查找或新建用户的列表并移到 LRU 队首，调用方持有段锁
+    Entry& touchLocked(Stripe& stripe, int uid);
+    /// 已加载的列表返回 entry，未加载时标记 stale 并返回 nullptr，调用方持有段锁
+    Entry* loadedLocked(Stripe& stripe, int uid);
+    void dropLocked(Stripe& stripe, int uid);
+    void evictLocked(Stripe& stripe);
+
+    static constexpr size_t STRIPES = 16;
+
+    const Options options_;
+    const size_t stripe_users_;
+    loadHandler loader_;
+    std::unique_ptr<Stripe[]> stripes_;
+
+    struct Metrics {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> loads{0};
+        std::atomic<uint64_t> loadFailures{0};
+        std::atomic<uint64_t> updates{0};
+        std::atomic<uint64_t> drops{0};
+        std::atomic<uint64_t> evictions{0};
+    } metrics_;
+};
+
+
+#endif //IMSERVER_CONVERSATIONLISTCACHE_H
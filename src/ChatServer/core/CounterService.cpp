@@ -0,0 +1,362 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "CounterService.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include "ChatMsgNode.h"
+#include "ConfigMgr.h"
+#include "RedisMgr.h"
+#include "db/mysql/MysqlMgr.h"
+
+namespace {
+constexpr int DEFAULT_COUNTER_FLUSH_INTERVAL_MS = 1000;
+constexpr size_t DEFAULT_COUNTER_FLUSH_BATCH_SIZE = 4096;
+constexpr int DEFAULT_COUNTER_RECONCILE_INTERVAL_MS = 60000;
+constexpr int DEFAULT_COUNTER_RECONCILE_QUIET_MS = 10000;
+constexpr size_t DEFAULT_COUNTER_RECONCILE_BATCH = 64;
+constexpr int DEFAULT_COUNTER_REDIS_TTL_SEC = 86400;
+// 对账候选的上限，超过后新的键不再记录，只依赖已读水位修正
+constexpr size_t MAX_TOUCHED = 100000;
+
+// KEYS[1] 计数哈希；ARGV: 字段, 增量。字段存在时才累加，结果不低于 0
+constexpr const char* INCR_SCRIPT =
+    "if redis.call('HEXISTS', KEYS[1], ARGV[1]) == 0 then return -1 end "
+    "local v = redis.call('HINCRBY', KEYS[1], ARGV[1], ARGV[2]) "
+    "if v < 0 then redis.call('HSET', KEYS[1], ARGV[1], 0) v = 0 end "
+    "return v";
+
+// KEYS 同上；ARGV: 字段, MySQL 计算的值, 过期秒数。期间其他服务器已写入时保留已有的值
+constexpr const char* SEED_SCRIPT =
+    "if redis.call('HSETNX', KEYS[1], ARGV[1], ARGV[2]) == 1 then redis.call('EXPIRE', KEYS[1], ARGV[3]) end "
+    "return redis.call('HGET', KEYS[1], ARGV[1])";
+
+// KEYS 同上；ARGV: 字段, 对账的值。字段存在且不一致时覆盖，返回 1 表示有偏差
+constexpr const char* RECONCILE_SCRIPT =
+    "local v = redis.call('HGET', KEYS[1], ARGV[1]) "
+    "if not v or v == ARGV[2] then return 0 end "
+    "redis.call('HSET', KEYS[1], ARGV[1], ARGV[2]) "
+    "return 1";
+}
+
+CounterService::CounterService()
+    : flushInterval_(DEFAULT_COUNTER_FLUSH_INTERVAL_MS), flushBatchSize_(DEFAULT_COUNTER_FLUSH_BATCH_SIZE),
+      reconcileInterval_(DEFAULT_COUNTER_RECONCILE_INTERVAL_MS), reconcileQuiet_(DEFAULT_COUNTER_RECONCILE_QUIET_MS),
+      reconcileBatch_(DEFAULT_COUNTER_RECONCILE_BATCH), redisTtlSec_(std::to_string(DEFAULT_COUNTER_REDIS_TTL_SEC)),
+      lastReconcile_(std::chrono::steady_clock::now()), lastMetricTime_(std::chrono::steady_clock::now()) {
+    auto& config = ConfigMgr::getInstance();
+    if (!config["ChatServer"]["CounterFlushIntervalMs"].empty()) {
+        flushInterval_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["CounterFlushIntervalMs"]));
+    }
+    if (!config["ChatServer"]["CounterFlushBatchSize"].empty()) {
+        flushBatchSize_ = std::max<size_t>(1, std::stoul(config["ChatServer"]["CounterFlushBatchSize"]));
+    }
+    if (!config["ChatServer"]["CounterReconcileIntervalMs"].empty()) {
+        reconcileInterval_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["CounterReconcileIntervalMs"]));
+    }
+    if (!config["ChatServer"]["CounterReconcileQuietMs"].empty()) {
+        reconcileQuiet_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["CounterReconcileQuietMs"]));
+    }
+    if (!config["ChatServer"]["CounterReconcileBatch"].empty()) {
+        reconcileBatch_ = std::max<size_t>(1, std::stoul(config["ChatServer"]["CounterReconcileBatch"]));
+    }
+    if (!config["ChatServer"]["CounterRedisTtlSec"].empty()) {
+        redisTtlSec_ = config["ChatServer"]["CounterRedisTtlSec"];
+    }
+    // 已由 ChatLogicSystem 构造消息 ID 生成器时校验
+    if (!config["ChatServer"]["WorkerId"].empty()) {
+        workerId_ = std::stoll(config["ChatServer"]["WorkerId"]);
+    }
+}
+
+CounterService::~CounterService() {
+    stop();
+}
+
+void CounterService::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread([this] { flushLoop(); });
+}
+
+void CounterService::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    flush();
+}
+
+int CounterService::friendApplyCount(const int uid) {
+    const std::string key = counterKey(uid);
+    if (const auto value = RedisMgr::getInstance()->hGet(key, USER_FRIEND_REPLY_COUNT); !value.empty()) {
+        metrics_.applyHits.fetch_add(1, std::memory_order_relaxed);
+        return std::max(0, std::stoi(value));
+    }
+    metrics_.applyMisses.fetch_add(1, std::memory_order_relaxed);
+
+    int count = 0;
+    if (!MysqlMgr::getInstance()->getFriendApplyCount(uid, count)) {
+        return 0;
+    }
+    count = std::max(0, count);
+    std::vector<std::vector<std::string>> replies;
+    if (RedisMgr::getInstance()->pipeline({{"EVAL", SEED_SCRIPT, "1", key, USER_FRIEND_REPLY_COUNT,
+            std::to_string(count), redisTtlSec_}}, replies) && !replies[0].empty()) {
+        return std::max(0, std::stoi(replies[0][0]));
+    }
+    return count;
+}
+
+void CounterService::addFriendApply(const int uid, const int delta) {
+    if (!RedisMgr::getInstance()->pipeline({{"EVAL", INCR_SCRIPT, "1", counterKey(uid), USER_FRIEND_REPLY_COUNT,
+            std::to_string(delta)}})) {
+        // 增量丢失时删除计数，下次读取重新计算
+        invalidateFriendApply(uid);
+    }
+    if (reconcileInterval_.count() > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (touchedUsers_.size() < MAX_TOUCHED) {
+            touchedUsers_[uid] = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+void CounterService::invalidateFriendApply(const int uid) {
+    RedisMgr::getInstance()->hDel(counterKey(uid), USER_FRIEND_REPLY_COUNT);
+}
+
+void CounterService::onMessagesPersisted(const std::vector<std::shared_ptr<ChatMsgNode>> &nodes) {
+    metrics_.messages.fetch_add(nodes.size(), std::memory_order_relaxed);
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& n : nodes) {
+            pending_.add(n->msg.convId.value_or(""), n->msg.servId, n->msg.fromUid);
+        }
+        full = pending_.messages() >= flushBatchSize_;
+    }
+    if (full) {
+        cond_.notify_one();
+    }
+}
+
+void CounterService::setUnreadFixHandler(UnreadFixHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fixHandler_ = std::move(handler);
+}
+
+void CounterService::flushLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait_for(lock, flushInterval_, [this]() {
+                return !running_ || pending_.messages() >= flushBatchSize_;
+            });
+        }
+        flush();
+        // 写回与对账在同一线程，对账期间 user_conversation 不会被本服务的增量改动
+        if (const auto now = std::chrono::steady_clock::now();
+            running_ && reconcileInterval_.count() > 0 && now - lastReconcile_ >= reconcileInterval_) {
+            lastReconcile_ = now;
+            reconcile();
+        }
+    }
+}
+
+bool CounterService::updateReadWatermarks(std::vector<MessageStatusWatermark>& marks) {
+    std::lock_guard<std::mutex> flushLock(flushMutex_);
+    bool pending = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending = std::any_of(marks.begin(), marks.end(), [this](const MessageStatusWatermark& mark) {
+            return pending_.contains(mark.convId);
+        });
+    }
+    // 水位之前的消息若在重算之后才累加增量会重复计数，先写回
+    if (pending) {
+        flushLocked();
+    }
+    {
+        // 写回失败或期间新到的增量仍在 pending_ 中，重算只计到其最小消息之前；
+        // 没有待写回增量的会话不设上界，之后到达的少量消息可能重复计数，由对账修正
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& mark : marks) {
+            int64_t minMsgId = 0;
+            if (pending_.minMsgId(mark.convId, minMsgId)) {
+                mark.countedMsgId = minMsgId - 1;
+            }
+        }
+    }
+    return MysqlMgr::getInstance()->batchUpdateMessageStatus(marks);
+}
+
+void CounterService::flush() {
+    std::lock_guard<std::mutex> flushLock(flushMutex_);
+    flushLocked();
+}
+
+void CounterService::flushLocked() {
+    std::vector<ConvUnreadDelta> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.convs() == 0) {
+            return;
+        }
+        batch = pending_.drain();
+    }
+
+    int deadlocks = 0;
+    const bool ok = MysqlMgr::getInstance()->batchAddUnreadCounts(batch, deadlocks);
+    metrics_.flushes.fetch_add(1, std::memory_order_relaxed);
+    const size_t rows = batch.size();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ok) {
+            // 失败的增量放回，与期间新增的合并后下一轮重试
+            pending_.merge(std::move(batch));
+        }
+        else if (reconcileInterval_.count() > 0) {
+            const auto now = std::chrono::steady_clock::now();
+            for (const auto& delta : batch) {
+                auto it = touchedConvs_.find(delta.convId);
+                if (it == touchedConvs_.end()) {
+                    if (touchedConvs_.size() >= MAX_TOUCHED) {
+                        continue;
+                    }
+                    it = touchedConvs_.emplace(delta.convId, std::make_pair(0, now)).first;
+                }
+                it->second.first = std::max(it->second.first, delta.maxMsgId);
+                it->second.second = now;
+            }
+        }
+    }
+
+    if (!ok) {
+        metrics_.failures.fetch_add(1, std::memory_order_relaxed);
+        std::cout << "CounterService: write " << rows << " unread deltas failed" << std::endl;
+        return;
+    }
+    metrics_.rows.fetch_add(rows, std::memory_order_relaxed);
+}
+
+void CounterService::reconcile() {
+    std::vector<ConvUnreadDelta> convs;
+    std::vector<int> uids;
+    UnreadFixHandler handler;
+    {
+        // 只取已静默的键：最近仍有写入的会话，增量可能还在途中
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = touchedConvs_.begin(); it != touchedConvs_.end() && convs.size() < reconcileBatch_;) {
+            if (now - it->second.second < reconcileQuiet_ || pending_.contains(it->first)) {
+                ++it;
+                continue;
+            }
+            ConvUnreadDelta conv;
+            conv.convId = it->first;
+            conv.maxMsgId = it->second.first;
+            convs.push_back(std::move(conv));
+            it = touchedConvs_.erase(it);
+        }
+        for (auto it = touchedUsers_.begin(); it != touchedUsers_.end() && uids.size() < reconcileBatch_;) {
+            if (now - it->second < reconcileQuiet_) {
+                ++it;
+                continue;
+            }
+            uids.push_back(it->first);
+            it = touchedUsers_.erase(it);
+        }
+        handler = fixHandler_;
+    }
+
+    if (!convs.empty()) {
+        std::vector<UnreadCountFix> fixed;
+        if (MysqlMgr::getInstance()->reconcileUnreadCounts(convs, workerId_, fixed)) {
+            metrics_.reconciled.fetch_add(convs.size(), std::memory_order_relaxed);
+            metrics_.drift.fetch_add(fixed.size(), std::memory_order_relaxed);
+            for (const auto& fix : fixed) {
+                std::cout << "CounterService: unread drift uid=" << fix.uid << " conv=" << fix.convId
+                          << " drift=" << fix.drift << std::endl;
+                if (handler) {
+                    handler(fix);
+                }
+            }
+        }
+    }
+    if (!uids.empty()) {
+        reconcileFriendApply(uids);
+    }
+}
+
+void CounterService::reconcileFriendApply(const std::vector<int> &uids) {
+    std::vector<std::vector<std::string>> commands;
+    commands.reserve(uids.size());
+    for (const int uid : uids) {
+        int count = 0;
+        if (!MysqlMgr::getInstance()->getFriendApplyCount(uid, count)) {
+            continue;
+        }
+        commands.push_back({"EVAL", RECONCILE_SCRIPT, "1", counterKey(uid), USER_FRIEND_REPLY_COUNT,
+            std::to_string(std::max(0, count))});
+    }
+    std::vector<std::vector<std::string>> replies;
+    if (commands.empty() || !RedisMgr::getInstance()->pipeline(commands, replies)) {
+        return;
+    }
+    metrics_.reconciled.fetch_add(commands.size(), std::memory_order_relaxed);
+    for (const auto& reply : replies) {
+        if (!reply.empty() && reply[0] == "1") {
+            metrics_.drift.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::string CounterService::counterKey(const int uid) {
+    return USER_COUNTER_PREFIX + std::to_string(uid);
+}
+
+void CounterService::printMetrics() {
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - lastMetricTime_).count();
+    lastMetricTime_ = now;
+
+    const uint64_t messages = metrics_.messages.exchange(0, std::memory_order_relaxed);
+    const uint64_t rows = metrics_.rows.exchange(0, std::memory_order_relaxed);
+    const uint64_t flushes = metrics_.flushes.exchange(0, std::memory_order_relaxed);
+    const uint64_t failures = metrics_.failures.exchange(0, std::memory_order_relaxed);
+    const uint64_t applyHits = metrics_.applyHits.exchange(0, std::memory_order_relaxed);
+    const uint64_t applyMisses = metrics_.applyMisses.exchange(0, std::memory_order_relaxed);
+    const uint64_t reconciled = metrics_.reconciled.exchange(0, std::memory_order_relaxed);
+    const uint64_t drift = metrics_.drift.exchange(0, std::memory_order_relaxed);
+    if (messages == 0 && rows == 0 && applyHits + applyMisses == 0 && reconciled == 0) {
+        return;
+    }
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending = pending_.convs();
+    }
+
+    std::cout << "[counter] "
+              << "msgs/s=" << std::fixed << std::setprecision(0) << (elapsed > 0 ? messages / elapsed : 0)
+              << " rows=" << rows
+              << " flushes=" << flushes
+              << " coalesce=" << std::setprecision(1) << (rows > 0 ? static_cast<double>(messages) / rows : 0)
+              << " pending=" << pending
+              << " apply_hits=" << applyHits
+              << " apply_misses=" << applyMisses
+              << " reconciled=" << reconciled
+              << " drift=" << drift
+              << " failures=" << failures
+              << std::endl;
+}
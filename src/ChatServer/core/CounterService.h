@@ -0,0 +1,136 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_COUNTERSERVICE_H
+#define IMSERVER_COUNTERSERVICE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Singleton.h"
+#include "UnreadDeltaTable.h"
+#include "common/model/MessageInfo.h"
+
+// 用户状态计数哈希 user_counter_<uid> 中的字段
+#define USER_FRIEND_REPLY_COUNT "friend_reply"  // 未处理的好友申请数
+
+struct ChatMsgNode;
+
+/**
+ * @brief 计数服务：热读走 Redis，写入只做增量，MySQL 计数由后台线程合并后写回，定时对账修正偏差。
+ *
+ * 好友申请数：
+ *   - Redis user_counter_<uid> 哈希中的 friend_reply 即读取的值，O(1) 读取；
+ *     字段不存在时由 MySQL COUNT 计算一次，HSETNX 写入并设置 CounterRedisTtlSec 过期；
+ *   - 新建申请加一，同意、拒绝减一，均为一条 Lua 脚本，字段存在时才 HINCRBY 且不低于 0；
+ *     重复申请无法确定原申请是否仍有效，删除字段下次重新计算；
+ *   - 申请行本身即 MySQL 中的数据，不需要写回；申请按时间过期不产生事件，由对账修正。
+ * 会话未读数：
+ *   - Redis 与本地会话列表在收到消息时已累加（ConversationCache），这里只负责 MySQL；
+ *   - 消息落库后按会话累加到 UnreadDeltaTable，每 CounterFlushIntervalMs 或累计 CounterFlushBatchSize 条
+ *     一次写入 user_conversation，热点会话的多条消息合并为一次行更新，不再与消息插入同一事务；
+ *   - 写入失败的增量放回，下一轮重试；进程崩溃时丢失未写入的增量，由已读水位或对账修正；
+ *   - 已读水位经 updateReadWatermarks 写回：先写回涉及会话的增量，重算未读数只计到已计入增量的消息，
+ *     与增量写回互斥，之后的消息留给增量累加，两者不重复计数。
+ * 对账：每 CounterReconcileIntervalMs 取最近写入过、且已静默 CounterReconcileQuietMs 的会话和用户，
+ *   每轮最多 CounterReconcileBatch 个，按消息表、申请表重新计算，不一致时覆盖并回调 UnreadFixHandler。
+ *   重算的上界只覆盖本服务器已写回的增量，其他服务器的增量是否写回无从得知，因此已读水位之后有其他服务器
+ *   生成的消息（serverId 中的机器号不同）的成员不对账，也不回调，由该成员下次已读时的水位重算修正。
+ *
+ * 监控 (Metrics):
+ *   - msgs/s / rows       : 每秒累加的落库消息数 / 写回 user_conversation 的会话数
+ *   - coalesce            : 消息数 / 写回的会话数
+ *   - pending             : 尚未写回的会话数
+ *   - apply_hits/misses   : 好友申请数读取命中 Redis / 回源 MySQL
+ *   - reconciled / drift  : 对账检查的会话与用户数 / 修正的行数
+ */
+class CounterService : public Singleton<CounterService> {
+public:
+    using UnreadFixHandler = std::function<void(const UnreadCountFix&)>;
+
+    ~CounterService();
+
+    void start();
+    /// 停止并写回剩余增量
+    void stop();
+
+    /// 未处理的好友申请数
+    int friendApplyCount(int uid);
+    /// 好友申请数增减，Redis 中没有该计数时忽略
+    void addFriendApply(int uid, int delta);
+    /// 无法确定增量时删除计数，下次读取重新计算
+    void invalidateFriendApply(int uid);
+
+    /// 消息落库后累加未读增量（已去掉重复消息）
+    void onMessagesPersisted(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes);
+    /// 写回已读水位并按水位重算未读数，重算的上界由本服务尚未写回的增量决定
+    bool updateReadWatermarks(std::vector<MessageStatusWatermark>& marks);
+    /// 对账修正了 MySQL 中的未读数后回调，用于同步缓存层
+    void setUnreadFixHandler(UnreadFixHandler handler);
+
+    void printMetrics();
+
+private:
+    friend class Singleton<CounterService>;
+    CounterService();
+
+    void flushLoop();
+    /// 写回未读增量，失败的放回
+    void flush();
+    /// 同上，调用方已持有 flushMutex_
+    void flushLocked();
+    void reconcile();
+    void reconcileFriendApply(const std::vector<int>& uids);
+
+    static std::string counterKey(int uid);
+
+    std::chrono::milliseconds flushInterval_;
+    size_t flushBatchSize_;
+    std::chrono::milliseconds reconcileInterval_;
+    std::chrono::milliseconds reconcileQuiet_;
+    size_t reconcileBatch_;
+    std::string redisTtlSec_;
+    /// 本服务器的机器号，对账只处理水位之后的消息都由本服务器生成的成员
+    int64_t workerId_ = 0;
+
+    /// 增量写回与已读水位重算互斥：写回途中的增量既不在 pending_ 中，也还未计入 MySQL
+    std::mutex flushMutex_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    UnreadDeltaTable pending_;
+    /// 最近写回过的会话 -> (已计入的最大消息 ID, 写回时间)，对账的候选
+    std::unordered_map<std::string, std::pair<int64_t, std::chrono::steady_clock::time_point>> touchedConvs_;
+    /// 最近变更过好友申请数的用户 -> 变更时间
+    std::unordered_map<int, std::chrono::steady_clock::time_point> touchedUsers_;
+    std::chrono::steady_clock::time_point lastReconcile_;
+    UnreadFixHandler fixHandler_;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    struct Metrics {
+        std::atomic<uint64_t> messages{0};
+        std::atomic<uint64_t> rows{0};
+        std::atomic<uint64_t> flushes{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> applyHits{0};
+        std::atomic<uint64_t> applyMisses{0};
+        std::atomic<uint64_t> reconciled{0};
+        std::atomic<uint64_t> drift{0};
+    } metrics_;
+
+    std::chrono::steady_clock::time_point lastMetricTime_;
+};
+
+
+#endif //IMSERVER_COUNTERSERVICE_H
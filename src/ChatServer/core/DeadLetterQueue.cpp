@@ -0,0 +1,470 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "DeadLetterQueue.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+
+#include <json/json.h>
+
+namespace {
+constexpr const char* SPILL_FILE = "spill.log";
+constexpr const char* SPILL_OFFSET_FILE = "spill.offset";
+constexpr const char* POISON_FILE = "poison.log";
+
+int64_t steadyUs(const std::chrono::steady_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(tp.time_since_epoch()).count();
+}
+
+std::chrono::milliseconds withJitter(const std::chrono::milliseconds base) {
+    thread_local std::mt19937 rng{std::random_device{}()};
+    std::uniform_real_distribution<double> jitter(0.5, 1.5);
+    return std::chrono::milliseconds(static_cast<int64_t>(static_cast<double>(base.count()) * jitter(rng)));
+}
+}
+
+DeadLetterQueue::DeadLetterQueue(const Options& options, redeliverHandler redeliver, poisonHandler onPoison)
+    : redeliver_(std::move(redeliver)), on_poison_(std::move(onPoison)), dir_(options.dir),
+      memory_budget_(std::max<size_t>(1, options.memoryBytes)),
+      retry_base_(std::max(std::chrono::milliseconds(1), options.retryBase)),
+      retry_max_(std::max(retry_base_, options.retryMax)), max_attempts_(std::max(1, options.maxAttempts)),
+      reload_batch_size_(std::max<size_t>(1, options.reloadBatchSize)),
+      boot_id_(std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count()) {
+}
+
+DeadLetterQueue::~DeadLetterQueue() {
+    stop();
+}
+
+bool DeadLetterQueue::start() {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        std::cout << "[DeadLetterQueue] create dir " << dir_ << " failed: " << ec.message() << std::endl;
+        return false;
+    }
+
+    // 恢复上次运行未重投完的溢出消息：从记录的读取位置起逐行计数
+    {
+        std::lock_guard<std::mutex> lock(spill_mtx_);
+        if (std::ifstream offsetIn(dir_ + "/" + SPILL_OFFSET_FILE); offsetIn) {
+            offsetIn >> spill_committed_;
+        }
+        spill_offset_ = spill_committed_;
+        spill_inflight_.clear();
+        size_t count = 0;
+        if (std::ifstream in(dir_ + "/" + SPILL_FILE); in) {
+            in.seekg(static_cast<std::streamoff>(spill_offset_));
+            std::string line;
+            while (std::getline(in, line)) {
+                count += in.eof() ? 0 : 1;
+            }
+        }
+        spilled_ = count;
+        if (count > 0) {
+            std::cout << "[DeadLetterQueue] recovered " << count << " spilled messages" << std::endl;
+        }
+    }
+
+    if (running_.exchange(true)) {
+        return true;
+    }
+    retry_thread_ = std::thread([this] { retryLoop(); });
+    return true;
+}
+
+void DeadLetterQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+        cond_.notify_all();
+    }
+    if (retry_thread_.joinable()) {
+        retry_thread_.join();
+    }
+
+    // 内存中的消息写入溢出文件，重启后继续重投
+    std::deque<Entry> remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        remaining.swap(queue_);
+        depth_ = 0;
+        memory_bytes_ = 0;
+    }
+    size_t lost = 0;
+    for (const auto& entry : remaining) {
+        if (appendSpill(entry.batch)) {
+            if (entry.spillEnd > 0) {
+                resolveSpill(entry.spillEnd, entry.batch.size());
+            }
+            continue;
+        }
+        // 读回的消息仍在溢出文件记录的位置之后，重启后再次读回；其余的只能丢弃
+        if (entry.spillEnd > 0) {
+            continue;
+        }
+        lost += entry.batch.size();
+        for (const auto& node : entry.batch) {
+            std::cout << "[DeadLetterQueue] drop on stop, conv_id=" << node->msg.convId.value_or("")
+                      << " msg_id=" << node->msg.msgId << std::endl;
+        }
+    }
+    if (lost > 0) {
+        metrics_.dropped.fetch_add(lost, std::memory_order_relaxed);
+        std::cout << "[DeadLetterQueue] " << lost << " messages could not be spilled on stop" << std::endl;
+    }
+}
+
+void DeadLetterQueue::add(Batch batch) {
+    if (batch.empty()) {
+        return;
+    }
+    Entry entry;
+    entry.bytes = estimateBytes(batch);
+    entry.lastFailure = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 溢出文件还有积压时新批次也写入文件，保持大致的先后顺序
+        if (memory_bytes_ + entry.bytes <= memory_budget_ && spilled_ == 0) {
+            depth_ += batch.size();
+            memory_bytes_ += entry.bytes;
+            entry.batch = std::move(batch);
+            queue_.push_back(std::move(entry));
+            cond_.notify_one();
+            return;
+        }
+    }
+    if (appendSpill(batch)) {
+        // 空转等待的重投线程在 mutex_ 下检查溢出计数，持锁一次再通知避免错过唤醒
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cond_.notify_one();
+        return;
+    }
+    // 磁盘也写不进去时只能留在内存，宁可超出上限也不丢消息
+    std::lock_guard<std::mutex> lock(mutex_);
+    depth_ += batch.size();
+    memory_bytes_ += entry.bytes;
+    entry.batch = std::move(batch);
+    queue_.push_back(std::move(entry));
+    cond_.notify_one();
+}
+
+void DeadLetterQueue::onWriteSucceeded() {
+    last_success_us_.store(steadyUs(std::chrono::steady_clock::now()), std::memory_order_relaxed);
+}
+
+void DeadLetterQueue::retryLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        // 内存队列降到一半以下时读回溢出消息
+        if (spilled_ > 0 && memory_bytes_ < memory_budget_ / 2) {
+            lock.unlock();
+            uint64_t spillEnd = 0;
+            Batch batch = loadSpill(reload_batch_size_, spillEnd);
+            lock.lock();
+            if (!batch.empty()) {
+                Entry entry;
+                entry.spillEnd = spillEnd;
+                entry.bytes = estimateBytes(batch);
+                // 溢出消息早已等待过，读回后立即重投，不再等一个基础周期
+                entry.lastFailure = std::chrono::steady_clock::now() - retry_base_;
+                depth_ += batch.size();
+                memory_bytes_ += entry.bytes;
+                entry.batch = std::move(batch);
+                queue_.push_back(std::move(entry));
+            }
+        }
+        if (queue_.empty()) {
+            cond_.wait(lock, [this] { return !running_ || !queue_.empty() || spilled_ > 0; });
+            continue;
+        }
+
+        // 失败后至少间隔一个基础周期再重投；处于退避时等到退避结束
+        const auto due = std::max(resume_at_, queue_.front().lastFailure + retry_base_);
+        if (cond_.wait_until(lock, due, [this] { return !running_; })) {
+            break;
+        }
+        if (queue_.empty()) {
+            continue;
+        }
+
+        Entry entry = std::move(queue_.front());
+        queue_.pop_front();
+        depth_ -= entry.batch.size();
+        memory_bytes_ -= entry.bytes;
+        lock.unlock();
+
+        bool ok = false;
+        try {
+            ok = redeliver_(entry.batch);
+        } catch (const std::exception& e) {
+            std::cout << "[DeadLetterQueue] redeliver exception: " << e.what() << std::endl;
+        }
+        if (ok) {
+            metrics_.redelivered.fetch_add(entry.batch.size(), std::memory_order_relaxed);
+            onWriteSucceeded();
+            if (entry.spillEnd > 0) {
+                resolveSpill(entry.spillEnd, entry.batch.size());
+            }
+            lock.lock();
+            backoff_ = std::chrono::milliseconds(0);
+            continue;
+        }
+        handleFailure(std::move(entry));
+        lock.lock();
+    }
+}
+
+void DeadLetterQueue::handleFailure(Entry entry) {
+    const auto now = std::chrono::steady_clock::now();
+    // 上次失败之后有写入成功，说明 MySQL 可用，失败由批次内的消息引起
+    const bool healthy = last_success_us_.load(std::memory_order_relaxed) > steadyUs(entry.lastFailure);
+    entry.lastFailure = now;
+
+    // 批次对半拆分，逐步缩小到单条以定位毒消息；整体故障时拆分不影响重投节奏
+    std::optional<Entry> second;
+    if (entry.batch.size() > 1) {
+        const auto mid = entry.batch.begin() + static_cast<std::ptrdiff_t>(entry.batch.size() / 2);
+        second.emplace();
+        second->batch.assign(std::make_move_iterator(mid), std::make_move_iterator(entry.batch.end()));
+        second->bytes = estimateBytes(second->batch);
+        second->failures = entry.failures;
+        second->lastFailure = now;
+        second->spillEnd = entry.spillEnd;
+        entry.batch.erase(mid, entry.batch.end());
+        entry.bytes = estimateBytes(entry.batch);
+    }
+
+    if (!healthy) {
+        // 整体退避；失败的批次移到队尾，避免队首的毒消息挡住后面可以写入的批次
+        std::lock_guard<std::mutex> lock(mutex_);
+        backoff_ = backoff_.count() == 0 ? retry_base_ : std::min(retry_max_, backoff_ * 2);
+        resume_at_ = now + withJitter(backoff_);
+        pushBackLocked(std::move(entry));
+        if (second) {
+            pushBackLocked(std::move(*second));
+        }
+        return;
+    }
+
+    if (second) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backoff_ = std::chrono::milliseconds(0);
+        pushFrontLocked(std::move(*second));
+        pushFrontLocked(std::move(entry));
+        return;
+    }
+
+    if (++entry.failures < max_attempts_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backoff_ = std::chrono::milliseconds(0);
+        pushFrontLocked(std::move(entry));
+        return;
+    }
+
+    const auto& node = entry.batch.front();
+    writePoison(node);
+    metrics_.poisoned.fetch_add(1, std::memory_order_relaxed);
+    std::cout << "[DeadLetterQueue] poison message isolated, conv_id=" << node->msg.convId.value_or("")
+              << " msg_id=" << node->msg.msgId << std::endl;
+    if (on_poison_) {
+        on_poison_(node);
+    }
+    if (entry.spillEnd > 0) {
+        resolveSpill(entry.spillEnd, entry.batch.size());
+    }
+}
+
+void DeadLetterQueue::pushFrontLocked(Entry entry) {
+    depth_ += entry.batch.size();
+    memory_bytes_ += entry.bytes;
+    queue_.push_front(std::move(entry));
+}
+
+void DeadLetterQueue::pushBackLocked(Entry entry) {
+    depth_ += entry.batch.size();
+    memory_bytes_ += entry.bytes;
+    queue_.push_back(std::move(entry));
+}
+
+bool DeadLetterQueue::appendSpill(const Batch& batch) {
+    Json::FastWriter writer;
+    std::string lines;
+    for (const auto& node : batch) {
+        Json::Value value;
+        node->msg.toJson(value);
+        value["boot"] = static_cast<Json::Int64>(boot_id_);
+        value["wal_lsn"] = static_cast<Json::UInt64>(node->wal_lsn);
+        value["mem_bytes"] = static_cast<Json::UInt64>(node->mem_bytes);
+        lines += writer.write(value);
+    }
+
+    std::lock_guard<std::mutex> lock(spill_mtx_);
+    std::ofstream out(dir_ + "/" + SPILL_FILE, std::ios::binary | std::ios::app);
+    out << lines;
+    out.flush();
+    if (!out) {
+        std::cout << "[DeadLetterQueue] write spill file failed" << std::endl;
+        return false;
+    }
+    spilled_ += batch.size();
+    return true;
+}
+
+DeadLetterQueue::Batch DeadLetterQueue::loadSpill(const size_t limit, uint64_t& spillEnd) {
+    Batch batch;
+    std::lock_guard<std::mutex> lock(spill_mtx_);
+    if (spilled_ == 0) {
+        return batch;
+    }
+    const std::string path = dir_ + "/" + SPILL_FILE;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        spilled_ = 0;
+        spill_inflight_.clear();
+        spill_offset_ = 0;
+        spill_committed_ = 0;
+        saveSpillOffset();
+        return batch;
+    }
+    in.seekg(static_cast<std::streamoff>(spill_offset_));
+
+    size_t consumed = 0;
+    std::string line;
+    while (consumed < limit && std::getline(in, line)) {
+        if (in.eof()) {
+            break;  // 没有换行结尾的半行，写入尚未完成
+        }
+        spill_offset_ += line.size() + 1;
+        consumed++;
+
+        Json::Value value;
+        if (Json::Reader reader; !reader.parse(line, value)) {
+            std::cout << "[DeadLetterQueue] skip invalid spill record" << std::endl;
+            continue;
+        }
+        MessageInfo info;
+        info.fromJson(value);
+        auto node = std::make_shared<ChatMsgNode>(info, nullptr);
+        if (value["boot"].asInt64() == boot_id_) {
+            node->wal_lsn = value["wal_lsn"].asUInt64();
+            // 溢出期间消息仍计入写入方的内存预算，读回后由写入方照常归还
+            node->mem_bytes = value["mem_bytes"].asUInt64();
+        }
+        batch.push_back(std::move(node));
+    }
+    in.close();
+
+    spilled_ -= std::min<size_t>(spilled_, consumed);
+    if (consumed == 0) {
+        // 计数与文件内容不符（只剩未写完的半行），不再读取；区段都处理完时清空文件
+        spilled_ = 0;
+        advanceSpillLocked();
+        return batch;
+    }
+    // 读回的消息处理完之前不记录读取位置，解析失败的记录不需要处理
+    spillEnd = spill_offset_;
+    spill_inflight_[spillEnd] += batch.size();
+    advanceSpillLocked();
+    return batch;
+}
+
+void DeadLetterQueue::resolveSpill(const uint64_t spillEnd, const size_t count) {
+    std::lock_guard<std::mutex> lock(spill_mtx_);
+    if (const auto it = spill_inflight_.find(spillEnd); it != spill_inflight_.end()) {
+        it->second -= std::min(it->second, count);
+    }
+    advanceSpillLocked();
+}
+
+void DeadLetterQueue::advanceSpillLocked() {
+    bool advanced = false;
+    while (!spill_inflight_.empty() && spill_inflight_.begin()->second == 0) {
+        spill_committed_ = spill_inflight_.begin()->first;
+        spill_inflight_.erase(spill_inflight_.begin());
+        advanced = true;
+    }
+    if (spill_inflight_.empty() && spilled_ == 0) {
+        // 全部读回并处理完后清空文件，避免无限增长
+        std::remove((dir_ + "/" + SPILL_FILE).c_str());
+        spill_offset_ = 0;
+        spill_committed_ = 0;
+        advanced = true;
+    }
+    if (advanced) {
+        saveSpillOffset();
+    }
+}
+
+void DeadLetterQueue::saveSpillOffset() {
+    const std::string path = dir_ + "/" + SPILL_OFFSET_FILE;
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << spill_committed_;
+    }
+    std::rename(tmp.c_str(), path.c_str());
+}
+
+void DeadLetterQueue::writePoison(const std::shared_ptr<ChatMsgNode>& node) {
+    Json::Value value;
+    node->msg.toJson(value);
+    value["isolated_at"] = static_cast<Json::Int64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    std::lock_guard<std::mutex> lock(spill_mtx_);
+    std::ofstream out(dir_ + "/" + POISON_FILE, std::ios::binary | std::ios::app);
+    out << Json::FastWriter().write(value);
+}
+
+size_t DeadLetterQueue::estimateBytes(const Batch& batch) {
+    size_t bytes = 0;
+    for (const auto& node : batch) {
+        bytes += node->estimateBytes();
+    }
+    return bytes;
+}
+
+DeadLetterQueue::Stats DeadLetterQueue::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.depth = depth_;
+        stats.batches = queue_.size();
+        stats.memoryBytes = memory_bytes_;
+        stats.backoffMs = backoff_.count();
+    }
+    stats.spilled = spilled_;
+    stats.redelivered = metrics_.redelivered.load(std::memory_order_relaxed);
+    stats.poisoned = metrics_.poisoned.load(std::memory_order_relaxed);
+    stats.dropped = metrics_.dropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void DeadLetterQueue::printMetrics() {
+    const auto s = stats();
+    if (s.depth == 0 && s.spilled == 0 && s.backoffMs == 0 && s.dropped == 0) {
+        return;
+    }
+    std::cout << "[dlq] "
+              << "depth=" << s.depth
+              << " batches=" << s.batches
+              << " memory_kb=" << s.memoryBytes / 1024
+              << " spilled=" << s.spilled
+              << " redelivered=" << s.redelivered
+              << " poisoned=" << s.poisoned
+              << " dropped=" << s.dropped
+              << " backoff_ms=" << s.backoffMs
+              << std::endl;
+}
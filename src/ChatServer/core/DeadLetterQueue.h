@@ -0,0 +1,155 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_DEADLETTERQUEUE_H
+#define IMSERVER_DEADLETTERQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChatMsgNode.h"
+
+/**
+ * @brief 写库失败消息的死信队列与重投引擎。
+ *
+ * batchCreateMessages 在死锁重试后仍失败的批次进入本队列，由独立的重投线程按 FIFO 重新写入：
+ *   - 指数退避：重投失败且期间没有任何写入成功（MySQL 整体不可用）时，整个队列按
+ *     DlqRetryBaseMs * 2^n（上限 DlqRetryMaxMs，带抖动）暂停，每轮只用一个批次探测，不放大故障，
+ *     失败的批次移到队尾，避免挡住后面的批次；
+ *   - 毒消息隔离：失败的批次对半拆分后继续重投；单条消息在期间有其他写入成功的情况下
+ *     累计失败 DlqMaxAttempts 次判定为毒消息，写入 poison.log 并回调 onPoison，不再重试；
+ *   - 内存上限：内存中的消息超过 DlqMemoryMB 时新到的批次写入磁盘溢出文件 spill.log，
+ *     内存队列降到一半以下时再按批读回；ChatMsgNode::mem_bytes 随记录写入，同一次运行内读回时恢复，
+ *     写入方的内存预算在消息写入成功或判定为毒消息之前一直计入，溢出文件的大小也因此有上限；
+ *   - 重启恢复：stop 时内存中的消息全部写入溢出文件，start 时从记录的位置继续重投；
+ *     读回的消息写入成功、判定为毒消息或 stop 时重新写入溢出文件后，记录的位置才越过它们，
+ *     重投途中崩溃时重启后再读一遍，重复的消息由 batchCreateMessages 识别。
+ *
+ * 监控 (Metrics):
+ *   - depth / batches   : 内存中的消息数 / 批次数
+ *   - memory_kb         : 内存中消息的估算大小
+ *   - spilled           : 溢出文件中待重投的消息数
+ *   - redelivered       : 重投成功的消息数
+ *   - poisoned          : 判定为毒消息的消息数
+ *   - dropped           : stop 时无法写入溢出文件而丢失的消息数
+ *   - backoff_ms        : 当前退避时长，0 表示未处于退避
+ */
+class DeadLetterQueue {
+public:
+    typedef std::vector<std::shared_ptr<ChatMsgNode>> Batch;
+    /// 重新写入一批消息，成功返回 true
+    typedef std::function<bool(Batch& batch)> redeliverHandler;
+    /// 消息判定为毒消息，已写入 poison.log，不再重试
+    typedef std::function<void(const std::shared_ptr<ChatMsgNode>& node)> poisonHandler;
+
+    struct Options {
+        std::string dir = "dlq";
+        size_t memoryBytes = 64 << 20;
+        std::chrono::milliseconds retryBase{200};
+        std::chrono::milliseconds retryMax{30000};
+        int maxAttempts = 5;
+        size_t reloadBatchSize = 256;   ///< 每次从溢出文件读回的消息数
+    };
+
+    struct Stats {
+        size_t depth = 0;
+        size_t batches = 0;
+        size_t memoryBytes = 0;
+        size_t spilled = 0;
+        uint64_t redelivered = 0;
+        uint64_t poisoned = 0;
+        uint64_t dropped = 0;
+        int64_t backoffMs = 0;
+    };
+
+    DeadLetterQueue(const Options& options, redeliverHandler redeliver, poisonHandler onPoison);
+    ~DeadLetterQueue();
+
+    /// 打开溢出目录并恢复上次未重投完的消息，启动重投线程
+    bool start();
+    /// 停止重投线程，内存中的消息写入溢出文件
+    void stop();
+
+    void add(Batch batch);
+    /// 正常写入成功，说明 MySQL 可用，用于区分整体故障和个别毒消息
+    void onWriteSucceeded();
+
+    [[nodiscard]] Stats stats() const;
+    void printMetrics();
+
+private:
+    struct Entry {
+        Batch batch;
+        size_t bytes = 0;
+        int failures = 0;   ///< MySQL 可用时仍失败的次数
+        std::chrono::steady_clock::time_point lastFailure;
+        uint64_t spillEnd = 0;  ///< 从溢出文件读回时所在区段的结束位置，0 表示不是读回的
+    };
+
+    void retryLoop();
+    /// 重投失败后的处理：整体故障时退避，个别失败时拆分或隔离
+    void handleFailure(Entry entry);
+    void pushFrontLocked(Entry entry);
+    void pushBackLocked(Entry entry);
+
+    //=== 磁盘溢出 ============================================================
+    bool appendSpill(const Batch& batch);
+    /// 读回最多 limit 条溢出消息，spillEnd 返回所在区段的结束位置；区段处理完之前不记录读取位置
+    Batch loadSpill(size_t limit, uint64_t& spillEnd);
+    /// 读回的 count 条消息已写入、隔离或重新溢出，之前的区段都处理完时前移并记录读取位置
+    void resolveSpill(uint64_t spillEnd, size_t count);
+    void advanceSpillLocked();
+    void writePoison(const std::shared_ptr<ChatMsgNode>& node);
+    void saveSpillOffset();
+
+    static size_t estimateBytes(const Batch& batch);
+
+    redeliverHandler redeliver_;
+    poisonHandler on_poison_;
+
+    const std::string dir_;
+    const size_t memory_budget_;
+    const std::chrono::milliseconds retry_base_;
+    const std::chrono::milliseconds retry_max_;
+    const int max_attempts_;
+    const size_t reload_batch_size_;
+    int64_t boot_id_;       ///< 区分本次运行写入的溢出记录，WAL 序号只在同一次运行内有效
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<Entry> queue_;
+    size_t depth_ = 0;
+    size_t memory_bytes_ = 0;
+    std::chrono::milliseconds backoff_{0};
+    std::chrono::steady_clock::time_point resume_at_;
+
+    std::mutex spill_mtx_;
+    uint64_t spill_offset_ = 0;     ///< 溢出文件已读回的位置
+    uint64_t spill_committed_ = 0;  ///< 之前的消息都已处理完的位置，即 spill.offset 记录的值
+    std::map<uint64_t, size_t> spill_inflight_;    ///< 读回区段的结束位置 -> 未处理完的消息数
+    std::atomic<size_t> spilled_{0};
+
+    std::atomic<int64_t> last_success_us_{0};
+    std::atomic<bool> running_{false};
+    std::thread retry_thread_;
+
+    struct Metrics {
+        std::atomic<uint64_t> redelivered{0};
+        std::atomic<uint64_t> poisoned{0};
+        std::atomic<uint64_t> dropped{0};
+    } metrics_;
+};
+
+
+#endif //IMSERVER_DEADLETTERQUEUE_H
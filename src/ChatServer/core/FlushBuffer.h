@@ -5,49 +5,80 @@
 #ifndef IMSERVER_FLUSH_BUFFER_H
 #define IMSERVER_FLUSH_BUFFER_H
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
-#include <mutex>
-#include <shared_mutex>
 #include <vector>
 
 #include "ChatMsgNode.h"
 
 /**
- * @brief 双缓冲区：IO 线程 push 到 active，DB 线程 swap 后消费 flush。
+ * @brief 多生产者单消费者的刷写缓冲区：IO 线程 push，DB 线程 swap 后消费 flush。
  *
- * 使用 std::vector<shared_ptr<ChatMsgNode>> + shared_mutex 实现。
- * push 持 shared_lock（多 IO 线程并发），swap 持 unique_lock（独占）。
+ * 无锁单链表实现：
+ *   - push 以 CAS 把新节点挂到链表头，多个 IO 线程并发推入互不阻塞；
+ *   - swap 以一次 exchange 把整条链表取走并置空，不与 push 互斥，刷写期间 IO 线程照常推入；
+ *   - 消费者只整体取走、不逐个弹出，链表头不会出现 ABA 问题。
+ * 链表按推入逆序排列，swap 取出后反转恢复推入顺序，同一会话的消息按到达顺序落库。
+ * push 不能读取旧链表头的内容（可能已被 swap 取走释放），长度由单独的计数器维护：
+ *   - CAS 时链表为空即返回 1，是精确值，BatchWriter 据此登记刷写截止时间；
+ *   - 其余情况返回计数器的值，与并发的 swap 交错时可能略有偏差，仅用于判断是否达到批量阈值。
  */
 class FlushBuffer {
 public:
-    FlushBuffer() : active_idx_(0) {
-        buffers_[0].reserve(256);
-        buffers_[1].reserve(256);
+    FlushBuffer() = default;
+
+    FlushBuffer(const FlushBuffer&) = delete;
+    FlushBuffer& operator=(const FlushBuffer&) = delete;
+
+    ~FlushBuffer() {
+        Node* head = head_.exchange(nullptr, std::memory_order_acquire);
+        while (head) {
+            Node* next = head->next;
+            delete head;
+            head = next;
+        }
     }
 
-    // IO 线程调用：推入活跃缓冲区
-    void push(std::shared_ptr<ChatMsgNode> node) {
-        std::shared_lock lk(mtx_);
-        int idx = active_idx_.load(std::memory_order_relaxed);
-        buffers_[idx].push_back(std::move(node));
+    // IO 线程调用：推入缓冲区，返回推入后缓冲区的消息数
+    size_t push(std::shared_ptr<ChatMsgNode> node) {
+        auto* item = new Node{std::move(node), nullptr};
+        // CAS 成功后节点可能立即被 swap 取走释放，之后不再访问 item，是否为空由本地的 expected 判断
+        Node* expected = head_.load(std::memory_order_relaxed);
+        do {
+            item->next = expected;
+        } while (!head_.compare_exchange_weak(expected, item,
+            std::memory_order_seq_cst, std::memory_order_relaxed));
+        const int64_t size = size_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (expected == nullptr) {
+            return 1;
+        }
+        return static_cast<size_t>(std::max<int64_t>(2, size));
     }
 
-    // 定时器线程调用：检查活跃缓冲区是否有数据（无锁，允许误判）
+    // 定时器线程调用：检查缓冲区是否有数据
     [[nodiscard]] bool hasData() const {
-        return !buffers_[active_idx_.load(std::memory_order_relaxed)].empty();
+        return head_.load(std::memory_order_acquire) != nullptr;
     }
 
-    // DB 写入线程调用：交换缓冲区，返回待刷写的内容
+    // DB 写入线程调用：取走当前全部消息，按推入顺序返回
     std::vector<std::shared_ptr<ChatMsgNode>> swap() {
-        std::unique_lock lk(mtx_);
-        int old = active_idx_.load(std::memory_order_relaxed);
-        active_idx_.store(1 - old, std::memory_order_relaxed);
-        // 交换后，buffers_[old] 是待刷写的，buffers_[1-old] 是新的活跃缓冲区
-        // 但我们需要返回 old 的内容，并清空它供下一轮使用
+        // 先推进批次号再取走链表：push 之后读到旧批次号的消息一定会被本次取走，刷写截止时间不会遗漏消息。
+        // 两侧都是“写一个原子量再读另一个”，需要 seq_cst 保证全序
+        generation_.fetch_add(1, std::memory_order_seq_cst);
+        Node* head = head_.exchange(nullptr, std::memory_order_seq_cst);
+
         std::vector<std::shared_ptr<ChatMsgNode>> result;
-        result.swap(buffers_[old]);
+        while (head) {
+            Node* next = head->next;
+            result.push_back(std::move(head->value));
+            delete head;
+            head = next;
+        }
+        std::reverse(result.begin(), result.end());
+        size_.fetch_sub(static_cast<int64_t>(result.size()), std::memory_order_relaxed);
         last_swap_time_us_.store(
             std::chrono::duration_cast<std::chrono::microseconds>(
                 std::chrono::steady_clock::now().time_since_epoch()).count(),
@@ -58,11 +89,19 @@ public:
     /// 上次 swap 的时间戳 (μs)
     [[nodiscard]] int64_t lastSwapTimeUs() const { return last_swap_time_us_.load(std::memory_order_relaxed); }
 
+    /// swap 次数，刷写截止时间据此判断所属批次是否已被刷写
+    [[nodiscard]] uint64_t generation() const { return generation_.load(std::memory_order_seq_cst); }
+
 private:
-    std::vector<std::shared_ptr<ChatMsgNode>> buffers_[2];
-    std::atomic<int> active_idx_;
+    struct Node {
+        std::shared_ptr<ChatMsgNode> value;
+        Node* next;
+    };
+
+    std::atomic<Node*> head_{nullptr};
+    std::atomic<int64_t> size_{0};      ///< 近似长度，push 先挂链表后计数，swap 先取链表后扣减
     std::atomic<int64_t> last_swap_time_us_{0};
-    mutable std::shared_mutex mtx_;  // push=shared, swap=unique
+    std::atomic<uint64_t> generation_{0};
 };
 
 #endif //IMSERVER_FLUSH_BUFFER_H
@@ -0,0 +1,88 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "GroupMemberCache.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "ConfigMgr.h"
+#include "RedisMgr.h"
+#include "db/mysql/MysqlMgr.h"
+
+namespace {
+constexpr int DEFAULT_GROUP_MEMBER_TTL_MS = 60000;
+}
+
+GroupMemberCache::GroupMemberCache()
+    : ttl_(DEFAULT_GROUP_MEMBER_TTL_MS), started_(false) {
+    auto& config = ConfigMgr::getInstance();
+    if (!config["ChatServer"]["GroupMemberTtlMs"].empty()) {
+        ttl_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["GroupMemberTtlMs"]));
+    }
+}
+
+void GroupMemberCache::start() {
+    if (started_.exchange(true)) {
+        return;
+    }
+    RedisMgr::getInstance()->subscribe(GROUP_MEMBER_CHANNEL,
+        [this](const std::string& message) {
+            invalidate(message);
+        },
+        [this]() {
+            clear();
+        });
+}
+
+GroupMemberCache::MemberList GroupMemberCache::getMembers(const std::string &convId) {
+    uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto it = groups_.find(convId); it != groups_.end()) {
+            if (it->second.expireTime > std::chrono::steady_clock::now()) {
+                return it->second.members;
+            }
+            groups_.erase(it);
+        }
+        epoch = epoch_;
+    }
+
+    // 整群一次加载，SQL 已按 uid 排序
+    auto members = std::make_shared<const std::vector<int>>(MysqlMgr::getInstance()->selectGroupMembers(convId));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (epoch_ != epoch) {
+        return members;
+    }
+    if (groups_.size() >= MAX_GROUPS) {
+        groups_.clear();
+    }
+    groups_[convId] = GroupEntry{members, std::chrono::steady_clock::now() + ttl_};
+    return members;
+}
+
+bool GroupMemberCache::isMember(const std::string &convId, const int uid) {
+    const auto members = getMembers(convId);
+    return std::binary_search(members->begin(), members->end(), uid);
+}
+
+void GroupMemberCache::invalidate(const std::string &convId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    groups_.erase(convId);
+    epoch_++;
+}
+
+void GroupMemberCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    groups_.clear();
+    epoch_++;
+}
+
+void GroupMemberCache::publishMembersChanged(const std::string &convId) {
+    invalidate(convId);
+    if (!RedisMgr::getInstance()->publish(GROUP_MEMBER_CHANNEL, convId)) {
+        std::cout << "GroupMemberCache: publish member change of [" << convId << "] failed" << std::endl;
+    }
+}
@@ -0,0 +1,64 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_GROUPMEMBERCACHE_H
+#define IMSERVER_GROUPMEMBERCACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Singleton.h"
+
+/**
+ * @brief 本地群成员表：conv_id → 有序成员 uid 列表。
+ *
+ * 群消息扇出和发送权限校验都只读本地表，未命中时一次 SQL 整群加载，
+ * 发送路径上不按成员访问 MySQL。成员列表以只读 shared_ptr 发布，读者无需持锁遍历。
+ * 成员变更时通过 Redis 频道 GROUP_MEMBER_CHANNEL 广播 conv_id，各服务器失效本地表项，TTL 兜底。
+ */
+class GroupMemberCache : public Singleton<GroupMemberCache> {
+public:
+    using MemberList = std::shared_ptr<const std::vector<int>>;
+
+    ~GroupMemberCache() = default;
+
+    /// 订阅成员变更频道，重复调用无副作用
+    void start();
+
+    /// 返回群成员列表，群不存在时返回空列表
+    MemberList getMembers(const std::string& convId);
+    bool isMember(const std::string& convId, int uid);
+
+    void invalidate(const std::string& convId);
+    void clear();
+
+    /// 本地失效并广播成员变更
+    void publishMembersChanged(const std::string& convId);
+
+private:
+    friend class Singleton<GroupMemberCache>;
+    GroupMemberCache();
+
+    struct GroupEntry {
+        MemberList members;
+        std::chrono::steady_clock::time_point expireTime;
+    };
+
+    static constexpr size_t MAX_GROUPS = 16384;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, GroupEntry> groups_;
+    /// 每次失效递增，加载期间发生失效则不写回，避免旧成员列表覆盖变更
+    uint64_t epoch_ = 0;
+    std::chrono::milliseconds ttl_;
+    std::atomic<bool> started_;
+};
+
+
+#endif //IMSERVER_GROUPMEMBERCACHE_H
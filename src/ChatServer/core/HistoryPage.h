@@ -0,0 +1,112 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_HISTORYPAGE_H
+#define IMSERVER_HISTORYPAGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 历史消息分页：翻页方向与按字节数裁剪。
+ *
+ * 三种方向都以 serverId 为游标，在 message 表 (conv_id, id) 索引上一次定位后只扫描一页，
+ * 向前翻多少页就查询多少次，与会话的消息总数无关：
+ *   - AFTER ：ID 大于游标的最早 limit 条，向新翻页；
+ *   - BEFORE：ID 小于游标的最新 limit 条，向旧翻页，游标为 0 时即会话最新的一页；
+ *   - AROUND：游标之前的 limit/2 条加上游标及之后的其余条数，用于跳转到搜索命中的消息。
+ * 响应帧长度字段为 uint16，fit 按客户端协商的字节数从游标一侧开始保留消息，被裁掉的一侧由下一页继续。
+ */
+class HistoryPage {
+public:
+    enum class Direction : int8_t {
+        AFTER,
+        BEFORE,
+        AROUND,
+    };
+
+    static bool parseDirection(const std::string& value, Direction& direction) {
+        if (value == "after") {
+            direction = Direction::AFTER;
+        }
+        else if (value == "before") {
+            direction = Direction::BEFORE;
+        }
+        else if (value == "around") {
+            direction = Direction::AROUND;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    /// limit 条中游标之前、游标及之后各取的条数
+    static std::pair<int, int> split(const Direction direction, const int limit) {
+        switch (direction) {
+            case Direction::AFTER:
+                return {0, limit};
+            case Direction::BEFORE:
+                return {limit, 0};
+            default:
+                return {limit / 2, limit - limit / 2};
+        }
+    }
+
+    /**
+     * @brief 在按 ID 升序的一页中选取字节数不超过 maxBytes 的连续一段。
+     * @param sizes 每条消息序列化后的字节数
+     * @param anchor 开始保留的位置：AFTER 从第一条向后，BEFORE 从最后一条向前，
+     *               AROUND 从 anchor（第一条 ID 不小于游标的消息）向两侧交替扩展
+     * @return 保留的区间 [first, last)；页不为空时至少保留一条
+     */
+    static std::pair<size_t, size_t> fit(const std::vector<size_t>& sizes, const Direction direction,
+                                         const size_t anchor, const size_t maxBytes) {
+        if (sizes.empty()) {
+            return {0, 0};
+        }
+        size_t first;
+        switch (direction) {
+            case Direction::AFTER:
+                first = 0;
+                break;
+            case Direction::BEFORE:
+                first = sizes.size() - 1;
+                break;
+            default:
+                first = std::min(anchor, sizes.size() - 1);
+                break;
+        }
+        size_t last = first + 1;
+        size_t bytes = sizes[first];
+        bool growNewer = direction != Direction::BEFORE;
+        bool growOlder = direction != Direction::AFTER;
+        while (growNewer || growOlder) {
+            if (growNewer) {
+                if (last < sizes.size() && bytes + sizes[last] <= maxBytes) {
+                    bytes += sizes[last++];
+                }
+                else {
+                    growNewer = false;
+                }
+            }
+            if (growOlder) {
+                if (first > 0 && bytes + sizes[first - 1] <= maxBytes) {
+                    bytes += sizes[--first];
+                }
+                else {
+                    growOlder = false;
+                }
+            }
+        }
+        return {first, last};
+    }
+};
+
+
+#endif //IMSERVER_HISTORYPAGE_H
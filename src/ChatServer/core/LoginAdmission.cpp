@@ -0,0 +1,235 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "LoginAdmission.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "ConfigMgr.h"
+
+namespace {
+constexpr int DEFAULT_LOGIN_MAX_CONCURRENT = 32;
+constexpr size_t DEFAULT_LOGIN_QUEUE_SIZE = 4096;
+constexpr int DEFAULT_LOGIN_QUEUE_TIMEOUT_MS = 2000;
+constexpr int DEFAULT_LOGIN_TARGET_LATENCY_MS = 50;
+constexpr int DEFAULT_LOGIN_RETRY_AFTER_MS = 500;
+constexpr int DEFAULT_LOGIN_RETRY_AFTER_MAX_MS = 10000;
+
+// 并发许可调整周期，避免每次完成都调整导致抖动
+constexpr auto LIMIT_ADJUST_INTERVAL = std::chrono::milliseconds(100);
+// 许可占满时登录线程也按此周期醒来清理排队超时的请求
+constexpr auto EXPIRE_CHECK_INTERVAL = std::chrono::milliseconds(50);
+constexpr double LATENCY_EWMA_ALPHA = 0.1;
+}
+
+LoginAdmission::LoginAdmission()
+    : maxLimit_(DEFAULT_LOGIN_MAX_CONCURRENT), queueCapacity_(DEFAULT_LOGIN_QUEUE_SIZE),
+      queueTimeout_(DEFAULT_LOGIN_QUEUE_TIMEOUT_MS), targetLatencyMs_(DEFAULT_LOGIN_TARGET_LATENCY_MS),
+      retryAfterMs_(DEFAULT_LOGIN_RETRY_AFTER_MS), retryAfterMaxMs_(DEFAULT_LOGIN_RETRY_AFTER_MAX_MS),
+      lastMetricTime_(std::chrono::steady_clock::now()) {
+    auto& config = ConfigMgr::getInstance();
+    if (!config["ChatServer"]["LoginMaxConcurrent"].empty()) {
+        maxLimit_ = std::max(MIN_LIMIT, std::stoi(config["ChatServer"]["LoginMaxConcurrent"]));
+    }
+    if (!config["ChatServer"]["LoginQueueSize"].empty()) {
+        queueCapacity_ = std::stoul(config["ChatServer"]["LoginQueueSize"]);
+    }
+    if (!config["ChatServer"]["LoginQueueTimeoutMs"].empty()) {
+        queueTimeout_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["LoginQueueTimeoutMs"]));
+    }
+    if (!config["ChatServer"]["LoginTargetLatencyMs"].empty()) {
+        targetLatencyMs_ = std::stod(config["ChatServer"]["LoginTargetLatencyMs"]);
+    }
+    if (!config["ChatServer"]["LoginRetryAfterMs"].empty()) {
+        retryAfterMs_ = std::stoi(config["ChatServer"]["LoginRetryAfterMs"]);
+    }
+    if (!config["ChatServer"]["LoginRetryAfterMaxMs"].empty()) {
+        retryAfterMaxMs_ = std::max(retryAfterMs_, std::stoi(config["ChatServer"]["LoginRetryAfterMaxMs"]));
+    }
+    // 从一半许可起步，耗时正常再逐步放开
+    limit_ = std::max(MIN_LIMIT, maxLimit_ / 2);
+    lastAdjust_ = std::chrono::steady_clock::now();
+}
+
+LoginAdmission::~LoginAdmission() {
+    stop();
+}
+
+void LoginAdmission::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    // 登录要同步访问 Redis / MySQL，每个许可对应一个登录线程
+    for (int i = 0; i < maxLimit_; i++) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+void LoginAdmission::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    cond_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+
+    std::deque<Pending> remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        remaining.swap(queue_);
+    }
+    for (const auto& pending : remaining) {
+        pending.onRejected(retryAfterMs_);
+    }
+}
+
+void LoginAdmission::submit(const admittedTask &task, const rejectedCallback &onRejected) {
+    int retryAfter = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 许可占满时按排在前面的请求数估算等待，必然超时的请求直接拒绝，不占用队列
+        const double expectedWaitMs = avgLatencyMs_ * static_cast<double>(queue_.size() + 1) / limit_;
+        if (!running_ || queue_.size() >= queueCapacity_
+            || (inflight_ >= limit_ && expectedWaitMs > static_cast<double>(queueTimeout_.count()))) {
+            retryAfter = retryAfterMsLocked();
+        }
+        else {
+            queue_.push_back({task, onRejected, std::chrono::steady_clock::now() + queueTimeout_});
+        }
+    }
+
+    if (retryAfter > 0) {
+        metrics_.rejected.fetch_add(1, std::memory_order_relaxed);
+        onRejected(retryAfter);
+        return;
+    }
+    cond_.notify_one();
+}
+
+void LoginAdmission::workerLoop() {
+    while (running_) {
+        Pending pending;
+        std::vector<Pending> expired;
+        int retryAfter = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait_for(lock, EXPIRE_CHECK_INTERVAL, [this]() {
+                return !running_ || (!queue_.empty() && inflight_ < limit_);
+            });
+            if (!running_) {
+                return;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            while (!queue_.empty() && queue_.front().deadline <= now) {
+                expired.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            if (!expired.empty()) {
+                retryAfter = retryAfterMsLocked();
+            }
+            if (!queue_.empty() && inflight_ < limit_) {
+                pending = std::move(queue_.front());
+                queue_.pop_front();
+                inflight_++;
+            }
+        }
+
+        for (const auto& item : expired) {
+            metrics_.expired.fetch_add(1, std::memory_order_relaxed);
+            item.onRejected(retryAfter);
+        }
+        if (!pending.task) {
+            continue;
+        }
+
+        metrics_.admitted.fetch_add(1, std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            pending.task();
+        } catch (const std::exception& e) {
+            std::cout << "LoginAdmission: login task failed: " << e.what() << std::endl;
+        }
+        onCompleted(std::chrono::steady_clock::now() - start);
+    }
+}
+
+void LoginAdmission::onCompleted(const std::chrono::steady_clock::duration latency) {
+    bool grown = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inflight_--;
+        const double ms = std::chrono::duration<double, std::milli>(latency).count();
+        avgLatencyMs_ = avgLatencyMs_ == 0 ? ms : avgLatencyMs_ * (1 - LATENCY_EWMA_ALPHA) + ms * LATENCY_EWMA_ALPHA;
+
+        // 后端变慢时乘性减小许可，耗时正常且有积压时逐个放开
+        if (const auto now = std::chrono::steady_clock::now(); now - lastAdjust_ >= LIMIT_ADJUST_INTERVAL) {
+            lastAdjust_ = now;
+            if (avgLatencyMs_ > targetLatencyMs_) {
+                limit_ = std::max(MIN_LIMIT, limit_ * 3 / 4);
+            }
+            else if (!queue_.empty() && limit_ < maxLimit_) {
+                limit_++;
+                grown = true;
+            }
+        }
+    }
+    if (grown) {
+        cond_.notify_all();
+    }
+    else {
+        cond_.notify_one();
+    }
+}
+
+int LoginAdmission::retryAfterMsLocked() const {
+    // 按当前积压全部处理完所需的时间估算，再加 ±50% 抖动把重试打散
+    const double drainMs = avgLatencyMs_ * static_cast<double>(queue_.size() + inflight_) / limit_;
+    const double base = std::clamp(drainMs, static_cast<double>(retryAfterMs_), static_cast<double>(retryAfterMaxMs_));
+    thread_local std::mt19937 rng{std::random_device{}()};
+    std::uniform_real_distribution<double> jitter(0.5, 1.5);
+    return std::max(1, static_cast<int>(base * jitter(rng)));
+}
+
+void LoginAdmission::printMetrics() {
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - lastMetricTime_).count();
+    lastMetricTime_ = now;
+
+    const uint64_t admitted = metrics_.admitted.exchange(0, std::memory_order_relaxed);
+    const uint64_t rejected = metrics_.rejected.exchange(0, std::memory_order_relaxed);
+    const uint64_t expired = metrics_.expired.exchange(0, std::memory_order_relaxed);
+    if (admitted == 0 && rejected == 0 && expired == 0) {
+        return;
+    }
+
+    int limit = 0;
+    int inflight = 0;
+    size_t queued = 0;
+    double avgMs = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit = limit_;
+        inflight = inflight_;
+        queued = queue_.size();
+        avgMs = avgLatencyMs_;
+    }
+
+    std::cout << "[login] "
+              << "admitted/s=" << std::fixed << std::setprecision(0) << (elapsed > 0 ? admitted / elapsed : 0)
+              << " rejected=" << rejected
+              << " expired=" << expired
+              << " limit=" << limit
+              << " inflight=" << inflight
+              << " queued=" << queued
+              << " avg_ms=" << std::setprecision(1) << avgMs
+              << std::endl;
+}
@@ -0,0 +1,93 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_LOGINADMISSION_H
+#define IMSERVER_LOGINADMISSION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 登录准入控制。
+ *
+ * ChatServer 重启后全部客户端同时重连，登录要读用户信息、踢旧连接、写在线状态，
+ * 同一时刻打满 Redis / MySQL。这里把登录放到独立的登录线程执行：
+ *   - 并发许可 limit：同时执行的登录数上限，在 [MIN_LIMIT, LoginMaxConcurrent] 内按登录耗时自适应，
+ *     平均耗时超过 LoginTargetLatencyMs 乘性减小，低于目标且有排队时加一；
+ *   - 等待队列：容量 LoginQueueSize，排队超过 LoginQueueTimeoutMs 的请求不再执行；
+ *   - 拒绝：队列已满、预计等待超过截止时间或排队超时，回调 onRejected，给出按积压量估算并加随机抖动的
+ *     重试间隔，客户端错开重试，避免下一波同时到达。
+ *
+ * 监控 (Metrics):
+ *   - admitted / rejected / expired : 执行、入队即拒绝、排队超时的登录数
+ *   - limit / inflight / queued     : 当前并发许可、执行中、排队中
+ *   - avg_ms                        : 登录耗时（EWMA）
+ */
+class LoginAdmission {
+public:
+    typedef std::function<void()> admittedTask;
+    typedef std::function<void(int retryAfterMs)> rejectedCallback;
+
+    LoginAdmission();
+    ~LoginAdmission();
+
+    void start();
+    /// 停止登录线程，排队中的请求全部拒绝
+    void stop();
+
+    /// 申请登录许可，获得许可后在登录线程执行 task，否则调用 onRejected
+    void submit(const admittedTask& task, const rejectedCallback& onRejected);
+
+    void printMetrics();
+
+private:
+    struct Pending {
+        admittedTask task;
+        rejectedCallback onRejected;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void workerLoop();
+    /// 记录一次登录耗时并调整并发许可
+    void onCompleted(std::chrono::steady_clock::duration latency);
+    /// 按积压量估算重试间隔并加抖动，需持有 mutex_
+    int retryAfterMsLocked() const;
+
+    static constexpr int MIN_LIMIT = 2;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<Pending> queue_;
+    int limit_;
+    int inflight_ = 0;
+    double avgLatencyMs_ = 0;
+    std::chrono::steady_clock::time_point lastAdjust_;
+
+    int maxLimit_;
+    size_t queueCapacity_;
+    std::chrono::milliseconds queueTimeout_;
+    double targetLatencyMs_;
+    int retryAfterMs_;
+    int retryAfterMaxMs_;
+
+    std::atomic<bool> running_{false};
+    std::vector<std::thread> workers_;
+
+    struct Metrics {
+        std::atomic<uint64_t> admitted{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> expired{0};
+    } metrics_;
+
+    std::chrono::steady_clock::time_point lastMetricTime_;
+};
+
+
+#endif //IMSERVER_LOGINADMISSION_H
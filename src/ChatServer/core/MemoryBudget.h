@@ -0,0 +1,93 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_MEMORYBUDGET_H
+#define IMSERVER_MEMORYBUDGET_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 按字节计量的内存预算，限制 BatchWriter 中尚未落库的消息总量。
+ *
+ * IO 线程收到消息时 tryAcquire 申请该消息的估算字节数，消息写入 MySQL 或判定为毒消息后 release：
+ *   - 低于软上限：正常接收；
+ *   - 超过软上限、未超过硬上限：仍然接收，返回 SOFT，调用方在 ACK 中提示客户端降速；
+ *   - 申请后会超过硬上限：拒绝且不计入，调用方直接回复忙，消息不进入写入队列。
+ * 申请以 CAS 完成，并发申请也不会超过硬上限。硬上限为 0 时不限制，只做统计。
+ */
+class MemoryBudget {
+public:
+    enum class Admission {
+        ACCEPT,
+        SOFT,
+        REJECT,
+    };
+
+    struct Stats {
+        size_t usedBytes = 0;
+        size_t peakBytes = 0;
+        size_t softBytes = 0;
+        size_t hardBytes = 0;
+        uint64_t softAdmits = 0;    ///< 超过软上限时接收的消息数
+        uint64_t rejects = 0;       ///< 超过硬上限被拒绝的消息数
+    };
+
+    MemoryBudget(const size_t softBytes, const size_t hardBytes)
+        : hard_bytes_(hardBytes)
+        , soft_bytes_(hardBytes == 0 ? softBytes : std::min(softBytes, hardBytes)) {
+    }
+
+    Admission tryAcquire(const size_t bytes) {
+        size_t used = used_bytes_.load(std::memory_order_relaxed);
+        size_t next;
+        do {
+            next = used + bytes;
+            if (hard_bytes_ != 0 && next > hard_bytes_) {
+                rejects_.fetch_add(1, std::memory_order_relaxed);
+                return Admission::REJECT;
+            }
+        } while (!used_bytes_.compare_exchange_weak(used, next, std::memory_order_relaxed));
+
+        size_t peak = peak_bytes_.load(std::memory_order_relaxed);
+        while (next > peak && !peak_bytes_.compare_exchange_weak(peak, next, std::memory_order_relaxed)) {
+        }
+        if (soft_bytes_ != 0 && next > soft_bytes_) {
+            soft_admits_.fetch_add(1, std::memory_order_relaxed);
+            return Admission::SOFT;
+        }
+        return Admission::ACCEPT;
+    }
+
+    void release(const size_t bytes) {
+        used_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] size_t usedBytes() const { return used_bytes_.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] Stats stats() const {
+        Stats stats;
+        stats.usedBytes = usedBytes();
+        stats.peakBytes = peak_bytes_.load(std::memory_order_relaxed);
+        stats.softBytes = soft_bytes_;
+        stats.hardBytes = hard_bytes_;
+        stats.softAdmits = soft_admits_.load(std::memory_order_relaxed);
+        stats.rejects = rejects_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    const size_t hard_bytes_;
+    const size_t soft_bytes_;
+
+    std::atomic<size_t> used_bytes_{0};
+    std::atomic<size_t> peak_bytes_{0};
+    std::atomic<uint64_t> soft_admits_{0};
+    std::atomic<uint64_t> rejects_{0};
+};
+
+
+#endif //IMSERVER_MEMORYBUDGET_H
@@ -0,0 +1,78 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_MESSAGEIDGENERATOR_H
+#define IMSERVER_MESSAGEIDGENERATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief 按时间有序的 64 位消息 ID 生成器（Snowflake 布局）。
+ *
+ * ID 布局：0 | 毫秒时间戳 41 位（自 EPOCH_MS 起，约 69 年）| 机器号 10 位 | 序号 12 位。
+ * 机器号取自 ChatServer 配置 WorkerId，集群内各服务器必须不同，超出 [0, MAX_WORKER_ID] 时构造抛出
+ * std::out_of_range，不截断成可能与其他服务器相同的机器号。
+ *
+ * 内部状态是 (毫秒 << 12 | 序号) 的单个原子量，每次取号 CAS 到 max(当前时间, 上次 + 1)：
+ * 同一毫秒内序号递增，序号用尽时自动借用下一毫秒；时钟回拨时沿用上次的时间继续递增，
+ * 不阻塞也不产生重复 ID，时钟追上后恢复正常。
+ */
+class MessageIdGenerator {
+public:
+    static constexpr int WORKER_BITS = 10;
+    static constexpr int SEQUENCE_BITS = 12;
+    static constexpr int64_t MAX_WORKER_ID = (1 << WORKER_BITS) - 1;
+    /// 2026-01-01 00:00:00 UTC
+    static constexpr int64_t EPOCH_MS = 1767225600000LL;
+
+    explicit MessageIdGenerator(const int64_t workerId)
+        : worker_id_(workerId) {
+        if (workerId < 0 || workerId > MAX_WORKER_ID) {
+            throw std::out_of_range("WorkerId " + std::to_string(workerId) + " out of range [0, "
+                + std::to_string(MAX_WORKER_ID) + "]");
+        }
+    }
+
+    int64_t next() {
+        return nextAt(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    /// 以给定的当前时间（Unix 毫秒）取号，单测用来模拟时钟回拨
+    int64_t nextAt(const int64_t nowMs) {
+        const uint64_t floor = static_cast<uint64_t>(nowMs - EPOCH_MS) << SEQUENCE_BITS;
+        uint64_t last = state_.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            next = floor > last ? floor : last + 1;
+        } while (!state_.compare_exchange_weak(last, next, std::memory_order_relaxed));
+
+        const uint64_t ms = next >> SEQUENCE_BITS;
+        const uint64_t seq = next & ((1u << SEQUENCE_BITS) - 1);
+        return static_cast<int64_t>((ms << (WORKER_BITS + SEQUENCE_BITS))
+            | (static_cast<uint64_t>(worker_id_) << SEQUENCE_BITS) | seq);
+    }
+
+    [[nodiscard]] int64_t workerId() const { return worker_id_; }
+
+    static int64_t workerOf(const int64_t id) {
+        return (id >> SEQUENCE_BITS) & MAX_WORKER_ID;
+    }
+
+    /// ID 中的时间戳（Unix 毫秒）
+    static int64_t timestampOf(const int64_t id) {
+        return (id >> (WORKER_BITS + SEQUENCE_BITS)) + EPOCH_MS;
+    }
+
+private:
+    const int64_t worker_id_;
+    std::atomic<uint64_t> state_{0};
+};
+
+
+#endif //IMSERVER_MESSAGEIDGENERATOR_H
@@ -0,0 +1,951 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "MessageSearchIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char SEGMENT_MAGIC[4] = {'I', 'M', 'S', 'I'};
+constexpr uint32_t SEGMENT_VERSION = 1;
+constexpr const char* SEGMENT_SUFFIX = ".seg";
+constexpr char KEY_SEP = '\x1f';                // conv_id 与词之间的分隔符，不会出现在 conv_id 中
+constexpr size_t MAX_TERM_BYTES = 64;           // 超长的词（如链接）只取前缀作为倒排键，原文校验仍用整词
+constexpr size_t SNIPPET_BEFORE = 16;           // 片段中命中位置之前保留的字符数
+constexpr size_t SNIPPET_AFTER = 48;            // 命中位置及之后保留的字符数
+constexpr auto MAINTAIN_TICK = std::chrono::seconds(1);
+
+/// 段文件布局：头 | 键表 | 倒排表 | 消息表 | 字符串区，各区 8 字节对齐，全部以偏移量引用，
+/// mmap 后直接按结构体访问，不需要反序列化（本机字节序）
+struct SegmentHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t keyCount;
+    uint64_t postingCount;
+    uint64_t docCount;
+    int64_t minMsgId;
+    int64_t maxMsgId;
+    uint64_t keysOffset;
+    uint64_t postingsOffset;
+    uint64_t docsOffset;
+    uint64_t stringsOffset;
+    uint64_t size;
+};
+
+/// 键表按键的字节序排序，同一会话的键相邻
+struct KeyEntry {
+    uint64_t keyOffset;         // 相对字符串区
+    uint64_t postingStart;      // 倒排表下标
+    uint32_t keyLen;
+    uint32_t postingCount;
+};
+
+/// 消息表按 msgId 升序，倒排表中的消息下标因此也按 msgId 升序
+struct DocEntry {
+    int64_t msgId;
+    uint64_t convOffset;
+    uint64_t contentOffset;
+    int32_t senderUid;
+    uint32_t convLen;
+    uint32_t contentLen;
+    uint32_t reserved;
+};
+
+struct Doc {
+    int64_t msgId = 0;
+    int senderUid = 0;
+    std::string convId;
+    std::string content;
+};
+
+enum class CharClass : uint8_t {
+    SEP,
+    WORD,
+    CJK,
+};
+
+uint64_t align8(const uint64_t offset) {
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+/// 解码 s[i] 起的一个 UTF-8 字符并前移 i，非法编码返回 false 且只前移一个字节
+bool decodeUtf8(const std::string& s, size_t& i, uint32_t& cp) {
+    const auto lead = static_cast<uint8_t>(s[i]);
+    size_t len;
+    if (lead < 0x80) {
+        cp = lead;
+        i++;
+        return true;
+    }
+    if ((lead & 0xE0) == 0xC0) {
+        len = 2;
+        cp = lead & 0x1F;
+    }
+    else if ((lead & 0xF0) == 0xE0) {
+        len = 3;
+        cp = lead & 0x0F;
+    }
+    else if ((lead & 0xF8) == 0xF0) {
+        len = 4;
+        cp = lead & 0x07;
+    }
+    else {
+        i++;
+        return false;
+    }
+    if (i + len > s.size()) {
+        i++;
+        return false;
+    }
+    for (size_t k = 1; k < len; k++) {
+        const auto c = static_cast<uint8_t>(s[i + k]);
+        if ((c & 0xC0) != 0x80) {
+            i++;
+            return false;
+        }
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    i += len;
+    return true;
+}
+
+CharClass classify(const uint32_t cp) {
+    if (cp < 0x80) {
+        return std::isalnum(static_cast<int>(cp)) ? CharClass::WORD : CharClass::SEP;
+    }
+    if ((cp >= 0x3040 && cp <= 0x30FF)         // 平假名、片假名
+        || (cp >= 0x3400 && cp <= 0x4DBF)      // 扩展 A
+        || (cp >= 0x4E00 && cp <= 0x9FFF)      // 基本汉字
+        || (cp >= 0xAC00 && cp <= 0xD7AF)      // 韩文音节
+        || (cp >= 0xF900 && cp <= 0xFAFF)      // 兼容汉字
+        || (cp >= 0x20000 && cp <= 0x2FFFF)) { // 扩展 B 及以后
+        return CharClass::CJK;
+    }
+    if (cp <= 0xBF                              // Latin-1 标点、空白
+        || (cp >= 0x2000 && cp <= 0x2BFF)      // 通用标点、符号、箭头
+        || (cp >= 0x3000 && cp <= 0x303F)      // 中日韩标点
+        || (cp >= 0xFE00 && cp <= 0xFE6F)      // 变体选择符、竖排与小写标点
+        || (cp >= 0xFF00 && cp <= 0xFFEF)      // 全角标点
+        || cp >= 0x1F000) {                     // emoji
+        return CharClass::SEP;
+    }
+    return CharClass::WORD;
+}
+
+/**
+ * @brief 把文本切成词：连续的 WORD 字符为一个词（ASCII 转小写），连续的 CJK 字符为一段，
+ *        其余字符与非法编码为分隔符。fn(token, isCjk)
+ */
+template <typename Fn>
+void forEachToken(const std::string& text, Fn&& fn) {
+    std::string token;
+    bool cjk = false;
+    const auto emit = [&] {
+        if (!token.empty()) {
+            fn(token, cjk);
+            token.clear();
+        }
+    };
+    size_t i = 0;
+    while (i < text.size()) {
+        const size_t start = i;
+        uint32_t cp = 0;
+        const CharClass cls = decodeUtf8(text, i, cp) ? classify(cp) : CharClass::SEP;
+        if (cls == CharClass::SEP) {
+            emit();
+            continue;
+        }
+        if ((cls == CharClass::CJK) != cjk) {
+            emit();
+            cjk = cls == CharClass::CJK;
+        }
+        for (size_t k = start; k < i; k++) {
+            token.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(text[k]))));
+        }
+    }
+    emit();
+}
+
+/// 一段 CJK 文字拆成单个字符（均为合法 UTF-8）
+std::vector<std::string> splitCodepoints(const std::string& run) {
+    std::vector<std::string> chars;
+    for (size_t i = 0; i < run.size();) {
+        const size_t start = i;
+        uint32_t cp = 0;
+        decodeUtf8(run, i, cp);
+        chars.emplace_back(run, start, i - start);
+    }
+    return chars;
+}
+
+std::string asciiLower(const std::string& s) {
+    std::string out = s;
+    for (auto& c : out) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+std::string makeKey(const std::string& convId, const std::string& term) {
+    std::string key;
+    key.reserve(convId.size() + 1 + term.size());
+    key.append(convId).push_back(KEY_SEP);
+    key.append(term);
+    return key;
+}
+
+/// 把一批消息编码为段文件内容
+std::string buildSegment(std::vector<Doc> docs) {
+    std::sort(docs.begin(), docs.end(), [](const Doc& a, const Doc& b) {
+        return a.msgId < b.msgId;
+    });
+    docs.erase(std::unique(docs.begin(), docs.end(), [](const Doc& a, const Doc& b) {
+        return a.msgId == b.msgId;
+    }), docs.end());
+
+    std::map<std::string, std::vector<uint32_t>> postings;
+    for (uint32_t d = 0; d < docs.size(); d++) {
+        for (const auto& term : MessageSearchIndex::tokenize(docs[d].content)) {
+            postings[makeKey(docs[d].convId, term)].push_back(d);
+        }
+    }
+
+    std::string strings;
+    std::vector<KeyEntry> keys;
+    keys.reserve(postings.size());
+    uint64_t postingCount = 0;
+    for (const auto& [key, list] : postings) {
+        keys.push_back({strings.size(), postingCount, static_cast<uint32_t>(key.size()),
+                        static_cast<uint32_t>(list.size())});
+        strings.append(key);
+        postingCount += list.size();
+    }
+    std::unordered_map<std::string, uint64_t> convOffsets;
+    std::vector<DocEntry> entries;
+    entries.reserve(docs.size());
+    for (const auto& doc : docs) {
+        auto [it, inserted] = convOffsets.emplace(doc.convId, strings.size());
+        if (inserted) {
+            strings.append(doc.convId);
+        }
+        entries.push_back({doc.msgId, it->second, strings.size(), doc.senderUid,
+                           static_cast<uint32_t>(doc.convId.size()), static_cast<uint32_t>(doc.content.size()), 0});
+        strings.append(doc.content);
+    }
+
+    SegmentHeader header{};
+    memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = SEGMENT_VERSION;
+    header.keyCount = keys.size();
+    header.postingCount = postingCount;
+    header.docCount = docs.size();
+    header.minMsgId = docs.empty() ? 0 : docs.front().msgId;
+    header.maxMsgId = docs.empty() ? 0 : docs.back().msgId;
+    header.keysOffset = align8(sizeof(SegmentHeader));
+    header.postingsOffset = align8(header.keysOffset + keys.size() * sizeof(KeyEntry));
+    header.docsOffset = align8(header.postingsOffset + postingCount * sizeof(uint32_t));
+    header.stringsOffset = align8(header.docsOffset + entries.size() * sizeof(DocEntry));
+    header.size = header.stringsOffset + strings.size();
+
+    std::string buffer(header.size, '\0');
+    memcpy(buffer.data(), &header, sizeof(header));
+    if (!keys.empty()) {
+        memcpy(buffer.data() + header.keysOffset, keys.data(), keys.size() * sizeof(KeyEntry));
+    }
+    char* out = buffer.data() + header.postingsOffset;
+    for (const auto& [key, list] : postings) {
+        memcpy(out, list.data(), list.size() * sizeof(uint32_t));
+        out += list.size() * sizeof(uint32_t);
+    }
+    if (!entries.empty()) {
+        memcpy(buffer.data() + header.docsOffset, entries.data(), entries.size() * sizeof(DocEntry));
+    }
+    memcpy(buffer.data() + header.stringsOffset, strings.data(), strings.size());
+    return buffer;
+}
+
+bool writeFile(const std::string& path, const std::string& buffer) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    size_t written = 0;
+    while (written < buffer.size()) {
+        const ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    const bool ok = written == buffer.size() && ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+}
+
+/// 只读段：mmap 的段文件，或未配置目录时的内存副本
+class MessageSearchIndex::Segment {
+public:
+    static std::shared_ptr<const Segment> open(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SegmentHeader))) {
+            ::close(fd);
+            return nullptr;
+        }
+        void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            return nullptr;
+        }
+        std::shared_ptr<Segment> segment(new Segment());
+        segment->map_ = map;
+        segment->path_ = path;
+        if (!segment->bind(static_cast<const char*>(map), st.st_size)) {
+            return nullptr;
+        }
+        return segment;
+    }
+
+    static std::shared_ptr<const Segment> fromBuffer(const std::string& buffer) {
+        std::shared_ptr<Segment> segment(new Segment());
+        // 按 8 字节对齐存放，与 mmap 一样可以直接按结构体访问
+        segment->buffer_.resize(align8(buffer.size()) / sizeof(uint64_t));
+        memcpy(segment->buffer_.data(), buffer.data(), buffer.size());
+        if (!segment->bind(reinterpret_cast<const char*>(segment->buffer_.data()), buffer.size())) {
+            return nullptr;
+        }
+        return segment;
+    }
+
+    ~Segment() {
+        if (map_ != nullptr) {
+            ::munmap(map_, size_);
+        }
+    }
+
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    /// 从最新的消息向前取同时包含全部词、msgId 小于 upper 的消息，最多 limit 条
+    void search(const std::string& convId, const std::vector<QueryWord>& words, const int64_t upper,
+                const size_t limit, std::vector<Hit>& hits) const {
+        std::vector<std::pair<const uint32_t*, uint32_t>> lists;
+        for (const auto& word : words) {
+            for (const auto& term : word.terms) {
+                const auto list = lookup(makeKey(convId, term));
+                if (list.second == 0) {
+                    return;
+                }
+                lists.push_back(list);
+            }
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+            return a.second < b.second;
+        });
+
+        const auto* begin = lists.front().first;
+        const auto* it = std::partition_point(begin, begin + lists.front().second, [&](const uint32_t d) {
+            return docs_[d].msgId < upper;
+        });
+        size_t found = 0;
+        while (it != begin && found < limit) {
+            const uint32_t d = *--it;
+            const bool all = std::all_of(lists.begin() + 1, lists.end(), [d](const auto& list) {
+                return std::binary_search(list.first, list.first + list.second, d);
+            });
+            if (!all) {
+                continue;
+            }
+            const auto& doc = docs_[d];
+            std::string content(strings_ + doc.contentOffset, doc.contentLen);
+            if (!matchesAll(content, words)) {
+                continue;
+            }
+            hits.push_back({doc.msgId, convId, doc.senderUid, std::move(content)});
+            found++;
+        }
+    }
+
+    void collect(std::vector<Doc>& docs) const {
+        for (uint64_t i = 0; i < header_.docCount; i++) {
+            const auto& doc = docs_[i];
+            docs.push_back({doc.msgId, doc.senderUid, std::string(strings_ + doc.convOffset, doc.convLen),
+                            std::string(strings_ + doc.contentOffset, doc.contentLen)});
+        }
+    }
+
+    [[nodiscard]] int64_t minMsgId() const { return header_.minMsgId; }
+    [[nodiscard]] int64_t maxMsgId() const { return header_.maxMsgId; }
+    [[nodiscard]] size_t docCount() const { return header_.docCount; }
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] const std::string& path() const { return path_; }
+
+private:
+    Segment() = default;
+
+    /// 校验头部与全部偏移量，损坏的段文件不加载
+    bool bind(const char* data, const size_t size) {
+        size_ = size;
+        memcpy(&header_, data, sizeof(header_));
+        const auto& h = header_;
+        if (memcmp(h.magic, SEGMENT_MAGIC, sizeof(h.magic)) != 0 || h.version != SEGMENT_VERSION || h.size != size
+            || h.keyCount > size || h.postingCount > size || h.docCount > size
+            || h.keysOffset % 8 != 0 || h.postingsOffset % 8 != 0 || h.docsOffset % 8 != 0
+            || h.keysOffset < sizeof(SegmentHeader)
+            || h.keysOffset + h.keyCount * sizeof(KeyEntry) > h.postingsOffset
+            || h.postingsOffset + h.postingCount * sizeof(uint32_t) > h.docsOffset
+            || h.docsOffset + h.docCount * sizeof(DocEntry) > h.stringsOffset
+            || h.stringsOffset > size) {
+            return false;
+        }
+        keys_ = reinterpret_cast<const KeyEntry*>(data + h.keysOffset);
+        postings_ = reinterpret_cast<const uint32_t*>(data + h.postingsOffset);
+        docs_ = reinterpret_cast<const DocEntry*>(data + h.docsOffset);
+        strings_ = data + h.stringsOffset;
+        const uint64_t stringsLen = size - h.stringsOffset;
+
+        for (uint64_t i = 0; i < h.keyCount; i++) {
+            const auto& key = keys_[i];
+            if (key.keyOffset + key.keyLen > stringsLen || key.postingStart + key.postingCount > h.postingCount) {
+                return false;
+            }
+        }
+        for (uint64_t i = 0; i < h.postingCount; i++) {
+            if (postings_[i] >= h.docCount) {
+                return false;
+            }
+        }
+        for (uint64_t i = 0; i < h.docCount; i++) {
+            const auto& doc = docs_[i];
+            if (doc.convOffset + doc.convLen > stringsLen || doc.contentOffset + doc.contentLen > stringsLen) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::pair<const uint32_t*, uint32_t> lookup(const std::string& key) const {
+        const auto* end = keys_ + header_.keyCount;
+        const auto* it = std::lower_bound(keys_, end, key, [this](const KeyEntry& entry, const std::string& k) {
+            return std::string_view(strings_ + entry.keyOffset, entry.keyLen) < k;
+        });
+        if (it == end || std::string_view(strings_ + it->keyOffset, it->keyLen) != key) {
+            return {nullptr, 0};
+        }
+        return {postings_ + it->postingStart, it->postingCount};
+    }
+
+    static bool matchesAll(const std::string& content, const std::vector<QueryWord>& words) {
+        const std::string lower = asciiLower(content);
+        return std::all_of(words.begin(), words.end(), [&](const QueryWord& word) {
+            return lower.find(word.phrase) != std::string::npos;
+        });
+    }
+
+    friend struct MessageSearchIndex::MemSegment;
+
+    void* map_ = nullptr;
+    std::vector<uint64_t> buffer_;
+    std::string path_;
+    size_t size_ = 0;
+    SegmentHeader header_{};
+    const KeyEntry* keys_ = nullptr;
+    const uint32_t* postings_ = nullptr;
+    const DocEntry* docs_ = nullptr;
+    const char* strings_ = nullptr;
+};
+
+/// 可写的内存段，倒排表中的消息下标按加入顺序递增
+struct MessageSearchIndex::MemSegment {
+    std::vector<Doc> docs;
+    std::unordered_map<std::string, std::vector<uint32_t>> postings;
+    std::chrono::steady_clock::time_point createdAt = std::chrono::steady_clock::now();
+
+    void search(const std::string& convId, const std::vector<QueryWord>& words, const int64_t upper,
+                const size_t limit, std::vector<Hit>& hits) const {
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (const auto& word : words) {
+            for (const auto& term : word.terms) {
+                const auto it = postings.find(makeKey(convId, term));
+                if (it == postings.end()) {
+                    return;
+                }
+                lists.push_back(&it->second);
+            }
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) {
+            return a->size() < b->size();
+        });
+
+        // 加入顺序与 msgId 顺序不完全一致，候选按 msgId 排序后再校验
+        std::vector<uint32_t> candidates;
+        for (const uint32_t d : *lists.front()) {
+            if (docs[d].msgId >= upper) {
+                continue;
+            }
+            const bool all = std::all_of(lists.begin() + 1, lists.end(), [d](const auto* list) {
+                return std::binary_search(list->begin(), list->end(), d);
+            });
+            if (all) {
+                candidates.push_back(d);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [this](const uint32_t a, const uint32_t b) {
+            return docs[a].msgId > docs[b].msgId;
+        });
+        size_t found = 0;
+        for (const uint32_t d : candidates) {
+            if (found >= limit) {
+                break;
+            }
+            if (!Segment::matchesAll(docs[d].content, words)) {
+                continue;
+            }
+            hits.push_back({docs[d].msgId, convId, docs[d].senderUid, docs[d].content});
+            found++;
+        }
+    }
+};
+
+MessageSearchIndex::MessageSearchIndex(const Options& options)
+    : options_(options), partitions_(std::make_unique<Partition[]>(PARTITIONS)) {
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        partitions_[i].mem = std::make_shared<MemSegment>();
+    }
+}
+
+MessageSearchIndex::~MessageSearchIndex() {
+    stop();
+}
+
+bool MessageSearchIndex::start() {
+    if (!options_.dir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(options_.dir, ec);
+        if (ec) {
+            std::cout << "[MessageSearchIndex] create dir " << options_.dir << " failed: " << ec.message()
+                      << std::endl;
+            return false;
+        }
+
+        // 文件名 pNN-SEQ.seg，SEQ 全局递增，按 SEQ 加载即恢复每个分区的段顺序
+        std::vector<std::tuple<uint64_t, size_t, std::string>> files;
+        for (const auto& entry : std::filesystem::directory_iterator(options_.dir, ec)) {
+            const std::string path = entry.path().string();
+            if (entry.path().extension() == ".tmp") {
+                // 封存或合并时崩溃留下的半个文件
+                std::filesystem::remove(entry.path(), ec);
+                continue;
+            }
+            size_t partition = 0;
+            uint64_t seq = 0;
+            if (entry.path().extension() != SEGMENT_SUFFIX
+                || std::sscanf(entry.path().filename().c_str(), "p%zu-%" SCNu64, &partition, &seq) != 2
+                || partition >= PARTITIONS) {
+                std::cout << "[MessageSearchIndex] ignore unknown file " << entry.path() << std::endl;
+                continue;
+            }
+            files.emplace_back(seq, partition, path);
+        }
+        std::sort(files.begin(), files.end());
+
+        uint64_t maxSeq = 0;
+        size_t loaded = 0;
+        for (const auto& [seq, partition, path] : files) {
+            maxSeq = std::max(maxSeq, seq);
+            auto segment = Segment::open(path);
+            if (!segment) {
+                std::cout << "[MessageSearchIndex] load " << path << " failed, skipped" << std::endl;
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(partitions_[partition].mutex);
+            partitions_[partition].segments.push_back(std::move(segment));
+            loaded++;
+        }
+        next_seq_ = maxSeq + 1;
+        if (loaded > 0) {
+            std::cout << "[MessageSearchIndex] loaded " << loaded << " segments from " << options_.dir << std::endl;
+        }
+    }
+
+    running_ = true;
+    thread_ = std::thread(&MessageSearchIndex::maintainLoop, this);
+    return true;
+}
+
+void MessageSearchIndex::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+        flush();
+    }
+}
+
+void MessageSearchIndex::add(const MessageInfo& msg) {
+    if (!msg.convId || !msg.content || msg.servId <= 0 || msg.type == 2 || msg.type == 3 || msg.type == 4) {
+        return;
+    }
+    const auto terms = tokenize(*msg.content);
+    if (terms.empty()) {
+        return;
+    }
+    std::vector<std::string> keys;
+    keys.reserve(terms.size());
+    for (const auto& term : terms) {
+        keys.push_back(makeKey(*msg.convId, term));
+    }
+
+    auto& partition = partitions_[partitionOf(*msg.convId)];
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(partition.mutex);
+        auto& mem = *partition.mem;
+        if (mem.docs.empty()) {
+            mem.createdAt = std::chrono::steady_clock::now();
+        }
+        const auto d = static_cast<uint32_t>(mem.docs.size());
+        mem.docs.push_back({msg.servId, msg.fromUid, *msg.convId, *msg.content});
+        for (auto& key : keys) {
+            mem.postings[std::move(key)].push_back(d);
+        }
+        count = mem.docs.size();
+    }
+    metrics_.docs.fetch_add(1, std::memory_order_relaxed);
+    if (count == options_.sealDocs) {
+        wake_.notify_one();
+    }
+}
+
+bool MessageSearchIndex::search(const std::vector<std::string>& convIds, const std::string& query,
+                                const int64_t before, const int limit, std::vector<Hit>& hits) const {
+    const auto start = std::chrono::steady_clock::now();
+    hits.clear();
+    std::vector<QueryWord> words;
+    analyze(query, words);
+    if (words.empty()) {
+        return false;
+    }
+    if (limit <= 0) {
+        return true;
+    }
+    const int64_t upper = before > 0 ? before : std::numeric_limits<int64_t>::max();
+    const auto want = static_cast<size_t>(limit);
+
+    for (const auto& convId : convIds) {
+        const auto& partition = partitions_[partitionOf(convId)];
+        std::vector<Hit> found;
+        std::shared_ptr<const MemSegment> sealing;
+        std::vector<std::shared_ptr<const Segment>> segments;
+        {
+            std::lock_guard<std::mutex> lock(partition.mutex);
+            partition.mem->search(convId, words, upper, want, found);
+            sealing = partition.sealing;
+            segments = partition.segments;
+        }
+        if (sealing) {
+            sealing->search(convId, words, upper, want, found);
+        }
+        // 段按封存顺序从新到旧查，已有 limit 条都比某段新时跳过该段；消息落库后才加入索引，死信重投、
+        // WAL 重放的旧消息会封存在更新的段中，各段 ID 范围交叠，更早的段仍可能有更新的消息，不能提前结束
+        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+            const auto& segment = *it;
+            if (segment->docCount() == 0 || segment->minMsgId() >= upper) {
+                continue;
+            }
+            if (found.size() >= want) {
+                std::nth_element(found.begin(), found.begin() + (want - 1), found.end(),
+                                 [](const Hit& a, const Hit& b) { return a.msgId > b.msgId; });
+                if (found[want - 1].msgId > segment->maxMsgId()) {
+                    continue;
+                }
+            }
+            segment->search(convId, words, upper, want, found);
+        }
+        std::move(found.begin(), found.end(), std::back_inserter(hits));
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+        return a.msgId > b.msgId;
+    });
+    // 合并段的旧文件删除前崩溃时，同一条消息会出现在两个段中
+    hits.erase(std::unique(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+        return a.msgId == b.msgId;
+    }), hits.end());
+    if (hits.size() > want) {
+        hits.resize(want);
+    }
+    for (auto& hit : hits) {
+        hit.snippet = snippetOf(hit.snippet, words);
+    }
+
+    metrics_.queries.fetch_add(1, std::memory_order_relaxed);
+    metrics_.queryUs.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    return true;
+}
+
+void MessageSearchIndex::flush() {
+    maintain(true);
+}
+
+std::vector<std::string> MessageSearchIndex::tokenize(const std::string& text) {
+    std::vector<std::string> terms;
+    forEachToken(text, [&terms](const std::string& token, const bool cjk) {
+        if (!cjk) {
+            terms.push_back(token.substr(0, MAX_TERM_BYTES));
+            return;
+        }
+        const auto chars = splitCodepoints(token);
+        for (size_t i = 0; i < chars.size(); i++) {
+            terms.push_back(chars[i]);
+            if (i + 1 < chars.size()) {
+                terms.push_back(chars[i] + chars[i + 1]);
+            }
+        }
+    });
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    return terms;
+}
+
+MessageSearchIndex::Stats MessageSearchIndex::stats() const {
+    Stats s;
+    s.docs = metrics_.docs.load(std::memory_order_relaxed);
+    s.queries = metrics_.queries.load(std::memory_order_relaxed);
+    s.queryUs = metrics_.queryUs.load(std::memory_order_relaxed);
+    s.seals = metrics_.seals.load(std::memory_order_relaxed);
+    s.compactions = metrics_.compactions.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        std::lock_guard<std::mutex> lock(partitions_[i].mutex);
+        s.memDocs += partitions_[i].mem->docs.size();
+        if (partitions_[i].sealing) {
+            s.memDocs += partitions_[i].sealing->docs.size();
+        }
+        s.segments += partitions_[i].segments.size();
+        for (const auto& segment : partitions_[i].segments) {
+            s.segmentBytes += segment->size();
+        }
+    }
+    return s;
+}
+
+void MessageSearchIndex::printMetrics() const {
+    const auto s = stats();
+    std::cout << "[search_index] "
+              << "docs=" << s.docs
+              << " mem_docs=" << s.memDocs
+              << " segments=" << s.segments
+              << " mb=" << s.segmentBytes / (1024 * 1024)
+              << " queries=" << s.queries
+              << " avg_us=" << (s.queries > 0 ? s.queryUs / s.queries : 0)
+              << " seals=" << s.seals
+              << " compactions=" << s.compactions
+              << std::endl;
+}
+
+void MessageSearchIndex::analyze(const std::string& text, std::vector<QueryWord>& words) {
+    forEachToken(text, [&words](const std::string& token, const bool cjk) {
+        QueryWord word{token, {}};
+        if (!cjk) {
+            word.terms.push_back(token.substr(0, MAX_TERM_BYTES));
+        }
+        else {
+            const auto chars = splitCodepoints(token);
+            if (chars.size() == 1) {
+                word.terms.push_back(token);
+            }
+            for (size_t i = 0; i + 1 < chars.size(); i++) {
+                word.terms.push_back(chars[i] + chars[i + 1]);
+            }
+            std::sort(word.terms.begin(), word.terms.end());
+            word.terms.erase(std::unique(word.terms.begin(), word.terms.end()), word.terms.end());
+        }
+        words.push_back(std::move(word));
+    });
+}
+
+std::string MessageSearchIndex::snippetOf(const std::string& content, const std::vector<QueryWord>& words) {
+    const std::string lower = asciiLower(content);
+    size_t pos = std::string::npos;
+    for (const auto& word : words) {
+        pos = std::min(pos, lower.find(word.phrase));
+    }
+    if (pos == std::string::npos) {
+        pos = 0;
+    }
+    const auto isContinuation = [&content](const size_t i) {
+        return i < content.size() && (static_cast<uint8_t>(content[i]) & 0xC0) == 0x80;
+    };
+    size_t first = pos;
+    for (size_t n = 0; n < SNIPPET_BEFORE && first > 0; n++) {
+        do {
+            first--;
+        } while (first > 0 && isContinuation(first));
+    }
+    size_t last = pos;
+    for (size_t n = 0; n < SNIPPET_AFTER && last < content.size(); n++) {
+        do {
+            last++;
+        } while (isContinuation(last));
+    }
+    std::string snippet;
+    if (first > 0) {
+        snippet = "…";
+    }
+    snippet.append(content, first, last - first);
+    if (last < content.size()) {
+        snippet.append("…");
+    }
+    return snippet;
+}
+
+size_t MessageSearchIndex::partitionOf(const std::string& convId) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char c : convId) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash % PARTITIONS;
+}
+
+void MessageSearchIndex::maintainLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            if (!running_) {
+                break;
+            }
+            wake_.wait_for(lock, MAINTAIN_TICK);
+            if (!running_) {
+                break;
+            }
+        }
+        maintain(false);
+    }
+}
+
+void MessageSearchIndex::maintain(const bool force) {
+    std::lock_guard<std::mutex> guard(maintain_mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        bool due;
+        {
+            std::lock_guard<std::mutex> lock(partitions_[i].mutex);
+            const auto& mem = *partitions_[i].mem;
+            due = !mem.docs.empty() && (force || mem.docs.size() >= options_.sealDocs
+                                        || now - mem.createdAt >= options_.sealInterval);
+        }
+        if (due) {
+            seal(i);
+        }
+        compact(i);
+    }
+}
+
+void MessageSearchIndex::seal(const size_t partition) {
+    auto& p = partitions_[partition];
+    std::shared_ptr<const MemSegment> sealing;
+    {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        sealing = p.mem;
+        p.sealing = sealing;
+        p.mem = std::make_shared<MemSegment>();
+    }
+    // 编码与写文件期间新消息进入新的内存段，正在封存的段仍参与搜索
+    auto segment = persist(buildSegment(sealing->docs), partition);
+    {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        p.segments.push_back(std::move(segment));
+        p.sealing.reset();
+    }
+    metrics_.seals.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MessageSearchIndex::compact(const size_t partition) {
+    auto& p = partitions_[partition];
+    std::vector<std::shared_ptr<const Segment>> segments;
+    {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        segments = p.segments;
+    }
+    if (segments.size() <= options_.maxSegments) {
+        return;
+    }
+    // 分层合并：从最新的段向前，取大小不超过已选总量两倍的段，避免反复重写大段
+    size_t first = segments.size() - 1;
+    size_t bytes = segments.back()->size();
+    while (first > 0 && segments[first - 1]->size() <= 2 * bytes) {
+        bytes += segments[--first]->size();
+    }
+    if (first + 1 > options_.maxSegments) {
+        first = 0;
+    }
+
+    std::vector<Doc> docs;
+    for (size_t i = first; i < segments.size(); i++) {
+        segments[i]->collect(docs);
+    }
+    auto merged = persist(buildSegment(std::move(docs)), partition);
+    {
+        // 封存与合并串行执行，期间段列表不会变化
+        std::lock_guard<std::mutex> lock(p.mutex);
+        p.segments.erase(p.segments.begin() + static_cast<std::ptrdiff_t>(first), p.segments.end());
+        p.segments.push_back(std::move(merged));
+    }
+    // 正在进行的搜索仍持有旧段，删除文件后映射在其释放前一直有效
+    for (size_t i = first; i < segments.size(); i++) {
+        if (!segments[i]->path().empty()) {
+            ::unlink(segments[i]->path().c_str());
+        }
+    }
+    metrics_.compactions.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const MessageSearchIndex::Segment> MessageSearchIndex::persist(std::string buffer,
+                                                                               const size_t partition) {
+    if (!options_.dir.empty()) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "p%02zu-%012" PRIu64 "%s", partition, next_seq_.fetch_add(1),
+                      SEGMENT_SUFFIX);
+        const std::string path = (std::filesystem::path(options_.dir) / name).string();
+        const std::string tmp = path + ".tmp";
+        if (writeFile(tmp, buffer) && ::rename(tmp.c_str(), path.c_str()) == 0) {
+            if (auto segment = Segment::open(path)) {
+                return segment;
+            }
+        }
+        std::cout << "[MessageSearchIndex] write " << path << " failed: " << strerror(errno)
+                  << ", segment kept in memory" << std::endl;
+        ::unlink(tmp.c_str());
+    }
+    return Segment::fromBuffer(buffer);
+}
@@ -0,0 +1,144 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_MESSAGESEARCHINDEX_H
+#define IMSERVER_MESSAGESEARCHINDEX_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/model/MessageInfo.h"
+
+/**
+ * @brief 聊天消息的本地全文索引：BatchWriter 写入 MySQL 成功后加入，搜索不查询 MySQL。
+ *
+ * 倒排键为 conv_id + 词，按用户搜索时只查该用户所在的会话：
+ *   - 分词：ASCII 字母数字按词并转小写；中日韩文字按单字 + 相邻二字切分，查询时多字词取二字 AND，
+ *     候选消息再按原文逐词校验，去掉二字不相邻的误命中；
+ *   - 按 conv_id 哈希分为 16 个分区，每个分区一个可写的内存段加若干只读段；
+ *   - 内存段达到 SearchSealDocs 条或超过 SearchSealIntervalMs 时由后台线程封存为只读段：
+ *     键表、倒排表、消息表、字符串区连续存放，全部以偏移量引用，写入 SearchIndexDir 后 mmap 打开；
+ *   - 分区的只读段超过 SearchMaxSegments 个时后台合并为一个，合并完成后删除旧段文件；
+ *   - 启动时 mmap 加载目录中的段；内存段只在封存时落盘，进程崩溃时丢失最近未封存的部分。
+ *
+ * 监控 (Metrics):
+ *   - docs / mem_docs        : 累计加入的消息数 / 尚未封存的消息数
+ *   - segments / mb          : 只读段数 / 只读段总字节数
+ *   - queries / avg_us       : 搜索次数 / 平均耗时
+ *   - seals / compactions    : 累计封存 / 合并次数
+ */
+class MessageSearchIndex {
+public:
+    struct Options {
+        std::string dir;                                ///< 段文件目录，为空时只读段只在内存中
+        size_t sealDocs = 4096;
+        std::chrono::milliseconds sealInterval{60000};
+        size_t maxSegments = 8;
+    };
+
+    struct Hit {
+        int64_t msgId = 0;      ///< serverId
+        std::string convId;
+        int senderUid = 0;
+        std::string snippet;    ///< 命中位置前后的片段
+    };
+
+    struct Stats {
+        uint64_t docs = 0;
+        uint64_t queries = 0;
+        uint64_t queryUs = 0;
+        uint64_t seals = 0;
+        uint64_t compactions = 0;
+        size_t memDocs = 0;
+        size_t segments = 0;
+        size_t segmentBytes = 0;
+    };
+
+    explicit MessageSearchIndex(const Options& options);
+    ~MessageSearchIndex();
+
+    /// 加载目录中已有的段并启动后台封存、合并线程
+    bool start();
+    /// 停止后台线程并封存内存段
+    void stop();
+
+    /// 加入已落库的消息，图片、文件、视频消息不索引
+    void add(const MessageInfo& msg);
+    /**
+     * @brief 在 convIds 中搜索包含 query 全部词的消息，按 serverId 倒序。
+     * @param before 只返回 serverId 小于 before 的消息，0 为不限，用于翻页
+     * @return query 中没有可搜索的词时返回 false
+     */
+    bool search(const std::vector<std::string>& convIds, const std::string& query, int64_t before, int limit,
+                std::vector<Hit>& hits) const;
+    /// 立即封存全部内存段，并合并段数超限的分区
+    void flush();
+
+    /// 索引用的分词结果（已去重）
+    static std::vector<std::string> tokenize(const std::string& text);
+
+    [[nodiscard]] Stats stats() const;
+    void printMetrics() const;
+
+private:
+    class Segment;
+    struct MemSegment;
+
+    struct Partition {
+        mutable std::mutex mutex;
+        std::shared_ptr<MemSegment> mem;                    ///< 可写，读写都持有分区锁
+        std::shared_ptr<const MemSegment> sealing;          ///< 正在封存，只读，封存完成前仍参与搜索
+        std::vector<std::shared_ptr<const Segment>> segments;
+    };
+
+    /// 查询中的一个词：倒排查找用的 terms 与校验原文用的 phrase
+    struct QueryWord {
+        std::string phrase;
+        std::vector<std::string> terms;
+    };
+
+    static void analyze(const std::string& text, std::vector<QueryWord>& words);
+    static std::string snippetOf(const std::string& content, const std::vector<QueryWord>& words);
+    static size_t partitionOf(const std::string& convId);
+
+    void maintainLoop();
+    /// force 时封存全部非空内存段，否则只封存达到条数或时间阈值的
+    void maintain(bool force);
+    void seal(size_t partition);
+    /// 从最新的段向前合并大小相近的段，仍超过段数上限时合并全部
+    void compact(size_t partition);
+    /// 写入段文件并 mmap 打开，未配置目录或写入失败时留在内存中
+    std::shared_ptr<const Segment> persist(std::string buffer, size_t partition);
+
+    static constexpr size_t PARTITIONS = 16;
+
+    const Options options_;
+    std::unique_ptr<Partition[]> partitions_;
+
+    std::mutex maintain_mutex_;      ///< 封存与合并串行执行
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    std::atomic<uint64_t> next_seq_{1};
+
+    struct Metrics {
+        std::atomic<uint64_t> docs{0};
+        mutable std::atomic<uint64_t> queries{0};
+        mutable std::atomic<uint64_t> queryUs{0};
+        std::atomic<uint64_t> seals{0};
+        std::atomic<uint64_t> compactions{0};
+    } metrics_;
+};
+
+
+#endif //IMSERVER_MESSAGESEARCHINDEX_H
@@ -0,0 +1,360 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "MessageWal.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+constexpr size_t RECORD_HEADER_LEN = 16;    // len(4) + crc(4) + lsn(8)
+constexpr const char* SEGMENT_SUFFIX = ".wal";
+
+uint32_t crc32(const char* data, const size_t len, uint32_t crc = 0) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void encodeRecord(std::string& out, const uint64_t lsn, const std::string& payload) {
+    const auto len = static_cast<uint32_t>(payload.size());
+    uint32_t crc = crc32(reinterpret_cast<const char*>(&lsn), sizeof(lsn));
+    crc = crc32(payload.data(), payload.size(), crc);
+    out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+    out.append(reinterpret_cast<const char*>(&lsn), sizeof(lsn));
+    out.append(payload);
+}
+
+/// 读出段内的完整记录，遇到写了一半的尾部即停止
+bool readSegment(const std::string& path, std::vector<MessageWal::Record>& records) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    while (offset + RECORD_HEADER_LEN <= data.size()) {
+        uint32_t len = 0;
+        uint32_t crc = 0;
+        uint64_t lsn = 0;
+        memcpy(&len, data.data() + offset, sizeof(len));
+        memcpy(&crc, data.data() + offset + 4, sizeof(crc));
+        memcpy(&lsn, data.data() + offset + 8, sizeof(lsn));
+        if (offset + RECORD_HEADER_LEN + len > data.size()) {
+            break;
+        }
+        const char* payload = data.data() + offset + RECORD_HEADER_LEN;
+        if (crc32(payload, len, crc32(reinterpret_cast<const char*>(&lsn), sizeof(lsn))) != crc) {
+            break;
+        }
+        records.push_back({lsn, std::string(payload, len)});
+        offset += RECORD_HEADER_LEN + len;
+    }
+    if (offset != data.size()) {
+        std::cout << "[MessageWal] " << path << ": discard " << data.size() - offset << " bytes of torn tail" << std::endl;
+    }
+    return true;
+}
+
+void syncDirectory(const std::string& dir) {
+    const int fd = ::open(dir.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    ::fsync(fd);
+    ::close(fd);
+}
+
+bool syncFile(const int fd) {
+#ifdef __APPLE__
+    return ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+}
+}
+
+MessageWal::MessageWal(std::string dir, const std::chrono::microseconds groupCommit, const size_t segmentBytes)
+    : dir_(std::move(dir)), group_commit_(groupCommit), segment_bytes_(segmentBytes),
+      last_metric_time_(std::chrono::steady_clock::now()) {
+}
+
+MessageWal::~MessageWal() {
+    stop();
+    sealActive();
+}
+
+bool MessageWal::open(std::vector<Record>& recovered) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        std::cout << "[MessageWal] create dir " << dir_ << " failed: " << ec.message() << std::endl;
+        return false;
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> files;
+    for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+        if (entry.path().extension() != SEGMENT_SUFFIX) {
+            continue;
+        }
+        try {
+            files.emplace_back(std::stoull(entry.path().stem().string()), entry.path().string());
+        } catch (...) {
+            std::cout << "[MessageWal] ignore unknown file " << entry.path() << std::endl;
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    // 上次运行遗留的段全部封存，其中的记录由调用方重放后 release
+    uint64_t maxLsn = 0;
+    for (const auto& [firstLsn, path] : files) {
+        std::vector<Record> records;
+        if (!readSegment(path, records)) {
+            std::cout << "[MessageWal] read " << path << " failed" << std::endl;
+            return false;
+        }
+        if (records.empty()) {
+            ::unlink(path.c_str());
+            continue;
+        }
+        maxLsn = std::max(maxLsn, records.back().lsn);
+        {
+            std::lock_guard<std::mutex> lock(segment_mtx_);
+            auto& segment = segments_[firstLsn];
+            segment.path = path;
+            segment.outstanding = records.size();
+            segment.sealed = true;
+        }
+        std::move(records.begin(), records.end(), std::back_inserter(recovered));
+    }
+    next_lsn_ = maxLsn + 1;
+    if (!recovered.empty()) {
+        std::cout << "[MessageWal] recovered " << recovered.size() << " records from " << segments_.size()
+                  << " segments" << std::endl;
+    }
+    return openSegment(next_lsn_);
+}
+
+void MessageWal::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    commit_thread_ = std::thread([this] { commitLoop(); });
+}
+
+void MessageWal::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+        cond_.notify_all();
+    }
+    if (commit_thread_.joinable()) {
+        commit_thread_.join();
+    }
+    // 封存当前段，之后的确认全部完成即删除，正常退出后重启无需重放
+    sealActive();
+}
+
+void MessageWal::append(std::string payload, durableCallback onDurable) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            pending_.push_back({next_lsn_++, std::move(payload), std::move(onDurable)});
+            if (pending_.size() == 1) {
+                cond_.notify_one();
+            }
+            return;
+        }
+    }
+    // 未启动或已停止：不写 WAL，由调用方按无 WAL 处理
+    onDurable(0);
+}
+
+void MessageWal::release(const uint64_t lsn) {
+    if (lsn == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(segment_mtx_);
+    auto it = segments_.upper_bound(lsn);
+    if (it == segments_.begin()) {
+        return;
+    }
+    --it;
+    if (it->second.outstanding > 0) {
+        it->second.outstanding--;
+    }
+    removeIfDoneLocked(it);
+}
+
+void MessageWal::commitLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cond_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            return;
+        }
+        // 攒一个组提交周期，期间到达的记录一起落盘，只 fdatasync 一次
+        cond_.wait_for(lock, group_commit_, [this] { return !running_; });
+
+        std::vector<Pending> group;
+        group.swap(pending_);
+        lock.unlock();
+
+        const bool ok = writeGroup(group);
+        for (const auto& item : group) {
+            item.onDurable(ok ? item.lsn : 0);
+        }
+        lock.lock();
+    }
+}
+
+bool MessageWal::writeGroup(const std::vector<Pending>& group) {
+    const auto start = std::chrono::steady_clock::now();
+    if (!rotateIfFull(group.front().lsn)) {
+        metrics_.errors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::string buffer;
+    for (const auto& item : group) {
+        encodeRecord(buffer, item.lsn, item.payload);
+    }
+
+    size_t written = 0;
+    while (written < buffer.size()) {
+        const ssize_t n = ::write(fd_, buffer.data() + written, buffer.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    if (written < buffer.size() || !syncFile(fd_)) {
+        std::cout << "[MessageWal] write failed: " << strerror(errno) << std::endl;
+        metrics_.errors.fetch_add(1, std::memory_order_relaxed);
+        // 段尾可能残留半条记录，下一组换新段写入
+        active_bytes_ = segment_bytes_;
+        return false;
+    }
+    active_bytes_ += buffer.size();
+    {
+        std::lock_guard<std::mutex> lock(segment_mtx_);
+        segments_[active_first_lsn_].outstanding += group.size();
+    }
+
+    metrics_.commits.fetch_add(1, std::memory_order_relaxed);
+    metrics_.records.fetch_add(group.size(), std::memory_order_relaxed);
+    metrics_.sync_us.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    return true;
+}
+
+bool MessageWal::rotateIfFull(const uint64_t firstLsn) {
+    if (fd_ >= 0 && active_bytes_ < segment_bytes_) {
+        return true;
+    }
+    sealActive();
+    return openSegment(firstLsn);
+}
+
+void MessageWal::sealActive() {
+    if (fd_ < 0) {
+        return;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    std::lock_guard<std::mutex> lock(segment_mtx_);
+    if (const auto it = segments_.find(active_first_lsn_); it != segments_.end()) {
+        it->second.sealed = true;
+        removeIfDoneLocked(it);
+    }
+}
+
+bool MessageWal::openSegment(const uint64_t firstLsn) {
+    const std::string path = segmentPath(firstLsn);
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        std::cout << "[MessageWal] open " << path << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    // 目录项也要落盘，否则崩溃后新段文件可能不存在
+    syncDirectory(dir_);
+    active_first_lsn_ = firstLsn;
+    active_bytes_ = 0;
+
+    std::lock_guard<std::mutex> lock(segment_mtx_);
+    segments_[firstLsn].path = path;
+    return true;
+}
+
+void MessageWal::removeIfDoneLocked(const std::map<uint64_t, Segment>::iterator it) {
+    if (!it->second.sealed || it->second.outstanding > 0) {
+        return;
+    }
+    ::unlink(it->second.path.c_str());
+    segments_.erase(it);
+}
+
+std::string MessageWal::segmentPath(const uint64_t firstLsn) const {
+    std::ostringstream oss;
+    oss << dir_ << "/" << std::setw(20) << std::setfill('0') << firstLsn << SEGMENT_SUFFIX;
+    return oss.str();
+}
+
+void MessageWal::printMetrics() {
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - last_metric_time_).count();
+    last_metric_time_ = now;
+
+    const uint64_t commits = metrics_.commits.exchange(0, std::memory_order_relaxed);
+    const uint64_t records = metrics_.records.exchange(0, std::memory_order_relaxed);
+    const uint64_t syncUs = metrics_.sync_us.exchange(0, std::memory_order_relaxed);
+    if (commits == 0) {
+        return;
+    }
+    size_t segments = 0;
+    {
+        std::lock_guard<std::mutex> lock(segment_mtx_);
+        segments = segments_.size();
+    }
+
+    std::cout << "[wal] "
+              << "commit/s=" << std::fixed << std::setprecision(0) << (elapsed > 0 ? commits / elapsed : 0)
+              << " record/s=" << (elapsed > 0 ? records / elapsed : 0)
+              << " avg_group=" << std::setprecision(1) << static_cast<double>(records) / commits
+              << " avg_sync_us=" << std::setprecision(0) << static_cast<double>(syncUs) / commits
+              << " segments=" << segments
+              << " errors=" << metrics_.errors.load(std::memory_order_relaxed)
+              << std::endl;
+}
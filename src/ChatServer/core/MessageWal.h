@@ -0,0 +1,119 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_MESSAGEWAL_H
+#define IMSERVER_MESSAGEWAL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 聊天消息的本地预写日志 (WAL)，组提交落盘。
+ *
+ * 消息先顺序追加到 WAL，由提交线程按组写入并 fdatasync 一次后再回调，调用方在回调里发送 ACK、
+ * 推入批量写入缓冲区；MySQL 写入成功后 release 对应序号，段内记录全部确认后删除段文件。
+ * 进程崩溃后 open 读出全部未删除段中的记录，由调用方重放到 MySQL。确认以段为单位回收，
+ * 段内已确认的记录也会被重放，调用方的写入需要对重复记录幂等。
+ *
+ * 文件布局：目录下按起始序号命名的段文件 <first_lsn>.wal，写满 segmentBytes 后切换新段。
+ * 记录格式：len(4B) | crc32(4B) | lsn(8B) | payload，crc 覆盖 lsn 和 payload，
+ * 重放遇到长度越界或校验失败即认为是崩溃时写了一半的尾部，丢弃其后内容。
+ *
+ * 监控 (Metrics):
+ *   - commit/s / record/s : 每秒组提交次数 / 落盘记录数
+ *   - avg_group           : 每次组提交的记录数
+ *   - avg_sync_us         : 单次 write + fdatasync 耗时
+ *   - segments            : 尚未全部确认的段数
+ *   - errors              : 写入或落盘失败次数
+ */
+class MessageWal {
+public:
+    /// 落盘完成回调，lsn 为 0 表示写入失败
+    typedef std::function<void(uint64_t lsn)> durableCallback;
+
+    struct Record {
+        uint64_t lsn;
+        std::string payload;
+    };
+
+    MessageWal(std::string dir, std::chrono::microseconds groupCommit, size_t segmentBytes);
+    ~MessageWal();
+
+    /// 打开 WAL 目录，读出上次运行遗留的记录，新记录写入新段
+    bool open(std::vector<Record>& recovered);
+    void start();
+    /// 停止提交线程，已追加的记录全部落盘并回调后封存当前段
+    void stop();
+
+    /// 追加一条记录，落盘后在提交线程回调
+    void append(std::string payload, durableCallback onDurable);
+    /// 记录已写入 MySQL，所在段全部确认后删除段文件
+    void release(uint64_t lsn);
+
+    void printMetrics();
+
+private:
+    struct Pending {
+        uint64_t lsn;
+        std::string payload;
+        durableCallback onDurable;
+    };
+
+    struct Segment {
+        std::string path;
+        size_t outstanding = 0;     ///< 已落盘、尚未确认的记录数
+        bool sealed = false;        ///< 已切换到新段，不再写入
+    };
+
+    void commitLoop();
+    /// 写入一组记录并落盘，成功返回 true
+    bool writeGroup(const std::vector<Pending>& group);
+    /// 当前段写满时切换新段，新段从 firstLsn 开始
+    bool rotateIfFull(uint64_t firstLsn);
+    /// 关闭并封存当前段
+    void sealActive();
+    bool openSegment(uint64_t firstLsn);
+    /// 段全部确认且已封存时删除，需持有 segment_mtx_
+    void removeIfDoneLocked(std::map<uint64_t, Segment>::iterator it);
+    std::string segmentPath(uint64_t firstLsn) const;
+
+    std::string dir_;
+    std::chrono::microseconds group_commit_;
+    size_t segment_bytes_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<Pending> pending_;
+    uint64_t next_lsn_ = 1;
+
+    int fd_ = -1;                   ///< 当前段，仅提交线程访问
+    uint64_t active_first_lsn_ = 0;
+    size_t active_bytes_ = 0;
+
+    std::mutex segment_mtx_;
+    std::map<uint64_t, Segment> segments_;  ///< 起始序号 -> 段
+
+    std::atomic<bool> running_{false};
+    std::thread commit_thread_;
+
+    struct Metrics {
+        std::atomic<uint64_t> commits{0};
+        std::atomic<uint64_t> records{0};
+        std::atomic<uint64_t> sync_us{0};
+        std::atomic<uint64_t> errors{0};
+    } metrics_;
+
+    std::chrono::steady_clock::time_point last_metric_time_;
+};
+
+
+#endif //IMSERVER_MESSAGEWAL_H
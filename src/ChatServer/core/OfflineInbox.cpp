@@ -0,0 +1,119 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "OfflineInbox.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "ConfigMgr.h"
+#include "const.h"
+#include "RedisMgr.h"
+
+namespace {
+constexpr size_t DEFAULT_INBOX_MAX_LEN = 1000;
+constexpr int DEFAULT_INBOX_MAX_AGE_SEC = 86400;
+constexpr size_t DEFAULT_INBOX_SYNC_LIMIT = 500;
+
+constexpr const char* FIELD_MSG_ID = "msg_id";
+constexpr const char* FIELD_JSON = "json";
+}
+
+OfflineInbox::OfflineInbox()
+    : maxLen_(DEFAULT_INBOX_MAX_LEN), maxAgeSec_(DEFAULT_INBOX_MAX_AGE_SEC),
+      maxSyncLimit_(DEFAULT_INBOX_SYNC_LIMIT) {
+    auto& config = ConfigMgr::getInstance();
+    if (!config["ChatServer"]["InboxMaxLen"].empty()) {
+        maxLen_ = std::stoul(config["ChatServer"]["InboxMaxLen"]);
+    }
+    if (!config["ChatServer"]["InboxMaxAgeSec"].empty()) {
+        maxAgeSec_ = std::stoi(config["ChatServer"]["InboxMaxAgeSec"]);
+    }
+    if (!config["ChatServer"]["InboxSyncLimit"].empty()) {
+        maxSyncLimit_ = std::stoul(config["ChatServer"]["InboxSyncLimit"]);
+    }
+}
+
+std::string OfflineInbox::inboxKey(const int uid) {
+    return USER_INBOX_PREFIX + std::to_string(uid);
+}
+
+bool OfflineInbox::isPushMsg(const uint16_t msgId) {
+    switch (static_cast<MessageID>(msgId)) {
+        case MessageID::ID_NOTIFY_CHAT_MSG:
+        case MessageID::ID_NOTIFY_FRIEND_APPLY:
+        case MessageID::ID_NOTIFY_FRIEND_AUTH:
+        case MessageID::ID_NOTIFY_MSG_STATUS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool OfflineInbox::append(const int uid, const uint16_t msgId, const std::string &json) const {
+    return appendBatch({uid}, msgId, json);
+}
+
+bool OfflineInbox::appendBatch(const std::vector<int> &uids, const uint16_t msgId, const std::string &json) const {
+    if (uids.empty()) {
+        return true;
+    }
+    std::vector<std::string> keys;
+    keys.reserve(uids.size());
+    for (const int uid : uids) {
+        keys.push_back(inboxKey(uid));
+    }
+    const std::vector<std::pair<std::string, std::string>> fields = {
+        {FIELD_MSG_ID, std::to_string(msgId)},
+        {FIELD_JSON, json},
+    };
+    if (!RedisMgr::getInstance()->xAddPipeline(keys, fields, maxLen_, maxAgeSec_)) {
+        std::cout << "OfflineInbox::appendBatch: write " << uids.size() << " inboxes failed" << std::endl;
+        return false;
+    }
+    appended_.fetch_add(uids.size(), std::memory_order_relaxed);
+    return true;
+}
+
+bool OfflineInbox::sync(const int uid, const std::string &cursor, const size_t limit, SyncResult &result) const {
+    const auto key = inboxKey(uid);
+    const size_t count = std::min(std::max<size_t>(1, limit), maxSyncLimit_);
+
+    // 从游标（含）开始读，多读锚点和一条用于判断 has_more
+    std::vector<RedisStreamEntry> entries;
+    if (!RedisMgr::getInstance()->xRange(key, cursor.empty() ? "-" : cursor, count + 2, entries)) {
+        return false;
+    }
+
+    size_t begin = 0;
+    if (!cursor.empty()) {
+        if (!entries.empty() && entries.front().id == cursor) {
+            begin = 1;
+        }
+        else {
+            result.truncated = true;
+        }
+    }
+    const size_t end = std::min(entries.size(), begin + count);
+    result.hasMore = entries.size() > end;
+    result.cursor = cursor;
+    for (size_t i = begin; i < end; i++) {
+        auto& raw = entries[i];
+        result.cursor = raw.id;
+        if (raw.fields[FIELD_MSG_ID].empty()) {
+            continue;
+        }
+        Entry entry;
+        entry.id = raw.id;
+        entry.msgId = static_cast<uint16_t>(std::stoi(raw.fields[FIELD_MSG_ID]));
+        entry.json = std::move(raw.fields[FIELD_JSON]);
+        result.entries.push_back(std::move(entry));
+    }
+
+    // 客户端带回游标即确认之前的条目，只保留锚点
+    if (!cursor.empty()) {
+        RedisMgr::getInstance()->xTrimMinId(key, cursor);
+    }
+    return true;
+}
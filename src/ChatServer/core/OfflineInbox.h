@@ -0,0 +1,67 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_OFFLINEINBOX_H
+#define IMSERVER_OFFLINEINBOX_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Singleton.h"
+
+/**
+ * @brief 用户离线收件箱，每个用户一个 Redis Stream（USER_INBOX_PREFIX + uid）。
+ *
+ * 推送时接收方不在线、会话已失效或投递失败，将推送帧（消息 ID + JSON）追加到收件箱，
+ * 条数上限 InboxMaxLen、时长上限 InboxMaxAgeSec，均为近似裁剪。
+ * 客户端重连后带上次的游标发起一次同步即可补齐，不必再逐会话查询 MySQL。
+ *
+ * 游标即上次同步返回的最后一个条目 id。同步时删除游标之前的条目，但保留游标条目本身作为锚点：
+ * 下次同步读不到锚点说明中间条目已被裁剪，返回 truncated，客户端需退回全量拉取。
+ */
+class OfflineInbox : public Singleton<OfflineInbox> {
+public:
+    struct Entry {
+        std::string id;
+        uint16_t msgId = 0;
+        std::string json;
+    };
+
+    struct SyncResult {
+        std::vector<Entry> entries;
+        std::string cursor;         ///< 本次同步后的游标，无新条目时为请求游标
+        bool hasMore = false;
+        bool truncated = false;     ///< 游标之后有条目已被裁剪
+    };
+
+    ~OfflineInbox() = default;
+
+    bool append(int uid, uint16_t msgId, const std::string& json) const;
+    /// 同一帧写入多个用户的收件箱，流水线一次往返
+    bool appendBatch(const std::vector<int>& uids, uint16_t msgId, const std::string& json) const;
+
+    /// 读取游标之后最多 limit 条，cursor 为空表示从头读取
+    bool sync(int uid, const std::string& cursor, size_t limit, SyncResult& result) const;
+
+    size_t maxSyncLimit() const { return maxSyncLimit_; }
+
+    /// 是否为服务端主动推送（需要离线补偿）的消息，请求的响应不进收件箱
+    static bool isPushMsg(uint16_t msgId);
+
+private:
+    friend class Singleton<OfflineInbox>;
+    OfflineInbox();
+
+    static std::string inboxKey(int uid);
+
+    size_t maxLen_;
+    int maxAgeSec_;
+    size_t maxSyncLimit_;
+    mutable std::atomic<uint64_t> appended_{0};
+};
+
+
+#endif //IMSERVER_OFFLINEINBOX_H
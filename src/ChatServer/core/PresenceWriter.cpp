@@ -0,0 +1,200 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "PresenceWriter.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+
+#include "ConfigMgr.h"
+#include "RedisMgr.h"
+#include "UserRouteCache.h"
+
+namespace {
+constexpr int DEFAULT_OFFLINE_EXPIRE_SEC = 300;
+constexpr int DEFAULT_PRESENCE_COALESCE_US = 2000;
+constexpr int MAX_PRESENCE_ATTEMPTS = 5;
+constexpr size_t MAX_PRESENCE_PENDING = 100000;
+constexpr std::chrono::milliseconds PRESENCE_RETRY_INTERVAL{200};
+
+// KEYS[1] 在线信息 key；ARGV: session_id 字段名, session_id, 过期秒数, 路由频道, uid
+constexpr const char* OFFLINE_SCRIPT =
+    "if redis.call('HGET', KEYS[1], ARGV[1]) == ARGV[2] then "
+    "redis.call('EXPIRE', KEYS[1], ARGV[3]); "
+    "redis.call('PUBLISH', ARGV[4], ARGV[5]); "
+    "return 1 end "
+    "return 0";
+}
+
+PresenceWriter::PresenceWriter()
+    : offlineExpireSec_(DEFAULT_OFFLINE_EXPIRE_SEC), coalesce_(DEFAULT_PRESENCE_COALESCE_US) {
+    auto& config = ConfigMgr::getInstance();
+    serverName_ = config["ChatServer"]["Name"];
+    if (!config["ChatServer"]["PresenceCoalesceUs"].empty()) {
+        coalesce_ = std::chrono::microseconds(std::stoi(config["ChatServer"]["PresenceCoalesceUs"]));
+    }
+}
+
+PresenceWriter::~PresenceWriter() {
+    stop();
+}
+
+void PresenceWriter::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread([this] { writerLoop(); });
+}
+
+void PresenceWriter::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void PresenceWriter::online(const int uid, const std::string &sessionId) {
+    enqueue(Op{true, uid, sessionId});
+}
+
+void PresenceWriter::offline(const int uid, const std::string &sessionId) {
+    enqueue(Op{false, uid, sessionId});
+}
+
+void PresenceWriter::setServerCount(const int count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingServerCount_ = count;
+    }
+    cond_.notify_one();
+}
+
+void PresenceWriter::enqueue(Op op) {
+    // 本机路由立即失效，其他服务器在流水线写入后收到频道通知
+    UserRouteCache::getInstance()->invalidate(op.uid);
+    ops_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(op));
+    }
+    cond_.notify_one();
+}
+
+void PresenceWriter::writerLoop() {
+    std::vector<Op> ops;
+    while (true) {
+        int serverCount = -1;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]() {
+                return !running_ || !pending_.empty() || pendingServerCount_ >= 0;
+            });
+            if (running_ && coalesce_.count() > 0) {
+                // 聚合窗口：登录风暴时把多个会话的操作合并到一次往返
+                cond_.wait_for(lock, coalesce_, [this]() {
+                    return !running_;
+                });
+            }
+            ops.swap(pending_);
+            std::swap(serverCount, pendingServerCount_);
+            if (!running_ && ops.empty() && serverCount < 0) {
+                return;
+            }
+        }
+        if (!flush(ops, serverCount)) {
+            requeue(ops, serverCount);
+        }
+        ops.clear();
+    }
+}
+
+void PresenceWriter::requeue(std::vector<Op>& ops, const int serverCount) {
+    size_t dropped = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+        // 停止时不再重试
+        dropped = ops.size();
+    }
+    else {
+        const auto exhausted = std::remove_if(ops.begin(), ops.end(), [](Op& op) {
+            return ++op.attempts >= MAX_PRESENCE_ATTEMPTS;
+        });
+        dropped = static_cast<size_t>(std::distance(exhausted, ops.end()));
+        ops.erase(exhausted, ops.end());
+        // 放回队首，保持同一 uid 的先后顺序
+        pending_.insert(pending_.begin(), std::make_move_iterator(ops.begin()), std::make_move_iterator(ops.end()));
+        if (pending_.size() > MAX_PRESENCE_PENDING) {
+            const size_t excess = pending_.size() - MAX_PRESENCE_PENDING;
+            pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(excess));
+            dropped += excess;
+        }
+        if (pendingServerCount_ < 0) {
+            pendingServerCount_ = serverCount;
+        }
+        // Redis 不可用时不空转，等待后再重试
+        cond_.wait_for(lock, PRESENCE_RETRY_INTERVAL, [this]() {
+            return !running_;
+        });
+    }
+    if (dropped > 0) {
+        dropped_.fetch_add(dropped, std::memory_order_relaxed);
+        std::cout << "PresenceWriter: dropped " << dropped << " presence ops after write failures" << std::endl;
+    }
+}
+
+bool PresenceWriter::flush(const std::vector<Op> &ops, const int serverCount) const {
+    std::vector<std::vector<std::string>> commands;
+    commands.reserve(ops.size() * 3 + 1);
+    const std::string expire = std::to_string(offlineExpireSec_);
+    for (const auto& op : ops) {
+        const std::string key = USER_ONLINE_INFO_PREFIX + std::to_string(op.uid);
+        const std::string uid = std::to_string(op.uid);
+        if (op.online) {
+            // 设置用户登录地址服务名，登录后要清除过期时间
+            commands.push_back({"HSET", key, USER_ONLINE_SERVER_NAME, serverName_, USER_SESSION_ID, op.sessionId});
+            commands.push_back({"PERSIST", key});
+            commands.push_back({"PUBLISH", USER_ROUTE_CHANNEL, uid});
+        }
+        else {
+            // 其他终端已经登录时不修改，下线设置过期时间，用户可以重复登录
+            commands.push_back({"EVAL", OFFLINE_SCRIPT, "1", key, USER_SESSION_ID, op.sessionId, expire,
+                USER_ROUTE_CHANNEL, uid});
+        }
+    }
+    if (serverCount >= 0) {
+        commands.push_back({"HSET", LOGIN_COUNT, serverName_, std::to_string(serverCount)});
+    }
+    if (commands.empty()) {
+        return true;
+    }
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    if (!RedisMgr::getInstance()->pipeline(commands)) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        std::cout << "PresenceWriter: write " << ops.size() << " presence ops failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void PresenceWriter::printMetrics() {
+    const uint64_t ops = ops_.exchange(0, std::memory_order_relaxed);
+    const uint64_t batches = batches_.exchange(0, std::memory_order_relaxed);
+    const uint64_t failures = failures_.exchange(0, std::memory_order_relaxed);
+    const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (ops == 0 && failures == 0 && dropped == 0) {
+        return;
+    }
+    std::cout << "[presence] ops=" << ops
+              << " batches=" << batches
+              << " avg_batch=" << std::fixed << std::setprecision(1)
+              << (batches > 0 ? static_cast<double>(ops) / batches : 0)
+              << " failures=" << failures
+              << " dropped=" << dropped
+              << std::endl;
+}
@@ -0,0 +1,88 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_PRESENCEWRITER_H
+#define IMSERVER_PRESENCEWRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Singleton.h"
+
+/**
+ * @brief 在线状态异步写入器。
+ *
+ * 登录/下线不再在逻辑线程或 IO 线程上同步执行多条 Redis 命令，只把操作放入队列：
+ * 写线程等待 PresenceCoalesceUs 聚合多个会话的操作，按入队顺序拼成一次流水线写入。
+ *   - 上线：HSET server_name/session_id + PERSIST + PUBLISH 路由变更
+ *   - 下线：一条 Lua 脚本，session_id 仍为本会话时才设置过期并发布路由变更
+ *   - 服务器连接数：一批内只写最后一次的值
+ * 单写线程 + FIFO 保证同一 uid 的操作按序生效，快速下线再上线不会被颠倒；
+ * 跨服务器的竞争由下线脚本的 session_id 校验兜底。
+ * 流水线写入失败时整批放回队首（命令均可重复执行），等待 PRESENCE_RETRY_INTERVAL 后与新操作一起重试；
+ * 同一操作重试 MAX_PRESENCE_ATTEMPTS 次、队列超过 MAX_PRESENCE_PENDING 或停止时仍失败的操作丢弃并计数。
+ *
+ * 监控 (Metrics):
+ *   - ops / batches / avg_batch : 入队的操作数 / 流水线次数 / 平均每批操作数
+ *   - failures                  : 写入失败的流水线次数
+ *   - dropped                   : 重试后仍未写入而丢弃的操作数
+ */
+class PresenceWriter : public Singleton<PresenceWriter> {
+public:
+    ~PresenceWriter();
+
+    void start();
+    /// 停止并写出剩余操作
+    void stop();
+
+    void online(int uid, const std::string& sessionId);
+    void offline(int uid, const std::string& sessionId);
+    void setServerCount(int count);
+
+    void printMetrics();
+
+private:
+    friend class Singleton<PresenceWriter>;
+    PresenceWriter();
+
+    struct Op {
+        bool online;
+        int uid;
+        std::string sessionId;
+        int attempts = 0;   ///< 已失败的写入次数
+    };
+
+    void enqueue(Op op);
+    void writerLoop();
+    /// 写入失败返回 false，由调用方放回重试
+    bool flush(const std::vector<Op>& ops, int serverCount) const;
+    /// 失败的一批放回队首，新的服务器连接数优先；超过重试次数或队列上限的丢弃
+    void requeue(std::vector<Op>& ops, int serverCount);
+
+    std::string serverName_;
+    int offlineExpireSec_;
+    std::chrono::microseconds coalesce_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<Op> pending_;
+    int pendingServerCount_ = -1;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    std::atomic<uint64_t> ops_{0};
+    mutable std::atomic<uint64_t> batches_{0};
+    mutable std::atomic<uint64_t> failures_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+
+#endif //IMSERVER_PRESENCEWRITER_H
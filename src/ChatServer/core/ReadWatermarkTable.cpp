@@ -0,0 +1,201 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "ReadWatermarkTable.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <json/json.h>
+
+#include "ChatGrpcClient.h"
+#include "ChatLogicSystem.h"
+#include "ConfigMgr.h"
+#include "CounterService.h"
+#include "OfflineInbox.h"
+#include "common/utils/ConversationConvert.h"
+
+namespace {
+constexpr int DEFAULT_READ_FLUSH_INTERVAL_MS = 500;
+constexpr size_t DEFAULT_READ_FLUSH_BATCH_SIZE = 512;
+}
+
+ReadWatermarkTable::ReadWatermarkTable()
+    : flushInterval_(DEFAULT_READ_FLUSH_INTERVAL_MS), flushBatchSize_(DEFAULT_READ_FLUSH_BATCH_SIZE),
+      lastMetricTime_(std::chrono::steady_clock::now()) {
+    auto& config = ConfigMgr::getInstance();
+    if (!config["ChatServer"]["ReadFlushIntervalMs"].empty()) {
+        flushInterval_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["ReadFlushIntervalMs"]));
+    }
+    if (!config["ChatServer"]["ReadFlushBatchSize"].empty()) {
+        flushBatchSize_ = std::stoul(config["ChatServer"]["ReadFlushBatchSize"]);
+    }
+}
+
+ReadWatermarkTable::~ReadWatermarkTable() {
+    stop();
+}
+
+void ReadWatermarkTable::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread([this] { flushLoop(); });
+}
+
+void ReadWatermarkTable::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    flush();
+}
+
+void ReadWatermarkTable::update(const MessageStatusInfo &info) {
+    metrics_.updates.fetch_add(1, std::memory_order_relaxed);
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& mark = marks_[Key{info.uid, info.status, info.convId.value()}];
+        if (info.lastMsgId <= mark.lastMsgId) {
+            return;     // 旧水位，已被更大的覆盖
+        }
+        mark.lastMsgId = info.lastMsgId;
+        if (!mark.dirty) {
+            mark.dirty = true;
+            full = ++dirtyCount_ >= flushBatchSize_;
+        }
+    }
+    if (full) {
+        cond_.notify_one();
+    }
+}
+
+void ReadWatermarkTable::flushLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait_for(lock, flushInterval_, [this]() {
+                return !running_ || dirtyCount_ >= flushBatchSize_;
+            });
+        }
+        flush();
+    }
+}
+
+void ReadWatermarkTable::flush() {
+    std::vector<MessageStatusWatermark> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (dirtyCount_ == 0) {
+            return;
+        }
+        batch.reserve(dirtyCount_);
+        for (auto& [key, mark] : marks_) {
+            if (!mark.dirty) {
+                continue;
+            }
+            mark.dirty = false;
+            MessageStatusWatermark item;
+            item.uid = key.uid;
+            item.status = key.status;
+            item.convId = key.convId;
+            item.lastMsgId = mark.lastMsgId;
+            item.flushedMsgId = mark.flushedMsgId;
+            batch.push_back(std::move(item));
+        }
+        dirtyCount_ = 0;
+    }
+
+    // 经 CounterService 写回：重算未读数不与尚未写回的增量重复计数
+    const bool ok = CounterService::getInstance()->updateReadWatermarks(batch);
+    metrics_.flushes.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& item : batch) {
+            auto& mark = marks_[Key{item.uid, item.status, item.convId}];
+            if (ok) {
+                mark.flushedMsgId = std::max(mark.flushedMsgId, item.lastMsgId);
+            }
+            else if (!mark.dirty) {
+                // 失败的水位重新标脏，下一轮重试（期间可能已被更大的水位覆盖）
+                mark.dirty = true;
+                dirtyCount_++;
+            }
+        }
+        // 表过大时淘汰已刷写的条目，被淘汰的键下次从 0 开始作为下界
+        if (marks_.size() > MAX_MARKS) {
+            for (auto it = marks_.begin(); it != marks_.end();) {
+                it = it->second.dirty ? std::next(it) : marks_.erase(it);
+            }
+        }
+    }
+
+    if (!ok) {
+        metrics_.failures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    metrics_.rows.fetch_add(batch.size(), std::memory_order_relaxed);
+    for (const auto& item : batch) {
+        notifyPeer(item);
+    }
+}
+
+void ReadWatermarkTable::notifyPeer(const MessageStatusWatermark &mark) {
+    const int peerUid = getOtherUid(mark.convId, mark.uid);
+    if (peerUid < 0) {
+        return;     // 群聊不推送逐人回执
+    }
+    Json::Value root;
+    root["conv_id"] = mark.convId;
+    root["uid"] = mark.uid;
+    root["last_msg_id"] = static_cast<Json::Int64>(mark.lastMsgId);
+    root["status"] = mark.status;
+    const auto data = root.toStyledString();
+    ChatLogicSystem::getInstance()->notifyOnlineUserMsg(peerUid, data, MessageID::ID_NOTIFY_MSG_STATUS,
+        [peerUid, &mark, &data](const std::string& serverName) {
+            if (ChatGrpcClient::getInstance()->DeliverToPeer(serverName, peerUid,
+                MessageID::ID_NOTIFY_MSG_STATUS, data)) {
+                return;
+            }
+            auto request = std::make_shared<FanOutReq>();
+            request->set_conv_id(mark.convId);
+            request->set_from_uid(mark.uid);
+            request->set_msg_id(static_cast<int32_t>(MessageID::ID_NOTIFY_MSG_STATUS));
+            request->set_json(data);
+            request->add_to_uids(peerUid);
+            // 对端报告的离线用户由对端写入收件箱；调用失败则由本端转存，回执不丢失
+            ChatGrpcClient::getInstance()->FanOutAsync(serverName, request, nullptr,
+                [request](const std::vector<int>& failedUids) {
+                    OfflineInbox::getInstance()->appendBatch(failedUids, static_cast<uint16_t>(request->msg_id()),
+                        request->json());
+                });
+        });
+}
+
+void ReadWatermarkTable::printMetrics() {
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - lastMetricTime_).count();
+    lastMetricTime_ = now;
+
+    const uint64_t updates = metrics_.updates.exchange(0, std::memory_order_relaxed);
+    const uint64_t rows = metrics_.rows.exchange(0, std::memory_order_relaxed);
+    const uint64_t flushes = metrics_.flushes.exchange(0, std::memory_order_relaxed);
+    const uint64_t failures = metrics_.failures.exchange(0, std::memory_order_relaxed);
+    if (updates == 0 && rows == 0) {
+        return;
+    }
+
+    std::cout << "[read_receipt] "
+              << "updates/s=" << std::fixed << std::setprecision(0) << (elapsed > 0 ? updates / elapsed : 0)
+              << " rows/s=" << (elapsed > 0 ? rows / elapsed : 0)
+              << " flushes=" << flushes
+              << " coalesce=" << std::setprecision(1) << (rows > 0 ? static_cast<double>(updates) / rows : 0)
+              << " failures=" << failures
+              << std::endl;
+}
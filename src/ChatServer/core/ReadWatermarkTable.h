@@ -0,0 +1,98 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_READWATERMARKTABLE_H
+#define IMSERVER_READWATERMARKTABLE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/model/MessageInfo.h"
+
+/**
+ * @brief 消息状态（已读回执）水位表。
+ *
+ * 客户端滚动浏览时同一 (uid, 会话) 每秒会上报几十次状态，这里只在内存中保留最大消息 ID，
+ * 由后台线程按定时（ReadFlushIntervalMs）或脏条目数（ReadFlushBatchSize）触发，一个事务批量刷写，
+ * 刷写成功后按同一水位通知单聊对方，未读数也由水位推导。
+ *
+ * 监控 (Metrics):
+ *   - updates/s    : 每秒收到的状态上报
+ *   - rows/s       : 每秒刷写到 MySQL 的水位条数
+ *   - coalesce     : 上报数 / 刷写条数
+ */
+class ReadWatermarkTable {
+public:
+    ReadWatermarkTable();
+    ~ReadWatermarkTable();
+
+    void start();
+    /// 停止并刷写剩余水位
+    void stop();
+
+    /// 合并一次状态上报，水位只前进
+    void update(const MessageStatusInfo& info);
+
+    void printMetrics();
+
+private:
+    struct Key {
+        int uid;
+        int8_t status;
+        std::string convId;
+
+        bool operator==(const Key& other) const {
+            return uid == other.uid && status == other.status && convId == other.convId;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<std::string>{}(key.convId) ^ (static_cast<size_t>(key.uid) << 8)
+                ^ static_cast<size_t>(key.status);
+        }
+    };
+
+    struct Mark {
+        int64_t lastMsgId = 0;
+        int64_t flushedMsgId = 0;
+        bool dirty = false;
+    };
+
+    void flushLoop();
+    void flush();
+    /// 通知单聊对方消息状态已更新
+    static void notifyPeer(const MessageStatusWatermark& mark);
+
+    static constexpr size_t MAX_MARKS = 200000;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::unordered_map<Key, Mark, KeyHash> marks_;
+    size_t dirtyCount_ = 0;
+
+    std::chrono::milliseconds flushInterval_;
+    size_t flushBatchSize_;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    struct Metrics {
+        std::atomic<uint64_t> updates{0};
+        std::atomic<uint64_t> rows{0};
+        std::atomic<uint64_t> flushes{0};
+        std::atomic<uint64_t> failures{0};
+    } metrics_;
+
+    std::chrono::steady_clock::time_point lastMetricTime_;
+};
+
+
+#endif //IMSERVER_READWATERMARKTABLE_H
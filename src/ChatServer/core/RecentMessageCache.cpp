@@ -0,0 +1,292 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "RecentMessageCache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+#include "const.h"
+#include "MessageIdGenerator.h"
+
+RecentMessageCache::RecentMessageCache(const Options& options, loadHandler loader)
+    : options_{std::max<size_t>(1, options.ringSize), options.maxBytes, options.ttl}
+    , stripe_budget_(std::max<size_t>(1, options.maxBytes / STRIPES))
+    , loader_(std::move(loader))
+    , stripes_(std::make_unique<Stripe[]>(STRIPES)) {
+}
+
+void RecentMessageCache::append(const MessageInfo& msg) {
+    if (!msg.convId.has_value() || msg.servId <= 0) {
+        return;
+    }
+    MessageInfo copy = msg;
+    // 落库时由 MySQL 填写 create_time，缓存中的消息按 serverId 中的时间戳补齐
+    if (!copy.createTime.has_value()) {
+        copy.createTime = ms_to_datetime(MessageIdGenerator::timestampOf(copy.servId));
+    }
+    auto& stripe = stripeOf(copy.convId.value());
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto& entry = touchLocked(stripe, copy.convId.value());
+    // 客户端重发：落库时会以第一次的 serverId 为准，新分配的 ID 不进入环
+    const bool resent = copy.msgId >= 0 && std::any_of(entry.messages.rbegin(), entry.messages.rend(),
+        [&copy](const MessageInfo& m) {
+            return m.msgId == copy.msgId && m.fromUid == copy.fromUid && m.servId != copy.servId;
+        });
+    if (!resent) {
+        insertLocked(stripe, entry, copy, false);
+    }
+    evictLocked(stripe, entry);
+}
+
+bool RecentMessageCache::findResent(const MessageInfo& msg, int64_t& servId) {
+    if (!msg.convId.has_value() || msg.msgId < 0) {
+        return false;
+    }
+    auto& stripe = stripeOf(msg.convId.value());
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    const auto it = stripe.index.find(msg.convId.value());
+    if (it == stripe.index.end()) {
+        return false;
+    }
+    const auto& messages = it->second->messages;
+    const auto found = std::find_if(messages.rbegin(), messages.rend(), [&msg](const MessageInfo& m) {
+        return m.msgId == msg.msgId && m.fromUid == msg.fromUid;
+    });
+    if (found == messages.rend()) {
+        return false;
+    }
+    servId = found->servId;
+    return true;
+}
+
+void RecentMessageCache::correct(const MessageInfo& stored) {
+    if (!stored.convId.has_value() || stored.servId <= 0) {
+        return;
+    }
+    auto& stripe = stripeOf(stored.convId.value());
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    const auto it = stripe.index.find(stored.convId.value());
+    if (it == stripe.index.end()) {
+        return;
+    }
+    auto& entry = *it->second;
+    const size_t erased = eraseLocked(stripe, entry, [&stored](const MessageInfo& m) {
+        return m.msgId == stored.msgId && m.fromUid == stored.fromUid && m.servId != stored.servId;
+    });
+    if (erased == 0) {
+        return;
+    }
+    MessageInfo copy = stored;
+    if (!copy.createTime.has_value()) {
+        copy.createTime = ms_to_datetime(MessageIdGenerator::timestampOf(copy.servId));
+    }
+    insertLocked(stripe, entry, copy, false);
+}
+
+void RecentMessageCache::remove(const std::string& convId, const int64_t servId) {
+    auto& stripe = stripeOf(convId);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (const auto it = stripe.index.find(convId); it != stripe.index.end()) {
+        eraseLocked(stripe, *it->second, [servId](const MessageInfo& m) { return m.servId == servId; });
+    }
+}
+
+bool RecentMessageCache::fetch(const std::string& convId, const int64_t since, const int limit,
+                               std::vector<MessageInfo>& result) {
+    return serveLoaded(convId, [&](const Entry& entry) {
+        if (since < entry.floor) {
+            metrics_.misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        auto it = std::upper_bound(entry.messages.begin(), entry.messages.end(), since,
+            [](const int64_t id, const MessageInfo& m) { return id < m.servId; });
+        result.clear();
+        for (; it != entry.messages.end() && static_cast<int>(result.size()) < limit; ++it) {
+            result.push_back(*it);
+        }
+        metrics_.hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    });
+}
+
+bool RecentMessageCache::fetchBefore(const std::string& convId, const int64_t before, const int limit,
+                                     std::vector<MessageInfo>& result) {
+    return serveLoaded(convId, [&](const Entry& entry) {
+        const auto end = before <= 0 ? entry.messages.end()
+            : std::lower_bound(entry.messages.begin(), entry.messages.end(), before,
+                [](const MessageInfo& m, const int64_t id) { return m.servId < id; });
+        const auto available = std::distance(entry.messages.begin(), end);
+        // 环中不足一页且更早的消息不在环中
+        if (available < limit && entry.floor > 0) {
+            metrics_.misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        result.assign(end - std::min<std::ptrdiff_t>(available, std::max(0, limit)), end);
+        metrics_.hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    });
+}
+
+bool RecentMessageCache::serveLoaded(const std::string& convId, const std::function<bool(const Entry&)>& serve) {
+    auto& stripe = stripeOf(convId);
+    std::unique_lock<std::mutex> lock(stripe.mutex);
+    while (true) {
+        const auto it = stripe.index.find(convId);
+        if (it == stripe.index.end()) {
+            break;
+        }
+        if (it->second->loaded && std::chrono::steady_clock::now() - it->second->loadedAt < options_.ttl) {
+            return serve(touchLocked(stripe, convId));
+        }
+        if (!it->second->loading) {
+            break;
+        }
+        stripe.cond.wait(lock);
+    }
+
+    // 未加载或已过期：不持锁查询最新消息，期间到达的消息照常追加，合并时保留
+    touchLocked(stripe, convId).loading = true;
+    lock.unlock();
+    std::vector<MessageInfo> rows;
+    metrics_.loads.fetch_add(1, std::memory_order_relaxed);
+    const bool ok = loader_(convId, static_cast<int>(options_.ringSize), rows);
+    lock.lock();
+
+    // 加载期间会话可能已被淘汰，touchLocked 重新建立
+    auto& entry = touchLocked(stripe, convId);
+    entry.loading = false;
+    stripe.cond.notify_all();
+    if (!ok) {
+        metrics_.misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    std::deque<MessageInfo> pending;
+    pending.swap(entry.messages);
+    stripe.bytes -= entry.bytes;
+    entry.bytes = 0;
+    // 取满一个环时更早的消息不在环中；不满说明已是会话的全部消息
+    entry.floor = rows.size() >= options_.ringSize ? rows.front().servId - 1 : 0;
+    entry.loaded = true;
+    entry.loadedAt = std::chrono::steady_clock::now();
+    for (const auto& row : rows) {
+        insertLocked(stripe, entry, row, true);
+    }
+    // 环中 MySQL 还没有的消息（尚未刷写）按 ID 补回
+    for (const auto& msg : pending) {
+        insertLocked(stripe, entry, msg, false);
+    }
+    evictLocked(stripe, entry);
+    return serve(entry);
+}
+
+RecentMessageCache::Stripe& RecentMessageCache::stripeOf(const std::string& convId) {
+    return stripes_[std::hash<std::string>{}(convId) % STRIPES];
+}
+
+RecentMessageCache::Entry& RecentMessageCache::touchLocked(Stripe& stripe, const std::string& convId) {
+    if (const auto it = stripe.index.find(convId); it != stripe.index.end()) {
+        stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+        return *it->second;
+    }
+    stripe.lru.emplace_front();
+    stripe.lru.front().convId = convId;
+    stripe.index.emplace(convId, stripe.lru.begin());
+    return stripe.lru.front();
+}
+
+void RecentMessageCache::insertLocked(Stripe& stripe, Entry& entry, const MessageInfo& msg, const bool replace) {
+    if (entry.loaded && msg.servId <= entry.floor) {
+        return;
+    }
+    // 新消息几乎总在末尾，从后往前找插入位置
+    auto pos = entry.messages.end();
+    while (pos != entry.messages.begin() && std::prev(pos)->servId > msg.servId) {
+        --pos;
+    }
+    if (pos != entry.messages.begin() && std::prev(pos)->servId == msg.servId) {
+        if (replace) {
+            auto& existing = *std::prev(pos);
+            const size_t oldBytes = estimateBytes(existing);
+            const size_t newBytes = estimateBytes(msg);
+            entry.bytes = entry.bytes - oldBytes + newBytes;
+            stripe.bytes = stripe.bytes - oldBytes + newBytes;
+            existing = msg;
+        }
+        return;
+    }
+    const size_t bytes = estimateBytes(msg);
+    entry.messages.insert(pos, msg);
+    entry.bytes += bytes;
+    stripe.bytes += bytes;
+
+    while (entry.messages.size() > options_.ringSize) {
+        const size_t dropped = estimateBytes(entry.messages.front());
+        entry.floor = std::max(entry.floor, entry.messages.front().servId);
+        entry.messages.pop_front();
+        entry.bytes -= dropped;
+        stripe.bytes -= dropped;
+    }
+}
+
+size_t RecentMessageCache::eraseLocked(Stripe& stripe, Entry& entry,
+                                       const std::function<bool(const MessageInfo&)>& pred) {
+    size_t erased = 0;
+    for (auto it = entry.messages.begin(); it != entry.messages.end();) {
+        if (!pred(*it)) {
+            ++it;
+            continue;
+        }
+        const size_t bytes = estimateBytes(*it);
+        entry.bytes -= bytes;
+        stripe.bytes -= bytes;
+        it = entry.messages.erase(it);
+        erased++;
+    }
+    return erased;
+}
+
+void RecentMessageCache::evictLocked(Stripe& stripe, const Entry& keep) {
+    while (stripe.bytes > stripe_budget_ && stripe.lru.size() > 1 && &stripe.lru.back() != &keep) {
+        auto& victim = stripe.lru.back();
+        stripe.bytes -= victim.bytes;
+        stripe.index.erase(victim.convId);
+        stripe.lru.pop_back();
+        metrics_.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t RecentMessageCache::estimateBytes(const MessageInfo& msg) {
+    const auto heap = [](const std::optional<std::string>& s) -> size_t {
+        return s && s->capacity() > std::string().capacity() ? s->capacity() + 1 : 0;
+    };
+    return sizeof(MessageInfo) + heap(msg.convId) + heap(msg.content) + heap(msg.createTime);
+}
+
+RecentMessageCache::Stats RecentMessageCache::stats() const {
+    Stats stats;
+    for (size_t i = 0; i < STRIPES; i++) {
+        std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+        stats.conversations += stripes_[i].index.size();
+        stats.bytes += stripes_[i].bytes;
+    }
+    stats.hits = metrics_.hits.load(std::memory_order_relaxed);
+    stats.misses = metrics_.misses.load(std::memory_order_relaxed);
+    stats.loads = metrics_.loads.load(std::memory_order_relaxed);
+    stats.evictions = metrics_.evictions.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void RecentMessageCache::printMetrics() const {
+    const auto s = stats();
+    std::cout << "[recent_msg_cache] "
+              << "hits=" << s.hits
+              << " misses=" << s.misses
+              << " loads=" << s.loads
+              << " convs=" << s.conversations
+              << " kb=" << (s.bytes >> 10)
+              << " evictions=" << s.evictions
+              << std::endl;
+}
@@ -0,0 +1,137 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_RECENTMESSAGECACHE_H
+#define IMSERVER_RECENTMESSAGECACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/model/MessageInfo.h"
+
+/**
+ * @brief 热点会话的最近消息环：conv_id → 按 serverId 升序的最新 RingSize 条消息。
+ *
+ * 打开聊天时各参与者拉取的都是会话最新的一页，由本地环直接返回，不再逐次查询 MySQL：
+ *   - 写入填充：chatMsgHandle 收到消息即 append，BatchWriter 尚未落库的消息也能读到（读己之写）；
+ *     环中已有同一发送方同一客户端 msg_id 的消息时视为重发，chatMsgHandle 经 findResent 沿用第一次的
+ *     serverId 再扇出；环中已淘汰、落库时才发现的重发由 correct 改为已存储的 serverId，
+ *     判定为毒消息不会落库的由 remove 删除，环中不留没有落库的 serverId；
+ *   - 读未命中填充：会话未加载或已过期时一次查询最新 RingSize 条，与环中尚未落库的消息按 ID 合并；
+ *     同一会话同时只有一个加载，打开热点会话时其余读者等待加载完成，不会同时打到 MySQL；
+ *   - 每个环记录水位 floor：ID 大于 floor 的消息都在环中，since >= floor 的拉取可以完全由内存返回，
+ *     向旧翻页时环中够一页（或环中已是会话全部消息）也由内存返回，更早的页仍查询 MySQL；
+ *   - 其他服务器收到的消息和已读状态的变更不会写入本地环，加载后超过 RecentMsgTtlMs 重新加载；
+ *   - 按会话分段加锁，每段按字节估算限制内存，超出时按 LRU 淘汰整个会话。
+ *
+ * 监控 (Metrics):
+ *   - hits / misses      : 由内存返回 / 需要查询 MySQL 分页的拉取次数
+ *   - loads              : 加载最新消息的 MySQL 查询次数
+ *   - convs / kb         : 缓存的会话数 / 估算内存
+ *   - evictions          : 累计淘汰的会话数
+ */
+class RecentMessageCache {
+public:
+    /// 查询会话最新的 limit 条消息，按 ID 升序；查询失败返回 false
+    typedef std::function<bool(const std::string& convId, int limit, std::vector<MessageInfo>& result)> loadHandler;
+
+    struct Options {
+        size_t ringSize = 200;
+        size_t maxBytes = 64 << 20;
+        std::chrono::milliseconds ttl{2000};
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t loads = 0;
+        uint64_t evictions = 0;
+        size_t conversations = 0;
+        size_t bytes = 0;
+    };
+
+    RecentMessageCache(const Options& options, loadHandler loader);
+
+    /// 收到新消息时调用，会话不在缓存中时建立未加载的环，首次读取时再与 MySQL 合并
+    void append(const MessageInfo& msg);
+    /// 客户端重发：环中已有同一发送方同一客户端 msg_id 的消息时取出其 serverId，扇出前沿用
+    bool findResent(const MessageInfo& msg, int64_t& servId);
+    /// 客户端重发的消息落库时以已存储的 serverId 为准：删除环中同一消息的其他 serverId 并补入存储的
+    void correct(const MessageInfo& stored);
+    /// 删除不会落库的消息
+    void remove(const std::string& convId, int64_t servId);
+    /**
+     * @brief 拉取 serverId 大于 since 的最多 limit 条消息。
+     * @return 结果完全由缓存给出时返回 true；since 早于环的水位或加载失败时返回 false，调用方查询 MySQL
+     */
+    bool fetch(const std::string& convId, int64_t since, int limit, std::vector<MessageInfo>& result);
+    /**
+     * @brief 拉取 serverId 小于 before 的最新 limit 条消息（before 为 0 时不限），按 ID 升序。
+     * @return 环中不足一页且更早的消息不在环中，或加载失败时返回 false，调用方查询 MySQL
+     */
+    bool fetchBefore(const std::string& convId, int64_t before, int limit, std::vector<MessageInfo>& result);
+
+    [[nodiscard]] Stats stats() const;
+    void printMetrics() const;
+
+private:
+    struct Entry {
+        std::string convId;
+        std::deque<MessageInfo> messages;
+        int64_t floor = 0;          ///< ID 大于 floor 的消息都在环中，仅 loaded 时有效
+        bool loaded = false;        ///< 是否已与 MySQL 合并
+        bool loading = false;       ///< 正在加载，其余读者在段的 cond 上等待
+        std::chrono::steady_clock::time_point loadedAt;
+        size_t bytes = 0;
+    };
+
+    struct Stripe {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::list<Entry> lru;       ///< 队首最近使用
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    Stripe& stripeOf(const std::string& convId);
+    /// 会话的环已加载且未过期时直接 serve，否则单飞加载后 serve；加载失败返回 false
+    bool serveLoaded(const std::string& convId, const std::function<bool(const Entry&)>& serve);
+    /// 查找或新建会话的环并移到 LRU 队首，调用方持有段锁
+    Entry& touchLocked(Stripe& stripe, const std::string& convId);
+    /// 按 ID 插入，已存在时以 replace 决定是否覆盖；超出环大小时丢弃最旧的消息并推进水位
+    void insertLocked(Stripe& stripe, Entry& entry, const MessageInfo& msg, bool replace);
+    /// 删除满足 pred 的消息，返回删除的条数
+    size_t eraseLocked(Stripe& stripe, Entry& entry, const std::function<bool(const MessageInfo&)>& pred);
+    void evictLocked(Stripe& stripe, const Entry& keep);
+
+    static size_t estimateBytes(const MessageInfo& msg);
+
+    static constexpr size_t STRIPES = 16;
+
+    const Options options_;
+    const size_t stripe_budget_;
+    loadHandler loader_;
+    std::unique_ptr<Stripe[]> stripes_;
+
+    struct Metrics {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> loads{0};
+        std::atomic<uint64_t> evictions{0};
+    } metrics_;
+};
+
+
+#endif //IMSERVER_RECENTMESSAGECACHE_H
@@ -0,0 +1,97 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_UNREADDELTATABLE_H
+#define IMSERVER_UNREADDELTATABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/model/MessageInfo.h"
+
+/**
+ * @brief 会话未读增量表：消息落库后累加，由 CounterService 定时取出写入 user_conversation。
+ *
+ * 每个会话只记录落库的消息总数和各发送方的条数，与会话成员数无关；同一会话一段时间内的消息
+ * 合并为一次更新。按 conv_id 有序取出，各事务对 user_conversation 的加锁顺序一致。
+ * 不加锁，由调用方同步。
+ */
+class UnreadDeltaTable {
+public:
+    /// 一条消息落库
+    void add(const std::string& convId, const int64_t msgId, const int senderUid) {
+        auto& delta = deltas_[convId];
+        delta.total++;
+        delta.maxMsgId = std::max(delta.maxMsgId, msgId);
+        delta.minMsgId = std::min(delta.minMsgId, msgId);
+        delta.sent[senderUid]++;
+        messages_++;
+    }
+
+    /// 写入失败的增量放回，与期间新增的合并
+    void merge(std::vector<ConvUnreadDelta> deltas) {
+        for (auto& item : deltas) {
+            auto [it, inserted] = deltas_.try_emplace(item.convId);
+            auto& delta = it->second;
+            messages_ += item.total;
+            if (inserted) {
+                delta = std::move(item);
+                continue;
+            }
+            delta.total += item.total;
+            delta.maxMsgId = std::max(delta.maxMsgId, item.maxMsgId);
+            delta.minMsgId = std::min(delta.minMsgId, item.minMsgId);
+            for (const auto& [uid, sent] : item.sent) {
+                delta.sent[uid] += sent;
+            }
+        }
+    }
+
+    /// 按 conv_id 升序取出全部增量并清空
+    std::vector<ConvUnreadDelta> drain() {
+        std::vector<ConvUnreadDelta> result;
+        result.reserve(deltas_.size());
+        for (auto& [convId, delta] : deltas_) {
+            delta.convId = convId;
+            result.push_back(std::move(delta));
+        }
+        deltas_.clear();
+        messages_ = 0;
+        return result;
+    }
+
+    [[nodiscard]] bool contains(const std::string& convId) const {
+        return deltas_.count(convId) > 0;
+    }
+
+    /// 会话尚未写入的最小消息 ID，没有增量时返回 false
+    bool minMsgId(const std::string& convId, int64_t& msgId) const {
+        const auto it = deltas_.find(convId);
+        if (it == deltas_.end()) {
+            return false;
+        }
+        msgId = it->second.minMsgId;
+        return true;
+    }
+
+    [[nodiscard]] size_t convs() const {
+        return deltas_.size();
+    }
+
+    /// 尚未写入的消息条数
+    [[nodiscard]] size_t messages() const {
+        return messages_;
+    }
+
+private:
+    std::map<std::string, ConvUnreadDelta> deltas_;
+    size_t messages_ = 0;
+};
+
+
+#endif //IMSERVER_UNREADDELTATABLE_H
@@ -0,0 +1,147 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "UserRouteCache.h"
+
+#include <iostream>
+
+#include "ConfigMgr.h"
+#include "RedisMgr.h"
+
+namespace {
+constexpr int DEFAULT_ROUTE_ONLINE_TTL_MS = 5000;
+constexpr int DEFAULT_ROUTE_OFFLINE_TTL_MS = 1000;
+}
+
+UserRouteCache::UserRouteCache()
+    : onlineTtl_(DEFAULT_ROUTE_ONLINE_TTL_MS), offlineTtl_(DEFAULT_ROUTE_OFFLINE_TTL_MS),
+      started_(false), hits_(0), misses_(0) {
+    auto& config = ConfigMgr::getInstance();
+    if (!config["ChatServer"]["RouteCacheTtlMs"].empty()) {
+        onlineTtl_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["RouteCacheTtlMs"]));
+    }
+    if (!config["ChatServer"]["RouteCacheOfflineTtlMs"].empty()) {
+        offlineTtl_ = std::chrono::milliseconds(std::stoi(config["ChatServer"]["RouteCacheOfflineTtlMs"]));
+    }
+}
+
+void UserRouteCache::start() {
+    if (started_.exchange(true)) {
+        return;
+    }
+    // 断连期间的通知可能丢失，（重新）订阅成功后清空整表
+    RedisMgr::getInstance()->subscribe(USER_ROUTE_CHANNEL,
+        [this](const std::string& message) {
+            onRouteMessage(message);
+        },
+        [this]() {
+            clear();
+        });
+}
+
+std::string UserRouteCache::getServerName(const int uid) {
+    auto& shard = shardOf(uid);
+    uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (const auto it = shard.routes.find(uid); it != shard.routes.end()) {
+            if (it->second.expireTime > std::chrono::steady_clock::now()) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second.serverName;
+            }
+            shard.routes.erase(it);
+        }
+        epoch = shard.epoch;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    std::string serverName = RedisMgr::getInstance()->hGet(
+        USER_ONLINE_INFO_PREFIX + std::to_string(uid), USER_ONLINE_SERVER_NAME);
+    storeRoute(shard, uid, epoch, serverName);
+    return serverName;
+}
+
+std::unordered_map<std::string, std::vector<int>> UserRouteCache::groupByServer(const std::vector<int> &uids) {
+    std::unordered_map<std::string, std::vector<int>> result;
+    std::vector<int> missUids;
+    std::vector<uint64_t> missEpochs;
+    const auto now = std::chrono::steady_clock::now();
+    for (const int uid : uids) {
+        auto& shard = shardOf(uid);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (const auto it = shard.routes.find(uid); it != shard.routes.end() && it->second.expireTime > now) {
+            result[it->second.serverName].push_back(uid);
+            continue;
+        }
+        missUids.push_back(uid);
+        missEpochs.push_back(shard.epoch);
+    }
+    hits_.fetch_add(uids.size() - missUids.size(), std::memory_order_relaxed);
+    if (missUids.empty()) {
+        return result;
+    }
+
+    misses_.fetch_add(missUids.size(), std::memory_order_relaxed);
+    std::vector<std::string> keys;
+    keys.reserve(missUids.size());
+    for (const int uid : missUids) {
+        keys.push_back(USER_ONLINE_INFO_PREFIX + std::to_string(uid));
+    }
+    const auto serverNames = RedisMgr::getInstance()->hGetPipeline(keys, USER_ONLINE_SERVER_NAME);
+    for (size_t i = 0; i < missUids.size(); i++) {
+        storeRoute(shardOf(missUids[i]), missUids[i], missEpochs[i], serverNames[i]);
+        result[serverNames[i]].push_back(missUids[i]);
+    }
+    return result;
+}
+
+void UserRouteCache::storeRoute(RouteShard &shard, const int uid, const uint64_t epoch,
+    const std::string &serverName) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.epoch != epoch) {
+        return;  // 回源期间路由已变更，结果只用于本次投递
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (shard.routes.size() >= MAX_ROUTES_PER_SHARD) {
+        for (auto it = shard.routes.begin(); it != shard.routes.end();) {
+            it = it->second.expireTime <= now ? shard.routes.erase(it) : std::next(it);
+        }
+        if (shard.routes.size() >= MAX_ROUTES_PER_SHARD) {
+            shard.routes.clear();
+        }
+    }
+    shard.routes[uid] = RouteEntry{serverName, now + (serverName.empty() ? offlineTtl_ : onlineTtl_)};
+}
+
+void UserRouteCache::invalidate(const int uid) {
+    auto& shard = shardOf(uid);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.routes.erase(uid);
+    shard.epoch++;
+}
+
+void UserRouteCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.routes.clear();
+        shard.epoch++;
+    }
+}
+
+void UserRouteCache::publishRouteChanged(const int uid) {
+    invalidate(uid);
+    RedisMgr::getInstance()->publish(USER_ROUTE_CHANNEL, std::to_string(uid));
+}
+
+UserRouteCache::RouteShard & UserRouteCache::shardOf(const int uid) {
+    return shards_[static_cast<size_t>(uid) % SHARD_NUM];
+}
+
+void UserRouteCache::onRouteMessage(const std::string &message) {
+    try {
+        invalidate(std::stoi(message));
+    } catch (std::exception& e) {
+        std::cout << "UserRouteCache: invalid route message [" << message << "]" << std::endl;
+    }
+}
@@ -0,0 +1,86 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_USERROUTECACHE_H
+#define IMSERVER_USERROUTECACHE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Singleton.h"
+
+/**
+ * @brief 本地用户路由表：uid → 所在 ChatServer 服务名。
+ *
+ * 热路径（聊天消息、好友通知投递）先查本地路由，未命中再回源 Redis `user_online_{uid}`，
+ * 不在线的结果同样缓存（空服务名）。表项带短 TTL 兜底，
+ * 登录/下线/踢人时通过 Redis 频道 USER_ROUTE_CHANNEL 广播 uid，各服务器收到后删除对应表项。
+ */
+class UserRouteCache : public Singleton<UserRouteCache> {
+public:
+    ~UserRouteCache() = default;
+
+    /// 订阅路由变更频道，重复调用无副作用
+    void start();
+
+    /// 查询用户所在服务名，返回空串表示不在线
+    std::string getServerName(int uid);
+
+    /**
+     * @brief 批量查询路由并按服务名分组，不在线的用户归入空服务名。
+     *
+     * 命中本地表的直接分组，未命中的合并为一次 Redis 流水线回源，
+     * 群消息扇出时避免逐个成员往返 Redis。
+     */
+    std::unordered_map<std::string, std::vector<int>> groupByServer(const std::vector<int>& uids);
+
+    void invalidate(int uid);
+    void clear();
+
+    /// 本地失效并广播路由变更，其他服务器收到后失效各自的表项
+    void publishRouteChanged(int uid);
+
+    uint64_t hitCount() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t missCount() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    friend class Singleton<UserRouteCache>;
+    UserRouteCache();
+
+    struct RouteEntry {
+        std::string serverName;     ///< 为空表示不在线
+        std::chrono::steady_clock::time_point expireTime;
+    };
+
+    struct RouteShard {
+        std::mutex mutex;
+        std::unordered_map<int, RouteEntry> routes;
+        /// 每次失效递增，回源期间发生失效则丢弃回源结果，避免旧路由覆盖新通知
+        uint64_t epoch = 0;
+    };
+
+    static constexpr size_t SHARD_NUM = 16;
+    static constexpr size_t MAX_ROUTES_PER_SHARD = 65536;
+
+    RouteShard& shardOf(int uid);
+    /// 回源结果写回本地表，epoch 变化说明期间发生过失效，丢弃结果
+    void storeRoute(RouteShard& shard, int uid, uint64_t epoch, const std::string& serverName);
+    void onRouteMessage(const std::string& message);
+
+    std::array<RouteShard, SHARD_NUM> shards_;
+    std::chrono::milliseconds onlineTtl_;
+    std::chrono::milliseconds offlineTtl_;
+
+    std::atomic<bool> started_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+};
+
+
+#endif //IMSERVER_USERROUTECACHE_H
@@ -0,0 +1,262 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "ConversationCache.h"
+
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+#include "ConfigMgr.h"
+#include "RedisMgr.h"
+#include "core/ConversationListCache.h"
+#include "core/MessageIdGenerator.h"
+
+namespace {
+constexpr int DEFAULT_CONV_LIST_REDIS_TTL_SEC = 86400;
+constexpr int DEFAULT_CONV_LIST_SETTLE_SEC = 30;
+constexpr int DEFAULT_CONV_LIST_COALESCE_US = 2000;
+
+// KEYS[1] 会话列表，KEYS[2] 会话详情，KEYS[3] 未应用标记；ARGV: conv_id, 活跃时间, 最新消息 JSON, 未读增量, 标记过期秒数
+constexpr const char* MESSAGE_SCRIPT =
+    "local s = redis.call('ZSCORE', KEYS[1], ARGV[1]) "
+    "if not s then redis.call('DEL', KEYS[1], KEYS[2]) redis.call('SET', KEYS[3], '1', 'EX', ARGV[5]) return 0 end "
+    "if tonumber(ARGV[2]) >= tonumber(s) then "
+    "redis.call('ZADD', KEYS[1], ARGV[2], ARGV[1]); "
+    "redis.call('HSET', KEYS[2], ARGV[1] .. ':last', ARGV[3]) end "
+    "if ARGV[4] ~= '0' then redis.call('HINCRBY', KEYS[2], ARGV[1] .. ':unread', ARGV[4]) end "
+    "return 1";
+
+// KEYS 同上；ARGV: conv_id, 未读数（-1 表示按已读条数扣减）, 已读条数, 标记过期秒数
+constexpr const char* READ_SCRIPT =
+    "if not redis.call('ZSCORE', KEYS[1], ARGV[1]) then redis.call('SET', KEYS[3], '1', 'EX', ARGV[4]) return 0 end "
+    "local f = ARGV[1] .. ':unread' "
+    "if ARGV[2] ~= '-1' then redis.call('HSET', KEYS[2], f, ARGV[2]) return 1 end "
+    "if redis.call('HINCRBY', KEYS[2], f, -tonumber(ARGV[3])) < 0 then redis.call('HSET', KEYS[2], f, 0) end "
+    "return 1";
+
+// KEYS 同上；ARGV: 完整过期秒数, 存在未应用标记时的过期秒数
+constexpr const char* EXPIRE_SCRIPT =
+    "local t = ARGV[1] "
+    "if redis.call('EXISTS', KEYS[3]) == 1 then t = ARGV[2] end "
+    "redis.call('EXPIRE', KEYS[1], t) redis.call('EXPIRE', KEYS[2], t) "
+    "return tonumber(t)";
+
+std::string listKey(const int uid) {
+    return CONV_LIST_PREFIX + std::to_string(uid);
+}
+
+std::string itemKey(const int uid) {
+    return CONV_ITEM_PREFIX + std::to_string(uid);
+}
+
+std::string staleKey(const int uid) {
+    return CONV_LIST_STALE_PREFIX + std::to_string(uid);
+}
+}
+
+ConversationCache::ConversationCache()
+    : ttlSec_(std::to_string(DEFAULT_CONV_LIST_REDIS_TTL_SEC)), settleSec_(std::to_string(DEFAULT_CONV_LIST_SETTLE_SEC)),
+      coalesce_(DEFAULT_CONV_LIST_COALESCE_US) {
+    auto& config = ConfigMgr::getInstance();
+    if (!config["ChatServer"]["ConvListRedisTtlSec"].empty()) {
+        ttlSec_ = config["ChatServer"]["ConvListRedisTtlSec"];
+    }
+    if (!config["ChatServer"]["ConvListSettleSec"].empty()) {
+        settleSec_ = config["ChatServer"]["ConvListSettleSec"];
+    }
+    if (!config["ChatServer"]["ConvListCoalesceUs"].empty()) {
+        coalesce_ = std::chrono::microseconds(std::stoi(config["ChatServer"]["ConvListCoalesceUs"]));
+    }
+}
+
+ConversationCache::~ConversationCache() {
+    stop();
+}
+
+void ConversationCache::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread([this] { writerLoop(); });
+}
+
+void ConversationCache::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool ConversationCache::loadList(const int uid, std::vector<ConversationInfo> &result) const {
+    std::vector<std::vector<std::string>> replies;
+    if (!RedisMgr::getInstance()->pipeline({{"ZRANGE", listKey(uid), "0", "-1"}, {"HGETALL", itemKey(uid)}}, replies)
+        || replies[0].empty()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    std::unordered_map<std::string, std::string> fields;
+    for (size_t i = 0; i + 1 < replies[1].size(); i += 2) {
+        fields.emplace(std::move(replies[1][i]), std::move(replies[1][i + 1]));
+    }
+
+    result.clear();
+    result.reserve(replies[0].size());
+    Json::Reader reader;
+    for (const auto& convId : replies[0]) {
+        Json::Value value;
+        const auto item = fields.find(convId);
+        if (item == fields.end() || !reader.parse(item->second, value)) {
+            // 列表与详情不一致（写入中途失败），按未命中处理，由 MySQL 重建
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        ConversationInfo info;
+        info.fromJson(value);
+        info.uid = uid;
+        if (const auto unread = fields.find(convId + CONV_ITEM_UNREAD_SUFFIX); unread != fields.end()) {
+            info.unreadCount = std::stoi(unread->second);
+        }
+        if (const auto last = fields.find(convId + CONV_ITEM_LAST_SUFFIX); last != fields.end()) {
+            if (Json::Value lastValue; reader.parse(last->second, lastValue)) {
+                info.fromJson(lastValue);
+            }
+        }
+        result.push_back(std::move(info));
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ConversationCache::storeList(const int uid, const std::vector<ConversationInfo> &list) const {
+    if (list.empty()) {
+        return true;
+    }
+    const std::string list_key = listKey(uid);
+    const std::string item_key = itemKey(uid);
+    const std::string stale_key = staleKey(uid);
+    std::vector<std::string> zadd{"ZADD", list_key};
+    std::vector<std::string> hset{"HSET", item_key};
+    zadd.reserve(2 + list.size() * 2);
+    hset.reserve(2 + list.size() * 4);
+    for (const auto& info : list) {
+        Json::Value value;
+        info.toJson(value);
+        value.removeMember("unread_count");
+        zadd.push_back(std::to_string(ConversationListCache::activityOf(info)));
+        zadd.push_back(info.convId);
+        hset.push_back(info.convId);
+        hset.push_back(Json::FastWriter().write(value));
+        hset.push_back(info.convId + CONV_ITEM_UNREAD_SUFFIX);
+        hset.push_back(std::to_string(std::max(0, info.unreadCount)));
+    }
+    // 写入前有更新因列表不存在未应用时，快照可能缺少其中尚未计入 MySQL 的消息和已读，只保留 settleSec_，
+    // 过期后由已计入的 MySQL 重建；写入之后的更新都原地应用
+    std::vector<std::vector<std::string>> replies;
+    if (!RedisMgr::getInstance()->pipeline({
+        {"DEL", list_key, item_key},
+        std::move(zadd),
+        std::move(hset),
+        {"EVAL", EXPIRE_SCRIPT, "3", list_key, item_key, stale_key, ttlSec_, settleSec_},
+    }, replies)) {
+        return false;
+    }
+    if (replies.size() == 4 && !replies[3].empty() && replies[3][0] == settleSec_) {
+        settling_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void ConversationCache::applyMessage(const std::vector<int> &members, const MessageInfo &msg) {
+    if (members.empty() || !msg.convId.has_value() || msg.servId <= 0) {
+        return;
+    }
+    const int64_t timestamp = MessageIdGenerator::timestampOf(msg.servId);
+    Json::Value last;
+    last["last_msg_id"] = static_cast<Json::Int64>(msg.servId);
+    last["last_msg_content"] = msg.summary();
+    last["last_time"] = ms_to_datetime(timestamp);
+    const std::string lastJson = Json::FastWriter().write(last);
+    const std::string score = std::to_string(timestamp);
+
+    std::vector<std::vector<std::string>> commands;
+    commands.reserve(members.size());
+    for (const int uid : members) {
+        commands.push_back({"EVAL", MESSAGE_SCRIPT, "3", listKey(uid), itemKey(uid), staleKey(uid), msg.convId.value(),
+            score, lastJson, uid == msg.fromUid ? "0" : "1", settleSec_});
+    }
+    enqueue(std::move(commands));
+}
+
+void ConversationCache::applyRead(const int uid, const std::string &convId, const int unread, const int count) {
+    enqueue({{"EVAL", READ_SCRIPT, "3", listKey(uid), itemKey(uid), staleKey(uid), convId, std::to_string(unread),
+        std::to_string(std::max(0, count)), settleSec_}});
+}
+
+void ConversationCache::invalidate(const int uid) {
+    enqueue({{"DEL", listKey(uid), itemKey(uid)}});
+}
+
+void ConversationCache::enqueue(std::vector<std::vector<std::string>> commands) {
+    ops_.fetch_add(commands.size(), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& command : commands) {
+            pending_.push_back(std::move(command));
+        }
+    }
+    cond_.notify_one();
+}
+
+void ConversationCache::writerLoop() {
+    std::vector<std::vector<std::string>> commands;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]() {
+                return !running_ || !pending_.empty();
+            });
+            if (running_ && coalesce_.count() > 0) {
+                // 聚合窗口：群消息和连续消息的更新合并到一次往返
+                cond_.wait_for(lock, coalesce_, [this]() {
+                    return !running_;
+                });
+            }
+            commands.swap(pending_);
+            if (!running_ && commands.empty()) {
+                return;
+            }
+        }
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        if (!RedisMgr::getInstance()->pipeline(commands)) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            std::cout << "ConversationCache: write " << commands.size() << " conversation list ops failed" << std::endl;
+        }
+        commands.clear();
+    }
+}
+
+void ConversationCache::printMetrics() {
+    const uint64_t ops = ops_.exchange(0, std::memory_order_relaxed);
+    const uint64_t batches = batches_.exchange(0, std::memory_order_relaxed);
+    const uint64_t failures = failures_.exchange(0, std::memory_order_relaxed);
+    const uint64_t hits = hits_.exchange(0, std::memory_order_relaxed);
+    const uint64_t misses = misses_.exchange(0, std::memory_order_relaxed);
+    const uint64_t settling = settling_.exchange(0, std::memory_order_relaxed);
+    if (ops == 0 && hits == 0 && misses == 0) {
+        return;
+    }
+    std::cout << "[conv_list_redis] hits=" << hits
+              << " misses=" << misses
+              << " settling=" << settling
+              << " ops=" << ops
+              << " batches=" << batches
+              << " avg_batch=" << std::fixed << std::setprecision(1)
+              << (batches > 0 ? static_cast<double>(ops) / batches : 0)
+              << " failures=" << failures
+              << std::endl;
+}
@@ -0,0 +1,93 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_CONVERSATIONCACHE_H
+#define IMSERVER_CONVERSATIONCACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Singleton.h>
+
+#include "common/model/ConversationInfo.h"
+#include "common/model/MessageInfo.h"
+
+// 用户会话列表：有序集合 conv_id → 活跃时间毫秒
+#define CONV_LIST_PREFIX "conv_list_"
+// 用户会话详情：哈希 conv_id → 会话 JSON；{conv_id}:unread → 未读数；{conv_id}:last → 最新消息 JSON
+#define CONV_ITEM_PREFIX "conv_item_"
+#define CONV_ITEM_UNREAD_SUFFIX ":unread"
+#define CONV_ITEM_LAST_SUFFIX ":last"
+// 用户有更新因会话列表不存在而未应用的标记，存在时冷加载的快照只短暂缓存
+#define CONV_LIST_STALE_PREFIX "conv_list_stale_"
+
+/**
+ * @brief 会话列表的 Redis 层，各服务器共享，本地 ConversationListCache 未命中时先读这里，冷启动才查 MySQL。
+ *
+ * 每个用户一个有序集合加一个哈希，冷加载时整表写入；之后原地更新：
+ *   - 新消息：每个成员一条 Lua 脚本，列表存在时推进活跃时间、写最新消息、接收方未读数加一；
+ *     列表中没有该会话（新建的会话）时删除列表，下次读取重新加载；
+ *   - 已读：按本地算出的未读数覆盖，本地没有列表时按已读条数扣减；
+ *   - 好友、群成员、资料变更：删除列表。
+ * 消息落库、未读增量和已读水位写回 MySQL 都晚于上面的更新，冷加载读到的 MySQL 可能还不含刚发生的变更，
+ * 而这些更新执行时列表不存在、没有应用。因此更新未应用时写一个 ConvListSettleSec 过期的标记：
+ * 冷加载写入时标记仍在的快照只保留 ConvListSettleSec，过期后按已写回的 MySQL 重建；
+ * 没有标记时设置 ConvListRedisTtlSec 过期。
+ * 更新由写线程等待 ConvListCoalesceUs 聚合，按入队顺序拼成一次流水线写入，不阻塞逻辑线程。
+ * 与 MySQL 的未读计数不做强一致，偏差在下一次已读或列表过期后消除。
+ */
+class ConversationCache : public Singleton<ConversationCache> {
+public:
+    ~ConversationCache();
+
+    void start();
+    /// 停止并写出剩余更新
+    void stop();
+
+    /// 读取用户的全部会话，列表不在 Redis 中或不完整时返回 false
+    bool loadList(int uid, std::vector<ConversationInfo>& result) const;
+    /// 冷加载后整表写入，期间有未应用的更新时只短暂缓存
+    bool storeList(int uid, const std::vector<ConversationInfo>& list) const;
+
+    /// 会话收到新消息，members 为全部成员（含发送方）
+    void applyMessage(const std::vector<int>& members, const MessageInfo& msg);
+    /// unread 为本地算出的未读数，-1 表示未知，按 count 扣减
+    void applyRead(int uid, const std::string& convId, int unread, int count);
+    void invalidate(int uid);
+
+    void printMetrics();
+
+private:
+    friend class Singleton<ConversationCache>;
+    ConversationCache();
+
+    void enqueue(std::vector<std::vector<std::string>> commands);
+    void writerLoop();
+
+    std::string ttlSec_;
+    std::string settleSec_;
+    std::chrono::microseconds coalesce_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<std::vector<std::string>> pending_;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    std::atomic<uint64_t> ops_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> failures_{0};
+    mutable std::atomic<uint64_t> hits_{0};
+    mutable std::atomic<uint64_t> misses_{0};
+    mutable std::atomic<uint64_t> settling_{0};
+};
+
+
+#endif //IMSERVER_CONVERSATIONCACHE_H
@@ -41,31 +41,6 @@ bool FriendCache::getFriendInfo(const int uid, const int friendId, FriendInfo &i
     return true;
 }
 
-void FriendCache::clearFriendApplyCount(const int uid) {
-    RedisMgr::getInstance()->hDel(USER_COUNTER_PREFIX + std::to_string(uid),
-            USER_FRIEND_REPLY_COUNT);
-}
-
-bool FriendCache::getFriendApplyCount(const int uid, int &count) {
-    const auto res = RedisMgr::getInstance()->hGet(USER_COUNTER_PREFIX + std::to_string(uid),
-        USER_FRIEND_REPLY_COUNT);
-    if (res.empty()) {
-        return false;
-    }
-
-    count = std::stoi(res);
-    return true;
-}
-
-bool FriendCache::updateFriendApplyCount(const int uid, const int count) {
-    if (uid < 0 || count < 0) {
-        return false;
-    }
-
-    return RedisMgr::getInstance()->hSet(USER_COUNTER_PREFIX + std::to_string(uid),
-        USER_FRIEND_REPLY_COUNT, std::to_string(count));
-}
-
 FriendCache::FriendCache() {
     friendLocalCache_ = LruCache<FriendInfo>::create(
     {.blockOnExpire = true},
@@ -15,8 +15,6 @@
 // 好友关系
 #define FRIEND_SET_PREFIX "friend_set_"
 #define FRIEND_RELATION_INFO_PREFIX "friend_relation_info_"
-// 状态计数
-#define USER_FRIEND_REPLY_COUNT "friend_reply"  // 好友申请计数
 
 class FriendCache : public Singleton<FriendCache> {
     friend class Singleton<FriendCache>;
@@ -28,10 +26,6 @@ public:
      bool deleteFriendSet(int uid, int friendId);
      bool getFriendInfo(int uid, int friendId, FriendInfo& info);
 
-     void clearFriendApplyCount(int uid);
-     bool getFriendApplyCount(int uid, int& count);
-     bool updateFriendApplyCount(int uid, int count);
-
 private:
     FriendCache();
 
@@ -32,6 +32,52 @@ bool UserInfoCache::updateBaseInfo(const UserBaseInfo &info) {
     return RedisMgr::getInstance()->set(USER_BASE_INFO_PREFIX + std::to_string(info.uid), root.toStyledString());
 }
 
+bool UserInfoCache::getBaseInfos(const std::vector<int> &uids, std::vector<UserBaseInfo> &result) {
+    result.assign(uids.size(), UserBaseInfo{});
+    if (uids.empty()) {
+        return true;
+    }
+    std::vector<std::string> mget{"MGET"};
+    mget.reserve(uids.size() + 1);
+    for (const int uid : uids) {
+        mget.push_back(USER_BASE_INFO_PREFIX + std::to_string(uid));
+    }
+    std::vector<std::vector<std::string>> replies;
+    if (!RedisMgr::getInstance()->pipeline({std::move(mget)}, replies) || replies[0].size() != uids.size()) {
+        return false;
+    }
+    Json::Reader reader;
+    for (size_t i = 0; i < uids.size(); i++) {
+        Json::Value root;
+        if (uids[i] < 0 || replies[0][i].empty() || !reader.parse(replies[0][i], root)) {
+            continue;
+        }
+        result[i].fromJson(root);
+    }
+    return true;
+}
+
+bool UserInfoCache::updateBaseInfos(const std::vector<UserBaseInfo> &infos) {
+    std::vector<std::vector<std::string>> commands;
+    commands.reserve(infos.size() * 3);
+    for (const auto& info : infos) {
+        if (info.uid < 0) {
+            continue;
+        }
+        Json::Value root;
+        info.toJson(root);
+        const std::string uid = std::to_string(info.uid);
+        commands.push_back({"SET", USER_BASE_INFO_PREFIX + uid, root.toStyledString()});
+        if (info.email.has_value()) {
+            commands.push_back({"SET", UID_INDEX_MAP_PREFIX + info.email.value(), uid});
+        }
+        if (info.name.has_value()) {
+            commands.push_back({"SET", UID_INDEX_MAP_PREFIX + info.name.value(), uid});
+        }
+    }
+    return commands.empty() || RedisMgr::getInstance()->pipeline(commands);
+}
+
 bool UserInfoCache::getUserProfile(const int uid, UserProfile &profile) {
     if (uid < 0) {
         std::cout << "[getBaseInfo] Input invalid param" << std::endl;
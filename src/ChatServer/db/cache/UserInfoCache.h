@@ -5,6 +5,8 @@
 #ifndef IMSERVER_USERINFOCACHE_H
 #define IMSERVER_USERINFOCACHE_H
 
+#include <vector>
+
 #include <Singleton.h>
 
 #include "common/model/UserBaseInfo.h"
@@ -22,6 +24,10 @@ public:
 
     static bool getBaseInfo(int uid, UserBaseInfo& info);
     static bool updateBaseInfo(const UserBaseInfo& info);
+    /// 一次 MGET 读取多个用户，result 与 uids 一一对应，未命中的 uid 为 -1
+    static bool getBaseInfos(const std::vector<int>& uids, std::vector<UserBaseInfo>& result);
+    /// 一次流水线回填多个用户的基础信息及 uid 映射
+    static bool updateBaseInfos(const std::vector<UserBaseInfo>& infos);
 
     static bool getUserProfile(int uid, UserProfile& profile);
 
@@ -11,6 +11,10 @@ bool MysqlMgr::selectUserBaseInfo(UserBaseInfo &info) const {
     return userDao_.selectUserBaseInfo(info);
 }
 
+bool MysqlMgr::selectUserBaseInfos(const std::vector<int> &uids, std::vector<UserBaseInfo> &result) const {
+    return userDao_.selectUserBaseInfos(uids, result);
+}
+
 bool MysqlMgr::selectUserPassword(UserBaseInfo &info) const {
     return userDao_.getUserPassword(info);
 }
@@ -50,6 +54,10 @@ bool MysqlMgr::createFriendRelation(const FriendApply &applyInfo) {
     return friendDao_.createFriendRelation(applyInfo);
 }
 
+bool MysqlMgr::createFriendRelation(const FriendApply &applyInfo, int &applyUpdated) {
+    return friendDao_.createFriendRelation(applyInfo, applyUpdated);
+}
+
 bool MysqlMgr::updateFriendRelation(const int uid, const FriendInfo &friendInfo) {
     return friendDao_.updateFriendRelation(uid, friendInfo);
 }
@@ -66,6 +74,15 @@ bool MysqlMgr::updateFriendApply(const int uid, const int friendId, const int st
     return friendDao_.updateFriendApply(uid, friendId, status, msg);
 }
 
+bool MysqlMgr::updateFriendApply(const int uid, const int friendId, const int status, const std::string &msg,
+                                 int &affected) {
+    return friendDao_.updateFriendApply(uid, friendId, status, msg, affected);
+}
+
+bool MysqlMgr::resolvePendingFriendApply(const int uid, const int friendId, const int status, int &affected) {
+    return friendDao_.resolvePendingFriendApply(uid, friendId, status, affected);
+}
+
 bool MysqlMgr::getFriendApplyCount(const int uid, int &count) {
     return friendDao_.getFriendApplyCount(uid, count);
 }
@@ -78,28 +95,81 @@ std::vector<ConversationInfo> MysqlMgr::selectConversationList(const int uid, co
     return convDao_.selectConversationList(uid, sinceTime);
 }
 
-bool MysqlMgr::createMessage(const MessageInfo &info, int &result) const {
-    return convDao_.createMessage(info, result);
+bool MysqlMgr::selectUserConversations(const int uid, std::vector<ConversationInfo> &result) const {
+    return convDao_.selectUserConversations(uid, result);
+}
+
+bool MysqlMgr::createGroup(const ConversationInfo &info, const std::vector<int> &members, std::string &result) const {
+    return convDao_.createGroup(info, members, result);
+}
+
+bool MysqlMgr::addGroupMembers(const std::string &convId, const std::vector<int> &members) const {
+    return convDao_.addGroupMembers(convId, members);
+}
+
+bool MysqlMgr::removeGroupMembers(const std::string &convId, const std::vector<int> &members) const {
+    return convDao_.removeGroupMembers(convId, members);
+}
+
+bool MysqlMgr::selectGroupOwner(const std::string &convId, int &ownerUid) const {
+    return convDao_.selectGroupOwner(convId, ownerUid);
 }
 
-bool MysqlMgr::updateMessageStatus(const int id, const MessageStatus status) const {
+std::vector<int> MysqlMgr::selectGroupMembers(const std::string &convId) const {
+    return convDao_.selectGroupMembers(convId);
+}
+
+bool MysqlMgr::createMessage(const MessageInfo &info) {
+    return convDao_.createMessage(info);
+}
+
+bool MysqlMgr::updateMessageStatus(const int64_t id, const MessageStatus status) const {
     return convDao_.updateMessageStatus(id, status);
 }
 
-std::vector<MessageInfo> MysqlMgr::selectMessageList(const std::string &convId, const int sinceMsgId, const int limit) {
+std::vector<MessageInfo> MysqlMgr::selectMessageList(const std::string &convId, const int64_t sinceMsgId, const int limit) {
     return convDao_.selectMessageList(convId, sinceMsgId, limit);
 }
 
+bool MysqlMgr::selectRecentMessages(const std::string &convId, const int limit,
+                                    std::vector<MessageInfo> &result) const {
+    return convDao_.selectRecentMessages(convId, limit, result);
+}
+
+bool MysqlMgr::selectMessagesBefore(const std::string &convId, const int64_t beforeMsgId, const int limit,
+                                    std::vector<MessageInfo> &result) const {
+    return convDao_.selectMessagesBefore(convId, beforeMsgId, limit, result);
+}
+
+bool MysqlMgr::selectMessagesAround(const std::string &convId, const int64_t anchorMsgId, const int older,
+                                    const int newer, std::vector<MessageInfo> &result) const {
+    return convDao_.selectMessagesAround(convId, anchorMsgId, older, newer, result);
+}
+
 bool MysqlMgr::updateConvMessagesStatus(const MessageStatusInfo &info) {
     return convDao_.updateConvMessagesStatus(info);
 }
 
+bool MysqlMgr::batchUpdateMessageStatus(const std::vector<MessageStatusWatermark> &marks) {
+    return convDao_.batchUpdateMessageStatus(marks);
+}
+
+bool MysqlMgr::batchAddUnreadCounts(const std::vector<ConvUnreadDelta> &deltas, int &deadlockRetries) const {
+    return convDao_.batchAddUnreadCounts(deltas, deadlockRetries);
+}
+
+bool MysqlMgr::reconcileUnreadCounts(const std::vector<ConvUnreadDelta> &convs, const int64_t workerId,
+                                     std::vector<UnreadCountFix> &fixed) const {
+    return convDao_.reconcileUnreadCounts(convs, workerId, fixed);
+}
+
 
 
 
 
 
 bool MysqlMgr::batchCreateMessages(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes,
-                                   std::unordered_map<int64_t, int>& id_mapping) {
-    return convDao_.batchCreateMessages(nodes, id_mapping);
+                                   std::vector<std::shared_ptr<ChatMsgNode>>& duplicates,
+                                   const size_t chunkSize, int& deadlockRetries) {
+    return convDao_.batchCreateMessages(nodes, duplicates, chunkSize, deadlockRetries);
 }
@@ -28,6 +28,7 @@ public:
 
     // 用户信息接口
     bool selectUserBaseInfo(UserBaseInfo& info) const;
+    bool selectUserBaseInfos(const std::vector<int>& uids, std::vector<UserBaseInfo>& result) const;
     bool selectUserPassword(UserBaseInfo& info) const;
     // 详细信息必须用 UID 查询
     bool selectUserProfileInfo(int uid, UserProfile &info) const;
@@ -42,6 +43,8 @@ public:
     bool isFriendExist(int uid, int friendId);
     // 创建好友关系
     bool createFriendRelation(const FriendApply& applyInfo);
+    // applyUpdated 为 1 表示待处理的申请改为同意，0 表示申请已被处理过
+    bool createFriendRelation(const FriendApply& applyInfo, int& applyUpdated);
     bool updateFriendRelation(int uid, const FriendInfo& friendInfo);
 
     // 获取好友申请列表
@@ -49,23 +52,47 @@ public:
     // 检查是否存在好友申请
     [[nodiscard]] bool checkFriendApplyExist(int uid, int friendId) const;
     bool updateFriendApply(int uid, int friendId, int status = 0, const std::string& msg = "");
+    // affected 为 1 表示新建申请，2 表示更新了已有的申请
+    bool updateFriendApply(int uid, int friendId, int status, const std::string& msg, int& affected);
+    // 处理待处理且未过期的申请，affected 为 1 表示未处理申请数应减一
+    bool resolvePendingFriendApply(int uid, int friendId, int status, int& affected);
     bool getFriendApplyCount(int uid, int& count);
 
     // 聊天会话
     bool createConversation(const ConversationInfo& info, std::string& result) const;
     std::vector<ConversationInfo> selectConversationList(int uid, const std::string& sinceTime);
+    bool selectUserConversations(int uid, std::vector<ConversationInfo>& result) const;
+
+    // 群聊
+    bool createGroup(const ConversationInfo& info, const std::vector<int>& members, std::string& result) const;
+    bool addGroupMembers(const std::string& convId, const std::vector<int>& members) const;
+    bool removeGroupMembers(const std::string& convId, const std::vector<int>& members) const;
+    bool selectGroupOwner(const std::string& convId, int& ownerUid) const;
+    std::vector<int> selectGroupMembers(const std::string& convId) const;
 
     // 聊天消息
-    bool createMessage(const MessageInfo& info, int& result) const;
-    bool updateMessageStatus(int id, MessageStatus status) const;
+    bool createMessage(const MessageInfo& info);
+    bool updateMessageStatus(int64_t id, MessageStatus status) const;
 
-    std::vector<MessageInfo> selectMessageList(const std::string& convId, int sinceMsgId, int limit);
+    std::vector<MessageInfo> selectMessageList(const std::string& convId, int64_t sinceMsgId, int limit);
+    bool selectRecentMessages(const std::string& convId, int limit, std::vector<MessageInfo>& result) const;
+    bool selectMessagesBefore(const std::string& convId, int64_t beforeMsgId, int limit,
+                              std::vector<MessageInfo>& result) const;
+    bool selectMessagesAround(const std::string& convId, int64_t anchorMsgId, int older, int newer,
+                              std::vector<MessageInfo>& result) const;
 
     bool updateConvMessagesStatus(const MessageStatusInfo & info);
+    bool batchUpdateMessageStatus(const std::vector<MessageStatusWatermark>& marks);
+    // 未读计数写回与对账
+    bool batchAddUnreadCounts(const std::vector<ConvUnreadDelta>& deltas, int& deadlockRetries) const;
+    // 只对账水位之后的消息都由本服务器（机器号 workerId）生成的成员
+    bool reconcileUnreadCounts(const std::vector<ConvUnreadDelta>& convs, int64_t workerId,
+                               std::vector<UnreadCountFix>& fixed) const;
 
     // 批量异步入库 (聊天消息)
     bool batchCreateMessages(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes,
-                             std::unordered_map<int64_t, int>& id_mapping);
+                             std::vector<std::shared_ptr<ChatMsgNode>>& duplicates,
+                             size_t chunkSize, int& deadlockRetries);
 
 private:
     friend class Singleton<MysqlMgr>;
@@ -3,19 +3,146 @@
 //
 
 #include "ConversationDao.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <unordered_set>
+
 #include "ConfigMgr.h"
 
 constexpr size_t BATCH_CHUNK_SIZE = 50;
+constexpr size_t MAX_CHUNK_SIZE = 1000;  // 每行 7 个占位符，远低于 MySQL 单语句 65535 的上限
 constexpr int MAX_DEADLOCK_RETRIES = 3;  // MySQL placeholder 限制，每批最多 50 条
+constexpr size_t SET_CHUNK_SIZE = 200;   // 集合更新每条语句最多覆盖的会话数
+constexpr size_t MAX_PLACEHOLDERS = 60000;  // 每条语句的占位符上限，低于 MySQL 的 65535
 #include "core/ChatMsgNode.h"
+#include "core/MessageIdGenerator.h"
 
 constexpr std::string_view CONVERSATION_INFO_PARTS = "conversation.conv_id, conversation.conv_type, "
                                                      "conversation.last_msg_id, conversation.last_msg_content, "
                                                      "conversation.last_time, conversation.update_time, "
-                                                     "conversation.create_time, "
+                                                     "conversation.create_time, conversation.title, "
                                                      "user_conversation.unread_count, user_conversation.is_top, "
                                                      "user_conversation.is_mute ";
-constexpr std::string_view MESSAGE_INFO_PARTS_END = "id, conv_id, sender_uid, msg_type, content, status, create_time ";
+constexpr std::string_view MESSAGE_INFO_PARTS_END = "id, conv_id, sender_uid, msg_type, content, msg_id, status, create_time ";
+
+// 固定文本的热点语句，调用处和连接池预热共用
+const std::string SELECT_GROUP_OWNER_SQL =
+    "SELECT owner_uid FROM conversation WHERE conv_id = ? AND conv_type = ? AND status = 0";
+const std::string SELECT_GROUP_MEMBERS_SQL =
+    "SELECT uid FROM user_conversation WHERE conv_id = ? ORDER BY uid";
+const std::string SELECT_CONVERSATION_LIST_SQL = "SELECT " + std::string(CONVERSATION_INFO_PARTS)
+    + "FROM user_conversation "
+    "INNER JOIN conversation "
+    "ON user_conversation.conv_id = conversation.conv_id "
+    "WHERE user_conversation.uid = ? AND user_conversation.update_time > ? "
+    "ORDER by user_conversation.update_time ASC LIMIT ? ";
+const std::string SELECT_USER_CONVERSATIONS_SQL = "SELECT " + std::string(CONVERSATION_INFO_PARTS)
+    + ", user_conversation.last_read_msg_id "
+    "FROM user_conversation "
+    "INNER JOIN conversation "
+    "ON user_conversation.conv_id = conversation.conv_id "
+    "WHERE user_conversation.uid = ? ";
+const std::string SELECT_MESSAGE_LIST_SQL = "SELECT " + std::string(MESSAGE_INFO_PARTS_END)
+    + "FROM message "
+    "WHERE conv_id = ? AND id > ? "
+    "ORDER by id ASC LIMIT ? ";
+// 向旧翻页与跳转窗口：在 idx_conv_id (conv_id, id, ...) 上定位游标后按 id 顺序或逆序只扫描一页
+const std::string SELECT_MESSAGES_BEFORE_SQL = "SELECT " + std::string(MESSAGE_INFO_PARTS_END)
+    + "FROM message "
+    "WHERE conv_id = ? AND id < ? "
+    "ORDER BY id DESC LIMIT ? ";
+const std::string SELECT_MESSAGES_AROUND_SQL = "(" + SELECT_MESSAGES_BEFORE_SQL + ") UNION ALL "
+    "(SELECT " + std::string(MESSAGE_INFO_PARTS_END)
+    + "FROM message "
+    "WHERE conv_id = ? AND id >= ? "
+    "ORDER BY id ASC LIMIT ?) ";
+const std::string SELECT_RECENT_MESSAGES_SQL = "SELECT " + std::string(MESSAGE_INFO_PARTS_END)
+    + "FROM message "
+    "WHERE conv_id = ? "
+    "ORDER BY id DESC LIMIT ? ";
+const std::string UPDATE_MESSAGE_STATUS_RANGE_SQL =
+    "UPDATE message SET status = ? "
+    "WHERE conv_id = ? AND id > ? AND id <= ? AND sender_uid = ? AND status < ?";
+const std::string UPDATE_READ_WATERMARK_SQL =
+    "UPDATE user_conversation SET last_read_msg_id = ?, "
+    "unread_count = (SELECT COUNT(*) FROM message WHERE conv_id = ? AND id > ? AND id <= ? AND sender_uid <> ?) "
+    "WHERE uid = ? AND conv_id = ? AND last_read_msg_id < ?";
+// 对账：已读水位之后、已计入增量的消息中他人发送的条数，只返回与存储值不一致的成员。
+// 水位之后有其他服务器（serverId 中的机器号不同）生成的消息时跳过该成员：对方尚未写回的增量会被重复计入，
+// 对方已写回的上界之后的增量又会被减掉
+const std::string SELECT_UNREAD_DRIFT_SQL =
+    "SELECT uid, unread_count, last_read_msg_id, "
+    "(SELECT COUNT(*) FROM message WHERE message.conv_id = user_conversation.conv_id "
+    "AND message.id > user_conversation.last_read_msg_id AND message.id <= ? "
+    "AND message.sender_uid <> user_conversation.uid) AS actual "
+    "FROM user_conversation WHERE conv_id = ? "
+    "AND NOT EXISTS (SELECT 1 FROM message AS other WHERE other.conv_id = user_conversation.conv_id "
+    "AND other.id > user_conversation.last_read_msg_id "
+    "AND ((other.id >> " + std::to_string(MessageIdGenerator::SEQUENCE_BITS) + ") & "
+    + std::to_string(MessageIdGenerator::MAX_WORKER_ID) + ") <> ?) "
+    "HAVING unread_count <> actual";
+// 查询之后水位或未读数又被改动的行不覆盖，留给下一轮
+const std::string UPDATE_UNREAD_DRIFT_SQL =
+    "UPDATE user_conversation SET unread_count = ? "
+    "WHERE uid = ? AND conv_id = ? AND last_read_msg_id = ? AND unread_count = ?";
+
+/// rows 行的消息插入语句。ID 已分配：WAL 重放的记录主键冲突，客户端重发的消息 (conv_id, msg_id) 冲突，都不重复写入
+static std::string messageInsertSql(const size_t rows) {
+    std::string sql = "INSERT INTO message (id, conv_id, sender_uid, msg_type, content, msg_id, status) VALUES ";
+    for (size_t i = 0; i < rows; i++) {
+        if (i > 0) sql += ",";
+        sql += "(?,?,?,?,?,?,?)";
+    }
+    sql += " ON DUPLICATE KEY UPDATE id=id";
+    return sql;
+}
+
+/**
+ * 回查分块 [offset, end) 中 (conv_id, msg_id) 已存在的消息，写回已存储的 ID 并放入 duplicates，返回放入的条数。
+ * beforeInsert 为 true 时在插入前调用，查到的行都已落库（客户端重发、WAL 重放或死信重投）；
+ * 否则在插入后调用，本语句插入的行也会查到，只能识别已存储的 ID 与本次分配的不同的客户端重发
+ */
+static size_t collectDuplicates(sql::Connection* conn, const std::vector<std::shared_ptr<ChatMsgNode>>& nodes,
+                                const size_t offset, const size_t end, const bool beforeInsert,
+                                std::vector<std::shared_ptr<ChatMsgNode>>& duplicates) {
+    size_t found = 0;
+    std::unordered_map<std::string, std::vector<std::shared_ptr<ChatMsgNode>>> by_conv;
+    for (size_t i = offset; i < end; i++) {
+        by_conv[nodes[i]->msg.convId.value_or("")].push_back(nodes[i]);
+    }
+    for (auto& [conv_id, conv_nodes] : by_conv) {
+        std::string sql = "SELECT id, msg_id FROM message WHERE conv_id = ? AND msg_id IN (";
+        for (size_t i = 0; i < conv_nodes.size(); i++) {
+            if (i > 0) sql += ",";
+            sql += "?";
+        }
+        sql += ")";
+
+        const std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(sql));
+        stmt->setString(1, conv_id);
+        for (size_t i = 0; i < conv_nodes.size(); i++) {
+            stmt->setInt(static_cast<unsigned int>(i + 2), conv_nodes[i]->msg.msgId);
+        }
+        std::unordered_map<int, int64_t> stored;
+        const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+        while (res->next()) {
+            stored[res->getInt("msg_id")] = res->getInt64("id");
+        }
+        stmt->close();
+
+        for (const auto& n : conv_nodes) {
+            if (const auto it = stored.find(n->msg.msgId);
+                it != stored.end() && (beforeInsert || it->second != n->msg.servId)) {
+                n->msg.servId = it->second;
+                duplicates.push_back(n);
+                found++;
+            }
+        }
+    }
+    return found;
+}
 
 ConversationDao::ConversationDao() {
     auto& conf = ConfigMgr::getInstance();
@@ -25,6 +152,13 @@ ConversationDao::ConversationDao() {
     const auto& password = conf["Mysql"]["Password"];
     const auto& schema = conf["Mysql"]["Schema"];
     pool_ = std::make_unique<MysqlPool>(host + ":" + port, user, password, schema);
+    if (conf["Mysql"]["WarmStatements"] == "true") {
+        pool_->warmUp({SELECT_GROUP_OWNER_SQL, SELECT_GROUP_MEMBERS_SQL, SELECT_CONVERSATION_LIST_SQL,
+                       SELECT_USER_CONVERSATIONS_SQL, SELECT_MESSAGE_LIST_SQL, SELECT_RECENT_MESSAGES_SQL, UPDATE_MESSAGE_STATUS_RANGE_SQL,
+                       SELECT_MESSAGES_BEFORE_SQL, SELECT_MESSAGES_AROUND_SQL,
+                       UPDATE_READ_WATERMARK_SQL, SELECT_UNREAD_DRIFT_SQL, UPDATE_UNREAD_DRIFT_SQL,
+                       messageInsertSql(BATCH_CHUNK_SIZE)});
+    }
 }
 
 ConversationDao::~ConversationDao() {
@@ -62,7 +196,67 @@ bool ConversationDao::createConversation(const ConversationInfo &info, std::stri
     }
 }
 
-bool ConversationDao::createMessage(const MessageInfo &info, int& result) const {
+bool ConversationDao::createGroup(const ConversationInfo &info, const std::vector<int> &members,
+    std::string &result) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    const auto oldCommit = conn->conn_->getAutoCommit();
+    Defer defer([this, oldCommit, &conn]() {
+        conn->conn_->setAutoCommit(oldCommit);
+        pool_->returnConnect(std::move(conn));
+    });
+    try {
+        conn->conn_->setAutoCommit(false);
+
+        const auto stmt(conn->prepare(
+            "INSERT INTO conversation (conv_id, conv_type, status, owner_uid, title) VALUES (?,?,0,?,?)"));
+        stmt->setString(1, info.convId);
+        stmt->setInt(2, static_cast<int>(ConvType::GROUP_CHAT));
+        stmt->setInt(3, info.uid);
+        stmt->setString(4, info.title.value_or(""));
+        stmt->executeUpdate();
+
+        std::vector<int> all(members);
+        all.push_back(info.uid);
+        std::sort(all.begin(), all.end());
+        all.erase(std::unique(all.begin(), all.end()), all.end());
+        for (size_t offset = 0; offset < all.size(); offset += BATCH_CHUNK_SIZE) {
+            const size_t end = std::min(offset + BATCH_CHUNK_SIZE, all.size());
+            std::string sql = "INSERT INTO user_conversation (uid, conv_id, last_read_msg_id, unread_count) VALUES ";
+            for (size_t i = offset; i < end; i++) {
+                sql += i > offset ? ",(?,?,0,0)" : "(?,?,0,0)";
+            }
+            sql += " ON DUPLICATE KEY UPDATE is_deleted = 0, update_time = NOW()";
+            const std::unique_ptr<sql::PreparedStatement> insert(conn->conn_->prepareStatement(sql));
+            int param = 1;
+            for (size_t i = offset; i < end; i++) {
+                insert->setInt(param++, all[i]);
+                insert->setString(param++, info.convId);
+            }
+            insert->executeUpdate();
+        }
+
+        const auto select(conn->prepare(
+            "SELECT create_time FROM conversation WHERE conv_id = ?"));
+        select->setString(1, info.convId);
+        if (const std::unique_ptr<sql::ResultSet> res(select->executeQuery()); res->next()) {
+            result = res->getString("create_time");
+        }
+        conn->conn_->commit();
+        return true;
+    } catch (sql::SQLException &e) {
+        std::cout << "createGroup SQLException: " << e.what() << std::endl;
+        conn->conn_->rollback();
+        return false;
+    }
+}
+
+bool ConversationDao::addGroupMembers(const std::string &convId, const std::vector<int> &members) const {
+    if (members.empty()) {
+        return true;
+    }
     auto conn = pool_->getConnect();
     if (!conn) {
         return false;
@@ -71,34 +265,121 @@ bool ConversationDao::createMessage(const MessageInfo &info, int& result) const
         pool_->returnConnect(std::move(conn));
     });
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
-            "CALL save_chat_message(?,?,?,?,?,?,?,@result)"));
-        stmt->setString(1, info.convId.value());
-        stmt->setInt(2, info.fromUid);
-        stmt->setInt(3, info.toUid);
-        stmt->setInt(4, info.type);
-        stmt->setInt(5, info.msgId);
-        stmt->setInt(6, info.status);
-        stmt->setString(7, info.content.value());
+        for (size_t offset = 0; offset < members.size(); offset += BATCH_CHUNK_SIZE) {
+            const size_t end = std::min(offset + BATCH_CHUNK_SIZE, members.size());
+            std::string sql = "INSERT INTO user_conversation (uid, conv_id, last_read_msg_id, unread_count) VALUES ";
+            for (size_t i = offset; i < end; i++) {
+                sql += i > offset ? ",(?,?,0,0)" : "(?,?,0,0)";
+            }
+            sql += " ON DUPLICATE KEY UPDATE is_deleted = 0, update_time = NOW()";
+            const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+            int param = 1;
+            for (size_t i = offset; i < end; i++) {
+                stmt->setInt(param++, members[i]);
+                stmt->setString(param++, convId);
+            }
+            stmt->executeUpdate();
+        }
+        return true;
+    } catch (sql::SQLException &e) {
+        std::cout << "addGroupMembers SQLException: " << e.what() << std::endl;
+        return false;
+    }
+}
 
-        stmt->execute();
-        
-        const std::unique_ptr<sql::Statement> stmtResult(conn->conn_->createStatement());
-        if (const std::unique_ptr<sql::ResultSet> res(stmtResult->executeQuery("SELECT @result AS result"));
-                res->next()) {
-            result = res->getInt("result");
-            stmtResult->close();
+bool ConversationDao::removeGroupMembers(const std::string &convId, const std::vector<int> &members) const {
+    if (members.empty()) {
+        return true;
+    }
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    const auto oldCommit = conn->conn_->getAutoCommit();
+    Defer defer([this, oldCommit, &conn]() {
+        conn->conn_->setAutoCommit(oldCommit);
+        pool_->returnConnect(std::move(conn));
+    });
+    try {
+        conn->conn_->setAutoCommit(false);
+        for (size_t offset = 0; offset < members.size(); offset += BATCH_CHUNK_SIZE) {
+            const size_t end = std::min(offset + BATCH_CHUNK_SIZE, members.size());
+            std::string sql = "DELETE FROM user_conversation WHERE conv_id = ? AND uid IN (";
+            for (size_t i = offset; i < end; i++) {
+                sql += i > offset ? ",?" : "?";
+            }
+            sql += ")";
+            const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+            int param = 1;
+            stmt->setString(param++, convId);
+            for (size_t i = offset; i < end; i++) {
+                stmt->setInt(param++, members[i]);
+            }
+            stmt->executeUpdate();
+        }
+        conn->conn_->commit();
+        return true;
+    } catch (sql::SQLException &e) {
+        std::cout << "removeGroupMembers SQLException: " << e.what() << std::endl;
+        conn->conn_->rollback();
+        return false;
+    }
+}
+
+bool ConversationDao::selectGroupOwner(const std::string &convId, int &ownerUid) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+    try {
+        const auto stmt(conn->prepare(SELECT_GROUP_OWNER_SQL));
+        stmt->setString(1, convId);
+        stmt->setInt(2, static_cast<int>(ConvType::GROUP_CHAT));
+        if (const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery()); res->next()) {
+            ownerUid = res->getInt("owner_uid");
             return true;
         }
-        stmtResult->close();
         return false;
     } catch (sql::SQLException &e) {
-        std::cout << "createMessage SQLException: " << e.what() << std::endl;
+        std::cout << "selectGroupOwner SQLException: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool ConversationDao::updateMessageStatus(const int id, const MessageStatus status) const {
+std::vector<int> ConversationDao::selectGroupMembers(const std::string &convId) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return {};
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+    try {
+        std::vector<int> result;
+        const auto stmt(conn->prepare(SELECT_GROUP_MEMBERS_SQL));
+        stmt->setString(1, convId);
+        const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+        while (res->next()) {
+            result.push_back(res->getInt("uid"));
+        }
+        return result;
+    } catch (sql::SQLException &e) {
+        std::cout << "selectGroupMembers SQLException: " << e.what() << std::endl;
+        return {};
+    }
+}
+
+bool ConversationDao::createMessage(const MessageInfo &info) {
+    // 与批量入库同一路径，ID 已分配，不再调用存储过程回查
+    const std::vector<std::shared_ptr<ChatMsgNode>> nodes{std::make_shared<ChatMsgNode>(info, nullptr)};
+    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+    return batchCreateMessages(nodes, duplicates);
+}
+
+bool ConversationDao::updateMessageStatus(const int64_t id, const MessageStatus status) const {
     auto conn = pool_->getConnect();
     if (!conn) {
         return false;
@@ -108,10 +389,10 @@ bool ConversationDao::updateMessageStatus(const int id, const MessageStatus stat
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "UPDATE message SET status = ? WHERE id = ?"));
         stmt->setInt(1, static_cast<int>(status));
-        stmt->setInt(2, id);
+        stmt->setInt64(2, id);
         if (const int rowAffected = stmt->executeUpdate(); rowAffected < 0) {
             
             return false;
@@ -135,13 +416,7 @@ std::vector<ConversationInfo> ConversationDao::selectConversationList(const int
 
     try {
         std::vector<ConversationInfo> result;
-        const std::string sql = "SELECT " + std::string(CONVERSATION_INFO_PARTS)
-                                + "FROM user_conversation "
-                                "INNER JOIN conversation "
-                                "ON user_conversation.conv_id = conversation.conv_id "
-                                "WHERE user_conversation.uid = ? AND user_conversation.update_time > ? "
-                                "ORDER by user_conversation.update_time ASC LIMIT ? ";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(SELECT_CONVERSATION_LIST_SQL));
         stmt->setInt(1, uid);
         stmt->setString(2, sinceTime);
         stmt->setInt(3, 50);
@@ -157,7 +432,34 @@ std::vector<ConversationInfo> ConversationDao::selectConversationList(const int
     }
 }
 
-std::vector<MessageInfo> ConversationDao::selectMessageList(const std::string &convId, const int since_msg_id,
+bool ConversationDao::selectUserConversations(const int uid, std::vector<ConversationInfo> &result) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+
+    try {
+        const auto stmt(conn->prepare(SELECT_USER_CONVERSATIONS_SQL));
+        stmt->setInt(1, uid);
+        const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
+        result.clear();
+        while (res->next()) {
+            auto info = ConversationInfo::fromConversationListSearch(res);
+            info.uid = uid;
+            info.lastReadMsgId = res->getInt64("last_read_msg_id");
+            result.push_back(std::move(info));
+        }
+        return true;
+    } catch (sql::SQLException& e) {
+        std::cout << "selectUserConversations SQLException: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<MessageInfo> ConversationDao::selectMessageList(const std::string &convId, const int64_t since_msg_id,
                                                             const int limit) const {
     auto conn = pool_->getConnect();
     if (!conn) {
@@ -169,13 +471,9 @@ std::vector<MessageInfo> ConversationDao::selectMessageList(const std::string &c
 
     try {
         std::vector<MessageInfo> result;
-        const std::string sql = "SELECT " + std::string(MESSAGE_INFO_PARTS_END)
-                                + "FROM message "
-                                "WHERE conv_id = ? AND id > ? "
-                                "ORDER by id ASC LIMIT ? ";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(SELECT_MESSAGE_LIST_SQL));
         stmt->setString(1, convId);
-        stmt->setInt(2, since_msg_id);
+        stmt->setInt64(2, since_msg_id);
         stmt->setInt(3, limit);
         const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
         
@@ -189,6 +487,95 @@ std::vector<MessageInfo> ConversationDao::selectMessageList(const std::string &c
     }
 }
 
+bool ConversationDao::selectRecentMessages(const std::string &convId, const int limit,
+                                           std::vector<MessageInfo> &result) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+
+    try {
+        const auto stmt(conn->prepare(SELECT_RECENT_MESSAGES_SQL));
+        stmt->setString(1, convId);
+        stmt->setInt(2, limit);
+        const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
+        result.clear();
+        while (res->next()) {
+            result.push_back(MessageInfo::fromMessageListSearch(res));
+        }
+        std::reverse(result.begin(), result.end());
+        return true;
+    } catch (sql::SQLException& e) {
+        std::cout << "selectRecentMessages SQLException: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool ConversationDao::selectMessagesBefore(const std::string &convId, const int64_t before_msg_id, const int limit,
+                                           std::vector<MessageInfo> &result) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+
+    try {
+        const auto stmt(conn->prepare(SELECT_MESSAGES_BEFORE_SQL));
+        stmt->setString(1, convId);
+        stmt->setInt64(2, before_msg_id > 0 ? before_msg_id : std::numeric_limits<int64_t>::max());
+        stmt->setInt(3, limit);
+        const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
+        result.clear();
+        while (res->next()) {
+            result.push_back(MessageInfo::fromMessageListSearch(res));
+        }
+        std::reverse(result.begin(), result.end());
+        return true;
+    } catch (sql::SQLException& e) {
+        std::cout << "selectMessagesBefore SQLException: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool ConversationDao::selectMessagesAround(const std::string &convId, const int64_t anchor_msg_id, const int older,
+                                           const int newer, std::vector<MessageInfo> &result) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+
+    try {
+        const auto stmt(conn->prepare(SELECT_MESSAGES_AROUND_SQL));
+        stmt->setString(1, convId);
+        stmt->setInt64(2, anchor_msg_id);
+        stmt->setInt(3, older);
+        stmt->setString(4, convId);
+        stmt->setInt64(5, anchor_msg_id);
+        stmt->setInt(6, newer);
+        const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
+        result.clear();
+        while (res->next()) {
+            result.push_back(MessageInfo::fromMessageListSearch(res));
+        }
+        // 两段各自有序，拼接后按 id 升序
+        std::sort(result.begin(), result.end(), [](const MessageInfo& a, const MessageInfo& b) {
+            return a.servId < b.servId;
+        });
+        return true;
+    } catch (sql::SQLException& e) {
+        std::cout << "selectMessagesAround SQLException: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 bool ConversationDao::updateConvMessagesStatus(const MessageStatusInfo &info) const {
     auto conn = pool_->getConnect();
     if (!conn) {
@@ -202,24 +589,24 @@ bool ConversationDao::updateConvMessagesStatus(const MessageStatusInfo &info) co
     try {
         conn->conn_->setAutoCommit(false);
 
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
-            "UPDATE message SET status = ? "
-            "WHERE id <= ? AND conv_id = ? AND sender_uid = ? ORDER BY id LIMIT ?"));
-        stmt->setInt(1, info.status);
-        stmt->setInt(2, info.lastMsgId);
-        stmt->setString(3, info.convId.value());
-        // 消息状态应该对方才是发送方，接收方来更新发送方的消息状态
-        const auto senderUid = getOtherUid(info.convId.value(), info.uid);
-        stmt->setInt(4, senderUid);
-        stmt->setInt(5, info.count);
-        if (const int rowAffected = stmt->executeUpdate(); rowAffected < 0) {
-            
-            return false;
+        // 消息状态应该对方才是发送方，接收方来更新发送方的消息状态；群消息没有单一发送方，只更新未读计数
+        if (const auto senderUid = getOtherUid(info.convId.value(), info.uid); senderUid >= 0) {
+            const auto stmt(conn->prepare(
+                "UPDATE message SET status = ? "
+                "WHERE id <= ? AND conv_id = ? AND sender_uid = ? ORDER BY id LIMIT ?"));
+            stmt->setInt(1, info.status);
+            stmt->setInt64(2, info.lastMsgId);
+            stmt->setString(3, info.convId.value());
+            stmt->setInt(4, senderUid);
+            stmt->setInt(5, info.count);
+            if (const int rowAffected = stmt->executeUpdate(); rowAffected < 0) {
+                return false;
+            }
         }
-        
+
 
         // 获取未读计数
-        const std::unique_ptr<sql::PreparedStatement> stmt_select(conn->conn_->prepareStatement(
+        const auto stmt_select(conn->prepare(
             "SELECT unread_count FROM user_conversation "
             "WHERE uid = ? AND conv_id = ?"));
         stmt_select->setInt(1, info.uid);
@@ -231,7 +618,7 @@ bool ConversationDao::updateConvMessagesStatus(const MessageStatusInfo &info) co
 
         unread = (unread - info.count > 0) ? unread : 0;
         // 更新自己会话的未读计数
-        const std::unique_ptr<sql::PreparedStatement> stmt_update(conn->conn_->prepareStatement(
+        const auto stmt_update(conn->prepare(
             "UPDATE user_conversation SET unread_count = ? "
             "WHERE uid = ? AND conv_id = ?"));
         stmt_update->setInt(1, unread);
@@ -250,8 +637,70 @@ bool ConversationDao::updateConvMessagesStatus(const MessageStatusInfo &info) co
     }
 }
 
+bool ConversationDao::batchUpdateMessageStatus(const std::vector<MessageStatusWatermark> &marks) const {
+    if (marks.empty()) {
+        return true;
+    }
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    const auto oldCommit = conn->conn_->getAutoCommit();
+    Defer defer([this, oldCommit, &conn]() {
+        conn->conn_->setAutoCommit(oldCommit);
+        pool_->returnConnect(std::move(conn));
+    });
+    try {
+        conn->conn_->setAutoCommit(false);
+
+        // 状态只前进，已是目标状态的行不重复写
+        const auto stmt_msg(conn->prepare(UPDATE_MESSAGE_STATUS_RANGE_SQL));
+        // 未读数由水位推导：水位之后、已计入增量的消息中他人发送的条数，更新的消息由增量累加
+        const auto stmt_read(conn->prepare(UPDATE_READ_WATERMARK_SQL));
+
+        for (const auto& mark : marks) {
+            if (const auto senderUid = getOtherUid(mark.convId, mark.uid); senderUid >= 0) {
+                stmt_msg->setInt(1, mark.status);
+                stmt_msg->setString(2, mark.convId);
+                stmt_msg->setInt64(3, mark.flushedMsgId);
+                stmt_msg->setInt64(4, mark.lastMsgId);
+                stmt_msg->setInt(5, senderUid);
+                stmt_msg->setInt(6, mark.status);
+                stmt_msg->executeUpdate();
+            }
+            if (mark.status != static_cast<int8_t>(MessageStatus::IS_READ)) {
+                continue;
+            }
+            stmt_read->setInt64(1, mark.lastMsgId);
+            stmt_read->setString(2, mark.convId);
+            stmt_read->setInt64(3, mark.lastMsgId);
+            stmt_read->setInt64(4, mark.countedMsgId);
+            stmt_read->setInt(5, mark.uid);
+            stmt_read->setInt(6, mark.uid);
+            stmt_read->setString(7, mark.convId);
+            stmt_read->setInt64(8, mark.lastMsgId);
+            stmt_read->executeUpdate();
+        }
+
+        conn->conn_->commit();
+        return true;
+    } catch (sql::SQLException& e) {
+        std::cout << "batchUpdateMessageStatus SQLException: " << e.what() << std::endl;
+        conn->conn_->rollback();
+        return false;
+    }
+}
+
 bool ConversationDao::batchCreateMessages(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes,
-                                          std::unordered_map<int64_t, int>& id_mapping) {
+                                          std::vector<std::shared_ptr<ChatMsgNode>>& duplicates) {
+    int deadlockRetries = 0;
+    return batchCreateMessages(nodes, duplicates, BATCH_CHUNK_SIZE, deadlockRetries);
+}
+
+bool ConversationDao::batchCreateMessages(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes,
+                                          std::vector<std::shared_ptr<ChatMsgNode>>& duplicates,
+                                          size_t chunkSize, int& deadlockRetries) {
+    chunkSize = std::clamp<size_t>(chunkSize, 1, MAX_CHUNK_SIZE);
     auto conn = pool_->getConnect();
     if (!conn) return false;
 
@@ -261,38 +710,47 @@ bool ConversationDao::batchCreateMessages(const std::vector<std::shared_ptr<Chat
         pool_->returnConnect(std::move(conn));
     });
 
-    // 按 (conv_id, msg_id) 排序，保证所有事务加锁顺序一致，减少死锁
+    // 按 (conv_id, 服务端 ID) 排序，保证所有事务加锁顺序一致，减少死锁
     // nodes 是 const&，需要拷一份 mutable 指针来排序
     std::vector<std::shared_ptr<ChatMsgNode>> sorted_nodes(nodes);
     std::sort(sorted_nodes.begin(), sorted_nodes.end(),
               [](const auto& a, const auto& b) {
                   if (a->msg.convId.value_or("") != b->msg.convId.value_or(""))
                       return a->msg.convId.value_or("") < b->msg.convId.value_or("");
-                  return a->msg.msgId < b->msg.msgId;
+                  return a->msg.servId < b->msg.servId;
               });
 
     // 死锁重试 (使用排序后的副本)
     auto& txn_nodes = sorted_nodes;
+    // 批次中有与已存储 ID 相同的行（WAL 重放、死信重投已提交的消息）时，插入后无法与本次插入的行区分，
+    // 回滚后改为每块插入前回查
+    bool precheck = false;
     for (int retry = 0; retry < MAX_DEADLOCK_RETRIES; retry++) {
         bool deadlock = false;
         conn->conn_->setAutoCommit(false);
 
         try {
+        // 插入前回查能找出全部已落库的行，重新收集；否则死锁重试时保留已识别的重发消息
+        if (precheck) {
+            duplicates.clear();
+        }
+        bool restart = false;
         // ── Step 1: 批量 INSERT message (分块) ──────────
-        for (size_t offset = 0; offset < txn_nodes.size(); offset += BATCH_CHUNK_SIZE) {
-            size_t end = std::min(offset + BATCH_CHUNK_SIZE, txn_nodes.size());
+        for (size_t offset = 0; offset < txn_nodes.size(); offset += chunkSize) {
+            size_t end = std::min(offset + chunkSize, txn_nodes.size());
             size_t chunk_len = end - offset;
-
-            std::string sql = "INSERT INTO message (conv_id, sender_uid, msg_type, content, msg_id, status) VALUES ";
-            for (size_t i = 0; i < chunk_len; i++) {
-                if (i > 0) sql += ",";
-                sql += "(?,?,?,?,?,?)";
+            if (precheck) {
+                collectDuplicates(conn->conn_.get(), txn_nodes, offset, end, true, duplicates);
             }
-            sql += " ON DUPLICATE KEY UPDATE msg_id=msg_id";
 
-            const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+            const std::string sql = messageInsertSql(chunk_len);
+            // 满块的 SQL 文本固定，走语句缓存；尾块长度随批次变化，不占用缓存
+            const auto stmt = chunk_len == chunkSize
+                ? conn->prepare(sql)
+                : std::shared_ptr<sql::PreparedStatement>(conn->conn_->prepareStatement(sql));
             int param = 1;
             for (size_t i = offset; i < end; i++) {
+                stmt->setInt64(param++, txn_nodes[i]->msg.servId);
                 stmt->setString(param++, txn_nodes[i]->msg.convId.value_or(""));
                 stmt->setInt(param++, txn_nodes[i]->msg.fromUid);
                 stmt->setInt(param++, txn_nodes[i]->msg.type);
@@ -300,120 +758,93 @@ bool ConversationDao::batchCreateMessages(const std::vector<std::shared_ptr<Chat
                 stmt->setInt(param++, txn_nodes[i]->msg.msgId);
                 stmt->setInt(param++, txn_nodes[i]->msg.status);
             }
-            stmt->executeUpdate();
-            stmt->close();
+            // 未设置 CLIENT_FOUND_ROWS 时冲突且未修改的行影响行数为 0，全部插入则无需回查
+            const auto inserted = static_cast<size_t>(stmt->executeUpdate());
+            if (!precheck && inserted < chunk_len
+                && collectDuplicates(conn->conn_.get(), txn_nodes, offset, end, false, duplicates)
+                    < chunk_len - inserted) {
+                restart = true;
+                break;
+            }
+        }
+        if (restart) {
+            // 未插入的行多于识别出的重发消息，其余是已落库的相同 ID；不计入死锁重试次数
+            conn->conn_->rollback();
+            precheck = true;
+            retry--;
+            continue;
         }
 
-        // 按 conv_id 分组
-        std::unordered_map<std::string, std::vector<std::shared_ptr<ChatMsgNode>>> by_conv;
+        // 按 conv_id 聚合，有序遍历使各事务的加锁顺序一致；重复的消息已更新过会话，不再参与
+        struct ConvAgg {
+            int64_t max_id = 0;
+            std::shared_ptr<ChatMsgNode> max_node;
+        };
+        std::map<std::string, ConvAgg> by_conv;
+        std::unordered_set<const ChatMsgNode*> skipped;
+        for (const auto& n : duplicates) {
+            skipped.insert(n.get());
+        }
         for (const auto& n : txn_nodes) {
-            by_conv[n->msg.convId.value_or("")].push_back(n);
+            if (skipped.count(n.get())) {
+                continue;
+            }
+            auto& agg = by_conv[n->msg.convId.value_or("")];
+            // 服务端 ID 按时间有序，最大的即最新一条
+            if (n->msg.servId > agg.max_id) {
+                agg.max_id = n->msg.servId;
+                agg.max_node = n;
+            }
         }
 
-        // ── Step 2: SELECT 回查 serverId ────────────────
-        for (auto& [conv_id, conv_nodes] : by_conv) {
-            std::string sql = "SELECT id, msg_id FROM message WHERE conv_id = ? AND msg_id IN (";
-            for (size_t i = 0; i < conv_nodes.size(); i++) {
-                if (i > 0) sql += ",";
-                sql += "?";
+        // 会话摘要用一条集合更新完成（会话数超过 SET_CHUNK_SIZE 时分块），语句数与批次大小无关；
+        // 未读数不在这里累加，由 CounterService 合并后经 batchAddUnreadCounts 写入
+        for (auto chunk_begin = by_conv.begin(); chunk_begin != by_conv.end();) {
+            auto chunk_end = chunk_begin;
+            size_t conv_count = 0;
+            while (chunk_end != by_conv.end() && conv_count < SET_CHUNK_SIZE) {
+                ++chunk_end;
+                ++conv_count;
             }
-            sql += ")";
 
-            const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
-            stmt->setString(1, conv_id);
-            for (size_t i = 0; i < conv_nodes.size(); i++) {
-                stmt->setInt(i + 2, conv_nodes[i]->msg.msgId);
-            }
-            const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
-            while (res->next()) {
-                int id = res->getInt("id");
-                int mid = res->getInt("msg_id");
-                int64_t key = static_cast<int64_t>(std::hash<std::string>{}(conv_id)) * 1000000000LL + mid;
-                id_mapping[key] = id;
+            std::string in_list;
+            for (size_t i = 0; i < conv_count; i++) {
+                in_list += i == 0 ? "?" : ",?";
             }
-            stmt->close();
-        }
 
-        // ── Step 3: 批量 UPDATE conversation ────────────
-        {
-            // SQL 在所有迭代中相同，预处理一次后复用
-            const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
-                "UPDATE conversation SET "
-                "  last_msg_id = GREATEST(last_msg_id, ?), "
-                "  last_msg_content = CASE WHEN ? >= last_msg_id THEN ? ELSE last_msg_content END, "
-                "  last_time = NOW() "
-                "WHERE conv_id = ?")
-            );
-            for (auto& [conv_id, conv_nodes] : by_conv) {
-                // 找 max_msg_id 对应的节点
-                int max_id = 0;
-                std::shared_ptr<ChatMsgNode> max_node = nullptr;
-                for (const auto& n : conv_nodes) {
-                    if (n->msg.msgId > max_id) {
-                        max_id = n->msg.msgId;
-                        max_node = n;
-                    }
+            // ── Step 2: UPDATE conversation，CASE 按会话取本批最新消息 ──
+            // 单表 UPDATE 按书写顺序赋值，摘要先用旧的 last_msg_id 比较
+            {
+                std::string content_case = "CASE conv_id";
+                std::string id_case = "CASE conv_id";
+                for (size_t i = 0; i < conv_count; i++) {
+                    content_case += " WHEN ? THEN IF(CAST(? AS SIGNED) >= last_msg_id, ?, last_msg_content)";
+                    id_case += " WHEN ? THEN CAST(? AS SIGNED)";
                 }
-
-                std::string summary;
-                if (max_node) {
-                    switch (max_node->msg.type) {
-                        case 2: summary = "[图片]"; break;
-                        case 3: summary = "[文件]"; break;
-                        case 4: summary = "[视频]"; break;
-                        default: summary = max_node->msg.content.value_or("").substr(0, 100); break;
-                    }
+                const std::string sql = "UPDATE conversation SET "
+                    "  last_msg_content = " + content_case + " ELSE last_msg_content END, "
+                    "  last_msg_id = GREATEST(last_msg_id, " + id_case + " ELSE 0 END), "
+                    "  last_time = NOW() "
+                    "WHERE conv_id IN (" + in_list + ")";
+
+                const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+                int content_param = 1;
+                int id_param = 1 + static_cast<int>(conv_count) * 3;
+                int in_param = id_param + static_cast<int>(conv_count) * 2;
+                for (auto it = chunk_begin; it != chunk_end; ++it) {
+                    const std::string summary = it->second.max_node->msg.summary();
+                    stmt->setString(content_param++, it->first);
+                    stmt->setInt64(content_param++, it->second.max_id);
+                    stmt->setString(content_param++, summary);
+                    stmt->setString(id_param++, it->first);
+                    stmt->setInt64(id_param++, it->second.max_id);
+                    stmt->setString(in_param++, it->first);
                 }
-
-                stmt->setInt(1, max_id);
-                stmt->setInt(2, max_id);
-                stmt->setString(3, summary);
-                stmt->setString(4, conv_id);
                 stmt->executeUpdate();
+                stmt->close();
             }
-            stmt->close();
-        }
 
-        // ── Step 4: 批量 UPDATE user_conversation ───────
-        {
-            // 按 (conv_id, uid) 聚合
-            struct uc_key {
-                std::string conv_id;
-                int uid;
-                bool operator==(const uc_key& o) const { return uid == o.uid && conv_id == o.conv_id; }
-            };
-            struct uc_hash {
-                size_t operator()(const uc_key& k) const {
-                    return std::hash<std::string>{}(k.conv_id) * 31 + static_cast<size_t>(k.uid);
-                }
-            };
-            struct uc_val {
-                int unread_inc = 0;
-                bool is_sender = false;
-            };
-            std::unordered_map<uc_key, uc_val, uc_hash> uc_map;
-
-            for (const auto& n : txn_nodes) {
-                std::string cid = n->msg.convId.value_or("");
-                uc_key sk{cid, n->msg.fromUid};
-                uc_map[sk].is_sender = true;
-                uc_key rk{cid, n->msg.toUid};
-                uc_map[rk].unread_inc += 1;
-            }
-
-            const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
-                "UPDATE user_conversation SET "
-                "  unread_count = unread_count + ?, "
-                "  update_time = NOW() "
-                "WHERE conv_id = ? AND uid = ?")
-            );
-            for (auto& [key, val] : uc_map) {
-                stmt->setInt(1, val.is_sender ? 0 : val.unread_inc);
-                stmt->setString(2, key.conv_id);
-                stmt->setInt(3, key.uid);
-                stmt->executeUpdate();
-            }
-            stmt->close();
+            chunk_begin = chunk_end;
         }
 
         conn->conn_->commit();
@@ -421,6 +852,9 @@ bool ConversationDao::batchCreateMessages(const std::vector<std::shared_ptr<Chat
 
         } catch (sql::SQLException& e) {
             conn->conn_->rollback();
+            if (e.getErrorCode() == 1213) {
+                deadlockRetries++;
+            }
             if (e.getErrorCode() == 1213 && retry < MAX_DEADLOCK_RETRIES - 1) {
                 // MySQL deadlock error code = 1213
                 std::cout << "[batchCreateMessages] deadlock, retry " << retry + 1 << std::endl;
@@ -435,3 +869,129 @@ bool ConversationDao::batchCreateMessages(const std::vector<std::shared_ptr<Chat
     }
     return false;  // 所有重试耗尽
 }
+
+bool ConversationDao::batchAddUnreadCounts(const std::vector<ConvUnreadDelta>& deltas, int& deadlockRetries) const {
+    if (deltas.empty()) {
+        return true;
+    }
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    const auto oldCommit = conn->conn_->getAutoCommit();
+    Defer defer([this, oldCommit, &conn]() {
+        conn->conn_->setAutoCommit(oldCommit);
+        pool_->returnConnect(std::move(conn));
+    });
+
+    for (int retry = 0; retry < MAX_DEADLOCK_RETRIES; retry++) {
+        try {
+            conn->conn_->setAutoCommit(false);
+            // 每 SET_CHUNK_SIZE 个会话一条集合更新，CASE 按会话/发送方取计数；
+            // 每个成员的未读增量 = 会话消息数 - 自己发送的条数，单聊和群聊同一条语句。
+            // 占位符数随会话数 × 发送方数增长，超过 MAX_PLACEHOLDERS 时提前分块，每块至少一个会话
+            for (size_t offset = 0, end = 0; offset < deltas.size(); offset = end) {
+                size_t placeholders = 0;
+                for (end = offset; end < deltas.size() && end - offset < SET_CHUNK_SIZE; end++) {
+                    // total_case 2 个，sent_case 每个发送方 3 个，in_list 1 个
+                    const size_t cost = 3 + 3 * deltas[end].sent.size();
+                    if (end > offset && placeholders + cost > MAX_PLACEHOLDERS) {
+                        break;
+                    }
+                    placeholders += cost;
+                }
+                std::string total_case = "CASE conv_id";
+                std::string sent_case = "CASE";
+                std::string in_list;
+                for (size_t i = offset; i < end; i++) {
+                    total_case += " WHEN ? THEN CAST(? AS SIGNED)";
+                    for (size_t s = 0; s < deltas[i].sent.size(); s++) {
+                        sent_case += " WHEN conv_id = ? AND uid = ? THEN CAST(? AS SIGNED)";
+                    }
+                    in_list += i == offset ? "?" : ",?";
+                }
+                const std::string sql = "UPDATE user_conversation SET "
+                    "  unread_count = unread_count + (" + total_case + " ELSE 0 END) - ("
+                    + sent_case + " ELSE 0 END), "
+                    "  update_time = NOW() "
+                    "WHERE conv_id IN (" + in_list + ")";
+
+                const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+                int param = 1;
+                for (size_t i = offset; i < end; i++) {
+                    stmt->setString(param++, deltas[i].convId);
+                    stmt->setInt(param++, deltas[i].total);
+                }
+                for (size_t i = offset; i < end; i++) {
+                    for (const auto& [uid, sent] : deltas[i].sent) {
+                        stmt->setString(param++, deltas[i].convId);
+                        stmt->setInt(param++, uid);
+                        stmt->setInt(param++, sent);
+                    }
+                }
+                for (size_t i = offset; i < end; i++) {
+                    stmt->setString(param++, deltas[i].convId);
+                }
+                stmt->executeUpdate();
+                stmt->close();
+            }
+            conn->conn_->commit();
+            return true;
+        } catch (sql::SQLException& e) {
+            conn->conn_->rollback();
+            if (e.getErrorCode() == 1213) {
+                deadlockRetries++;
+            }
+            if (e.getErrorCode() == 1213 && retry < MAX_DEADLOCK_RETRIES - 1) {
+                std::cout << "[batchAddUnreadCounts] deadlock, retry " << retry + 1 << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10 * (retry + 1)));
+                continue;
+            }
+            std::cout << "[batchAddUnreadCounts] SQL exception: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    return false;
+}
+
+bool ConversationDao::reconcileUnreadCounts(const std::vector<ConvUnreadDelta>& convs, const int64_t workerId,
+                                            std::vector<UnreadCountFix>& fixed) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+    try {
+        const auto stmt_select(conn->prepare(SELECT_UNREAD_DRIFT_SQL));
+        const auto stmt_update(conn->prepare(UPDATE_UNREAD_DRIFT_SQL));
+        for (const auto& conv : convs) {
+            stmt_select->setInt64(1, conv.maxMsgId);
+            stmt_select->setString(2, conv.convId);
+            stmt_select->setInt64(3, workerId);
+            const std::unique_ptr<sql::ResultSet> res(stmt_select->executeQuery());
+            while (res->next()) {
+                UnreadCountFix fix;
+                fix.uid = res->getInt("uid");
+                fix.convId = conv.convId;
+                fix.unreadCount = static_cast<int>(res->getInt64("actual"));
+                const int stored = res->getInt("unread_count");
+                fix.drift = stored - fix.unreadCount;
+
+                stmt_update->setInt(1, fix.unreadCount);
+                stmt_update->setInt(2, fix.uid);
+                stmt_update->setString(3, conv.convId);
+                stmt_update->setInt64(4, res->getInt64("last_read_msg_id"));
+                stmt_update->setInt(5, stored);
+                if (stmt_update->executeUpdate() > 0) {
+                    fixed.push_back(std::move(fix));
+                }
+            }
+        }
+        return true;
+    } catch (sql::SQLException& e) {
+        std::cout << "reconcileUnreadCounts SQLException: " << e.what() << std::endl;
+        return false;
+    }
+}
@@ -17,23 +17,72 @@ public:
 
     bool createConversation(const ConversationInfo& info, std::string& result) const;
 
-    bool createMessage(const MessageInfo & info, int& result) const;
+    // ── 群聊 ─────────────────────────────────────────────
+    /// 创建群会话，成员关系即 user_conversation 中的行，一个事务内写入
+    bool createGroup(const ConversationInfo& info, const std::vector<int>& members, std::string& result) const;
+    bool addGroupMembers(const std::string& convId, const std::vector<int>& members) const;
+    /// 一个事务内移除全部成员，失败时一个都不移除
+    bool removeGroupMembers(const std::string& convId, const std::vector<int>& members) const;
+    /// 查询群主 ID，群不存在或已解散返回 false
+    bool selectGroupOwner(const std::string& convId, int& ownerUid) const;
+    [[nodiscard]] std::vector<int> selectGroupMembers(const std::string& convId) const;
 
-    [[nodiscard]] bool updateMessageStatus(int id, MessageStatus status) const;
+    /// 写入单条消息，info.servId 需已分配
+    bool createMessage(const MessageInfo & info);
+
+    [[nodiscard]] bool updateMessageStatus(int64_t id, MessageStatus status) const;
 
     [[nodiscard]] std::vector<ConversationInfo> selectConversationList(int uid, const std::string & sinceTime) const;
+    /// 用户的全部会话（不分页、不排序），会话列表缓存冷加载时使用；查询失败返回 false，与没有会话区分
+    bool selectUserConversations(int uid, std::vector<ConversationInfo>& result) const;
 
-    std::vector<MessageInfo> selectMessageList(const std::string & convId, int since_msg_id, int limit) const;
+    std::vector<MessageInfo> selectMessageList(const std::string & convId, int64_t since_msg_id, int limit) const;
+    /// 会话最新的 limit 条消息，按 id 升序返回；查询失败返回 false，与会话没有消息区分
+    bool selectRecentMessages(const std::string & convId, int limit, std::vector<MessageInfo>& result) const;
+    /// id 小于 before_msg_id 的最新 limit 条（before_msg_id 为 0 时不限），按 id 升序返回
+    bool selectMessagesBefore(const std::string & convId, int64_t before_msg_id, int limit,
+                              std::vector<MessageInfo>& result) const;
+    /// id 小于 anchor_msg_id 的最新 older 条加上 anchor_msg_id 及之后的 newer 条，一条语句查询，按 id 升序返回
+    bool selectMessagesAround(const std::string & convId, int64_t anchor_msg_id, int older, int newer,
+                              std::vector<MessageInfo>& result) const;
 
     bool updateConvMessagesStatus(const MessageStatusInfo & info) const;
+    /**
+     * @brief 批量刷写状态水位，一个事务内完成。
+     *
+     * 单聊更新对方发送的 (flushedMsgId, lastMsgId] 区间消息状态；已读水位同时更新
+     * last_read_msg_id，并按水位重新计算未读数，只计到 countedMsgId，之后的消息由未读增量累加。
+     */
+    bool batchUpdateMessageStatus(const std::vector<MessageStatusWatermark>& marks) const;
+    /**
+     * @brief 累加合并后的未读增量，deltas 需按 conv_id 有序，一个事务内完成，死锁时重试。
+     * @param deadlockRetries 返回本次遇到的死锁次数
+     */
+    bool batchAddUnreadCounts(const std::vector<ConvUnreadDelta>& deltas, int& deadlockRetries) const;
+    /**
+     * @brief 对账：按已读水位之后、maxMsgId 及之前的消息重新计算成员未读数，覆盖不一致的行。
+     *
+     * maxMsgId 只是本服务器已写回增量的上界，水位之后有其他机器号（workerId 之外）的消息的成员不对账，
+     * 多台服务器同时写入的会话由已读水位重算修正。只覆盖查询之后没有再变化的行，fixed 返回实际修正的成员。
+     */
+    bool reconcileUnreadCounts(const std::vector<ConvUnreadDelta>& convs, int64_t workerId,
+                               std::vector<UnreadCountFix>& fixed) const;
 
 
     // ── 批量异步入库 ─────────────────────────────────────
     /**
-     * @brief 批量插入聊天消息 + 更新会话元数据 + 更新用户会话未读计数。
+     * @brief 批量插入聊天消息 + 更新会话元数据，未读计数由 batchAddUnreadCounts 合并写入。
+     *
+     * 消息 ID 已在收到消息时分配，插入不再回查自增 ID。有未插入行的分块才回查已存储的 ID，
+     * 写回节点的 servId 并放入 duplicates：客户端重发的消息 ID 不同，WAL 重放或死信重投已提交的消息 ID 相同，
+     * 都不再更新会话摘要，也不交给落库回调。
      */
     bool batchCreateMessages(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes,
-                             std::unordered_map<int64_t, int>& id_mapping);
+                             std::vector<std::shared_ptr<ChatMsgNode>>& duplicates);
+    /// 同上，每条 INSERT 写入 chunkSize 行，deadlockRetries 返回本次遇到的死锁次数，供调整批次大小
+    bool batchCreateMessages(const std::vector<std::shared_ptr<ChatMsgNode>>& nodes,
+                             std::vector<std::shared_ptr<ChatMsgNode>>& duplicates,
+                             size_t chunkSize, int& deadlockRetries);
 
 private:
     std::unique_ptr<MysqlPool> pool_;
@@ -16,6 +16,20 @@ constexpr std::string_view FRIEND_APPLY_INFO_STATUS_PARTS = "friend_apply.uid, f
                                                     "friend_apply.create_time, friend_apply.update_time, "
                                                     "user.name, user.email, user.gender ";
 
+// 固定文本的热点语句，调用处和连接池预热共用
+const std::string SELECT_FRIEND_SQL = "SELECT " + std::string(FRIEND_LIST_INFO_PARTS)
+    + "FROM friend_relation JOIN user ON friend_relation.friend_id = user.uid "
+    "WHERE friend_relation.uid = ? AND friend_relation.friend_id = ?";
+const std::string SELECT_FRIEND_LIST_SQL = "SELECT " + std::string(FRIEND_LIST_INFO_PARTS)
+    + "FROM friend_relation JOIN user ON friend_relation.friend_id = user.uid "
+    "WHERE friend_relation.uid = ? AND friend_relation.is_hide = 0 "
+    "AND friend_relation.status != 3 AND friend_relation.update_time > ? "
+    "ORDER by friend_relation.update_time ASC LIMIT ? ";
+const std::string SELECT_FRIEND_STATUS_SQL = "SELECT " + std::string(FRIEND_INFO_STATUS_PARTS)
+    + "FROM friend_relation "
+    "WHERE friend_relation.uid = ? AND friend_relation.friend_id = ? "
+    "AND friend_relation.is_hide = 0 ";
+
 FriendInfoDao::FriendInfoDao() {
     auto& conf = ConfigMgr::getInstance();
     const auto& host = conf["Mysql"]["Host"];
@@ -24,6 +38,9 @@ FriendInfoDao::FriendInfoDao() {
     const auto& password = conf["Mysql"]["Password"];
     const auto& schema = conf["Mysql"]["Schema"];
     pool_ = std::make_unique<MysqlPool>(host + ":" + port, user, password, schema);
+    if (conf["Mysql"]["WarmStatements"] == "true") {
+        pool_->warmUp({SELECT_FRIEND_SQL, SELECT_FRIEND_LIST_SQL, SELECT_FRIEND_STATUS_SQL});
+    }
 }
 
 FriendInfoDao::~FriendInfoDao() {
@@ -41,10 +58,7 @@ bool FriendInfoDao::selectFriend(const int uid, const int friendId, FriendInfo &
 
     try {
         std::vector<FriendInfo> result;
-        const std::string sql = "SELECT " + std::string(FRIEND_LIST_INFO_PARTS)
-                                + "FROM friend_relation JOIN user ON friend_relation.friend_id = user.uid "
-                                "WHERE friend_relation.uid = ? AND friend_relation.friend_id = ?";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(SELECT_FRIEND_SQL));
         stmt->setInt(1, uid);
         stmt->setInt(2, friendId);
         const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
@@ -71,12 +85,7 @@ std::vector<FriendInfo> FriendInfoDao::selectFriendList(const int uid, const std
 
     try {
         std::vector<FriendInfo> result;
-        const std::string sql = "SELECT " + std::string(FRIEND_LIST_INFO_PARTS)
-                                + "FROM friend_relation JOIN user ON friend_relation.friend_id = user.uid "
-                                "WHERE friend_relation.uid = ? AND friend_relation.is_hide = 0 "
-                                "AND friend_relation.status != 3 AND friend_relation.update_time > ? "
-                                "ORDER by friend_relation.update_time ASC LIMIT ? ";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(SELECT_FRIEND_LIST_SQL));
         stmt->setInt(1, uid);
         stmt->setString(2, sinceTime);
         stmt->setInt(3, 200);
@@ -102,11 +111,7 @@ bool FriendInfoDao::selectFriendStatus(const int uid, const int friendId, int& s
     });
 
     try {
-        const std::string sql = "SELECT " + std::string(FRIEND_INFO_STATUS_PARTS)
-                                + "FROM friend_relation "
-                                "WHERE friend_relation.uid = ? AND friend_relation.friend_id = ? "
-                                "AND friend_relation.is_hide = 0 ";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(SELECT_FRIEND_STATUS_SQL));
         stmt->setInt(1, uid);
         stmt->setInt(2, friendId);
         if (const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery()); res->next()) {
@@ -142,7 +147,7 @@ std::vector<FriendApply> FriendInfoDao::selectFriendApplyList(const int uid, con
                                 "WHERE (friend_apply.uid = ? OR friend_apply.friend_id = ?) "
                                 "AND friend_apply.update_time > ? "
                                 "ORDER by friend_apply.id ASC LIMIT ? ";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(sql));
         stmt->setInt(1, uid);
         stmt->setInt(2, uid);
         stmt->setInt(3, uid);
@@ -180,7 +185,7 @@ bool FriendInfoDao::checkFriendApplyExist(const int uid, const int friendId) con
         const std::string sql = "SELECT 1 FROM friend_apply "
                                 "WHERE (friend_apply.uid = ? OR friend_apply.friend_id = ?) "
                                 "AND friend_apply.status = 0 ";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(sql));
         stmt->setInt(1, uid);
         stmt->setInt(2, friendId);
         if (const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery()); res->next()) {
@@ -196,6 +201,12 @@ bool FriendInfoDao::checkFriendApplyExist(const int uid, const int friendId) con
 }
 
 bool FriendInfoDao::updateFriendApply(const int uid, const int friendId, const int status, const std::string &msg) {
+    int affected = 0;
+    return updateFriendApply(uid, friendId, status, msg, affected);
+}
+
+bool FriendInfoDao::updateFriendApply(const int uid, const int friendId, const int status, const std::string &msg,
+                                      int &affected) {
     auto conn = pool_->getConnect();
     if (!conn) {
         return false;
@@ -205,7 +216,7 @@ bool FriendInfoDao::updateFriendApply(const int uid, const int friendId, const i
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "INSERT INTO friend_apply (uid, friend_id, msg, status, expire_time) values (?,?,?,?,NOW() + INTERVAL ? DAY) "
             "ON DUPLICATE KEY UPDATE uid = uid, friend_id = friend_id, status = ?, msg = ?, "
             "expire_time = NOW() + INTERVAL ? DAY, create_time = NOW()"));
@@ -217,18 +228,40 @@ bool FriendInfoDao::updateFriendApply(const int uid, const int friendId, const i
         stmt->setInt(6, status);
         stmt->setString(7, msg);
         stmt->setInt(8, 7); // 重设申请过期时间
-        if (const int rowAffected = stmt->executeUpdate(); rowAffected < 0) {
-            
-            return false;
-        }
-        
-        return true;
+        affected = stmt->executeUpdate();
+        return affected >= 0;
     } catch (sql::SQLException& e) {
         std::cout << "get user SQLException: " << e.what() << std::endl;
         return false;
     }
 }
 
+bool FriendInfoDao::resolvePendingFriendApply(const int uid, const int friendId, const int status, int &affected) {
+    affected = 0;
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+
+    try {
+        // 条件与未处理申请计数一致，重复处理或已过期的申请不会再次扣减计数
+        const auto stmt(conn->prepare(
+            "UPDATE friend_apply SET status = ? "
+            "WHERE uid = ? AND friend_id = ? AND status = 0 AND expire_time > NOW()"));
+        stmt->setInt(1, status);
+        stmt->setInt(2, uid);
+        stmt->setInt(3, friendId);
+        affected = stmt->executeUpdate();
+        return affected >= 0;
+    } catch (sql::SQLException& e) {
+        std::cout << "resolve friend apply SQLException: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 bool FriendInfoDao::getFriendApplyCount(const int uid, int& count) {
     auto conn = pool_->getConnect();
     if (!conn) {
@@ -238,7 +271,7 @@ bool FriendInfoDao::getFriendApplyCount(const int uid, int& count) {
         pool_->returnConnect(std::move(conn));
     });
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
         "SELECT COUNT(*) AS unread_count "
             "FROM friend_apply "
             "WHERE friend_id = ? AND status = 0 AND expire_time > NOW()"));
@@ -257,6 +290,12 @@ bool FriendInfoDao::getFriendApplyCount(const int uid, int& count) {
 }
 
 bool FriendInfoDao::createFriendRelation(const FriendApply &applyInfo) {
+    int applyUpdated = 0;
+    return createFriendRelation(applyInfo, applyUpdated);
+}
+
+bool FriendInfoDao::createFriendRelation(const FriendApply &applyInfo, int &applyUpdated) {
+    applyUpdated = 0;
     auto conn = pool_->getConnect();
     if (!conn) {
         return false;
@@ -269,17 +308,16 @@ bool FriendInfoDao::createFriendRelation(const FriendApply &applyInfo) {
     try {
         conn->conn_->setAutoCommit(false);
 
-        const std::unique_ptr<sql::PreparedStatement> stmt_apply(conn->conn_->prepareStatement(
+        const auto stmt_apply(conn->prepare(
             "UPDATE friend_apply SET status = 1 WHERE uid = ? AND friend_id = ? AND status = 0"));
         stmt_apply->setInt(1, applyInfo.uid);
         stmt_apply->setInt(2, applyInfo.friendId);
-        if (const int rowAffected = stmt_apply->executeUpdate(); rowAffected < 0) {
-            stmt_apply->close();
+        const int applyAffected = stmt_apply->executeUpdate();
+        if (applyAffected < 0) {
             return false;
         }
-        stmt_apply->close();
 
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "INSERT INTO friend_relation (uid, friend_id) values (?,?)"));
         stmt->setInt(1, applyInfo.uid);
         stmt->setInt(2, applyInfo.friendId);
@@ -296,6 +334,7 @@ bool FriendInfoDao::createFriendRelation(const FriendApply &applyInfo) {
         }
         
         conn->conn_->commit();
+        applyUpdated = applyAffected;
         return true;
     } catch (sql::SQLException &e) {
         std::cout << "add friend relation SQLException: " << e.what() << std::endl;
@@ -316,7 +355,7 @@ bool FriendInfoDao::updateFriendRelation(const int uid, const FriendInfo &friend
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "UPDATE friend_relation SET " + friendInfo.getUpdateProperty() + " = ? "
             "WHERE uid = ? AND friend_id = ?"));
         if (std::string strValue; friendInfo.getUpdatePropertyStringValue(strValue)) {
@@ -21,9 +21,15 @@ public:
     [[nodiscard]] std::vector<FriendApply> selectFriendApplyList(int uid, const std::string& sinceTime) const;
     [[nodiscard]] bool checkFriendApplyExist(int uid, int friendId) const;
     bool updateFriendApply(int uid, int friendId, int status, const std::string & msg);
+    /// 同上，affected 返回影响行数：1 为新建申请，2 为更新了已有的申请，0 为内容未变
+    bool updateFriendApply(int uid, int friendId, int status, const std::string & msg, int& affected);
+    /// 只把待处理且未过期的申请改为 status，affected 为 1 表示确实处理了一条计入未处理数的申请
+    bool resolvePendingFriendApply(int uid, int friendId, int status, int& affected);
     bool getFriendApplyCount(int uid, int& count);
 
     bool createFriendRelation(const FriendApply & applyInfo);
+    /// 同上，applyUpdated 返回改为同意的待处理申请行数，申请已被处理过时为 0
+    bool createFriendRelation(const FriendApply & applyInfo, int& applyUpdated);
     bool updateFriendRelation(int uid, const FriendInfo& friendInfo);
 
 private:
@@ -2,6 +2,7 @@
 // Created by Fan on 2026/6/23.
 //
 
+#include <algorithm>
 #include <format>
 #include "UserInfoDao.h"
 #include "ConfigMgr.h"
@@ -10,6 +11,22 @@ constexpr std::string_view USER_BASE_INFO_PARTS = "id, uid, gender, name, email,
 constexpr std::string_view USER_PROFILE_INFO_PARTS = "uid, signature, birthday, region, self_intro, create_time";
 constexpr std::string_view USER_PROFILE_CONFIG_PARTS = "uid, privacy_friend, privacy_chat, blacklist_switch";
 
+// 固定文本的热点语句，调用处和连接池预热共用
+const std::string SELECT_USER_PROFILE_SQL = "SELECT * FROM user_profile WHERE uid = ?";
+
+// 批量查询每条语句最多携带的 uid 个数
+constexpr size_t USER_BATCH_CHUNK = 200;
+
+/// rows 个 uid 的批量查询语句
+static std::string userBaseInfoBatchSql(const size_t rows) {
+    std::string sql = "SELECT " + std::string(USER_BASE_INFO_PARTS) + " FROM user WHERE uid IN (";
+    for (size_t i = 0; i < rows; i++) {
+        sql += i > 0 ? ",?" : "?";
+    }
+    sql += ")";
+    return sql;
+}
+
 UserInfoDao::UserInfoDao() {
     auto& conf = ConfigMgr::getInstance();
     const auto& host = conf["Mysql"]["Host"];
@@ -18,6 +35,9 @@ UserInfoDao::UserInfoDao() {
     const auto& password = conf["Mysql"]["Password"];
     const auto& schema = conf["Mysql"]["Schema"];
     pool_ = std::make_unique<MysqlPool>(host + ":" + port, user, password, schema);
+    if (conf["Mysql"]["WarmStatements"] == "true") {
+        pool_->warmUp({SELECT_USER_PROFILE_SQL});
+    }
 }
 
 UserInfoDao::~UserInfoDao() {
@@ -36,7 +56,7 @@ std::vector<UserBaseInfo> UserInfoDao::selectUserListInfo(const UserBaseInfo &se
         std::vector<UserBaseInfo> result;
         const std::string sql = "SELECT " + std::string(USER_BASE_INFO_PARTS)
             + " FROM user WHERE " + searchInfo.getSearchProperty() + " = ?";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(sql));
         if (const std::string value = searchInfo.getSearchPropertyStringValue(); !value.empty()) {
             stmt->setString(1, value);
         }
@@ -70,7 +90,7 @@ bool UserInfoDao::selectUserBaseInfo(UserBaseInfo &info) const {
     try {
         const std::string sql = "SELECT " + std::string(USER_BASE_INFO_PARTS)
             + " FROM user WHERE " + info.getSearchProperty() + " = ? LIMIT 1";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(sql));
         if (const int uid = info.getSearchPropertyIntValue(); uid >= 0) {
             stmt->setInt(1, uid);
         }
@@ -95,6 +115,39 @@ bool UserInfoDao::selectUserBaseInfo(UserBaseInfo &info) const {
     }
 }
 
+bool UserInfoDao::selectUserBaseInfos(const std::vector<int> &uids, std::vector<UserBaseInfo> &result) const {
+    if (uids.empty()) {
+        return true;
+    }
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+    try {
+        for (size_t offset = 0; offset < uids.size(); offset += USER_BATCH_CHUNK) {
+            const size_t rows = std::min(USER_BATCH_CHUNK, uids.size() - offset);
+            // 只缓存整块的语句；不足一块的尾部行数各不相同，缓存会挤出其他常用语句，直接预处理用完即弃
+            const std::shared_ptr<sql::PreparedStatement> stmt = rows == USER_BATCH_CHUNK
+                ? conn->prepare(userBaseInfoBatchSql(rows))
+                : std::shared_ptr<sql::PreparedStatement>(conn->conn_->prepareStatement(userBaseInfoBatchSql(rows)));
+            for (size_t i = 0; i < rows; i++) {
+                stmt->setInt(static_cast<unsigned int>(i + 1), uids[offset + i]);
+            }
+            const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
+            while (res->next()) {
+                result.push_back(UserBaseInfo::fromResult(res));
+            }
+        }
+        return true;
+    } catch (sql::SQLException& e) {
+        std::cout << "batch get user info SQLException: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 bool UserInfoDao::updateUserBaseInfo(const UserBaseInfo &info) const {
     auto conn = pool_->getConnect();
     if (!conn) {
@@ -112,7 +165,7 @@ bool UserInfoDao::updateUserBaseInfo(const UserBaseInfo &info) const {
     }
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "UPDATE user SET " + property + " = ? WHERE uid = ?"));
         if (std::string strValue; info.getUpdatePropertyStringValue(strValue)) {
             stmt->setString(1, strValue);
@@ -143,7 +196,7 @@ bool UserInfoDao::getUserPassword(UserBaseInfo &info) const {
     });
     try {
         const std::string sql = "SELECT pwd, salt FROM user WHERE " + info.getSearchProperty() + " = ? LIMIT 1";
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(sql));
+        const auto stmt(conn->prepare(sql));
         if (const std::string value = info.getSearchPropertyStringValue(); !value.empty()) {
             stmt->setString(1, value);
         }
@@ -183,8 +236,7 @@ bool UserInfoDao::selectUserProfileInfo(const int uid, UserProfile &info) const
     }
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->conn_->prepareStatement("SELECT * FROM user_profile WHERE uid = ?"));
+        const auto stmt(conn->prepare(SELECT_USER_PROFILE_SQL));
         stmt->setInt(1, uid);
 
         if (const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery()); res->next()) {
@@ -222,7 +274,7 @@ bool UserInfoDao::updateUserProfileInfo(const UserProfile &profile) const {
     }
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "UPDATE user_profile SET " + property + " = ? WHERE uid = ?"));
         if (std::string strValue; profile.getUpdatePropertyStringValue(strValue)) {
             stmt->setString(1, strValue);
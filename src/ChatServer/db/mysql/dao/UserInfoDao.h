@@ -17,6 +17,8 @@ public:
     [[nodiscard]] std::vector<UserBaseInfo> selectUserListInfo(const UserBaseInfo& searchInfo) const;
 
     bool selectUserBaseInfo(UserBaseInfo& info) const;
+    /// 按 uid 批量查询，每 200 个一条 IN 查询，查到的用户追加到 result，顺序不限
+    bool selectUserBaseInfos(const std::vector<int>& uids, std::vector<UserBaseInfo>& result) const;
     [[nodiscard]] bool updateUserBaseInfo(const UserBaseInfo & info) const;
     bool getUserPassword(UserBaseInfo& info) const;
 
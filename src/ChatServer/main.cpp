@@ -8,6 +8,7 @@
 #include "AsioIOServicePool.h"
 #include "ChatLogicSystem.h"
 #include "ChatServiceImpl.h"
+#include "ChatGrpcClient.h"
 #include "RedisMgr.h"
 #include "const.h"
 #include "DistLock.h"
@@ -23,6 +24,10 @@ int main()
     auto port = std::stoi(portStr);
 
     try {
+        // 先于其他线程构造逻辑层，配置非法（如 WorkerId 越界）时在这里抛出并退出
+        const std::string serverName = config["ChatServer"]["Name"];
+        ChatLogicSystem::getInstance()->setServerName(serverName);
+
         net::io_context io_context{1};
 
         std::make_shared<ChatServer>(io_context, port)->start();
@@ -49,12 +54,12 @@ int main()
             boost::ignore_unused(signal_number);
             io_context.stop();
             pool->stop();
-            server->Shutdown();
+            // 对端投递流是常驻调用，限时关闭，超时后取消未结束的流
+            ChatGrpcClient::getInstance()->close();
+            server->Shutdown(std::chrono::system_clock::now() + std::chrono::seconds(1));
         });
 
         // ChatServer启动成功初始化 Redis 的连接计数
-        const std::string serverName = config["ChatServer"]["Name"];
-        ChatLogicSystem::getInstance()->setServerName(serverName);
         {
             // DistLockGuard lockServer(DIST_LOCK_PREFIX + serverName, DIST_LOCK_TIMEOUT, DIST_ACQUIRE_TIMEOUT);
             RedisMgr::getInstance()->hSet(LOGIN_COUNT, serverName, "0");
@@ -11,6 +11,7 @@
 #include "ConfigMgr.h"
 #include "DistLock.h"
 #include "RedisMgr.h"
+#include "PresenceWriter.h"
 
 #include "db/cache/FriendCache.h"
 
@@ -111,10 +112,8 @@ void ChatServer::checkSessionHeartbeat() {
 
 void ChatServer::updateServerCount() const {
     const int count = static_cast<int>(sessions_.size());
-    const auto serverName = ConfigMgr::getInstance().getValue("ChatServer", "Name");
-    // DistLockGuard lockServer(DIST_LOCK_PREFIX + serverName, DIST_LOCK_TIMEOUT, DIST_ACQUIRE_TIMEOUT);
-    // 更新登录数量
-    RedisMgr::getInstance()->hSet(LOGIN_COUNT, serverName, std::to_string(count));
+    // 更新登录数量，与登录/下线操作合并写入，不阻塞 IO 线程
+    PresenceWriter::getInstance()->setServerCount(count);
 }
 
 
@@ -15,6 +15,9 @@
 #include "RedisMgr.h"
 #include "ConfigMgr.h"
 #include "UserMgr.h"
+#include "UserRouteCache.h"
+#include "OfflineInbox.h"
+#include "PresenceWriter.h"
 
 using boost::uuids::uuid;
 using boost::uuids::random_generator;
@@ -57,49 +60,58 @@ int Session::getUserId() const {
     return uid_;
 }
 
+void Session::setToken(const std::string &token) {
+    std::lock_guard<std::mutex> lock(tokenMtx_);
+    token_ = token;
+}
+
+std::string Session::getToken() const {
+    std::lock_guard<std::mutex> lock(tokenMtx_);
+    return token_;
+}
+
 void Session::asyncSend(const std::string &msg, const std::uint16_t msgId) {
     asyncSend(msg.c_str(), msg.size(), msgId);
 }
 
 void Session::asyncSend(const char *msg, std::uint16_t size, std::uint16_t msgId) {
-    std::lock_guard<std::mutex> lock(sendMtx_);
-    const size_t sendSize = sendNodeQueue_.size();
-    if (sendSize > MAX_SEND_QUEUE) {   // 发送抑制
-        std::cout << "Session: " << sessionId_ << "Send queue is full " << MAX_SEND_QUEUE << std::endl;
-        return;
+    asyncSend(std::make_shared<SendNode>(msg, size, msgId));
+}
+
+void Session::asyncSend(const std::shared_ptr<SendNode> &node) {
+    {
+        std::lock_guard<std::mutex> lock(sendMtx_);
+        const size_t sendSize = sendNodeQueue_.size();
+        if (sendSize <= MAX_SEND_QUEUE) {
+            sendNodeQueue_.push(node);
+            if (sendSize == 0) {
+                asyncSend();    // 队列非空时已经有线程在发送数据，不需要重复调用发送
+            }
+            return;
+        }
     }
+    // 发送抑制，被丢弃的推送转存离线收件箱
+    std::cout << "Session: " << sessionId_ << "Send queue is full " << MAX_SEND_QUEUE << std::endl;
+    stashToInbox(node);
+}
 
-    sendNodeQueue_.push(std::make_shared<SendNode>(msg, size, msgId));
-    if (sendSize > 0) {
-        return; // 已经有线程在发送数据，不需要重复调用发送
+void Session::stashToInbox(const std::shared_ptr<SendNode> &node) const {
+    const int uid = uid_.load();
+    if (uid <= 0 || !OfflineInbox::isPushMsg(node->msgId_)) {
+        return;
     }
-    asyncSend();
+    OfflineInbox::getInstance()->append(uid, node->msgId_,
+        std::string(node->buffer_ + HEAD_TOTAL_LEN, node->used_ - HEAD_TOTAL_LEN));
 }
 
 void Session::updateState(const SessionState state) const {
-    const auto serverName = ConfigMgr::getInstance().getValue("ChatServer", "Name");
-    // 多个服务器可能同时修改在线状态和服务在线计数，需要加分布式锁
-    // DistLockGuard lockUser(DIST_LOCK_PREFIX + std::to_string(uid_), DIST_LOCK_TIMEOUT, DIST_ACQUIRE_TIMEOUT);
-    // DistLockGuard lockServer(DIST_LOCK_PREFIX + serverName, DIST_LOCK_TIMEOUT, DIST_ACQUIRE_TIMEOUT);
-
+    // 在线状态交给写线程流水线写入 Redis，不阻塞 IO/逻辑线程；同一 uid 的操作按入队顺序生效
     if (state == SessionState::ONLINE) {
-        // 设置用户登录地址服务名，注意要提前设置好 uid，session 在客户端 TCP 建链后才收到 uid
-        RedisMgr::getInstance()->hSet(USER_ONLINE_INFO_PREFIX+ std::to_string(uid_),
-            USER_ONLINE_SERVER_NAME, serverName);
-        RedisMgr::getInstance()->hSet(USER_ONLINE_INFO_PREFIX+ std::to_string(uid_),
-            USER_SESSION_ID, sessionId_);
-        // 登录后要清除过期时间
-        RedisMgr::getInstance()->clearExpire(USER_ONLINE_INFO_PREFIX+ std::to_string(uid_));
+        PresenceWriter::getInstance()->online(uid_, sessionId_);
     }
     else if (state == SessionState::OFFLINE) {
-        // 先检查是否有其他终端登录
-        const auto sessionId = RedisMgr::getInstance()->hGet(USER_ONLINE_INFO_PREFIX+ std::to_string(uid_),
-            USER_SESSION_ID);
-        if (sessionId.empty() || sessionId != sessionId_) {
-            return; // 没有登录 session 或其他终端已经登录，直接返回
-        }
-        // 下线设置过期时间，用户可以重复登录
-        RedisMgr::getInstance()->setExpire(USER_ONLINE_INFO_PREFIX+ std::to_string(uid_), 300);
+        // 写线程校验 session_id，其他终端已经登录时不修改
+        PresenceWriter::getInstance()->offline(uid_, sessionId_);
     }
 }
 
@@ -209,6 +221,15 @@ void Session::asyncSend() {
     boost::asio::async_write(socket_, boost::asio::buffer(node->buffer_, node->used_),
         [self, this](const boost::system::error_code& error, size_t bytes_transfer) {
             if (error) {
+                // 未写出的推送（含写失败的这一帧）转存离线收件箱，重连后同步补齐
+                std::queue<std::shared_ptr<SendNode>> unsent;
+                {
+                    std::lock_guard<std::mutex> lock(sendMtx_);
+                    unsent.swap(sendNodeQueue_);
+                }
+                for (; !unsent.empty(); unsent.pop()) {
+                    stashToInbox(unsent.front());
+                }
                 close();
                 chatServer_->clearSession(sessionId_);
                 return;
@@ -5,6 +5,8 @@
 #ifndef IMSERVER_SESSION_H
 #define IMSERVER_SESSION_H
 
+#include <atomic>
+#include <mutex>
 #include <queue>
 
 #include "const.h"
@@ -24,6 +26,7 @@ public:
 
     void start();
     void close();
+    bool isClosed() const { return stop_.load(); }
 
     tcp::socket & getSocket();
 
@@ -32,8 +35,14 @@ public:
     void setUserId(int uid);
     int getUserId() const;
 
+    /// 登录使用的 token，登出时吊销；登录准入线程写入，逻辑线程读取，返回副本
+    void setToken(const std::string& token);
+    std::string getToken() const;
+
     void asyncSend(const std::string &msg, std::uint16_t msgId);
     void asyncSend(const char* msg, std::uint16_t size, std::uint16_t msgId);
+    /// 发送已编码好的帧，群消息扇出时同一帧由多个会话共享，只编码一次
+    void asyncSend(const std::shared_ptr<SendNode>& node);
 
     void updateState(SessionState state) const;
 
@@ -52,11 +61,15 @@ private:
         const std::function<void(const boost::system::error_code &, std::uint16_t)>& callback);
 
     void asyncSend();
+    /// 未能写出的推送帧转存离线收件箱
+    void stashToInbox(const std::shared_ptr<SendNode>& node) const;
 
     static constexpr int MAX_SEND_QUEUE = 1024;
 
     std::atomic<bool> stop_;
-    int uid_;
+    std::atomic<int> uid_;          ///< 登录准入线程写入，IO 线程与逻辑线程读取
+    mutable std::mutex tokenMtx_;
+    std::string token_;
     std::string sessionId_;
     std::chrono::steady_clock::time_point lstActiveTime_;
     std::mutex sessionMtx_;
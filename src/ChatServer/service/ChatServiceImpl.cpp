@@ -11,6 +11,7 @@
 #include "Session.h"
 #include "ChatLogicSystem.h"
 #include "RedisMgr.h"
+#include "OfflineInbox.h"
 
 ChatServiceImpl::ChatServiceImpl() {
 }
@@ -20,6 +21,8 @@ Status ChatServiceImpl::NotifyAddFriend(ServerContext *context, const ChatServic
     const auto to = request->to_uid();
     const auto session = UserMgr::getInstance()->getSession(to);
     if (!session) {
+        // 接收方已下线，转存离线收件箱
+        OfflineInbox::getInstance()->append(to, static_cast<uint16_t>(MessageID::ID_NOTIFY_FRIEND_APPLY), request->json());
         response->set_error(static_cast<int32_t>(ErrorCodes::USER_IS_OFFLINE));
         return Status::OK;
     }
@@ -37,6 +40,8 @@ Status ChatServiceImpl::NotifyAuthFriend(ServerContext *context, const ChatServi
     const auto to = request->to_uid();
     const auto session = UserMgr::getInstance()->getSession(to);
     if (!session) {
+        // 接收方已下线，转存离线收件箱
+        OfflineInbox::getInstance()->append(to, static_cast<uint16_t>(MessageID::ID_NOTIFY_FRIEND_AUTH), request->json());
         response->set_error(static_cast<int32_t>(ErrorCodes::USER_IS_OFFLINE));
         return Status::OK;
     }
@@ -49,6 +54,8 @@ Status ChatServiceImpl::SendChatMsg(ServerContext *context, const ChatServiceReq
     const auto to = request->to_uid();
     const auto session = UserMgr::getInstance()->getSession(to);
     if (!session) {
+        // 接收方已下线，转存离线收件箱
+        OfflineInbox::getInstance()->append(to, static_cast<uint16_t>(MessageID::ID_NOTIFY_CHAT_MSG), request->json());
         response->set_error(static_cast<int32_t>(ErrorCodes::USER_IS_OFFLINE));
         return Status::OK;
     }
@@ -68,3 +75,60 @@ Status ChatServiceImpl::NotifyOffline(ServerContext *context, const ChatServiceR
     session->notifyOffline();
     return Status::OK;
 }
+
+Status ChatServiceImpl::DeliverStream(ServerContext *context, ServerReaderWriter<DeliveryAck, DeliveryBatch> *stream) {
+    DeliveryBatch batch;
+    while (stream->Read(&batch)) {
+        DeliveryAck ack;
+        ack.set_batch_id(batch.batch_id());
+        ack.set_error(static_cast<int32_t>(ErrorCodes::SUCCESS));
+        for (const auto& delivery : batch.deliveries()) {
+            const auto session = UserMgr::getInstance()->getSession(delivery.to_uid());
+            if (!session) {
+                OfflineInbox::getInstance()->append(delivery.to_uid(), static_cast<uint16_t>(delivery.msg_id()),
+                    delivery.json());
+                ack.add_offline_uids(delivery.to_uid());
+                continue;
+            }
+            session->asyncSend(delivery.json(), static_cast<uint16_t>(delivery.msg_id()));
+        }
+        if (!stream->Write(ack)) {
+            break;
+        }
+    }
+    return Status::OK;
+}
+
+Status ChatServiceImpl::FanOut(ServerContext *context, const FanOutReq *request, FanOutRsp *response) {
+    response->set_error(static_cast<int32_t>(ErrorCodes::SUCCESS));
+    const auto& json = request->json();
+    const auto frame = std::make_shared<SendNode>(json.data(), static_cast<uint16_t>(json.size()),
+        static_cast<uint16_t>(request->msg_id()));
+    std::vector<int> offline;
+    for (const auto uid : request->to_uids()) {
+        const auto session = UserMgr::getInstance()->getSession(uid);
+        if (!session) {
+            offline.push_back(uid);
+            response->add_offline_uids(uid);
+            continue;
+        }
+        session->asyncSend(frame);
+    }
+    // 本机已下线的成员一次流水线写入收件箱
+    OfflineInbox::getInstance()->appendBatch(offline, static_cast<uint16_t>(request->msg_id()), json);
+    return Status::OK;
+}
+
+Status ChatServiceImpl::GetDeadLetterStats(ServerContext *context, const DeadLetterStatsReq *request,
+    DeadLetterStatsRsp *response) {
+    const auto stats = ChatLogicSystem::getInstance()->deadLetterStats();
+    response->set_error(static_cast<int32_t>(ErrorCodes::SUCCESS));
+    response->set_depth(stats.depth);
+    response->set_batches(stats.batches);
+    response->set_memory_bytes(stats.memoryBytes);
+    response->set_spilled(stats.spilled);
+    response->set_redelivered(stats.redelivered);
+    response->set_poisoned(stats.poisoned);
+    response->set_backoff_ms(stats.backoffMs);
+    return Status::OK;
+}
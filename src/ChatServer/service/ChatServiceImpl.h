@@ -14,11 +14,18 @@ using grpc::ServerContext;
 using grpc::Server;
 using grpc::ServerBuilder;
 using grpc::ServerUnaryReactor;
+using grpc::ServerReaderWriter;
 using grpc::Status;
 
 using message::ChatService;
 using message::ChatServiceReq;
 using message::ChatServiceRsp;
+using message::DeliveryBatch;
+using message::DeliveryAck;
+using message::FanOutReq;
+using message::FanOutRsp;
+using message::DeadLetterStatsReq;
+using message::DeadLetterStatsRsp;
 
 class ChatServiceImpl final : public ChatService::Service {
 public:
@@ -29,6 +36,13 @@ public:
     Status NotifyAuthFriend(ServerContext* context, const ChatServiceReq* request, ChatServiceRsp* response) override;
     Status SendChatMsg(ServerContext* context, const ChatServiceReq* request, ChatServiceRsp* response) override;
     Status NotifyOffline(ServerContext* context, const ChatServiceReq* request, ChatServiceRsp* response) override;
+    // 对端服务器的常驻投递流，逐批分发到本地会话并回复 ACK
+    Status DeliverStream(ServerContext* context, ServerReaderWriter<DeliveryAck, DeliveryBatch>* stream) override;
+    // 群消息扇出，消息帧只编码一次，推送给本机全部接收方
+    Status FanOut(ServerContext* context, const FanOutReq* request, FanOutRsp* response) override;
+    // 运维查询死信队列积压
+    Status GetDeadLetterStats(ServerContext* context, const DeadLetterStatsReq* request,
+        DeadLetterStatsRsp* response) override;
 };
 
 
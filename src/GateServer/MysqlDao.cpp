@@ -5,6 +5,10 @@
 #include "ConfigMgr.h"
 #include "const.h"
 
+// 固定文本的热点语句，调用处和连接池预热共用
+const std::string SELECT_USER_BY_EMAIL_SQL = "SELECT * FROM user WHERE email = ?";
+const std::string SELECT_UID_BY_EMAIL_SQL = "SELECT uid FROM user WHERE email = ?";
+
 MysqlDao::MysqlDao() {
     auto& conf = ConfigMgr::getInstance();
     const auto& host = conf["Mysql"]["Host"];
@@ -13,6 +17,9 @@ MysqlDao::MysqlDao() {
     const auto& password = conf["Mysql"]["Password"];
     const auto& schema = conf["Mysql"]["Schema"];
     pool_ = std::make_unique<MysqlPool>(host + ":" + port, user, password, schema);
+    if (conf["Mysql"]["WarmStatements"] == "true") {
+        pool_->warmUp({SELECT_USER_BY_EMAIL_SQL, SELECT_UID_BY_EMAIL_SQL});
+    }
 }
 
 MysqlDao::~MysqlDao() {
@@ -62,8 +69,7 @@ bool MysqlDao::checkEmail(const std::string &email) const {
         pool_->returnConnect(std::move(conn));
     });
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->conn_->prepareStatement("SELECT name FROM user WHERE email = ?"));
+        const auto stmt(conn->prepare("SELECT name FROM user WHERE email = ?"));
         stmt->setString(1, email);
         const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
         
@@ -91,8 +97,7 @@ bool MysqlDao::updatePasswd(const std::string &email, const std::string &passwd)
         pool_->returnConnect(std::move(conn));
     });
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->conn_->prepareStatement("UPDATE user SET pwd = ? WHERE email = ?"));
+        const auto stmt(conn->prepare("UPDATE user SET pwd = ? WHERE email = ?"));
         stmt->setString(1, passwd);
         stmt->setString(2, email);
         stmt->executeUpdate();
@@ -112,8 +117,7 @@ bool MysqlDao::checkPasswd(const std::string &email, const std::string &passwd,
         pool_->returnConnect(std::move(conn));
     });
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->conn_->prepareStatement("SELECT * FROM user WHERE email = ?"));
+        const auto stmt(conn->prepare(SELECT_USER_BY_EMAIL_SQL));
         stmt->setString(1, email);
         const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
         std::string originPassword;
@@ -149,8 +153,7 @@ int MysqlDao::getUid(const std::string &email) const {
         pool_->returnConnect(std::move(conn));
     });
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->conn_->prepareStatement("SELECT uid FROM user WHERE email = ?"));
+        const auto stmt(conn->prepare(SELECT_UID_BY_EMAIL_SQL));
         stmt->setString(1, email);
         const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
         int uid = -1;
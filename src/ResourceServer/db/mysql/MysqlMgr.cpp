@@ -24,7 +24,6 @@ bool MysqlMgr::updateThumbPath(const std::string &resourceId, const std::string
     return resourceMetaDao_.updateThumbPath(resourceId, thumbPath);
 }
 
-
-
-
-
+bool MysqlMgr::isConversationMember(const int uid, const std::string &convId) const {
+    return convMemberDao_.isMember(uid, convId);
+}
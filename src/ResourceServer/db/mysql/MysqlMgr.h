@@ -13,6 +13,7 @@
 
 #include "common/model/ResourceMeta.h"
 #include "db/mysql/dao/ResourceMetaDao.h"
+#include "db/mysql/dao/ConvMemberDao.h"
 
 class MysqlMgr : public Singleton<MysqlMgr> {
 public:
@@ -28,11 +29,14 @@ public:
 
     bool updateThumbPath(const std::string &resourceId, const std::string & thumbPath) const;
 
+    bool isConversationMember(int uid, const std::string &convId) const;
+
 private:
     friend class Singleton<MysqlMgr>;
     MysqlMgr() = default;
 
     ResourceMetaDao resourceMetaDao_;
+    ConvMemberDao convMemberDao_;
 };
 
 #endif //IMSERVER_MYSQLMGR_H
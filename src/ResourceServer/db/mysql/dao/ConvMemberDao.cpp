@@ -0,0 +1,53 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "ConvMemberDao.h"
+
+#include <iostream>
+
+#include <jdbc/cppconn/prepared_statement.h>
+#include <jdbc/cppconn/resultset.h>
+
+#include "ConfigMgr.h"
+
+// 固定文本的热点语句，调用处和连接池预热共用
+const std::string SELECT_MEMBER_SQL = "SELECT 1 FROM user_conversation WHERE uid = ? AND conv_id = ? LIMIT 1";
+
+ConvMemberDao::ConvMemberDao() {
+    auto& conf = ConfigMgr::getInstance();
+    const auto& host = conf["Mysql"]["Host"];
+    const auto& port = conf["Mysql"]["Port"];
+    const auto& user = conf["Mysql"]["User"];
+    const auto& password = conf["Mysql"]["Password"];
+    const auto& schema = conf["Mysql"]["Schema"];
+    pool_ = std::make_unique<MysqlPool>(host + ":" + port, user, password, schema);
+    if (conf["Mysql"]["WarmStatements"] == "true") {
+        pool_->warmUp({SELECT_MEMBER_SQL});
+    }
+}
+
+ConvMemberDao::~ConvMemberDao() {
+    pool_->close();
+}
+
+bool ConvMemberDao::isMember(const int uid, const std::string &convId) const {
+    auto conn = pool_->getConnect();
+    if (!conn) {
+        return false;
+    }
+    Defer defer([this, &conn]() {
+        pool_->returnConnect(std::move(conn));
+    });
+
+    try {
+        const auto stmt(conn->prepare(SELECT_MEMBER_SQL));
+        stmt->setInt(1, uid);
+        stmt->setString(2, convId);
+        const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+        return res->next();
+    } catch (sql::SQLException& e) {
+        std::cerr << "SQL error in isMember: " << e.what() << std::endl;
+        return false;
+    }
+}
@@ -0,0 +1,28 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_CONVMEMBERDAO_H
+#define IMSERVER_CONVMEMBERDAO_H
+
+#include <memory>
+#include <string>
+
+#include "MysqlPool.h"
+
+/**
+ * @brief 会话成员查询，群聊成员关系即 user_conversation 中的行。
+ */
+class ConvMemberDao {
+public:
+    ConvMemberDao();
+    ~ConvMemberDao();
+
+    bool isMember(int uid, const std::string& convId) const;
+
+private:
+    std::unique_ptr<MysqlPool> pool_;
+};
+
+
+#endif //IMSERVER_CONVMEMBERDAO_H
@@ -10,6 +10,15 @@
 #include "ConfigMgr.h"
 #include "MysqlPool.h"
 
+// 固定文本的热点语句，调用处和连接池预热共用
+const std::string INSERT_RESOURCE_SQL =
+    "INSERT INTO resource_meta (resource_id, conv_id, uploader_uid, md5, "
+    "file_size, file_name, file_path, thumb_path, resource_type, status, "
+    "reference_count, width, height, duration) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+const std::string SELECT_RESOURCE_SQL = "SELECT * FROM resource_meta WHERE resource_id = ?";
+const std::string SELECT_RESOURCE_BY_MD5_SQL = "SELECT * FROM resource_meta WHERE md5 = ? AND status = 0 LIMIT 1";
+
 ResourceMetaDao::ResourceMetaDao() {
     auto& conf = ConfigMgr::getInstance();
     const auto& host = conf["Mysql"]["Host"];
@@ -18,6 +27,9 @@ ResourceMetaDao::ResourceMetaDao() {
     const auto& password = conf["Mysql"]["Password"];
     const auto& schema = conf["Mysql"]["Schema"];
     pool_ = std::make_unique<MysqlPool>(host + ":" + port, user, password, schema);
+    if (conf["Mysql"]["WarmStatements"] == "true") {
+        pool_->warmUp({INSERT_RESOURCE_SQL, SELECT_RESOURCE_SQL, SELECT_RESOURCE_BY_MD5_SQL});
+    }
 }
 
 ResourceMetaDao::~ResourceMetaDao() {
@@ -35,11 +47,7 @@ bool ResourceMetaDao::insert(const ResourceMeta& meta) const {
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
-            "INSERT INTO resource_meta (resource_id, conv_id, uploader_uid, md5, "
-            "file_size, file_name, file_path, thumb_path, resource_type, status, "
-            "reference_count, width, height, duration) "
-            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+        const auto stmt(conn->prepare(INSERT_RESOURCE_SQL));
 
         stmt->setString(1, meta.resourceId);
         stmt->setString(2, meta.convId);
@@ -98,8 +106,7 @@ bool ResourceMetaDao::selectByResourceId(const std::string &resourceId, Resource
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
-            "SELECT * FROM resource_meta WHERE resource_id = ?"));
+        const auto stmt(conn->prepare(SELECT_RESOURCE_SQL));
         stmt->setString(1, resourceId);
 
         if (const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery()); res->next()) {
@@ -125,8 +132,7 @@ bool ResourceMetaDao::selectByMd5(const std::string &md5, ResourceMeta &meta) co
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
-            "SELECT * FROM resource_meta WHERE md5 = ? AND status = 0 LIMIT 1"));
+        const auto stmt(conn->prepare(SELECT_RESOURCE_BY_MD5_SQL));
         stmt->setString(1, md5);
 
         if (const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery()); res->next()) {
@@ -155,7 +161,7 @@ std::vector<ResourceMeta> ResourceMetaDao::selectByConvId(const std::string& con
     try {
         std::vector<ResourceMeta> results;
 
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "SELECT * FROM resource_meta WHERE conv_id = ? AND status = 0 "
             "ORDER BY create_time DESC LIMIT ? OFFSET ?"));
         stmt->setString(1, convId);
@@ -184,7 +190,7 @@ bool ResourceMetaDao::updateRefCount(const std::string& resourceId, const int de
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "UPDATE resource_meta SET reference_count = reference_count + ? "
             "WHERE resource_id = ?"));
         stmt->setInt(1, delta);
@@ -209,7 +215,7 @@ bool ResourceMetaDao::updateThumbPath(const std::string& resourceId,
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "UPDATE resource_meta SET thumb_path = ? WHERE resource_id = ?"));
         stmt->setString(1, thumbPath);
         stmt->setString(2, resourceId);
@@ -232,7 +238,7 @@ bool ResourceMetaDao::updateStatus(const std::string& resourceId, ResourceStatus
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "UPDATE resource_meta SET status = ? WHERE resource_id = ?"));
         stmt->setInt(1, static_cast<int>(status));
         stmt->setString(2, resourceId);
@@ -255,7 +261,7 @@ bool ResourceMetaDao::remove(const std::string& resourceId) const {
     });
 
     try {
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "DELETE FROM resource_meta WHERE resource_id = ?"));
         stmt->setString(1, resourceId);
         const auto res = stmt->executeUpdate();
@@ -278,7 +284,7 @@ std::vector<ResourceMeta> ResourceMetaDao::selectZeroRefDeleted() const {
 
     try {
         std::vector<ResourceMeta> results;
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "SELECT * FROM resource_meta WHERE reference_count = 0 AND status = 2"));
         const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
         
@@ -304,7 +310,7 @@ std::vector<ResourceMeta> ResourceMetaDao::selectPotentiallyOrphan() const {
     try {
         std::vector<ResourceMeta> results;
 
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "SELECT * FROM resource_meta WHERE reference_count > 0 AND status = 0"));
         const std::shared_ptr<sql::ResultSet> res(stmt->executeQuery());
         
@@ -330,7 +336,7 @@ std::vector<ResourceMeta> ResourceMetaDao::selectStaleUploading(const int minute
     try {
         std::vector<ResourceMeta> results;
 
-        const std::unique_ptr<sql::PreparedStatement> stmt(conn->conn_->prepareStatement(
+        const auto stmt(conn->prepare(
             "SELECT * FROM resource_meta WHERE status = 1 "
             "AND create_time < DATE_SUB(NOW(), INTERVAL ? MINUTE)"));
         stmt->setInt(1, minutes);
@@ -6,12 +6,15 @@
 
 #include "AsioIOServicePool.h"
 #include "ConfigMgr.h"
+#include "TokenAuth.h"
 #include "net/ResourceServer.h"
 
 int main() {
     auto port = std::stoi(ConfigMgr::getInstance()["ResourceServer"]["Port"]);
 
     try {
+        // 订阅 token 吊销通知，鉴权在本地完成
+        TokenAuth::getInstance()->start();
         net::io_context io_context{1};
         boost::asio::signal_set signals(io_context, SIGINT, SIGTERM);
         auto pool = AsioIOServicePool::getInstance();
@@ -7,7 +7,8 @@
 #include <iostream>
 
 #include "const.h"
-#include "StatusGrpcClient.h"
+#include "TokenAuth.h"
+#include "db/mysql/MysqlMgr.h"
 
 AuthMiddleware::AuthResult AuthMiddleware::authenticate(const http::request<http::dynamic_body>& req) {
     const auto token = extractBearerToken(req);
@@ -19,7 +20,7 @@ AuthMiddleware::AuthResult AuthMiddleware::authenticate(const http::request<http
         return { static_cast<int>(ErrorCodes::RESOURCE_AUTH_FAILED ), -1, "" };
     }
 
-    if (!verifyTokenFromStatusServer(uid, token)) {
+    if (!verifyToken(uid, token)) {
         return { static_cast<int>(ErrorCodes::RESOURCE_AUTH_FAILED ), -1, "" };
     }
 
@@ -60,12 +61,9 @@ std::string AuthMiddleware::extractHeaderString(const http::request<http::dynami
     return std::string(it->value());
 }
 
-bool AuthMiddleware::verifyTokenFromStatusServer(const int uid, const std::string& token) {
-    const auto response = StatusGrpcClient::getInstance()->VerifyToken(uid, token);
-    if (response.error() != static_cast<int32_t>(ErrorCodes::SUCCESS)) {
-        return false;
-    }
-    return response.error() == static_cast<int32_t>(ErrorCodes::SUCCESS);
+bool AuthMiddleware::verifyToken(const int uid, const std::string& token) {
+    // 本地验签和吊销检查，每个请求不再往返 StatusServer
+    return TokenAuth::getInstance()->verify(uid, token);
 }
 
 bool AuthMiddleware::isConversationMember(const int uid, const std::string& convId) {
@@ -87,7 +85,9 @@ bool AuthMiddleware::isConversationMember(const int uid, const std::string& conv
         }
     }
 
-    // For group chat, would need to query group member table
-    // For now, allow access (group membership check is a TODO)
-    return true;
+    // 群聊成员关系在 user_conversation 中
+    if (convId.compare(0, 6, "group_") == 0) {
+        return MysqlMgr::getInstance()->isConversationMember(uid, convId);
+    }
+    return false;
 }
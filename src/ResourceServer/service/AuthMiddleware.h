@@ -29,7 +29,7 @@ public:
 
 private:
     static std::string extractBearerToken(const http::request<http::dynamic_body>& req);
-    static bool verifyTokenFromStatusServer(int uid, const std::string& token);
+    static bool verifyToken(int uid, const std::string& token);
     static bool isConversationMember(int uid, const std::string& convId);
 };
 
@@ -4,16 +4,10 @@
 
 #include "StatusServiceImpl.h"
 
-#include <boost/uuid/uuid.hpp>
-#include <boost/uuid/uuid_generators.hpp>
-#include <boost/uuid/uuid_io.hpp>
-
 #include "const.h"
 #include "RedisMgr.h"
 #include "DistLock.h"
-
-using boost::uuids::uuid;
-using boost::uuids::random_generator;
+#include "TokenAuth.h"
 
 StatusServiceImpl::StatusServiceImpl() {
     auto& config = ConfigMgr::getInstance();
@@ -24,6 +18,8 @@ StatusServiceImpl::StatusServiceImpl() {
 
     initChatServer(config);
     initResourceServer(config);
+    // Login / VerifyToken 保留给旧客户端，同样走本地验签
+    TokenAuth::getInstance()->start();
 }
 
 Status StatusServiceImpl::GetResourceServer(ServerContext *context, const GetResourceServerReq *request,
@@ -42,11 +38,13 @@ Status StatusServiceImpl::GetChatServer(ServerContext *context, const GetChatSer
     response->set_host(server.host);
     response->set_port(server.port);
 
-    random_generator generator;
-    std::string token = boost::uuids::to_string(generator());
+    // 签名 token 由 ChatServer / ResourceServer 本地校验，不再写入 Redis
+    const auto token = TokenAuth::getInstance()->issue(request->uid());
+    if (token.empty()) {
+        response->set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
+        return Status::OK;
+    }
     response->set_token(token);
-    // 后续登录校验
-    insertToken(request->uid(), response->token());
     return Status::OK;
 }
 
@@ -55,7 +53,7 @@ Status StatusServiceImpl::Login(ServerContext *context, const message::LoginReq
     const auto& token = request->token();
 
     response->set_error(static_cast<int32_t>(ErrorCodes::SUCCESS));
-    if (!checkToken(uid, token)) {
+    if (!TokenAuth::getInstance()->verify(uid, token)) {
         response->set_error(static_cast<int32_t>(ErrorCodes::CHAT_LOGIN_TOKEN_ERROR));
         return Status::OK;
     }
@@ -71,7 +69,7 @@ Status StatusServiceImpl::VerifyToken(ServerContext *context, const VerifyTokenR
     response->set_error(static_cast<int32_t>(ErrorCodes::SUCCESS));
     response->set_uid(uid);
 
-    if (checkToken(uid, token)) {
+    if (TokenAuth::getInstance()->verify(uid, token)) {
         response->set_error(static_cast<int32_t>(ErrorCodes::SUCCESS));
     } else {
         response->set_error(static_cast<int32_t>(ErrorCodes::RESOURCE_AUTH_FAILED));
@@ -155,21 +153,3 @@ ServerInfo StatusServiceImpl::getChatServerInfo() {
     }
     return minServer;
 }
-
-void StatusServiceImpl::insertToken(const int uid, const std::string& token) {
-    std::cout << "Insert [uid: " << uid << ", token: " << token << "]" << std::endl;
-    RedisMgr::getInstance()->hSet(USER_ONLINE_INFO_PREFIX+ std::to_string(uid),USER_ONLINE_TOKEN, token);
-}
-
-bool StatusServiceImpl::checkToken(const int uid, const std::string &token) {
-    if (token.empty()) {
-        return false;
-    }
-    const auto expect = RedisMgr::getInstance()->hGet(
-        USER_ONLINE_INFO_PREFIX + std::to_string(uid), USER_ONLINE_TOKEN);
-    if (expect.empty()) {
-        std::cout << "Check [uid: " << uid << "] not found" << std::endl;
-        return false;
-    }
-    return expect == token;
-}
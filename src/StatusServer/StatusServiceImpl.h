@@ -49,9 +49,6 @@ private:
 
     ServerInfo getChatServerInfo();
 
-    void insertToken(int uid, const std::string& token);
-    bool checkToken(int uid, const std::string& token);
-
     std::unordered_map<std::string, ServerInfo> chatServers_;
     std::unordered_map<std::string, ServerInfo> resourceServers_;
     std::mutex serverMutex_;
@@ -2,30 +2,74 @@
 
 #include <iostream>
 #include <chrono>
+#include <stdexcept>
 
 SqlConnection::SqlConnection(sql::Connection *conn, int64_t lastTime) : conn_(conn), lastOptTime_(lastTime) {
 }
 
+std::shared_ptr<sql::PreparedStatement> SqlConnection::prepare(const std::string &sql) {
+    if (const auto it = stmts_.find(sql); it != stmts_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        it->second.stmt->clearParameters();
+        return it->second.stmt;
+    }
+
+    std::shared_ptr<sql::PreparedStatement> stmt(conn_->prepareStatement(sql));
+    if (stmts_.size() >= MYSQL_STMT_CACHE_SIZE) {
+        stmts_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    lru_.push_front(sql);
+    stmts_.emplace(sql, CachedStatement{stmt, lru_.begin()});
+    return stmt;
+}
+
+void SqlConnection::reset(sql::Connection *conn) {
+    stmts_.clear();
+    lru_.clear();
+    conn_.reset(conn);
+}
+
 MysqlPool::MysqlPool(const std::string &url, const std::string &user,
     const std::string &password, const std::string &schema, const int size)
     : url_(url), user_(user), password_(password), schema_(schema), poolSize_(size) {
     try {
         std::cout << "Create MysqlPool with " << user << "....";
-        for (int i = 0; i < size; i++) {
-            const auto driver = sql::mysql::get_driver_instance();
-            if (!driver) {
-                throw std::runtime_error("Driver is null");
-            }
+        const auto driver = sql::mysql::get_driver_instance();
+        if (!driver) {
+            throw std::runtime_error("Driver is null");
+        }
 
-            const auto conn = driver->connect(url, user, password);
-            if (!conn) {
-                throw std::runtime_error("Connection is null");
+        // 并行建立连接，启动耗时约为单条连接的握手时间
+        std::vector<std::unique_ptr<SqlConnection>> created(size);
+        std::vector<std::string> errors(size);
+        std::vector<std::thread> workers;
+        for (int i = 0; i < size; i++) {
+            workers.emplace_back([this, driver, i, &created, &errors]() {
+                driver->threadInit();
+                try {
+                    const auto conn = driver->connect(url_, user_, password_);
+                    if (!conn) {
+                        throw std::runtime_error("Connection is null");
+                    }
+                    conn->setSchema(schema_);
+                    auto curTime = std::chrono::system_clock::now().time_since_epoch();
+                    long long timeStamp = std::chrono::duration_cast<std::chrono::seconds>(curTime).count();
+                    created[i] = std::make_unique<SqlConnection>(conn, timeStamp);
+                } catch (std::exception &e) {
+                    errors[i] = e.what();
+                }
+                driver->threadEnd();
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (int i = 0; i < size; i++) {
+            if (!errors[i].empty()) {
+                throw std::runtime_error(errors[i]);
             }
-
-            conn->setSchema(schema_);
-            auto curTime = std::chrono::system_clock::now().time_since_epoch();
-            long long timeStamp = std::chrono::duration_cast<std::chrono::seconds>(curTime).count();
-            connections_.push(std::make_unique<SqlConnection>(conn, timeStamp));
+            connections_.push(std::move(created[i]));
         }
 
         thread_ = std::thread([&]() {
@@ -45,7 +89,7 @@ MysqlPool::MysqlPool(const std::string &url, const std::string &user,
             }
         });
         std::cout << "OK" << std::endl;
-    } catch (sql::SQLException &e) {
+    } catch (std::exception &e) {
         std::cout << "SQLException: " << e.what() << std::endl;
     }
 }
@@ -87,6 +131,52 @@ void MysqlPool::returnConnect(std::unique_ptr<SqlConnection> conn) {
     cond_.notify_one();
 }
 
+void MysqlPool::warmUp(const std::vector<std::string> &statements) {
+    std::vector<std::unique_ptr<SqlConnection>> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!connections_.empty()) {
+            idle.push_back(std::move(connections_.front()));
+            connections_.pop();
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto driver = sql::mysql::get_driver_instance();
+    std::atomic<int> failed{0};
+    std::vector<std::thread> workers;
+    for (auto& conn : idle) {
+        workers.emplace_back([driver, &conn, &statements, &failed]() {
+            driver->threadInit();
+            for (const auto& sql : statements) {
+                try {
+                    conn->prepare(sql);
+                } catch (sql::SQLException &e) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                    std::cout << "warm up statement SQLException: " << e.what() << " sql: " << sql << std::endl;
+                }
+            }
+            driver->threadEnd();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& conn : idle) {
+            connections_.push(std::move(conn));
+        }
+    }
+    cond_.notify_all();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "MysqlPool warm up " << statements.size() << " statements on " << idle.size()
+              << " connections in " << elapsed << "ms, failed " << failed.load() << std::endl;
+}
+
 void MysqlPool::close() {
     stop_.store(true);
     cond_.notify_all();
@@ -124,7 +214,7 @@ void MysqlPool::checkConnection() {
                 return;
             }
             newConn->setSchema(schema_);
-            conn->conn_.reset(newConn);
+            conn->reset(newConn);
             conn->lastOptTime_ = timeStamp;
         }
     }
@@ -1,8 +1,12 @@
 #ifndef IMSERVER_MYSQLPOOL_H
 #define IMSERVER_MYSQLPOOL_H
 
+#include <list>
 #include <memory>
 #include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
@@ -17,12 +21,34 @@
 
 #include "const.h"
 
+/**
+ * @brief 连接池中的一条 MySQL 连接，附带按 SQL 文本缓存的预处理语句。
+ *
+ * prepare 命中缓存时复用已在服务端预处理过的语句，省去每次查询的 prepare 往返；
+ * 缓存超过 MYSQL_STMT_CACHE_SIZE 条时淘汰最久未用的语句。语句以 shared_ptr 返回，
+ * 淘汰不影响调用方正在使用的语句。缓存的语句会被后续调用复用，用完不要 close。
+ * 存储过程 (CALL) 会返回多个结果集，仍直接使用 conn_->prepareStatement。
+ */
 class SqlConnection {
 public:
     SqlConnection(sql::Connection* conn, int64_t lastTime);
 
+    std::shared_ptr<sql::PreparedStatement> prepare(const std::string& sql);
+    /// 重连后替换底层连接，旧连接上预处理的语句一并丢弃，下次使用时重新 prepare
+    void reset(sql::Connection* conn);
+    [[nodiscard]] size_t cachedStatements() const { return stmts_.size(); }
+
     std::unique_ptr<sql::Connection> conn_;
     int64_t lastOptTime_;
+
+private:
+    struct CachedStatement {
+        std::shared_ptr<sql::PreparedStatement> stmt;
+        std::list<std::string>::iterator lru;
+    };
+    // 声明在 conn_ 之后，析构时先于连接释放
+    std::list<std::string> lru_;    ///< 最近使用的在前
+    std::unordered_map<std::string, CachedStatement> stmts_;
 };
 
 class MysqlPool {
@@ -34,6 +60,9 @@ public:
     std::unique_ptr<SqlConnection> getConnect();
     void returnConnect(std::unique_ptr<SqlConnection> conn);
 
+    /// 在所有空闲连接上并行预处理给定语句，启动时调用，期间 getConnect 等待
+    void warmUp(const std::vector<std::string>& statements);
+
     void close();
 private:
     void checkConnection();
@@ -4,7 +4,9 @@
 
 #include "RedisMgr.h"
 
+#include <chrono>
 #include <iostream>
+#include <poll.h>
 #include <json/value.h>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
@@ -75,29 +77,50 @@ void RedisPool::returnConnection(redisContext *c) {
     cond_.notify_one();// 通知阻塞线程
 }
 
+void RedisPool::discardConnection(redisContext *c) {
+    redisFree(c);
+    // 在锁外建立连接，不阻塞其他线程取还连接
+    const auto conn = stop_.load() ? nullptr : connect();
+    if (conn == nullptr) {
+        return;     // 由 checkConnection 重建
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (stop_.load()) {
+        redisFree(conn);
+        return;
+    }
+    connections_.push(conn);
+    cond_.notify_one();
+}
+
 void RedisPool::close() {
     stop_.store(true);
     cond_.notify_all();
 }
 
+redisContext* RedisPool::connect() const {
+    auto conn = redisConnect(host_.c_str(), port_);
+    if (conn == nullptr || conn->err) {
+        redisFree(conn);
+        return nullptr;
+    }
+    // 认证连接
+    const auto reply = static_cast<redisReply *>(redisCommand(conn, "AUTH %s", passwd_.c_str()));
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR) {
+        std::cout << "RedisPool::redisConnect() AUTH failed" << std::endl;
+        redisFree(conn);
+        freeReplyObject(reply);
+        return nullptr;
+    }
+    freeReplyObject(reply);
+    return conn;
+}
+
 void RedisPool::createPool() {
     for (int i = 0; i < capacity_; i++) {
-        auto conn = redisConnect(host_.c_str(), port_);
-        if (conn == nullptr || conn->err) {
-            redisFree(conn);
-            continue;
+        if (const auto conn = connect()) {
+            connections_.push(conn);
         }
-        // 认证连接
-        const auto reply = static_cast<redisReply *>(redisCommand(conn, "AUTH %s", passwd_.c_str()));
-        if (reply == nullptr || reply->type == REDIS_REPLY_ERROR) {
-            std::cout << "RedisPool::redisConnect() AUTH failed" << std::endl;
-            redisFree(conn);
-            freeReplyObject(reply);
-            continue;
-        }
-
-        freeReplyObject(reply);
-        connections_.push(conn);
     }
 
     if (!connections_.empty()) {
@@ -152,6 +175,12 @@ void RedisPool::checkConnection() {
 
 RedisMgr::~RedisMgr() {
     close();
+    std::lock_guard<std::mutex> guard(subMutex_);
+    for (auto& thread : subThreads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
 }
 
 bool RedisMgr::get(const std::string &key, std::string &value) {
@@ -569,6 +598,51 @@ std::unordered_map<std::string, std::string> RedisMgr::hGetAll(const std::string
     return result;
 }
 
+std::vector<std::string> RedisMgr::hGetPipeline(const std::vector<std::string> &keys, const std::string &hKey) const {
+    std::vector<std::string> values(keys.size());
+    if (keys.empty()) {
+        return values;
+    }
+    const auto conn = redisPool_->getConnection();
+    if (conn == nullptr) {
+        return values;
+    }
+    bool broken = false;
+    Defer defer([&conn, &broken, this] {
+        if (broken) {
+            redisPool_->discardConnection(conn);
+        }
+        else {
+            redisPool_->returnConnection(conn);
+        }
+    });
+
+    // 先把全部 HGET 写入输出缓冲，再依次读取回复，只有一次网络往返
+    for (const auto& key : keys) {
+        const char* argv[3] = {"HGET", key.c_str(), hKey.c_str()};
+        const size_t argv_size[3] = {4, key.length(), hKey.length()};
+        if (redisAppendCommandArgv(conn, 3, argv, argv_size) != REDIS_OK) {
+            std::cout << "RedisMgr::hGetPipeline: append HGET [" << key << "] failed!" << std::endl;
+            broken = true;
+            return values;
+        }
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+        void* raw = nullptr;
+        if (redisGetReply(conn, &raw) != REDIS_OK) {
+            std::cout << "RedisMgr::hGetPipeline: read reply failed: " << conn->errstr << std::endl;
+            broken = true;
+            return values;
+        }
+        const auto reply = static_cast<redisReply *>(raw);
+        if (reply->type == REDIS_REPLY_STRING) {
+            values[i].assign(reply->str, reply->len);
+        }
+        freeReplyObject(reply);
+    }
+    return values;
+}
+
 bool RedisMgr::zSet(const std::string &key, long long score, const std::string &value) {
     const auto conn = redisPool_->getConnection();
     if (conn == nullptr) {
@@ -615,6 +689,32 @@ bool RedisMgr::zRevrange(const std::string &key, std::vector<std::string> &value
     return true;
 }
 
+bool RedisMgr::zRangeByScore(const std::string &key, const long long min, const long long max,
+    std::vector<std::string> &values) const {
+    const auto conn = redisPool_->getConnection();
+    if (conn == nullptr) {
+        return false;
+    }
+    Defer defer([&conn, this] {
+        redisPool_->returnConnection(conn);
+    });
+
+    auto reply = static_cast<redisReply *>(redisCommand(conn,
+        "ZRANGEBYSCORE %s %lld %lld", key.c_str(), min, max));
+    if (nullptr == reply || reply->type != REDIS_REPLY_ARRAY) {
+        std::cout << "RedisMgr::zRangeByScore: RedisCommand() ZRANGEBYSCORE ["<< key << "] failed!" << std::endl;
+        freeReplyObject(reply);
+        return false;
+    }
+
+    for (size_t i = 0; i < reply->elements; ++i) {
+        values.emplace_back(reply->element[i]->str, reply->element[i]->len);
+    }
+
+    freeReplyObject(reply);
+    return true;
+}
+
 bool RedisMgr::zRem(const std::string &key, const std::string &value) {
     const auto conn = redisPool_->getConnection();
     if (conn == nullptr) {
@@ -636,6 +736,259 @@ bool RedisMgr::zRem(const std::string &key, const std::string &value) {
     return true;
 }
 
+bool RedisMgr::xAddPipeline(const std::vector<std::string> &keys,
+    const std::vector<std::pair<std::string, std::string>> &fields, const size_t maxLen, const int maxAgeSec) const {
+    if (keys.empty()) {
+        return true;
+    }
+    const auto conn = redisPool_->getConnection();
+    if (conn == nullptr) {
+        return false;
+    }
+    bool broken = false;
+    Defer defer([&conn, &broken, this] {
+        if (broken) {
+            redisPool_->discardConnection(conn);
+        }
+        else {
+            redisPool_->returnConnection(conn);
+        }
+    });
+
+    const std::string maxLenStr = std::to_string(maxLen);
+    const auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const std::string minIdStr = std::to_string(nowMs - static_cast<long long>(maxAgeSec) * 1000);
+    const std::string maxAgeStr = std::to_string(maxAgeSec);
+
+    // XADD key MAXLEN ~ n * f1 v1 f2 v2 ...
+    std::vector<const char*> xAddArgv = {"XADD", nullptr, "MAXLEN", "~", maxLenStr.c_str(), "*"};
+    std::vector<size_t> xAddArgvSize = {4, 0, 6, 1, maxLenStr.length(), 1};
+    for (const auto& [field, value] : fields) {
+        xAddArgv.push_back(field.c_str());
+        xAddArgvSize.push_back(field.length());
+        xAddArgv.push_back(value.c_str());
+        xAddArgvSize.push_back(value.length());
+    }
+
+    for (const auto& key : keys) {
+        xAddArgv[1] = key.c_str();
+        xAddArgvSize[1] = key.length();
+        const char* trimArgv[5] = {"XTRIM", key.c_str(), "MINID", "~", minIdStr.c_str()};
+        const size_t trimArgvSize[5] = {5, key.length(), 5, 1, minIdStr.length()};
+        const char* expireArgv[3] = {"EXPIRE", key.c_str(), maxAgeStr.c_str()};
+        const size_t expireArgvSize[3] = {6, key.length(), maxAgeStr.length()};
+        if (redisAppendCommandArgv(conn, static_cast<int>(xAddArgv.size()), xAddArgv.data(), xAddArgvSize.data()) != REDIS_OK
+            || redisAppendCommandArgv(conn, 5, trimArgv, trimArgvSize) != REDIS_OK
+            || redisAppendCommandArgv(conn, 3, expireArgv, expireArgvSize) != REDIS_OK) {
+            std::cout << "RedisMgr::xAddPipeline: append XADD [" << key << "] failed!" << std::endl;
+            broken = true;
+            return false;
+        }
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < keys.size() * 3; i++) {
+        void* raw = nullptr;
+        if (redisGetReply(conn, &raw) != REDIS_OK) {
+            std::cout << "RedisMgr::xAddPipeline: read reply failed: " << conn->errstr << std::endl;
+            broken = true;
+            return false;
+        }
+        const auto reply = static_cast<redisReply *>(raw);
+        if (reply->type == REDIS_REPLY_ERROR) {
+            std::cout << "RedisMgr::xAddPipeline: " << reply->str << std::endl;
+            ok = false;
+        }
+        freeReplyObject(reply);
+    }
+    return ok;
+}
+
+bool RedisMgr::xRange(const std::string &key, const std::string &start, const size_t count,
+    std::vector<RedisStreamEntry> &entries) const {
+    const auto conn = redisPool_->getConnection();
+    if (conn == nullptr) {
+        return false;
+    }
+    Defer defer([&conn, this] {
+        redisPool_->returnConnection(conn);
+    });
+
+    const auto reply = static_cast<redisReply *>(redisCommand(conn, "XRANGE %b %b + COUNT %zu",
+        key.data(), key.size(), start.data(), start.size(), count));
+    if (nullptr == reply || reply->type != REDIS_REPLY_ARRAY) {
+        std::cout << "RedisMgr::xRange: RedisCommand() XRANGE [" << key << "] failed!" << std::endl;
+        freeReplyObject(reply);
+        return false;
+    }
+
+    // 每个条目为 [id, [f1, v1, f2, v2, ...]]
+    for (size_t i = 0; i < reply->elements; ++i) {
+        const auto item = reply->element[i];
+        if (item->type != REDIS_REPLY_ARRAY || item->elements != 2) {
+            continue;
+        }
+        RedisStreamEntry entry;
+        entry.id.assign(item->element[0]->str, item->element[0]->len);
+        const auto values = item->element[1];
+        for (size_t j = 0; j + 1 < values->elements; j += 2) {
+            entry.fields[std::string(values->element[j]->str, values->element[j]->len)]
+                = std::string(values->element[j + 1]->str, values->element[j + 1]->len);
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    freeReplyObject(reply);
+    return true;
+}
+
+bool RedisMgr::xTrimMinId(const std::string &key, const std::string &minId) const {
+    const auto conn = redisPool_->getConnection();
+    if (conn == nullptr) {
+        return false;
+    }
+    Defer defer([&conn, this] {
+        redisPool_->returnConnection(conn);
+    });
+
+    const auto reply = static_cast<redisReply *>(redisCommand(conn, "XTRIM %b MINID %b",
+        key.data(), key.size(), minId.data(), minId.size()));
+    if (nullptr == reply || reply->type != REDIS_REPLY_INTEGER) {
+        std::cout << "RedisMgr::xTrimMinId: RedisCommand() XTRIM [" << key << "] failed!" << std::endl;
+        freeReplyObject(reply);
+        return false;
+    }
+
+    freeReplyObject(reply);
+    return true;
+}
+
+bool RedisMgr::pipeline(const std::vector<std::vector<std::string>> &commands) const {
+    if (commands.empty()) {
+        return true;
+    }
+    const auto conn = redisPool_->getConnection();
+    if (conn == nullptr) {
+        return false;
+    }
+    bool broken = false;
+    Defer defer([&conn, &broken, this] {
+        if (broken) {
+            redisPool_->discardConnection(conn);
+        }
+        else {
+            redisPool_->returnConnection(conn);
+        }
+    });
+
+    std::vector<const char*> argv;
+    std::vector<size_t> argvSize;
+    for (const auto& command : commands) {
+        argv.clear();
+        argvSize.clear();
+        for (const auto& arg : command) {
+            argv.push_back(arg.data());
+            argvSize.push_back(arg.size());
+        }
+        if (redisAppendCommandArgv(conn, static_cast<int>(argv.size()), argv.data(), argvSize.data()) != REDIS_OK) {
+            std::cout << "RedisMgr::pipeline: append " << command.front() << " failed!" << std::endl;
+            broken = true;
+            return false;
+        }
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < commands.size(); i++) {
+        void* raw = nullptr;
+        if (redisGetReply(conn, &raw) != REDIS_OK) {
+            std::cout << "RedisMgr::pipeline: read reply failed: " << conn->errstr << std::endl;
+            broken = true;
+            return false;
+        }
+        const auto reply = static_cast<redisReply *>(raw);
+        if (reply->type == REDIS_REPLY_ERROR) {
+            std::cout << "RedisMgr::pipeline: " << commands[i].front() << " " << reply->str << std::endl;
+            ok = false;
+        }
+        freeReplyObject(reply);
+    }
+    return ok;
+}
+
+bool RedisMgr::pipeline(const std::vector<std::vector<std::string>> &commands,
+    std::vector<std::vector<std::string>> &replies) const {
+    replies.assign(commands.size(), {});
+    if (commands.empty()) {
+        return true;
+    }
+    const auto conn = redisPool_->getConnection();
+    if (conn == nullptr) {
+        return false;
+    }
+    bool broken = false;
+    Defer defer([&conn, &broken, this] {
+        if (broken) {
+            redisPool_->discardConnection(conn);
+        }
+        else {
+            redisPool_->returnConnection(conn);
+        }
+    });
+
+    std::vector<const char*> argv;
+    std::vector<size_t> argvSize;
+    for (const auto& command : commands) {
+        argv.clear();
+        argvSize.clear();
+        for (const auto& arg : command) {
+            argv.push_back(arg.data());
+            argvSize.push_back(arg.size());
+        }
+        if (redisAppendCommandArgv(conn, static_cast<int>(argv.size()), argv.data(), argvSize.data()) != REDIS_OK) {
+            std::cout << "RedisMgr::pipeline: append " << command.front() << " failed!" << std::endl;
+            broken = true;
+            return false;
+        }
+    }
+
+    const auto toString = [](const redisReply* reply) -> std::string {
+        if (reply->type == REDIS_REPLY_STRING || reply->type == REDIS_REPLY_STATUS) {
+            return {reply->str, reply->len};
+        }
+        if (reply->type == REDIS_REPLY_INTEGER) {
+            return std::to_string(reply->integer);
+        }
+        return {};
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < commands.size(); i++) {
+        void* raw = nullptr;
+        if (redisGetReply(conn, &raw) != REDIS_OK) {
+            std::cout << "RedisMgr::pipeline: read reply failed: " << conn->errstr << std::endl;
+            broken = true;
+            return false;
+        }
+        const auto reply = static_cast<redisReply *>(raw);
+        if (reply->type == REDIS_REPLY_ERROR) {
+            std::cout << "RedisMgr::pipeline: " << commands[i].front() << " " << reply->str << std::endl;
+            ok = false;
+        }
+        else if (reply->type == REDIS_REPLY_ARRAY) {
+            replies[i].reserve(reply->elements);
+            for (size_t j = 0; j < reply->elements; j++) {
+                replies[i].push_back(toString(reply->element[j]));
+            }
+        }
+        else if (reply->type != REDIS_REPLY_NIL) {
+            replies[i].push_back(toString(reply));
+        }
+        freeReplyObject(reply);
+    }
+    return ok;
+}
+
 bool RedisMgr::del(const std::string &key) const {
     const auto conn = redisPool_->getConnection();
     if (conn == nullptr) {
@@ -774,19 +1127,126 @@ bool RedisMgr::releaseLock(const std::string &name, const std::string& identifie
     return false;
 }
 
+bool RedisMgr::publish(const std::string &channel, const std::string &message) const {
+    const auto conn = redisPool_->getConnection();
+    if (conn == nullptr) {
+        return false;
+    }
+    Defer defer([&conn, this] {
+        redisPool_->returnConnection(conn);
+    });
+
+    const auto reply = static_cast<redisReply *>(redisCommand(conn, "PUBLISH %b %b",
+        channel.data(), channel.size(), message.data(), message.size()));
+    if (nullptr == reply || reply->type != REDIS_REPLY_INTEGER) {
+        std::cout << "RedisMgr::publish: RedisCommand() [" << channel << " : " << message << "] failed!" << std::endl;
+        freeReplyObject(reply);
+        return false;
+    }
+
+    freeReplyObject(reply);
+    return true;
+}
+
+void RedisMgr::subscribe(const std::string &channel, const redisSubscribeCallback &callback,
+    const redisResubscribeCallback &onSubscribed) {
+    std::lock_guard<std::mutex> guard(subMutex_);
+    if (subStop_.load()) {
+        return;
+    }
+    subThreads_.emplace_back(&RedisMgr::subscribeLoop, this, channel, callback, onSubscribed);
+}
+
+redisContext * RedisMgr::createSubscribeConnection(const std::string &channel) const {
+    auto conn = redisConnect(host_.c_str(), port_);
+    if (conn == nullptr || conn->err) {
+        redisFree(conn);
+        return nullptr;
+    }
+
+    auto reply = static_cast<redisReply *>(redisCommand(conn, "AUTH %s", password_.c_str()));
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR) {
+        std::cout << "RedisMgr::subscribe: AUTH failed" << std::endl;
+        freeReplyObject(reply);
+        redisFree(conn);
+        return nullptr;
+    }
+    freeReplyObject(reply);
+
+    reply = static_cast<redisReply *>(redisCommand(conn, "SUBSCRIBE %b", channel.data(), channel.size()));
+    if (reply == nullptr || reply->type != REDIS_REPLY_ARRAY) {
+        std::cout << "RedisMgr::subscribe: SUBSCRIBE [" << channel << "] failed" << std::endl;
+        freeReplyObject(reply);
+        redisFree(conn);
+        return nullptr;
+    }
+    freeReplyObject(reply);
+    return conn;
+}
+
+void RedisMgr::subscribeLoop(const std::string &channel, const redisSubscribeCallback &callback,
+    const redisResubscribeCallback &onSubscribed) const {
+    constexpr int POLL_TIMEOUT_MS = 1000;
+    while (!subStop_.load()) {
+        const auto conn = createSubscribeConnection(channel);
+        if (conn == nullptr) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MS));
+            continue;
+        }
+        Defer defer([conn] {
+            redisFree(conn);
+        });
+        std::cout << "RedisMgr::subscribe: [" << channel << "] subscribed" << std::endl;
+        if (onSubscribed) {
+            onSubscribed();
+        }
+
+        // 用 poll 限时等待，保证停止标记能被及时检查，不依赖 socket 超时（超时后 hiredis 上下文不可复用）
+        while (!subStop_.load()) {
+            pollfd pfd{conn->fd, POLLIN, 0};
+            const int ret = poll(&pfd, 1, POLL_TIMEOUT_MS);
+            if (ret == 0 || (ret < 0 && errno == EINTR)) {
+                continue;
+            }
+            if (ret < 0 || redisBufferRead(conn) != REDIS_OK) {
+                std::cout << "RedisMgr::subscribe: [" << channel << "] connection lost, reconnecting" << std::endl;
+                break;
+            }
+
+            void* raw = nullptr;
+            while (redisGetReplyFromReader(conn, &raw) == REDIS_OK && raw != nullptr) {
+                const auto reply = static_cast<redisReply *>(raw);
+                // 推送格式: ["message", channel, payload]
+                if (reply->type == REDIS_REPLY_ARRAY && reply->elements == 3
+                    && reply->element[0]->type == REDIS_REPLY_STRING
+                    && strcmp(reply->element[0]->str, "message") == 0
+                    && reply->element[2]->type == REDIS_REPLY_STRING) {
+                    callback(std::string(reply->element[2]->str, reply->element[2]->len));
+                }
+                freeReplyObject(reply);
+                raw = nullptr;
+            }
+            if (conn->err) {
+                break;
+            }
+        }
+    }
+}
+
 void RedisMgr::close() const {
+    subStop_.store(true);
     redisPool_->close();
 }
 
-RedisMgr::RedisMgr() {
+RedisMgr::RedisMgr() : subStop_(false) {
     auto& config = ConfigMgr::getInstance();
     size_t poolSize = DEFAULT_REDIS_POOL_SIZE;
     if (!config["Redis"]["PoolSize"].empty()) {
         poolSize = std::stoi(config["Redis"]["PoolSize"]);
     }
 
-    const std::string host = config["Redis"]["Host"];
-    int port = std::stoi(config["Redis"]["Port"]);
-    const std::string password = config["Redis"]["Password"];
-    redisPool_ = std::make_unique<RedisPool>(poolSize, host.c_str(), port, password.c_str());
+    host_ = config["Redis"]["Host"];
+    port_ = std::stoi(config["Redis"]["Port"]);
+    password_ = config["Redis"]["Password"];
+    redisPool_ = std::make_unique<RedisPool>(poolSize, host_.c_str(), port_, password_.c_str());
 }
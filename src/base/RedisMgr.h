@@ -10,6 +10,10 @@
 #include <condition_variable>
 #include <queue>
 #include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <unordered_map>
 #include <unordered_set>
 #include <hiredis/hiredis.h>
 
@@ -22,10 +26,19 @@
 #define USER_ONLINE_TOKEN "token"
 #define USER_SESSION_ID "session_id"
 #define LOGIN_COUNT "login_chat_server_count"
+// 用户路由变更通知频道，消息体为 uid
+#define USER_ROUTE_CHANNEL "user_route_changed"
+// 群成员变更通知频道，消息体为 conv_id
+#define GROUP_MEMBER_CHANNEL "group_member_changed"
 // 用户状态
 #define USER_COUNTER_PREFIX "user_counter_"     // 用户状态计数
 // 好友申请
 #define FRIEND_APPLY_PREFIX "friend_apply_"
+// 离线收件箱（Stream），用户不在线或投递失败时写入
+#define USER_INBOX_PREFIX "user_inbox_"
+// 登录 token 吊销列表（有序集合，score 为过期时间毫秒）及其变更通知频道，消息体为列表成员
+#define TOKEN_REVOKE_KEY "token_revoked"
+#define TOKEN_REVOKE_CHANNEL "token_revoked_changed"
 
 // 聊天会话缓存
 #define CHAT_CONVER_PREFIX "chat_conver_"
@@ -43,10 +56,14 @@ public:
     ~RedisPool();
     redisContext* getConnection();
     void returnConnection(redisContext* c);
+    /// 流水线中途失败的连接还有未发送的命令或未读取的回复，不能再复用：释放并补充一条新连接
+    void discardConnection(redisContext* c);
     void close();
 
 private:
     void createPool();
+    /// 建立一条已认证的连接，失败返回 nullptr
+    redisContext* connect() const;
     void recreatePool();
     void checkConnection();
 
@@ -62,6 +79,17 @@ private:
     std::thread thread_;
 };
 
+/**
+ * @brief Stream 条目，id 为 Redis 生成的 "毫秒时间戳-序号"
+ */
+struct RedisStreamEntry {
+    std::string id;
+    std::unordered_map<std::string, std::string> fields;
+};
+
+typedef std::function<void(const std::string& message)> redisSubscribeCallback;
+typedef std::function<void()> redisResubscribeCallback;
+
 class RedisMgr : public Singleton<RedisMgr> {
 public:
     ~RedisMgr();
@@ -85,16 +113,57 @@ public:
     bool hDel(const std::string& key, const std::string & hKey);
     std::string hGet(const std::string& key, const std::string& hKey);
     std::unordered_map<std::string, std::string> hGetAll(const std::string& key) const;
+    /// 流水线批量读取多个哈希的同一字段，结果与 keys 一一对应，不存在或失败为空串
+    std::vector<std::string> hGetPipeline(const std::vector<std::string>& keys, const std::string& hKey) const;
     // 有序集合
     bool zSet(const std::string& key, long long score, const std::string& value);
     bool zRevrange(const std::string& key, std::vector<std::string>& values, int start, int end);
+    /// ZRANGEBYSCORE key min max，返回分值在 [min, max] 内的成员
+    bool zRangeByScore(const std::string& key, long long min, long long max, std::vector<std::string>& values) const;
     bool zRem(const std::string& key, const std::string& value);
+    // 流
+    /**
+     * @brief 流水线向多个 Stream 追加同一条目，只有一次网络往返。
+     *
+     * 每个 key 依次执行 XADD（MAXLEN ~ maxLen）、XTRIM MINID ~ 早于 maxAgeSec 的条目、EXPIRE maxAgeSec，
+     * 条数和时长两个上限都近似裁剪。MINID 需要 Redis 6.2 及以上。
+     */
+    bool xAddPipeline(const std::vector<std::string>& keys,
+        const std::vector<std::pair<std::string, std::string>>& fields, size_t maxLen, int maxAgeSec) const;
+    /// XRANGE key start + COUNT count，start 为 "-" 时从头读取
+    bool xRange(const std::string& key, const std::string& start, size_t count,
+        std::vector<RedisStreamEntry>& entries) const;
+    /// 删除 id 小于 minId 的条目
+    bool xTrimMinId(const std::string& key, const std::string& minId) const;
+
+    /**
+     * @brief 流水线执行多条命令，只有一次网络往返。
+     * @return 全部命令发送并读到回复，且没有错误回复时返回 true
+     */
+    bool pipeline(const std::vector<std::vector<std::string>>& commands) const;
+    /**
+     * @brief 同上，并按命令顺序返回回复：数组回复按元素展开，整数转为字符串；空回复为空数组，数组中的空元素为空串。
+     * @return 全部回复读取成功且没有错误回复时返回 true，错误回复对应的结果为空
+     */
+    bool pipeline(const std::vector<std::vector<std::string>>& commands,
+        std::vector<std::vector<std::string>>& replies) const;
 
     bool del(const std::string& key) const;
     bool existsKey(const std::string& key) const;
     bool setExpire(const std::string& key, int expire) const;
     bool clearExpire(const std::string& key) const;
 
+    // 发布订阅
+    bool publish(const std::string& channel, const std::string& message) const;
+    /**
+     * @brief 订阅频道，使用独立连接和后台线程接收消息。
+     *
+     * 连接断开后自动重连并重新订阅，每次（重新）订阅成功后调用 onSubscribed，
+     * 订阅方可在回调中丢弃断连期间可能错过通知的本地状态。
+     */
+    void subscribe(const std::string& channel, const redisSubscribeCallback& callback,
+        const redisResubscribeCallback& onSubscribed = nullptr);
+
     std::string acquireLock(const std::string& name, int timeout, int acquireTimeout) const;
     bool releaseLock(const std::string& name, const std::string& identifier) const;
 
@@ -105,7 +174,19 @@ private:
     friend class Singleton<RedisMgr>;
     RedisMgr();
 
+    void subscribeLoop(const std::string& channel, const redisSubscribeCallback& callback,
+        const redisResubscribeCallback& onSubscribed) const;
+    redisContext* createSubscribeConnection(const std::string& channel) const;
+
     std::unique_ptr<RedisPool> redisPool_;
+
+    std::string host_;
+    std::string password_;
+    int port_ = 0;
+
+    mutable std::atomic<bool> subStop_;
+    std::mutex subMutex_;
+    std::vector<std::thread> subThreads_;
 };
 
 
@@ -0,0 +1,186 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "TokenAuth.h"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include "RedisMgr.h"
+
+namespace {
+constexpr int64_t REVOKE_SWEEP_INTERVAL_MS = 60000;
+}
+
+TokenAuth::TokenAuth()
+    : signer_(TokenSigner::fromConfig()), started_(false), verified_(0), rejected_(0) {
+}
+
+void TokenAuth::start() {
+    if (started_.exchange(true)) {
+        return;
+    }
+    // 断连期间的吊销通知可能丢失，（重新）订阅成功后从 Redis 加载全部未过期的吊销项
+    RedisMgr::getInstance()->subscribe(TOKEN_REVOKE_CHANNEL,
+        [this](const std::string& message) {
+            applyEntry(message);
+        },
+        [this]() {
+            reload();
+        });
+}
+
+std::string TokenAuth::issue(const int uid) const {
+    return signer_->sign(uid);
+}
+
+bool TokenAuth::verify(const int uid, const std::string &token) const {
+    TokenSigner::Claims claims;
+    if (const auto result = signer_->verify(token, claims); result != TokenSigner::Result::OK) {
+        std::cout << "Token [uid: " << uid << "] verify failed, result: " << static_cast<int>(result) << std::endl;
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (claims.uid != uid || isRevoked(claims)) {
+        std::cout << "Token [uid: " << uid << "] mismatch or revoked" << std::endl;
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    verified_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool TokenAuth::revoke(const std::string &token) {
+    TokenSigner::Claims claims;
+    if (signer_->verify(token, claims) != TokenSigner::Result::OK) {
+        // 无效或已过期的 token 本身不能通过校验
+        return true;
+    }
+    return publishRevoke("n:" + claims.nonce + ":" + std::to_string(claims.expireAt), claims.expireAt);
+}
+
+bool TokenAuth::revokeUser(const int uid) {
+    return revokeUserBefore(uid, TokenSigner::nowMs());
+}
+
+bool TokenAuth::revokeOlder(const std::string &token) {
+    TokenSigner::Claims claims;
+    if (signer_->verify(token, claims) != TokenSigner::Result::OK) {
+        return false;
+    }
+    // 不含该 token 自身，同一 token 断线重连不受影响
+    return revokeUserBefore(claims.uid, claims.issuedAt - 1);
+}
+
+void TokenAuth::printMetrics() const {
+    size_t tokens = 0;
+    size_t users = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tokens = revokedTokens_.size();
+        users = revokedUsers_.size();
+    }
+    std::cout << "[token] verified=" << verified_.load(std::memory_order_relaxed)
+              << " rejected=" << rejected_.load(std::memory_order_relaxed)
+              << " revoked_tokens=" << tokens
+              << " revoked_users=" << users << std::endl;
+}
+
+bool TokenAuth::isRevoked(const TokenSigner::Claims &claims) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (revokedTokens_.empty() && revokedUsers_.empty()) {
+        return false;
+    }
+    if (revokedTokens_.count(claims.nonce) > 0) {
+        return true;
+    }
+    const auto it = revokedUsers_.find(claims.uid);
+    return it != revokedUsers_.end() && claims.issuedAt <= it->second.first;
+}
+
+bool TokenAuth::revokeUserBefore(const int uid, const int64_t before) {
+    // 此刻之前签发的 token 最晚在一个有效期后全部过期
+    const int64_t expireAt = TokenSigner::nowMs()
+        + std::chrono::duration_cast<std::chrono::milliseconds>(signer_->ttl()).count();
+    return publishRevoke("u:" + std::to_string(uid) + ":" + std::to_string(before) + ":" + std::to_string(expireAt),
+        expireAt);
+}
+
+bool TokenAuth::publishRevoke(const std::string &entry, const int64_t expireAt) {
+    applyEntry(entry);
+    // 写入吊销列表、清理已过期项并广播，一次往返
+    const auto now = std::to_string(TokenSigner::nowMs());
+    return RedisMgr::getInstance()->pipeline({
+        {"ZADD", TOKEN_REVOKE_KEY, std::to_string(expireAt), entry},
+        {"ZREMRANGEBYSCORE", TOKEN_REVOKE_KEY, "-inf", now},
+        {"PUBLISH", TOKEN_REVOKE_CHANNEL, entry},
+    });
+}
+
+void TokenAuth::applyEntry(const std::string &entry) {
+    std::vector<std::string> parts;
+    std::stringstream ss(entry);
+    std::string part;
+    while (std::getline(ss, part, ':')) {
+        parts.push_back(part);
+    }
+
+    const int64_t now = TokenSigner::nowMs();
+    try {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (parts.size() == 3 && parts[0] == "n") {
+            const int64_t expireAt = std::stoll(parts[2]);
+            if (expireAt > now) {
+                revokedTokens_[parts[1]] = expireAt;
+            }
+        }
+        else if (parts.size() == 4 && parts[0] == "u") {
+            const int uid = std::stoi(parts[1]);
+            const int64_t before = std::stoll(parts[2]);
+            const int64_t expireAt = std::stoll(parts[3]);
+            if (expireAt > now) {
+                auto& [revokedBefore, revokedExpire] = revokedUsers_[uid];
+                revokedBefore = std::max(revokedBefore, before);
+                revokedExpire = std::max(revokedExpire, expireAt);
+            }
+        }
+        else {
+            std::cout << "TokenAuth: invalid revoke entry [" << entry << "]" << std::endl;
+            return;
+        }
+        sweepLocked(now);
+    } catch (...) {
+        std::cout << "TokenAuth: invalid revoke entry [" << entry << "]" << std::endl;
+    }
+}
+
+void TokenAuth::reload() {
+    std::vector<std::string> entries;
+    if (!RedisMgr::getInstance()->zRangeByScore(TOKEN_REVOKE_KEY, TokenSigner::nowMs(), LLONG_MAX, entries)) {
+        std::cout << "TokenAuth: load revoke list failed" << std::endl;
+        return;
+    }
+    // 吊销不可撤销，只需补齐断连期间错过的项，本地已有的项随过期清理
+    for (const auto& entry : entries) {
+        applyEntry(entry);
+    }
+    std::cout << "TokenAuth: loaded " << entries.size() << " revoke entries" << std::endl;
+}
+
+void TokenAuth::sweepLocked(const int64_t nowMs) {
+    if (nowMs - lastSweep_ < REVOKE_SWEEP_INTERVAL_MS) {
+        return;
+    }
+    lastSweep_ = nowMs;
+    for (auto it = revokedTokens_.begin(); it != revokedTokens_.end();) {
+        it = it->second <= nowMs ? revokedTokens_.erase(it) : std::next(it);
+    }
+    for (auto it = revokedUsers_.begin(); it != revokedUsers_.end();) {
+        it = it->second.second <= nowMs ? revokedUsers_.erase(it) : std::next(it);
+    }
+}
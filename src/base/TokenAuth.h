@@ -0,0 +1,75 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_TOKENAUTH_H
+#define IMSERVER_TOKENAUTH_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Singleton.h"
+#include "TokenSigner.h"
+
+/**
+ * @brief 登录 token 的签发与本地校验。
+ *
+ * StatusServer 签发，ChatServer / ResourceServer 用同一组密钥本地验签，登录和资源请求不再访问
+ * StatusServer 和 Redis。token 在过期前始终有效，需要提前失效时写入吊销列表：
+ *   - Redis 有序集合 TOKEN_REVOKE_KEY 保存全部未过期的吊销项，（重新）订阅成功后整表加载；
+ *   - 新增吊销项通过 TOKEN_REVOKE_CHANNEL 广播，各服务更新本地表。
+ * 吊销项在对应 token 过期后即无意义，随过期清理，列表规模与有效期内的吊销次数相当。
+ */
+class TokenAuth : public Singleton<TokenAuth> {
+public:
+    ~TokenAuth() = default;
+
+    /// 订阅吊销通知，需要本地校验 token 的服务启动时调用
+    void start();
+
+    /// 签发 token，密钥未配置时返回空串
+    std::string issue(int uid) const;
+    /// 校验签名、有效期、uid 以及吊销列表
+    bool verify(int uid, const std::string& token) const;
+
+    /// 吊销单个 token
+    bool revoke(const std::string& token);
+    /// 吊销用户当前时刻之前签发的全部 token
+    bool revokeUser(int uid);
+    /// 吊销同一用户在该 token 之前签发的全部 token，顶号登录后旧客户端不能再用原 token 登录
+    bool revokeOlder(const std::string& token);
+
+    void printMetrics() const;
+
+private:
+    friend class Singleton<TokenAuth>;
+    friend class TokenAuthTest;
+    TokenAuth();
+
+    bool isRevoked(const TokenSigner::Claims& claims) const;
+    /// 吊销 uid 在 before（含）之前签发的 token
+    bool revokeUserBefore(int uid, int64_t before);
+    bool publishRevoke(const std::string& entry, int64_t expireAt);
+    /// 解析吊销项并加入本地表："n:<nonce>:<exp>" 或 "u:<uid>:<before>:<exp>"
+    void applyEntry(const std::string& entry);
+    void reload();
+    void sweepLocked(int64_t nowMs);
+
+    std::unique_ptr<TokenSigner> signer_;
+    std::atomic<bool> started_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, int64_t> revokedTokens_;               ///< nonce -> 过期时间
+    std::unordered_map<int, std::pair<int64_t, int64_t>> revokedUsers_;    ///< uid -> (吊销时刻, 过期时间)
+    int64_t lastSweep_ = 0;
+
+    mutable std::atomic<uint64_t> verified_;
+    mutable std::atomic<uint64_t> rejected_;
+};
+
+
+#endif //IMSERVER_TOKENAUTH_H
@@ -0,0 +1,167 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "TokenSigner.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include "ConfigMgr.h"
+
+namespace {
+constexpr int DEFAULT_TOKEN_TTL_SEC = 86400;
+constexpr size_t TOKEN_NONCE_BYTES = 8;
+constexpr size_t TOKEN_PARTS = 6;
+// 仓库中配置文件的占位密钥，部署时必须替换
+constexpr const char* TOKEN_KEY_PLACEHOLDER = "CHANGE_ME";
+
+std::string toHex(const unsigned char* data, const size_t len) {
+    std::ostringstream oss;
+    oss << std::hex << std::setfill('0');
+    for (size_t i = 0; i < len; i++) {
+        oss << std::setw(2) << static_cast<int>(data[i]);
+    }
+    return oss.str();
+}
+
+std::vector<std::string> split(const std::string& str, const char delim) {
+    std::vector<std::string> parts;
+    std::stringstream ss(str);
+    std::string part;
+    while (std::getline(ss, part, delim)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+}
+
+TokenSigner::TokenSigner(std::unordered_map<std::string, std::string> keys, std::string activeKid,
+    const std::chrono::seconds ttl)
+    : keys_(std::move(keys)), activeKid_(std::move(activeKid)), ttl_(ttl) {
+}
+
+std::unique_ptr<TokenSigner> TokenSigner::fromConfig() {
+    auto& config = ConfigMgr::getInstance();
+    std::unordered_map<std::string, std::string> keys;
+    for (const auto& item : split(config["Token"]["Keys"], ',')) {
+        const auto pos = item.find(':');
+        if (pos == std::string::npos || pos == 0 || pos + 1 == item.size()) {
+            continue;
+        }
+        // kid 作为 token 的一段，不能包含分隔符
+        const auto kid = item.substr(0, pos);
+        if (kid.find('.') != std::string::npos) {
+            continue;
+        }
+        auto secret = item.substr(pos + 1);
+        if (secret == TOKEN_KEY_PLACEHOLDER) {
+            std::cout << "TokenSigner: key [" << kid << "] is a placeholder, set a secret in [Token] Keys" << std::endl;
+            continue;
+        }
+        keys[kid] = std::move(secret);
+    }
+
+    auto activeKid = config["Token"]["ActiveKid"];
+    if (activeKid.empty() && keys.size() == 1) {
+        activeKid = keys.begin()->first;
+    }
+    std::chrono::seconds ttl(DEFAULT_TOKEN_TTL_SEC);
+    if (!config["Token"]["TtlSec"].empty()) {
+        ttl = std::chrono::seconds(std::stoi(config["Token"]["TtlSec"]));
+    }
+
+    auto signer = std::make_unique<TokenSigner>(std::move(keys), activeKid, ttl);
+    if (!signer->valid()) {
+        std::cout << "TokenSigner: active key [" << activeKid << "] not configured in [Token] Keys" << std::endl;
+    }
+    return signer;
+}
+
+std::string TokenSigner::sign(const int uid) const {
+    return sign(uid, nowMs());
+}
+
+std::string TokenSigner::sign(const int uid, const int64_t nowMs) const {
+    const auto it = keys_.find(activeKid_);
+    if (it == keys_.end()) {
+        return "";
+    }
+    // 随机源不可用时不签发，nonce 可预测的 token 无法按 token 吊销
+    const auto nonce = randomHex(TOKEN_NONCE_BYTES);
+    if (nonce.empty()) {
+        std::cout << "TokenSigner: RAND_bytes failed, token not issued" << std::endl;
+        return "";
+    }
+    const int64_t expireAt = nowMs + std::chrono::duration_cast<std::chrono::milliseconds>(ttl_).count();
+    const std::string payload = activeKid_ + "." + std::to_string(uid) + "." + std::to_string(nowMs)
+        + "." + std::to_string(expireAt) + "." + nonce;
+    return payload + "." + hmacHex(it->second, payload);
+}
+
+TokenSigner::Result TokenSigner::verify(const std::string &token, Claims &claims) const {
+    return verify(token, nowMs(), claims);
+}
+
+TokenSigner::Result TokenSigner::verify(const std::string &token, const int64_t nowMs, Claims &claims) const {
+    const auto parts = split(token, '.');
+    if (parts.size() != TOKEN_PARTS || token.back() == '.') {
+        return Result::MALFORMED;
+    }
+
+    const auto it = keys_.find(parts[0]);
+    if (it == keys_.end()) {
+        return Result::UNKNOWN_KEY;
+    }
+
+    // 签名覆盖最后一个分隔符之前的全部内容
+    const auto payload = token.substr(0, token.size() - parts[5].size() - 1);
+    const auto expect = hmacHex(it->second, payload);
+    if (expect.size() != parts[5].size()
+        || CRYPTO_memcmp(expect.data(), parts[5].data(), expect.size()) != 0) {
+        return Result::BAD_SIGNATURE;
+    }
+
+    try {
+        claims.kid = parts[0];
+        claims.uid = std::stoi(parts[1]);
+        claims.issuedAt = std::stoll(parts[2]);
+        claims.expireAt = std::stoll(parts[3]);
+        claims.nonce = parts[4];
+    } catch (...) {
+        return Result::MALFORMED;
+    }
+
+    if (claims.expireAt <= nowMs) {
+        return Result::EXPIRED;
+    }
+    return Result::OK;
+}
+
+int64_t TokenSigner::nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string TokenSigner::hmacHex(const std::string &key, const std::string &data) {
+    unsigned char buf[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+        reinterpret_cast<const unsigned char*>(data.data()), data.size(), buf, &len);
+    return toHex(buf, len);
+}
+
+std::string TokenSigner::randomHex(const size_t bytes) {
+    std::vector<unsigned char> buf(bytes);
+    if (RAND_bytes(buf.data(), static_cast<int>(buf.size())) != 1) {
+        return "";
+    }
+    return toHex(buf.data(), buf.size());
+}
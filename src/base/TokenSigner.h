@@ -0,0 +1,76 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_TOKENSIGNER_H
+#define IMSERVER_TOKENSIGNER_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief HMAC-SHA256 签名的登录 token，持有密钥的服务可本地校验，不需要查询 StatusServer。
+ *
+ * 格式：kid.uid.iat.exp.nonce.sig
+ *   - kid：签名密钥编号，轮换密钥时旧 kid 保留在 Keys 中，已签发的 token 仍可校验；
+ *   - iat / exp：签发时间和过期时间，单位毫秒；
+ *   - nonce：随机数，用于按 token 吊销；
+ *   - sig：前五段拼接后的 HMAC-SHA256，十六进制。
+ */
+class TokenSigner {
+public:
+    struct Claims {
+        std::string kid;
+        int uid = 0;
+        int64_t issuedAt = 0;   ///< 毫秒
+        int64_t expireAt = 0;   ///< 毫秒
+        std::string nonce;
+    };
+
+    enum class Result {
+        OK = 0,
+        MALFORMED = 1,
+        UNKNOWN_KEY = 2,
+        BAD_SIGNATURE = 3,
+        EXPIRED = 4,
+    };
+
+    /**
+     * @param keys      kid -> 密钥
+     * @param activeKid 签发使用的 kid，必须在 keys 中
+     * @param ttl       token 有效期
+     */
+    TokenSigner(std::unordered_map<std::string, std::string> keys, std::string activeKid,
+        std::chrono::seconds ttl);
+
+    /// 从配置 [Token] 段读取：Keys = kid:secret,kid:secret，ActiveKid，TtlSec
+    static std::unique_ptr<TokenSigner> fromConfig();
+
+    /// 签发 token，密钥未配置时返回空串
+    std::string sign(int uid) const;
+    std::string sign(int uid, int64_t nowMs) const;
+
+    /// 校验签名和有效期，成功时填充 claims
+    Result verify(const std::string& token, Claims& claims) const;
+    Result verify(const std::string& token, int64_t nowMs, Claims& claims) const;
+
+    bool valid() const { return keys_.count(activeKid_) > 0; }
+    std::chrono::seconds ttl() const { return ttl_; }
+
+    static int64_t nowMs();
+
+private:
+    static std::string hmacHex(const std::string& key, const std::string& data);
+    /// 随机源失败时返回空串
+    static std::string randomHex(size_t bytes);
+
+    std::unordered_map<std::string, std::string> keys_;
+    std::string activeKid_;
+    std::chrono::seconds ttl_;
+};
+
+
+#endif //IMSERVER_TOKENSIGNER_H
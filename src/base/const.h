@@ -23,6 +23,7 @@ using tcp = boost::asio::ip::tcp;
 constexpr int DEFAULT_RPC_POOL_SIZE = 10;
 constexpr int DEFAULT_REDIS_POOL_SIZE = 5;
 constexpr int DEFAULT_MYSQL_POOL_SIZE = 5;
+constexpr size_t MYSQL_STMT_CACHE_SIZE = 128;   // 每个 MySQL 连接缓存的预处理语句上限
 
 constexpr int HEAD_TOTAL_LEN = 4;
 constexpr int HEAD_MSG_ID_LEN = 2;
@@ -45,6 +46,7 @@ enum class ErrorCodes : int32_t {
     VERIFY_CODE_EXPIRED = 2001,
     VERIFY_CODE_NOT_REACHED = 2002,
     CONV_CREATE_NO_PERMISSION = 2003,
+    GROUP_NO_PERMISSION = 2004,
 
     // 业务逻辑错误
     USER_EXISTS = 3001,
@@ -57,10 +59,16 @@ enum class ErrorCodes : int32_t {
     FRIEND_NOT_EXISTS = 3102,
     // 聊天消息相关
     CHAT_MSG_NOT_EXISTS = 3201,
+    CHAT_MSG_BUSY = 3202,           // 消息写入积压超过内存上限，按 retry_after_ms 延迟重发
+    // 群聊相关
+    GROUP_NOT_EXISTS = 3301,
+    GROUP_NOT_MEMBER = 3302,
+    GROUP_MEMBER_LIMIT = 3303,
 
     // 系统错误
     CHAT_LOGIN_TOKEN_ERROR = 4001,
     CHAT_LOGIN_UID_ERROR = 4002,
+    CHAT_LOGIN_BUSY = 4003,         // 登录过载，按 retry_after_ms 延迟重试
 
     // 资源服务器错误
     RESOURCE_AUTH_FAILED    = 5001,   // Token 无效/过期/uid 不匹配
@@ -79,6 +87,8 @@ enum class MessageID : uint16_t {
     ID_USER_LOGIN = 1004, // 登录用户
     ID_CHAT_LOGIN = 1005, // 登录聊天服务器
     ID_CHAT_LOGIN_RSP = 1006, // 登录聊天服务器响应
+    ID_CHAT_LOGOUT_REQ = 1007, // 登出，吊销当前 token
+    ID_CHAT_LOGOUT_RSP = 1008,
 
     ID_FIRST_PAGE_REQ = 1101, // 主页页面信息
     ID_FIRST_PAGE_RSP = 1102, // 主页页面信息
@@ -113,6 +123,7 @@ enum class MessageID : uint16_t {
     ID_CHAT_DOWNLOAD_FILE_REQ = 3006, // 下载文件请求
     ID_CHAT_DOWNLOAD_FILE_RSP = 3007, // 下载文件响应
     ID_NOTIFY_MSG_RESULT = 3008, // 异步写入成功后 serverId 映射推送
+    ID_NOTIFY_MSG_STATUS = 3009, // 推送对方已读/已送达水位
 
     ID_CHAT_CONVERSATION_REQ = 4001, // 会话创建请求
     ID_CHAT_CONVERSATION_RSP = 4002, // 会话创建响应
@@ -122,6 +133,14 @@ enum class MessageID : uint16_t {
     ID_CONV_LIST_RSP = 4006,
     ID_CONV_MSG_UPDATE_STATUS_REQ = 4007, // 会话消息更新状态
     ID_CONV_MSG_UPDATE_STATUS_RSP = 4008,
+    ID_GROUP_CREATE_REQ = 4009, // 创建群聊
+    ID_GROUP_CREATE_RSP = 4010,
+    ID_GROUP_MEMBER_UPDATE_REQ = 4011, // 群成员变更（邀请/退出/移除）
+    ID_GROUP_MEMBER_UPDATE_RSP = 4012,
+    ID_INBOX_SYNC_REQ = 4013, // 离线收件箱同步
+    ID_INBOX_SYNC_RSP = 4014,
+    ID_MSG_SEARCH_REQ = 4015, // 聊天记录全文搜索
+    ID_MSG_SEARCH_RSP = 4016,
 
     ID_NOTIFY_OFFLINE = 5001, // 通知客户端离线
     ID_HEART_BEAT_REQ = 5002, // PING
@@ -172,6 +191,23 @@ inline std::string ms_to_datetime(const long long timestamp_ms)
     return {buf};
 }
 
+/// "YYYY-MM-DD HH:MM:SS" 本地时间 → 毫秒时间戳，格式不合法（如 MySQL 零值日期）返回 0
+inline long long datetime_to_ms(const std::string& datetime)
+{
+    tm time_info{};
+    if (sscanf(datetime.c_str(), "%d-%d-%d %d:%d:%d",
+               &time_info.tm_year, &time_info.tm_mon, &time_info.tm_mday,
+               &time_info.tm_hour, &time_info.tm_min, &time_info.tm_sec) != 6
+        || time_info.tm_year < 1970 || time_info.tm_mon < 1 || time_info.tm_mday < 1) {
+        return 0;
+    }
+    time_info.tm_year -= 1900;
+    time_info.tm_mon -= 1;
+    time_info.tm_isdst = -1;
+    const time_t sec = mktime(&time_info);
+    return sec < 0 ? 0 : static_cast<long long>(sec) * 1000;
+}
+
 inline std::string base64_decode(const std::string& base64_str)
 {
     using namespace boost::archive::iterators;
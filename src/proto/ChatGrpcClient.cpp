@@ -3,6 +3,9 @@
 //
 
 #include "ChatGrpcClient.h"
+
+#include <iomanip>
+
 #include "ConfigMgr.h"
 #include "const.h"
 
@@ -10,13 +13,24 @@ ChatGrpcClient::ChatGrpcClient() {
     auto& config = ConfigMgr::getInstance();
     size_t size = DEFAULT_RPC_POOL_SIZE;
     if (!config["ChatServer"]["RPCConnPoolSize"].empty()) {
-        size = std::stoi(config["GateServer"]["RPCConnPoolSize"]);
+        size = std::stoi(config["ChatServer"]["RPCConnPoolSize"]);
     }
 
     if (config["PeerChatServers"]["Servers"].empty()) {
         return;
     }
 
+    // 服务器间投递流配置
+    const bool streamEnabled = config["ChatServer"]["PeerStreamEnabled"] != "false";
+    PeerDeliveryStream::Options options;
+    if (!config["ChatServer"]["PeerBatchSize"].empty()) {
+        options.maxBatchSize = std::stoul(config["ChatServer"]["PeerBatchSize"]);
+    }
+    if (!config["ChatServer"]["PeerFlushIntervalUs"].empty()) {
+        options.flushInterval = std::chrono::microseconds(std::stoi(config["ChatServer"]["PeerFlushIntervalUs"]));
+    }
+    const auto selfName = config["ChatServer"]["Name"];
+
     auto services = config["PeerChatServers"]["Servers"];
     std::string service;
     std::stringstream ss(services);
@@ -24,118 +38,169 @@ ChatGrpcClient::ChatGrpcClient() {
         if (config[service]["Name"].empty()) {
             continue;
         }
+        // 对端 gRPC 服务监听在 RPCPort，Port 是客户端 TCP 端口
         auto host = config[service]["Host"];
-        auto port = config[service]["Port"];
+        auto port = config[service]["RPCPort"].empty() ? config[service]["Port"] : config[service]["RPCPort"];
         auto pool = std::make_unique<ServiceConnPool<ChatService>>(size, host, port);
         pools_.insert({config[service]["Name"], std::move(pool)});
+
+        if (streamEnabled) {
+            const auto channel = grpc::CreateChannel(host + ":" + port, grpc::InsecureChannelCredentials());
+            streams_.insert({config[service]["Name"],
+                std::make_unique<PeerDeliveryStream>(channel, config[service]["Name"], selfName, options)});
+        }
     }
+    lastStatsTime_ = std::chrono::steady_clock::now();
 }
 
 ChatServiceRsp ChatGrpcClient::NotifyAddFriend(const std::string &serviceName, const ChatServiceReq &request) {
-    ClientContext context;
-    ChatServiceRsp reply;
-
-    if (pools_.find(serviceName) == pools_.end()) {
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
-    }
-    auto stub = pools_[serviceName]->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
-    }
-
-    Defer defer([this, &stub, &serviceName] () {
-        pools_[serviceName]->returnConnection(std::move(stub));
+    return callPeer(serviceName, "NotifyAddFriend", [&request](ChatAsyncStub* stub, ClientContext* context,
+        ChatServiceRsp* response, const ChatCallback& done) {
+        stub->NotifyAddFriend(context, &request, response, done);
     });
-
-    if (const auto status = stub->NotifyAddFriend(&context, request, &reply); status.ok()) {
-        std::cout << "RPC NotifyAddFriend success" << std::endl;
-        return reply;
-    }
-
-    reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-    return reply;
 }
 
 ChatServiceRsp ChatGrpcClient::NotifyAuthFriend(const std::string &serviceName, const ChatServiceReq &request) {
-    ClientContext context;
-    ChatServiceRsp reply;
+    return callPeer(serviceName, "NotifyAuthFriend", [&request](ChatAsyncStub* stub, ClientContext* context,
+        ChatServiceRsp* response, const ChatCallback& done) {
+        stub->NotifyAuthFriend(context, &request, response, done);
+    });
+}
 
-    if (pools_.find(serviceName) == pools_.end()) {
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
-    }
-    auto stub = pools_[serviceName]->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
+ChatServiceRsp ChatGrpcClient::SendChatMsg(const std::string &serviceName, const ChatServiceReq &request) {
+    return callPeer(serviceName, "SendChatMsg", [&request](ChatAsyncStub* stub, ClientContext* context,
+        ChatServiceRsp* response, const ChatCallback& done) {
+        stub->SendChatMsg(context, &request, response, done);
+    });
+}
+
+void ChatGrpcClient::SendChatMsgAsync(const std::string &serviceName, const ChatServiceReq &request,
+    const failedCallback &onFailed) {
+    const auto it = pools_.find(serviceName);
+    if (it == pools_.end()) {
+        if (onFailed) {
+            onFailed();
+        }
+        return;
     }
+    auto req = std::make_shared<ChatServiceReq>(request);
+    it->second->asyncCall<ChatServiceRsp>([req](ChatAsyncStub* stub, ClientContext* context,
+        ChatServiceRsp* response, const ChatCallback& done) {
+        stub->SendChatMsg(context, req.get(), response, done);
+    }, [req, serviceName, onFailed](const Status& status, const ChatServiceRsp&) {
+        if (!status.ok()) {
+            std::cout << "RPC SendChatMsg to [" << serviceName << "] failed: " << status.error_message() << std::endl;
+            if (onFailed) {
+                onFailed();
+            }
+        }
+    });
+}
 
-    Defer defer([this, &stub, &serviceName] () {
-        pools_[serviceName]->returnConnection(std::move(stub));
+ErrorCodes ChatGrpcClient::NotifyOffline(const std::string &serviceName, const int uid) {
+    ChatServiceReq request;
+    request.set_from_uid(-1);
+    request.set_to_uid(uid);
+    const auto response = callPeer(serviceName, "NotifyOffline", [&request](ChatAsyncStub* stub,
+        ClientContext* context, ChatServiceRsp* rsp, const ChatCallback& done) {
+        stub->NotifyOffline(context, &request, rsp, done);
     });
+    return static_cast<ErrorCodes>(response.error());
+}
 
-    if (const auto status = stub->NotifyAuthFriend(&context, request, &reply); status.ok()) {
-        std::cout << "RPC NotifyAuthFriend success" << std::endl;
-        return reply;
+void ChatGrpcClient::FanOutAsync(const std::string &serviceName, const std::shared_ptr<const FanOutReq> &request,
+    const fanOutCallback &onOffline, const fanOutCallback &onFailed) {
+    const auto it = pools_.find(serviceName);
+    if (it == pools_.end()) {
+        if (onFailed) {
+            onFailed(std::vector<int>(request->to_uids().begin(), request->to_uids().end()));
+        }
+        return;
     }
-
-    reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-    return reply;
+    it->second->asyncCall<FanOutRsp>([request](ChatAsyncStub* stub, ClientContext* context,
+        FanOutRsp* response, const ChatCallback& done) {
+        stub->FanOut(context, request.get(), response, done);
+    }, [request, serviceName, onOffline, onFailed](const Status& status, const FanOutRsp& response) {
+        if (!status.ok()) {
+            std::cout << "RPC FanOut to [" << serviceName << "] failed: " << status.error_message() << std::endl;
+            if (onFailed) {
+                onFailed(std::vector<int>(request->to_uids().begin(), request->to_uids().end()));
+            }
+            return;
+        }
+        if (response.offline_uids_size() > 0 && onOffline) {
+            onOffline(std::vector<int>(response.offline_uids().begin(), response.offline_uids().end()));
+        }
+    });
 }
 
-ChatServiceRsp ChatGrpcClient::SendChatMsg(const std::string &serviceName, const ChatServiceReq &request) {
-    ClientContext context;
+ChatServiceRsp ChatGrpcClient::callPeer(const std::string &serviceName, const char *method,
+    const std::function<void(ChatAsyncStub*, ClientContext*, ChatServiceRsp*, const ChatCallback&)> &invoke) {
     ChatServiceRsp reply;
-
-    if (pools_.find(serviceName) == pools_.end()) {
+    const auto it = pools_.find(serviceName);
+    if (it == pools_.end()) {
         reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
         return reply;
     }
-    auto stub = pools_[serviceName]->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
+    if (const auto status = it->second->call(invoke, reply); !status.ok()) {
+        std::cout << "RPC " << method << " to [" << serviceName << "] failed: " << status.error_message() << std::endl;
         reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
     }
+    return reply;
+}
 
-    Defer defer([this, &stub, &serviceName] () {
-        pools_[serviceName]->returnConnection(std::move(stub));
+bool ChatGrpcClient::DeliverToPeer(const std::string &serviceName, const int toUid, MessageID msgId,
+    const std::string &json) {
+    // 首次投递时启动全部流，保证 offline handler 已设置
+    std::call_once(streamsStarted_, [this]() {
+        for (auto& [name, stream] : streams_) {
+            stream->start();
+        }
     });
-
-    if (const auto status = stub->SendChatMsg(&context, request, &reply); status.ok()) {
-        std::cout << "RPC SendChatMsg success" << std::endl;
-        return reply;
+    const auto it = streams_.find(serviceName);
+    if (it == streams_.end()) {
+        return false;
     }
-
-    reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-    return reply;
+    return it->second->enqueue(toUid, static_cast<uint16_t>(msgId), json);
 }
 
-ErrorCodes ChatGrpcClient::NotifyOffline(const std::string &serviceName, const int uid) {
-    ClientContext context;
-    ChatServiceReq request;
-    ChatServiceRsp response;
-
-    if (pools_.find(serviceName) == pools_.end()) {
-        return ErrorCodes::RPC_FAILED;
-    }
-    auto stub = pools_[serviceName]->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
-        return ErrorCodes::RPC_FAILED;
+void ChatGrpcClient::setPeerOfflineHandler(const PeerDeliveryStream::offlineHandler &handler) {
+    for (auto& [name, stream] : streams_) {
+        stream->setOfflineHandler(handler);
     }
+}
 
-    Defer defer([this, &stub, &serviceName] () {
-        pools_[serviceName]->returnConnection(std::move(stub));
-    });
-
-    request.set_from_uid(-1);
-    request.set_to_uid(uid);
-    stub->NotifyOffline(&context, request, &response);
-    return static_cast<ErrorCodes>(response.error());
+void ChatGrpcClient::printPeerStats() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - lastStatsTime_).count();
+    lastStatsTime_ = now;
+    for (auto& [name, stream] : streams_) {
+        const auto& stats = stream->stats();
+        const uint64_t deliveries = stats.deliveries_sent.load(std::memory_order_relaxed);
+        const uint64_t batches = stats.batches_sent.load(std::memory_order_relaxed);
+        const uint64_t acked = stats.batches_acked.load(std::memory_order_relaxed);
+        const uint64_t delta = deliveries - lastDeliveries_[name];
+        lastDeliveries_[name] = deliveries;
+
+        std::cout << "[peer_stream] peer=" << name
+                  << " connected=" << stream->connected()
+                  << " deliver/s=" << std::fixed << std::setprecision(0) << (elapsed > 0 ? delta / elapsed : 0)
+                  << " avg_batch=" << std::setprecision(1)
+                  << (batches > 0 ? static_cast<double>(deliveries) / batches : 0)
+                  << " avg_ack=" << std::setprecision(0)
+                  << (acked > 0 ? static_cast<double>(stats.ack_latency_us.load(std::memory_order_relaxed)) / acked : 0)
+                  << "us"
+                  << " resent=" << stats.batches_resent.load(std::memory_order_relaxed)
+                  << " rejected=" << stats.rejected.load(std::memory_order_relaxed)
+                  << " offline=" << stats.offline.load(std::memory_order_relaxed)
+                  << " reconnects=" << stats.reconnects.load(std::memory_order_relaxed)
+                  << std::endl;
+    }
 }
 
+void ChatGrpcClient::close() {
+    for (auto& [name, stream] : streams_) {
+        stream->stop();
+    }
+}
@@ -13,6 +13,7 @@
 
 #include "Singleton.h"
 #include "ServiceConnPool.h"
+#include "PeerDeliveryStream.h"
 #include "const.h"
 
 using grpc::Channel;
@@ -22,6 +23,8 @@ using grpc::ClientContext;
 using message::ChatService;
 using message::ChatServiceReq;
 using message::ChatServiceRsp;
+using message::FanOutReq;
+using message::FanOutRsp;
 
 class ChatGrpcClient : public Singleton<ChatGrpcClient> {
 public:
@@ -32,15 +35,55 @@ public:
     ChatServiceRsp NotifyAuthFriend(const std::string& serviceName, const ChatServiceReq &request);
 
     ChatServiceRsp SendChatMsg(const std::string& serviceName, const ChatServiceReq& request);
+    typedef std::function<void()> failedCallback;
+    /**
+     * @brief 不等待结果的聊天消息转发，worker 线程不会被慢对端阻塞
+     * @param onFailed 调用失败（对端不可用/超时/熔断）时回调，调用方可转存离线收件箱
+     */
+    void SendChatMsgAsync(const std::string& serviceName, const ChatServiceReq& request,
+        const failedCallback& onFailed = nullptr);
 
     ErrorCodes NotifyOffline(const std::string& serviceName, int uid);
 
+    typedef std::function<void(const std::vector<int>& offlineUids)> fanOutCallback;
+    /**
+     * @brief 群消息扇出到对端服务器，一次调用携带该服务器上的全部接收方。
+     * @param onOffline 对端回报已不在线的接收方，在 gRPC 线程执行
+     * @param onFailed  调用失败时回调全部接收方
+     */
+    void FanOutAsync(const std::string& serviceName, const std::shared_ptr<const FanOutReq>& request,
+        const fanOutCallback& onOffline, const fanOutCallback& onFailed = nullptr);
+
+    /**
+     * @brief 通过常驻投递流异步推送消息给对端服务器上的用户。
+     * @return false 表示未开启投递流、流未连接或队列已满，调用方应退回单次 RPC
+     */
+    bool DeliverToPeer(const std::string& serviceName, int toUid, MessageID msgId, const std::string& json);
+
+    /// 对端 ACK 报告接收方不在线时的回调，需在首次投递前设置
+    void setPeerOfflineHandler(const PeerDeliveryStream::offlineHandler& handler);
+
+    void printPeerStats();
+
+    void close();
+
 private:
     friend class Singleton<ChatGrpcClient>;
 
     ChatGrpcClient();
 
+    using ChatAsyncStub = ServiceConnPool<ChatService>::AsyncStub;
+    using ChatCallback = ServiceConnPool<ChatService>::Callback;
+
+    ChatServiceRsp callPeer(const std::string& serviceName, const char* method,
+        const std::function<void(ChatAsyncStub*, ClientContext*, ChatServiceRsp*, const ChatCallback&)>& invoke);
+
     std::unordered_map<std::string, ChatServicePool> pools_;
+    std::unordered_map<std::string, std::unique_ptr<PeerDeliveryStream>> streams_;
+    std::once_flag streamsStarted_;
+    std::mutex statsMutex_;
+    std::chrono::steady_clock::time_point lastStatsTime_;
+    std::unordered_map<std::string, uint64_t> lastDeliveries_;
 };
 
 
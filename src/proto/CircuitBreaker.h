@@ -0,0 +1,96 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_CIRCUITBREAKER_H
+#define IMSERVER_CIRCUITBREAKER_H
+
+#include <chrono>
+#include <mutex>
+
+/**
+ * @brief 单个对端的熔断器。
+ *
+ * CLOSED：正常放行，连续失败达到阈值后进入 OPEN。
+ * OPEN：直接拒绝，openDuration 后进入 HALF_OPEN。
+ * HALF_OPEN：只放行 halfOpenProbes 个探测请求，探测成功回到 CLOSED，失败重新 OPEN。
+ */
+class CircuitBreaker {
+public:
+    enum class State {
+        CLOSED = 0,
+        OPEN = 1,
+        HALF_OPEN = 2,
+    };
+
+    struct Options {
+        int failureThreshold = 5;
+        std::chrono::milliseconds openDuration{5000};
+        int halfOpenProbes = 1;
+    };
+
+    explicit CircuitBreaker(const Options& options) : options_(options) {}
+
+    /// 是否放行本次请求；放行后必须调用 onSuccess、onFailure 或 cancelRequest 之一
+    bool allowRequest() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == State::OPEN) {
+            if (std::chrono::steady_clock::now() - openedAt_ < options_.openDuration) {
+                return false;
+            }
+            state_ = State::HALF_OPEN;
+            probesInFlight_ = 0;
+        }
+        if (state_ == State::HALF_OPEN) {
+            if (probesInFlight_ >= options_.halfOpenProbes) {
+                return false;
+            }
+            probesInFlight_++;
+        }
+        return true;
+    }
+
+    void onSuccess() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        consecutiveFailures_ = 0;
+        if (state_ == State::HALF_OPEN) {
+            state_ = State::CLOSED;
+            probesInFlight_ = 0;
+        }
+    }
+
+    /// 放行后请求未发出（如等待连接池超时），归还探测名额，不计入成功或失败
+    void cancelRequest() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == State::HALF_OPEN && probesInFlight_ > 0) {
+            probesInFlight_--;
+        }
+    }
+
+    void onFailure() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        consecutiveFailures_++;
+        if (state_ == State::HALF_OPEN || consecutiveFailures_ >= options_.failureThreshold) {
+            if (state_ != State::OPEN) {
+                openedAt_ = std::chrono::steady_clock::now();
+            }
+            state_ = State::OPEN;
+            probesInFlight_ = 0;
+        }
+    }
+
+    State state() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_;
+    }
+
+private:
+    Options options_;
+    mutable std::mutex mutex_;
+    State state_ = State::CLOSED;
+    int consecutiveFailures_ = 0;
+    int probesInFlight_ = 0;
+    std::chrono::steady_clock::time_point openedAt_;
+};
+
+#endif //IMSERVER_CIRCUITBREAKER_H
@@ -0,0 +1,212 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#include "PeerDeliveryStream.h"
+
+#include <iostream>
+#include <vector>
+
+PeerDeliveryStream::PeerDeliveryStream(const std::shared_ptr<grpc::Channel> &channel, std::string peerName,
+    std::string selfName, const Options &options)
+    : channel_(channel), stub_(ChatService::NewStub(channel)), peerName_(std::move(peerName)),
+      selfName_(std::move(selfName)), options_(options), stop_(false), connected_(false) {
+}
+
+PeerDeliveryStream::~PeerDeliveryStream() {
+    stop();
+}
+
+void PeerDeliveryStream::start() {
+    if (sender_.joinable()) {
+        return;
+    }
+    sender_ = std::thread(&PeerDeliveryStream::senderLoop, this);
+}
+
+void PeerDeliveryStream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_.store(true);
+        if (context_) {
+            context_->TryCancel();
+        }
+    }
+    cond_.notify_all();
+    if (sender_.joinable()) {
+        sender_.join();
+    }
+}
+
+bool PeerDeliveryStream::enqueue(const int toUid, const uint16_t msgId, const std::string &json) {
+    if (!connected_.load() || stop_.load()) {
+        stats_.rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.size() >= options_.maxPending) {
+            stats_.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (pending_.empty()) {
+            firstPendingTime_ = std::chrono::steady_clock::now();
+        }
+        Delivery delivery;
+        delivery.set_to_uid(toUid);
+        delivery.set_msg_id(msgId);
+        delivery.set_json(json);
+        pending_.push_back(std::move(delivery));
+        size = pending_.size();
+    }
+    stats_.enqueued.fetch_add(1, std::memory_order_relaxed);
+
+    // 第一条启动攒批计时，攒满一批立即唤醒发送线程
+    if (size == 1 || size >= options_.maxBatchSize) {
+        cond_.notify_one();
+    }
+    return true;
+}
+
+void PeerDeliveryStream::senderLoop() {
+    constexpr auto CONNECT_TIMEOUT = std::chrono::seconds(1);
+    while (!stop_.load()) {
+        if (!channel_->WaitForConnected(std::chrono::system_clock::now() + CONNECT_TIMEOUT)) {
+            continue;
+        }
+
+        grpc::ClientContext context;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_.load()) {
+                break;
+            }
+            context_ = &context;
+            streamBroken_ = false;
+        }
+        const auto stream = stub_->DeliverStream(&context);
+        std::thread reader(&PeerDeliveryStream::readerLoop, this, stream.get());
+
+        // 重连后先按 batch_id 顺序重发上一条流上未确认的批次
+        std::vector<DeliveryBatch> resend;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& [id, inflight] : inflight_) {
+                inflight.sendTime = std::chrono::steady_clock::now();
+                resend.push_back(inflight.batch);
+            }
+        }
+        bool ok = true;
+        for (const auto& batch : resend) {
+            if (!stream->Write(batch)) {
+                ok = false;
+                break;
+            }
+            stats_.batches_resent.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (ok) {
+            std::cout << "PeerDeliveryStream: [" << peerName_ << "] stream established" << std::endl;
+            connected_.store(true);
+            pumpBatches(stream.get());
+            connected_.store(false);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            context.TryCancel();
+            context_ = nullptr;
+        }
+        reader.join();
+        stream->Finish();
+        if (!stop_.load()) {
+            stats_.reconnects.fetch_add(1, std::memory_order_relaxed);
+            std::cout << "PeerDeliveryStream: [" << peerName_ << "] stream broken, reconnecting" << std::endl;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_.empty() || !inflight_.empty()) {
+        std::cout << "PeerDeliveryStream: [" << peerName_ << "] stopped, drop pending=" << pending_.size()
+                  << " inflight=" << inflight_.size() << std::endl;
+    }
+}
+
+void PeerDeliveryStream::pumpBatches(Stream *stream) {
+    DeliveryBatch batch;
+    while (takeBatch(batch)) {
+        const int count = batch.deliveries_size();
+        if (!stream->Write(batch)) {
+            return; // 批次已在 inflight_ 中，重连后重发
+        }
+        stats_.batches_sent.fetch_add(1, std::memory_order_relaxed);
+        stats_.deliveries_sent.fetch_add(count, std::memory_order_relaxed);
+    }
+}
+
+bool PeerDeliveryStream::takeBatch(DeliveryBatch &batch) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (stop_.load() || streamBroken_) {
+            return false;
+        }
+        if (!pending_.empty() && inflight_.size() < options_.maxInflightBatches) {
+            const auto deadline = firstPendingTime_ + options_.flushInterval;
+            if (pending_.size() >= options_.maxBatchSize || std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            cond_.wait_until(lock, deadline);
+            continue;
+        }
+        // 无数据或发送窗口已满，等待入队或 ACK 唤醒
+        cond_.wait_for(lock, std::chrono::milliseconds(100));
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const size_t count = std::min(pending_.size(), options_.maxBatchSize);
+    batch.Clear();
+    batch.set_batch_id(nextBatchId_++);
+    batch.set_from_server(selfName_);
+    for (size_t i = 0; i < count; i++) {
+        *batch.add_deliveries() = std::move(pending_.front());
+        pending_.pop_front();
+    }
+    if (!pending_.empty()) {
+        firstPendingTime_ = now;
+    }
+    inflight_.emplace(batch.batch_id(), InflightBatch{batch, now});
+    return true;
+}
+
+void PeerDeliveryStream::readerLoop(Stream *stream) {
+    DeliveryAck ack;
+    while (stream->Read(&ack)) {
+        std::vector<int> offlineUids(ack.offline_uids().begin(), ack.offline_uids().end());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (const auto it = inflight_.find(ack.batch_id()); it != inflight_.end()) {
+                const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - it->second.sendTime).count();
+                stats_.ack_latency_us.fetch_add(latency, std::memory_order_relaxed);
+                stats_.batches_acked.fetch_add(1, std::memory_order_relaxed);
+                inflight_.erase(it);
+            }
+        }
+        cond_.notify_one();   // 释放发送窗口
+
+        stats_.offline.fetch_add(offlineUids.size(), std::memory_order_relaxed);
+        if (offlineHandler_) {
+            for (const int uid : offlineUids) {
+                offlineHandler_(uid);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streamBroken_ = true;
+    }
+    cond_.notify_all();
+}
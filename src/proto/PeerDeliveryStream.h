@@ -0,0 +1,117 @@
+//
+// Created by Fan on 2026/10/18.
+//
+
+#ifndef IMSERVER_PEERDELIVERYSTREAM_H
+#define IMSERVER_PEERDELIVERYSTREAM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <grpcpp/grpcpp.h>
+
+#include "message.pb.h"
+#include "message.grpc.pb.h"
+
+using message::ChatService;
+using message::Delivery;
+using message::DeliveryBatch;
+using message::DeliveryAck;
+
+/**
+ * @brief 到单个对端 ChatServer 的常驻投递流。
+ *
+ * 业务线程只把投递放入待发队列；发送线程攒批，满 maxBatchSize 条或距第一条入队超过
+ * flushInterval 即写出一个批次，读线程按 batch_id 回收 ACK。
+ * 流断开后自动重连，未 ACK 的批次按原顺序重发（至少一次语义）。
+ * 流未建立或待发队列已满时 enqueue 返回 false，调用方退回单次 RPC。
+ */
+class PeerDeliveryStream {
+public:
+    struct Options {
+        size_t maxBatchSize = 64;
+        std::chrono::microseconds flushInterval{500};
+        size_t maxPending = 65536;          ///< 待发队列上限，超出拒绝入队
+        size_t maxInflightBatches = 64;     ///< 已发送未 ACK 的批次上限（发送窗口）
+    };
+
+    struct Stats {
+        std::atomic<uint64_t> enqueued{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> batches_sent{0};
+        std::atomic<uint64_t> deliveries_sent{0};
+        std::atomic<uint64_t> batches_acked{0};
+        std::atomic<uint64_t> batches_resent{0};
+        std::atomic<uint64_t> offline{0};
+        std::atomic<uint64_t> reconnects{0};
+        std::atomic<uint64_t> ack_latency_us{0};    ///< 累计写出到 ACK 的耗时
+    };
+
+    PeerDeliveryStream(const std::shared_ptr<grpc::Channel>& channel, std::string peerName,
+        std::string selfName, const Options& options);
+    ~PeerDeliveryStream();
+
+    typedef std::function<void(int uid)> offlineHandler;
+
+    PeerDeliveryStream(const PeerDeliveryStream&) = delete;
+    PeerDeliveryStream& operator=(const PeerDeliveryStream&) = delete;
+
+    /// 对端 ACK 中报告接收方已不在线时回调，需在 start 之前设置
+    void setOfflineHandler(const offlineHandler& handler) { offlineHandler_ = handler; }
+
+    void start();
+    void stop();
+
+    /// 入队一条投递，返回 false 表示流不可用或队列已满
+    bool enqueue(int toUid, uint16_t msgId, const std::string& json);
+
+    bool connected() const { return connected_.load(); }
+    const std::string& peerName() const { return peerName_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    using Stream = grpc::ClientReaderWriter<DeliveryBatch, DeliveryAck>;
+
+    struct InflightBatch {
+        DeliveryBatch batch;
+        std::chrono::steady_clock::time_point sendTime;
+    };
+
+    void senderLoop();
+    void readerLoop(Stream* stream);
+    /// 在已建立的流上发送，直到流出错或停止；返回后由 senderLoop 负责重连
+    void pumpBatches(Stream* stream);
+    bool takeBatch(DeliveryBatch& batch);
+
+    std::shared_ptr<grpc::Channel> channel_;
+    std::unique_ptr<ChatService::Stub> stub_;
+    std::string peerName_;
+    std::string selfName_;
+    Options options_;
+
+    std::atomic<bool> stop_;
+    std::atomic<bool> connected_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<Delivery> pending_;
+    std::chrono::steady_clock::time_point firstPendingTime_;
+    std::map<uint64_t, InflightBatch> inflight_;    ///< batch_id 有序，重连后按顺序重发
+    uint64_t nextBatchId_ = 1;
+    bool streamBroken_ = false;
+    grpc::ClientContext* context_ = nullptr;   ///< 当前流的上下文，stop 时用于取消阻塞中的读写
+    offlineHandler offlineHandler_;
+
+    std::thread sender_;
+    Stats stats_;
+};
+
+
+#endif //IMSERVER_PEERDELIVERYSTREAM_H
@@ -6,57 +6,148 @@
 #define IMSERVER_SERVICECONNPOOL_H
 
 #include <memory>
+#include <algorithm>
 #include <atomic>
 #include <mutex>
-#include <queue>
+#include <future>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include <type_traits>
 #include <condition_variable>
 #include <grpcpp/grpcpp.h>
 
+#include "CircuitBreaker.h"
+#include "ConfigMgr.h"
+
 using grpc::Channel;
 using grpc::Status;
 using grpc::ClientContext;
 
+/**
+ * @brief gRPC 调用参数，各客户端可从配置 [RPC] 段覆盖默认值。
+ */
+struct RpcOptions {
+    std::size_t channelCount = 2;                       ///< 共享 channel 数，每个 channel 一条 HTTP/2 连接
+    std::size_t maxInflight = 10;                       ///< 同时在途的调用上限
+    std::chrono::milliseconds acquireTimeout{200};      ///< 等待调用许可的上限
+    std::chrono::milliseconds callTimeout{1000};        ///< 单次调用 deadline
+    CircuitBreaker::Options breaker;
+
+    /// 从配置 [RPC] 段读取，maxInflight 沿用各服务原有的连接池大小配置
+    static RpcOptions fromConfig(const std::size_t maxInflight) {
+        auto& config = ConfigMgr::getInstance();
+        RpcOptions options;
+        options.maxInflight = maxInflight;
+        if (!config["RPC"]["Channels"].empty()) {
+            options.channelCount = std::stoul(config["RPC"]["Channels"]);
+        }
+        if (!config["RPC"]["AcquireTimeoutMs"].empty()) {
+            options.acquireTimeout = std::chrono::milliseconds(std::stoi(config["RPC"]["AcquireTimeoutMs"]));
+        }
+        if (!config["RPC"]["TimeoutMs"].empty()) {
+            options.callTimeout = std::chrono::milliseconds(std::stoi(config["RPC"]["TimeoutMs"]));
+        }
+        if (!config["RPC"]["BreakerFailures"].empty()) {
+            options.breaker.failureThreshold = std::stoi(config["RPC"]["BreakerFailures"]);
+        }
+        if (!config["RPC"]["BreakerOpenMs"].empty()) {
+            options.breaker.openDuration = std::chrono::milliseconds(std::stoi(config["RPC"]["BreakerOpenMs"]));
+        }
+        return options;
+    }
+};
+
+/**
+ * @brief 到单个服务端点的调用池。
+ *
+ * stub 线程安全，所有调用共享少量 channel（轮询选取），池只负责：
+ *   - 在途调用许可：超过 maxInflight 时最多等待 acquireTimeout，超时直接失败；
+ *   - 每次调用设置 deadline；
+ *   - 熔断：对端不可用/超时累计到阈值后快速失败，冷却后半开探测。
+ * 调用统一走 gRPC callback API，同步接口只是在异步调用上等待结果。
+ */
 template<typename ServiceType>
 class ServiceConnPool {
 public:
+    using Stub = typename ServiceType::Stub;
+    // 生成代码中 async 既是嵌套类名也是成员函数名，通过返回值类型取得
+    using AsyncStub = std::remove_pointer_t<decltype(std::declval<Stub&>().async())>;
+    using Callback = std::function<void(Status)>;
+
     ServiceConnPool(std::size_t size, const std::string &host, const std::string &port);
+    ServiceConnPool(const std::string &host, const std::string &port, const RpcOptions& options);
     ~ServiceConnPool();
 
     void close();
-    std::unique_ptr<typename ServiceType::Stub> getConnection();
-    void returnConnection(std::unique_ptr<typename ServiceType::Stub> stub);
+
+    /**
+     * @brief 发起异步调用。
+     * @param invoke 形如 [&req](AsyncStub* s, ClientContext* c, Rsp* r, Callback cb) { s->Method(c, &req, r, cb); }
+     * @param done   调用结束回调，在 gRPC 线程执行；拒绝（熔断/许可超时/已关闭）时在当前线程执行
+     */
+    template<typename Response, typename Invoke, typename Done>
+    void asyncCall(Invoke&& invoke, Done&& done);
+
+    /// 同步调用：在异步调用上等待，最长等待时间受 deadline 约束
+    template<typename Response, typename Invoke>
+    Status call(Invoke&& invoke, Response& response);
+
+    CircuitBreaker::State breakerState() const { return breaker_.state(); }
+    const std::string& endpoint() const { return endpoint_; }
 
     ServiceConnPool(const ServiceConnPool&) = delete;
     ServiceConnPool& operator=(const ServiceConnPool&) = delete;
 private:
+    bool acquire();
+    void release();
+    void onResult(const Status& status);
+    static bool isFailure(const Status& status);
+
     std::atomic<bool> stop_{false};
-    std::size_t size_;
     std::string endpoint_;
-    std::queue<std::unique_ptr<typename ServiceType::Stub>> connections_{};
-    // 控制队列线程安全
+    RpcOptions options_;
+    std::vector<std::unique_ptr<Stub>> stubs_;
+    std::atomic<std::size_t> next_{0};
+
+    // 在途调用许可
+    std::size_t inflight_ = 0;
     std::condition_variable cv_;
     std::mutex mutex_;
+
+    CircuitBreaker breaker_;
 };
 
 template<typename ServiceType>
 ServiceConnPool<ServiceType>::ServiceConnPool(const std::size_t size, const std::string &host, const std::string &port)
-    : size_(size), endpoint_(host + ":" + port) {
-    std::cout << "Creating service connection ...";
-    for (std::size_t i = 0; i < size; i++) {
-        const auto channel = grpc::CreateChannel(endpoint_,
-            grpc::InsecureChannelCredentials());
-        connections_.push(ServiceType::NewStub(channel));
+    : ServiceConnPool(host, port, RpcOptions::fromConfig(size)) {
+}
+
+template<typename ServiceType>
+ServiceConnPool<ServiceType>::ServiceConnPool(const std::string &host, const std::string &port,
+    const RpcOptions &options)
+    : endpoint_(host + ":" + port), options_(options), breaker_(options.breaker) {
+    std::cout << "Creating service connection [" << endpoint_ << "] ...";
+    const std::size_t channelCount = std::max<std::size_t>(1, options_.channelCount);
+    for (std::size_t i = 0; i < channelCount; i++) {
+        // 不同 channel 使用独立的 subchannel 池，才能建立多条连接分摊 HTTP/2 并发流
+        grpc::ChannelArguments args;
+        args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        const auto channel = grpc::CreateCustomChannel(endpoint_,
+            grpc::InsecureChannelCredentials(), args);
+        stubs_.push_back(ServiceType::NewStub(channel));
     }
-    std::cout << "OK" << std::endl;
+    std::cout << "OK, channels = " << channelCount << std::endl;
 }
 
 template<typename ServiceType>
 ServiceConnPool<ServiceType>::~ServiceConnPool() {
-    std::lock_guard<std::mutex> lock(mutex_);
     close();
-    while (!connections_.empty()) {
-        connections_.pop();
-    }
+    // 等待在途回调结束，回调中会访问本对象
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() {
+        return inflight_ == 0;
+    });
 }
 
 template<typename ServiceType>
@@ -66,30 +157,91 @@ void ServiceConnPool<ServiceType>::close() {
 }
 
 template<typename ServiceType>
-std::unique_ptr<typename ServiceType::Stub> ServiceConnPool<ServiceType>::getConnection() {
+bool ServiceConnPool<ServiceType>::acquire() {
+    // 先检查熔断：对端不可用时立即失败，不占用等待在途名额的时间
+    if (!breaker_.allowRequest()) {
+        return false;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
-    // todo:不能一直阻塞，需要有超时策略
-    cv_.wait(lock, [this]() {
-        if (stop_.load()) {
-            return true;
-        }
-        return !connections_.empty();
+    const bool ok = cv_.wait_for(lock, options_.acquireTimeout, [this]() {
+        return stop_.load() || inflight_ < options_.maxInflight;
     });
-    if (stop_.load()) {
-        return nullptr;
+    if (!ok || stop_.load()) {
+        lock.unlock();
+        breaker_.cancelRequest();
+        return false;
     }
-    auto conn = std::move(connections_.front());
-    connections_.pop();
-    return conn;
+    inflight_++;
+    return true;
 }
 
 template<typename ServiceType>
-void ServiceConnPool<ServiceType>::returnConnection(std::unique_ptr<typename ServiceType::Stub> stub) {
+void ServiceConnPool<ServiceType>::release() {
+    // 持锁通知：析构等到 inflight_ 归零后会销毁 cv_，解锁后再通知可能访问已销毁的对象
     std::lock_guard<std::mutex> lock(mutex_);
-    if (stop_.load()) {
+    inflight_--;
+    cv_.notify_all();
+}
+
+template<typename ServiceType>
+bool ServiceConnPool<ServiceType>::isFailure(const Status &status) {
+    // 只有对端不可用类错误计入熔断，业务错误码在响应体中
+    switch (status.error_code()) {
+        case grpc::StatusCode::UNAVAILABLE:
+        case grpc::StatusCode::DEADLINE_EXCEEDED:
+        case grpc::StatusCode::RESOURCE_EXHAUSTED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<typename ServiceType>
+void ServiceConnPool<ServiceType>::onResult(const Status &status) {
+    if (isFailure(status)) {
+        breaker_.onFailure();
+    }
+    else {
+        breaker_.onSuccess();
+    }
+}
+
+template<typename ServiceType>
+template<typename Response, typename Invoke, typename Done>
+void ServiceConnPool<ServiceType>::asyncCall(Invoke &&invoke, Done &&done) {
+    if (!acquire()) {
+        Response response;
+        done(Status(grpc::StatusCode::UNAVAILABLE, "circuit open or no call slot: " + endpoint_), response);
         return;
     }
-    connections_.push(std::move(stub));
+
+    struct CallState {
+        ClientContext context;
+        Response response;
+    };
+    auto state = std::make_shared<CallState>();
+    state->context.set_deadline(std::chrono::system_clock::now() + options_.callTimeout);
+
+    const auto& stub = stubs_[next_.fetch_add(1, std::memory_order_relaxed) % stubs_.size()];
+    invoke(stub->async(), &state->context, &state->response,
+        [this, state, done = std::forward<Done>(done)](const Status& status) mutable {
+            onResult(status);
+            done(status, state->response);
+            release();
+        });
+}
+
+template<typename ServiceType>
+template<typename Response, typename Invoke>
+Status ServiceConnPool<ServiceType>::call(Invoke &&invoke, Response &response) {
+    std::promise<Status> promise;
+    auto future = promise.get_future();
+    asyncCall<Response>(std::forward<Invoke>(invoke),
+        [&promise, &response](const Status& status, const Response& reply) {
+            response = reply;
+            promise.set_value(status);
+        });
+    return future.get();
 }
 
 #endif //IMSERVER_SERVICECONNPOOL_H
@@ -7,144 +7,68 @@
 #include "const.h"
 #include "ConfigMgr.h"
 
-StatusConnPool::StatusConnPool(const std::size_t size, const std::string &host, const std::string &port)
-    : size_(size), endpoint_(host + ":" + port) {
-    std::cout << "Creating Status connection ...";
-    for (std::size_t i = 0; i < size; i++) {
-        const auto channel = grpc::CreateChannel(endpoint_,
-            grpc::InsecureChannelCredentials());
-        connections_.push(StatusService::NewStub(channel));
-    }
-    std::cout << "OK" << std::endl;
-}
-
-StatusConnPool::~StatusConnPool() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    close();
-    while (!connections_.empty()) {
-        connections_.pop();
-    }
-}
-
-void StatusConnPool::close() {
-    stop_.store(true);
-    cv_.notify_all();
-}
-
-std::unique_ptr<StatusService::Stub> StatusConnPool::getConnection() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    // todo:不能一直阻塞，需要有超时策略
-    cv_.wait(lock, [this]() {
-        if (stop_.load()) {
-            return true;
-        }
-        return !connections_.empty();
-    });
-    if (stop_.load()) {
-        return nullptr;
-    }
-    auto conn = std::move(connections_.front());
-    connections_.pop();
-    return conn;
-}
-
-void StatusConnPool::returnConnection(std::unique_ptr<StatusService::Stub> stub) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (stop_.load()) {
-        return;
-    }
-    connections_.push(std::move(stub));
-}
+using StatusAsyncStub = ServiceConnPool<StatusService>::AsyncStub;
+using StatusCallback = ServiceConnPool<StatusService>::Callback;
 
 GetChatServerRsp StatusGrpcClient::GetChatServer(const int uid) const {
-    ClientContext context;
     GetChatServerReq request;
     GetChatServerRsp reply;
-    auto stub = pool_->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
-    }
-
-    Defer defer([this, &stub] () {
-        pool_->returnConnection(std::move(stub));
-    });
     request.set_uid(uid);
-    if (const auto status = stub->GetChatServer(&context, request, &reply); status.ok()) {
-        return reply;
+    const auto status = pool_->call([&request](StatusAsyncStub* stub, ClientContext* context,
+        GetChatServerRsp* response, const StatusCallback& done) {
+        stub->GetChatServer(context, &request, response, done);
+    }, reply);
+    if (!status.ok()) {
+        std::cout << "RPC GetChatServer failed: " << status.error_message() << std::endl;
+        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
     }
-
-    reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
     return reply;
 }
 
 GetResourceServerRsp StatusGrpcClient::GetResourceServer(const int uid) const {
-    ClientContext context;
     GetResourceServerReq request;
     GetResourceServerRsp reply;
-    auto stub = pool_->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
-    }
-    Defer defer([this, &stub]() {
-        pool_->returnConnection(std::move(stub));
-    });
-
     request.set_uid(uid);
-    if (const auto status = stub->GetResourceServer(&context, request, &reply); status.ok()) {
-        return reply;
+    const auto status = pool_->call([&request](StatusAsyncStub* stub, ClientContext* context,
+        GetResourceServerRsp* response, const StatusCallback& done) {
+        stub->GetResourceServer(context, &request, response, done);
+    }, reply);
+    if (!status.ok()) {
+        std::cout << "RPC GetResourceServer failed: " << status.error_message() << std::endl;
+        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
     }
-    reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
     return reply;
 }
 
 LoginRsp StatusGrpcClient::Login(const int uid, const std::string &token) const {
-    ClientContext context;
     LoginReq request;
     LoginRsp reply;
-    auto stub = pool_->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
-    }
-
-    Defer defer([this, &stub] () {
-        pool_->returnConnection(std::move(stub));
-    });
     request.set_uid(uid);
     request.set_token(token);
-    if (const auto status = stub->Login(&context, request, &reply); status.ok()) {
-        return reply;
+    const auto status = pool_->call([&request](StatusAsyncStub* stub, ClientContext* context,
+        LoginRsp* response, const StatusCallback& done) {
+        stub->Login(context, &request, response, done);
+    }, reply);
+    if (!status.ok()) {
+        std::cout << "RPC Login failed: " << status.error_message() << std::endl;
+        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
     }
-
-    reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
     return reply;
 }
 
 VerifyTokenRsp StatusGrpcClient::VerifyToken(const int uid, const std::string &token) const {
-    ClientContext context;
     VerifyTokenReq request;
     VerifyTokenRsp reply;
-    auto stub = pool_->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
-    }
-
-    Defer defer([this, &stub] () {
-        pool_->returnConnection(std::move(stub));
-    });
     request.set_uid(uid);
     request.set_token(token);
-    if (const auto status = stub->VerifyToken(&context, request, &reply); status.ok()) {
-        return reply;
+    const auto status = pool_->call([&request](StatusAsyncStub* stub, ClientContext* context,
+        VerifyTokenRsp* response, const StatusCallback& done) {
+        stub->VerifyToken(context, &request, response, done);
+    }, reply);
+    if (!status.ok()) {
+        std::cout << "RPC VerifyToken failed: " << status.error_message() << std::endl;
+        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
     }
-
     return reply;
 }
 
@@ -6,10 +6,6 @@
 #define IMSERVER_STATUSGRPCCLIENT_H
 
 #include <memory>
-#include <atomic>
-#include <mutex>
-#include <queue>
-#include <condition_variable>
 #include <grpcpp/grpcpp.h>
 
 #include "message.pb.h"
@@ -32,27 +28,6 @@ using message::StatusService;
 using message::VerifyTokenReq;
 using message::VerifyTokenRsp;
 
-class StatusConnPool {
-public:
-    StatusConnPool(std::size_t size, const std::string &host, const std::string &port);
-    ~StatusConnPool();
-
-    void close();
-    std::unique_ptr<StatusService::Stub> getConnection();
-    void returnConnection(std::unique_ptr<StatusService::Stub> stub);
-
-    StatusConnPool(const StatusConnPool&) = delete;
-    StatusConnPool& operator=(const StatusConnPool&) = delete;
-private:
-    std::atomic<bool> stop_{false};
-    std::size_t size_;
-    std::string endpoint_;
-    std::queue<std::unique_ptr<StatusService::Stub>> connections_;
-    // 控制队列线程安全
-    std::condition_variable cv_;
-    std::mutex mutex_;
-};
-
 class StatusGrpcClient : public Singleton<StatusGrpcClient> {
 public:
     [[nodiscard]] GetChatServerRsp GetChatServer(int uid) const;
@@ -69,4 +44,4 @@ private:
 };
 
 
-#endif //IMSERVER_STATUSGRPCCLIENT_H
\ No newline at end of file
+#endif //IMSERVER_STATUSGRPCCLIENT_H
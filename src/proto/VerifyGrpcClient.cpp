@@ -6,72 +6,17 @@
 #include "const.h"
 #include "ConfigMgr.h"
 
-RPCConnPool::RPCConnPool(const std::size_t size, const std::string &host, const std::string &port)
-    : size_(size), endpoint_(host + ":" + port) {
-    std::cout << "Creating RPC Connector, size = " << size << std::endl;
-    for (std::size_t i = 0; i < size; ++i) {
-        const auto channel = grpc::CreateChannel(endpoint_,
-                                                                 grpc::InsecureChannelCredentials());
-        connections_.push(VerifyService::NewStub(channel));
-    }
-}
-
-RPCConnPool::~RPCConnPool() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    close();
-    while (!connections_.empty()) {
-        connections_.pop();
-    }
-}
-
-void RPCConnPool::close() {
-    stop_.store(true);
-    cv_.notify_all();
-}
-
-std::unique_ptr<VerifyService::Stub> RPCConnPool::getConnection() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] {
-        if (stop_.load()) {// 已经停止继续执行
-            return true;
-        }
-        return !connections_.empty();
-    });
-     if (stop_.load()) {
-         return nullptr;
-     }
-    auto connection = std::move(connections_.front());
-    connections_.pop();
-    return connection;
-}
-
-// 使用完成后返还连接
-void RPCConnPool::returnConnection(std::unique_ptr<VerifyService::Stub> stub) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (stop_.load()) {
-        return;
-    }
-    connections_.push(std::move(stub));
-}
-
 GetVerifyRsp VerifyGrpcClient::GetVerifyCode(std::string email) const {
-    ClientContext context;
     GetVerifyRsp reply;
     GetVerifyReq request;
 
     request.set_email(email);
-    auto stub = connPool_->getConnection();
-    if (nullptr == stub) {
-        std::cout << "Error get rpc connection" << std::endl;
-        reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
-        return reply;
-    }
-
-    Defer defer([this, &stub] () {
-        connPool_->returnConnection(std::move(stub));
-    });
-    if (const Status status = stub->GetVerifyCode(&context, request, &reply); !status.ok()) {
-        std::cout << "Error getting verify code" << std::endl;
+    const Status status = connPool_->call([&request](ServiceConnPool<VerifyService>::AsyncStub* stub,
+        ClientContext* context, GetVerifyRsp* response, const ServiceConnPool<VerifyService>::Callback& done) {
+        stub->GetVerifyCode(context, &request, response, done);
+    }, reply);
+    if (!status.ok()) {
+        std::cout << "Error getting verify code: " << status.error_message() << std::endl;
         reply.set_error(static_cast<int32_t>(ErrorCodes::RPC_FAILED));
     }
     return reply;
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "TokenAuth.h"
+
+// TokenAuth 吊销列表测试，密钥取自 test/config.ini。
+// Redis 不可达时 revoke 的广播失败，但吊销项先写入本地表，本地校验结果不受影响。
+class TokenAuthTest : public ::testing::Test {
+protected:
+    static TokenAuth& auth() {
+        return *TokenAuth::getInstance();
+    }
+
+    static void apply(const std::string& entry) {
+        auth().applyEntry(entry);
+    }
+
+    static TokenSigner::Claims claims(const std::string& token) {
+        TokenSigner::Claims result;
+        EXPECT_EQ(auth().signer_->verify(token, result), TokenSigner::Result::OK);
+        return result;
+    }
+
+    /// 以给定时刻立即清理一次过期项，不影响后续的清理节奏
+    static void sweep(const int64_t nowMs) {
+        std::lock_guard<std::mutex> lock(auth().mutex_);
+        const auto lastSweep = auth().lastSweep_;
+        auth().lastSweep_ = 0;
+        auth().sweepLocked(nowMs);
+        auth().lastSweep_ = lastSweep;
+    }
+
+    static bool tokenRevoked(const std::string& nonce) {
+        std::lock_guard<std::mutex> lock(auth().mutex_);
+        return auth().revokedTokens_.count(nonce) > 0;
+    }
+
+    static bool userRevoked(const int uid) {
+        std::lock_guard<std::mutex> lock(auth().mutex_);
+        return auth().revokedUsers_.count(uid) > 0;
+    }
+
+    /// 用户吊销按毫秒比较签发时间，跨过当前毫秒再签发
+    static void nextMs() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+};
+
+// 吊销单个 token 不影响同一用户的其他 token。
+TEST_F(TokenAuthTest, RevokeToken) {
+    const auto first = auth().issue(9001);
+    const auto second = auth().issue(9001);
+    ASSERT_FALSE(first.empty());
+    ASSERT_TRUE(auth().verify(9001, first));
+    ASSERT_TRUE(auth().verify(9001, second));
+
+    auth().revoke(first);
+    EXPECT_TRUE(tokenRevoked(claims(first).nonce));
+    EXPECT_FALSE(auth().verify(9001, first));
+    EXPECT_TRUE(auth().verify(9001, second));
+    // uid 不匹配的 token 同样拒绝
+    EXPECT_FALSE(auth().verify(9002, second));
+}
+
+// 吊销用户之前签发的全部 token，之后签发的不受影响；revokeOlder 保留作为基准的 token。
+TEST_F(TokenAuthTest, RevokeUser) {
+    const auto before = auth().issue(9011);
+    nextMs();
+    auth().revokeUser(9011);
+    EXPECT_TRUE(userRevoked(9011));
+    EXPECT_FALSE(auth().verify(9011, before));
+    nextMs();
+    const auto after = auth().issue(9011);
+    EXPECT_TRUE(auth().verify(9011, after));
+    // 其他用户不受影响
+    EXPECT_TRUE(auth().verify(9012, auth().issue(9012)));
+
+    const auto old = auth().issue(9013);
+    nextMs();
+    const auto current = auth().issue(9013);
+    auth().revokeOlder(current);
+    EXPECT_FALSE(auth().verify(9013, old));
+    EXPECT_TRUE(auth().verify(9013, current));
+}
+
+// 广播收到的吊销项写入本地表；格式错误或已过期的项忽略。
+TEST_F(TokenAuthTest, ApplyEntry) {
+    const int64_t now = TokenSigner::nowMs();
+    const auto token = auth().issue(9021);
+    const auto nonce = claims(token).nonce;
+    ASSERT_TRUE(auth().verify(9021, token));
+
+    apply("n:" + nonce + ":" + std::to_string(now + 60000));
+    EXPECT_FALSE(auth().verify(9021, token));
+
+    const auto userToken = auth().issue(9022);
+    apply("u:9022:" + std::to_string(claims(userToken).issuedAt) + ":" + std::to_string(now + 60000));
+    EXPECT_FALSE(auth().verify(9022, userToken));
+    // 吊销时刻只前移不后退
+    apply("u:9022:0:" + std::to_string(now + 60000));
+    EXPECT_FALSE(auth().verify(9022, userToken));
+
+    apply("n:expired-nonce:" + std::to_string(now - 1));
+    EXPECT_FALSE(tokenRevoked("expired-nonce"));
+    apply("u:9023:" + std::to_string(now) + ":" + std::to_string(now - 1));
+    EXPECT_FALSE(userRevoked(9023));
+
+    apply("x:9024");
+    apply("n:missing-expire");
+    apply("u:abc:1:" + std::to_string(now + 60000));
+    apply("n:bad-expire:abc");
+    EXPECT_FALSE(tokenRevoked("missing-expire"));
+    EXPECT_FALSE(tokenRevoked("bad-expire"));
+    EXPECT_TRUE(auth().verify(9024, auth().issue(9024)));
+}
+
+// 对应 token 过期后吊销项随清理删除，未过期的保留。
+TEST_F(TokenAuthTest, SweepExpiredEntries) {
+    const int64_t now = TokenSigner::nowMs();
+    apply("n:short-lived:" + std::to_string(now + 1000));
+    apply("n:long-lived:" + std::to_string(now + 60000));
+    apply("u:9031:" + std::to_string(now) + ":" + std::to_string(now + 1000));
+    apply("u:9032:" + std::to_string(now) + ":" + std::to_string(now + 60000));
+    ASSERT_TRUE(tokenRevoked("short-lived"));
+    ASSERT_TRUE(userRevoked(9031));
+
+    sweep(now + 1000);
+    EXPECT_FALSE(tokenRevoked("short-lived"));
+    EXPECT_TRUE(tokenRevoked("long-lived"));
+    EXPECT_FALSE(userRevoked(9031));
+    EXPECT_TRUE(userRevoked(9032));
+
+    sweep(now + 60000);
+    EXPECT_FALSE(tokenRevoked("long-lived"));
+    EXPECT_FALSE(userRevoked(9032));
+}
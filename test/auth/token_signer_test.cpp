@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "TokenSigner.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+TokenSigner makeSigner(const std::string& activeKid = "k1") {
+    return TokenSigner({{"k1", "secret-1"}, {"k2", "secret-2"}}, activeKid, 3600s);
+}
+
+constexpr int64_t NOW_MS = 1800000000000;
+
+}  // namespace
+
+// 签发的 token 可本地校验，claims 与签发参数一致。
+TEST(TokenSignerTest, SignAndVerify) {
+    const auto signer = makeSigner();
+    const auto token = signer.sign(42, NOW_MS);
+    ASSERT_FALSE(token.empty());
+
+    TokenSigner::Claims claims;
+    ASSERT_EQ(signer.verify(token, NOW_MS + 1000, claims), TokenSigner::Result::OK);
+    EXPECT_EQ(claims.kid, "k1");
+    EXPECT_EQ(claims.uid, 42);
+    EXPECT_EQ(claims.issuedAt, NOW_MS);
+    EXPECT_EQ(claims.expireAt, NOW_MS + 3600 * 1000);
+    EXPECT_FALSE(claims.nonce.empty());
+
+    // 同一用户两次签发 nonce 不同，可分别吊销
+    TokenSigner::Claims other;
+    ASSERT_EQ(signer.verify(signer.sign(42, NOW_MS), NOW_MS, other), TokenSigner::Result::OK);
+    EXPECT_NE(claims.nonce, other.nonce);
+}
+
+// 篡改任意一段都会导致验签失败。
+TEST(TokenSignerTest, RejectsTampering) {
+    const auto signer = makeSigner();
+    const auto token = signer.sign(42, NOW_MS);
+    TokenSigner::Claims claims;
+
+    auto forgedUid = token;
+    forgedUid.replace(forgedUid.find(".42.") + 1, 2, "43");
+    EXPECT_EQ(signer.verify(forgedUid, NOW_MS, claims), TokenSigner::Result::BAD_SIGNATURE);
+
+    auto forgedSig = token;
+    forgedSig.back() = forgedSig.back() == '0' ? '1' : '0';
+    EXPECT_EQ(signer.verify(forgedSig, NOW_MS, claims), TokenSigner::Result::BAD_SIGNATURE);
+
+    EXPECT_EQ(signer.verify("", NOW_MS, claims), TokenSigner::Result::MALFORMED);
+    EXPECT_EQ(signer.verify("not-a-token", NOW_MS, claims), TokenSigner::Result::MALFORMED);
+    EXPECT_EQ(signer.verify(token + ".", NOW_MS, claims), TokenSigner::Result::MALFORMED);
+
+    // 其他密钥签发的 token 不能通过校验
+    const TokenSigner foreign({{"k1", "another"}}, "k1", 3600s);
+    EXPECT_EQ(foreign.verify(token, NOW_MS, claims), TokenSigner::Result::BAD_SIGNATURE);
+}
+
+TEST(TokenSignerTest, RejectsExpired) {
+    const auto signer = makeSigner();
+    const auto token = signer.sign(7, NOW_MS);
+    TokenSigner::Claims claims;
+    EXPECT_EQ(signer.verify(token, NOW_MS + 3600 * 1000 - 1, claims), TokenSigner::Result::OK);
+    EXPECT_EQ(signer.verify(token, NOW_MS + 3600 * 1000, claims), TokenSigner::Result::EXPIRED);
+}
+
+// 轮换密钥：切换 ActiveKid 后旧 kid 签发的 token 仍可校验，移除旧 kid 后失效。
+TEST(TokenSignerTest, KeyRotation) {
+    const auto oldToken = makeSigner("k1").sign(9, NOW_MS);
+    const auto rotated = makeSigner("k2");
+    TokenSigner::Claims claims;
+    EXPECT_EQ(rotated.verify(oldToken, NOW_MS, claims), TokenSigner::Result::OK);
+    EXPECT_EQ(rotated.verify(rotated.sign(9, NOW_MS), NOW_MS, claims), TokenSigner::Result::OK);
+    EXPECT_EQ(claims.kid, "k2");
+
+    const TokenSigner retired({{"k2", "secret-2"}}, "k2", 3600s);
+    EXPECT_EQ(retired.verify(oldToken, NOW_MS, claims), TokenSigner::Result::UNKNOWN_KEY);
+
+    const TokenSigner unconfigured({}, "k1", 3600s);
+    EXPECT_FALSE(unconfigured.valid());
+    EXPECT_TRUE(unconfigured.sign(9, NOW_MS).empty());
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <iomanip>
+#include <iostream>
+
+#include "BatchSizeController.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+BatchSizeController::Bounds makeBounds() {
+    BatchSizeController::Bounds b;
+    b.minBatch = 32;
+    b.maxBatch = 1024;
+    b.initBatch = 256;
+    b.batchStep = 16;
+    b.minChunk = 10;
+    b.maxChunk = 200;
+    b.initChunk = 50;
+    b.chunkStep = 5;
+    b.targetLatency = 20ms;
+    return b;
+}
+
+/// 模拟 MySQL 提交耗时：固定开销 + 每条 INSERT 往返 + 每行写入，throttle 为整体放慢倍数
+std::chrono::microseconds simulateCommit(const size_t batch, const size_t chunk, const double throttle) {
+    const size_t statements = (batch + chunk - 1) / chunk + 2;
+    const double us = (500.0 + statements * 300.0 + batch * 20.0) * throttle;
+    return std::chrono::microseconds(static_cast<int64_t>(us));
+}
+
+}  // namespace
+
+// 提交耗时低于目标且批次用满时加性增长，直到上限。
+TEST(BatchSizeControllerTest, AdditiveIncreaseUpToMax) {
+    BatchSizeController sizer(makeBounds());
+    sizer.onCommit(256, 5ms, 0);
+    EXPECT_EQ(sizer.batchSize(), 272u);
+    EXPECT_EQ(sizer.chunkSize(), 55u);
+
+    for (int i = 0; i < 200; i++) {
+        sizer.onCommit(sizer.batchSize(), 5ms, 0);
+    }
+    EXPECT_EQ(sizer.batchSize(), 1024u);
+    EXPECT_EQ(sizer.chunkSize(), 200u);
+}
+
+// 负载低、批次没有用满时不增长；介于目标和尖刺之间保持不变。
+TEST(BatchSizeControllerTest, HoldsWhenNotFullOrNearTarget) {
+    BatchSizeController sizer(makeBounds());
+    sizer.onCommit(20, 1ms, 0);
+    EXPECT_EQ(sizer.batchSize(), 256u);
+    EXPECT_EQ(sizer.chunkSize(), 50u);
+
+    sizer.onCommit(256, 30ms, 0);
+    EXPECT_EQ(sizer.batchSize(), 256u);
+    EXPECT_EQ(sizer.stats().increases, 0u);
+    EXPECT_EQ(sizer.stats().decreases, 0u);
+}
+
+// 死锁或耗时尖刺时减半，不低于下限；按旧批次切分的在途批次不重复减半。
+TEST(BatchSizeControllerTest, MultiplicativeDecreaseOnDeadlockOrSpike) {
+    BatchSizeController sizer(makeBounds());
+    sizer.onCommit(256, 5ms, 1);
+    EXPECT_EQ(sizer.batchSize(), 128u);
+    EXPECT_EQ(sizer.chunkSize(), 25u);
+
+    sizer.onCommit(256, 100ms, 0);
+    EXPECT_EQ(sizer.batchSize(), 128u);
+
+    sizer.onCommit(128, 100ms, 0);
+    EXPECT_EQ(sizer.batchSize(), 64u);
+    for (int i = 0; i < 10; i++) {
+        sizer.onCommit(sizer.batchSize(), 100ms, 2);
+    }
+    EXPECT_EQ(sizer.batchSize(), 32u);
+    EXPECT_EQ(sizer.chunkSize(), 10u);
+    EXPECT_EQ(sizer.stats().deadlocks, 1u + 20u);
+}
+
+// 上下限相同时大小固定，等同关闭自适应。
+TEST(BatchSizeControllerTest, FixedWhenBoundsEqual) {
+    auto bounds = makeBounds();
+    bounds.minBatch = bounds.maxBatch = bounds.initBatch;
+    bounds.minChunk = bounds.maxChunk = bounds.initChunk;
+    BatchSizeController sizer(bounds);
+    sizer.onCommit(256, 1ms, 0);
+    sizer.onCommit(256, 1s, 3);
+    EXPECT_EQ(sizer.batchSize(), 256u);
+    EXPECT_EQ(sizer.chunkSize(), 50u);
+}
+
+// 模拟 MySQL 被限速：限速期间批次收敛到更小的值，提交耗时回到目标附近；恢复后重新增长。
+TEST(BatchSizeControllerBench, ConvergesUnderThrottle) {
+    BatchSizeController sizer(makeBounds());
+    const auto run = [&sizer](const double throttle, const int rounds) {
+        std::chrono::microseconds last{0};
+        for (int i = 0; i < rounds; i++) {
+            last = simulateCommit(sizer.batchSize(), sizer.chunkSize(), throttle);
+            sizer.onCommit(sizer.batchSize(), last, 0);
+        }
+        return last;
+    };
+
+    std::cout << "\n=== AIMD Batch Sizing (simulated MySQL) ===" << std::endl;
+    std::cout << "Phase      | Batch | Chunk | Commit (ms)" << std::endl;
+    std::cout << "-----------|-------|-------|------------" << std::endl;
+    const auto print = [&sizer](const char* phase, const std::chrono::microseconds latency) {
+        std::cout << std::left << std::setw(10) << phase << " | " << std::right
+                  << std::setw(5) << sizer.batchSize() << " | "
+                  << std::setw(5) << sizer.chunkSize() << " | "
+                  << std::setw(10) << std::fixed << std::setprecision(2) << latency.count() / 1000.0 << std::endl;
+    };
+
+    const auto normal = run(1.0, 300);
+    const size_t normalBatch = sizer.batchSize();
+    print("normal", normal);
+
+    const auto throttled = run(8.0, 300);
+    const size_t throttledBatch = sizer.batchSize();
+    print("throttled", throttled);
+
+    const auto recovered = run(1.0, 300);
+    print("recovered", recovered);
+    std::cout << "===========================================\n" << std::endl;
+
+    EXPECT_LT(throttledBatch, normalBatch);
+    EXPECT_LE(throttled, makeBounds().targetLatency * BatchSizeController::SPIKE_FACTOR);
+    EXPECT_GT(sizer.batchSize(), throttledBatch);
+}
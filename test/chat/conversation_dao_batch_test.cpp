@@ -0,0 +1,529 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BatchSizeController.h"
+#include "MessageIdGenerator.h"
+#include "UnreadDeltaTable.h"
+#include "db/mysql_test_fixture.h"
+#include "db/mysql/dao/ConversationDao.h"
+
+// batchCreateMessages 的 DAO 级测试，直连 test/config.ini 中的 MySQL，不可达时跳过。
+namespace {
+
+constexpr int BASE_UID = 9900000;
+constexpr int C2C_CONVS = 200;
+constexpr int GROUP_CONVS = 4;
+constexpr int GROUP_MEMBERS = 50;
+
+std::string c2cId(const int i) {
+    return "c2c_" + std::to_string(BASE_UID + 2 * i) + "_" + std::to_string(BASE_UID + 2 * i + 1);
+}
+
+std::string groupId(const int i) {
+    return "group_" + std::to_string(BASE_UID) + "_bench" + std::to_string(i);
+}
+
+class ConversationDaoBatchTest : public MysqlDaoTest<ConversationDao> {
+protected:
+    static void SetUpTestSuite() {
+        setUpSuite([] {
+            cleanup();
+            seed();
+        });
+    }
+
+    static void TearDownTestSuite() {
+        tearDownSuite(cleanup);
+    }
+
+    static void seed() {
+        std::string conv_sql = "INSERT INTO conversation (conv_id, conv_type, owner_uid) VALUES ";
+        std::string uc_sql = "INSERT INTO user_conversation (uid, conv_id) VALUES ";
+        for (int i = 0; i < C2C_CONVS; i++) {
+            conv_sql += (i == 0 ? "('" : ",('") + c2cId(i) + "',1,0)";
+            uc_sql += (i == 0 ? "(" : ",(") + std::to_string(BASE_UID + 2 * i) + ",'" + c2cId(i) + "')";
+            uc_sql += ",(" + std::to_string(BASE_UID + 2 * i + 1) + ",'" + c2cId(i) + "')";
+        }
+        for (int g = 0; g < GROUP_CONVS; g++) {
+            conv_sql += ",('" + groupId(g) + "',2," + std::to_string(BASE_UID) + ")";
+            for (int m = 0; m < GROUP_MEMBERS; m++) {
+                uc_sql += ",(" + std::to_string(BASE_UID + m) + ",'" + groupId(g) + "')";
+            }
+        }
+        exec(conv_sql);
+        exec(uc_sql);
+    }
+
+    static void cleanup() {
+        for (const auto& table : {"message", "user_conversation", "conversation"}) {
+            exec(std::string("DELETE FROM ") + table + " WHERE conv_id LIKE 'c2c\\_9900___\\_9900___'"
+                " OR conv_id LIKE 'group\\_" + std::to_string(BASE_UID) + "\\_bench%'");
+        }
+    }
+
+    static std::shared_ptr<ChatMsgNode> makeNode(const std::string& convId, const int from, const int to) {
+        auto node = std::make_shared<ChatMsgNode>();
+        node->msg.servId = gIdGen.next();
+        node->msg.msgId = gNextMsgId++;
+        node->msg.convId = convId;
+        node->msg.fromUid = from;
+        node->msg.toUid = to;
+        node->msg.type = 1;
+        node->msg.status = 0;
+        node->msg.content = "bench message " + std::to_string(node->msg.msgId);
+        return node;
+    }
+
+    /// 生成 size 条消息，轮流分布到前 convs 个会话（单聊为主，每第 8 个换成群聊）
+    static std::vector<std::shared_ptr<ChatMsgNode>> makeBatch(const size_t size, const int convs) {
+        std::vector<std::shared_ptr<ChatMsgNode>> batch;
+        batch.reserve(size);
+        for (size_t i = 0; i < size; i++) {
+            const int c = static_cast<int>(i % convs);
+            if (c % 8 == 7) {
+                batch.push_back(makeNode(groupId(c % GROUP_CONVS), BASE_UID + c % GROUP_MEMBERS, 0));
+            } else {
+                const int from = BASE_UID + 2 * c + static_cast<int>(i / convs % 2);
+                const int to = from ^ 1;
+                batch.push_back(makeNode(c2cId(c), from, to));
+            }
+        }
+        return batch;
+    }
+
+    /// 按 CounterService 的方式累加本批（去掉重复消息）的未读增量并写回
+    static void addUnread(const std::vector<std::shared_ptr<ChatMsgNode>>& batch,
+                          const std::vector<std::shared_ptr<ChatMsgNode>>& duplicates) {
+        UnreadDeltaTable table;
+        for (const auto& n : batch) {
+            if (std::find(duplicates.begin(), duplicates.end(), n) == duplicates.end()) {
+                table.add(n->msg.convId.value(), n->msg.servId, n->msg.fromUid);
+            }
+        }
+        int deadlocks = 0;
+        ASSERT_TRUE(gDao->batchAddUnreadCounts(table.drain(), deadlocks));
+    }
+
+    static inline MessageIdGenerator gIdGen{MessageIdGenerator::MAX_WORKER_ID};
+    static inline std::atomic<int> gNextMsgId{1};
+};
+
+}  // namespace
+
+// 单聊双方在同一批次内互发：各自的未读数只累加对方发送的条数，会话摘要取最新一条。
+// 消息插入不再更新未读数，增量写回后才可见。
+TEST_F(ConversationDaoBatchTest, C2CBothSidesInOneBatch) {
+    const std::string conv = c2cId(0);
+    const int a = BASE_UID;
+    const int b = BASE_UID + 1;
+    exec("UPDATE user_conversation SET unread_count = 0 WHERE conv_id = '" + conv + "'");
+
+    std::vector<std::shared_ptr<ChatMsgNode>> batch;
+    for (int i = 0; i < 3; i++) batch.push_back(makeNode(conv, a, b));
+    for (int i = 0; i < 2; i++) batch.push_back(makeNode(conv, b, a));
+    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+    ASSERT_TRUE(gDao->batchCreateMessages(batch, duplicates));
+    EXPECT_TRUE(duplicates.empty());
+
+    const auto where = "conv_id = '" + conv + "' AND uid = ";
+    EXPECT_EQ(queryInt("SELECT unread_count FROM user_conversation WHERE " + where + std::to_string(b)), 0);
+    addUnread(batch, duplicates);
+    EXPECT_EQ(queryInt("SELECT unread_count FROM user_conversation WHERE " + where + std::to_string(a)), 2);
+    EXPECT_EQ(queryInt("SELECT unread_count FROM user_conversation WHERE " + where + std::to_string(b)), 3);
+    EXPECT_EQ(queryInt("SELECT last_msg_id FROM conversation WHERE conv_id = '" + conv + "'"),
+              batch.back()->msg.servId);
+
+    // 重发的消息按重复处理，不再累加未读数
+    std::vector<std::shared_ptr<ChatMsgNode>> resend;
+    auto again = std::make_shared<ChatMsgNode>(*batch.front());
+    again->msg.servId = gIdGen.next();
+    resend.push_back(again);
+    duplicates.clear();
+    ASSERT_TRUE(gDao->batchCreateMessages(resend, duplicates));
+    ASSERT_EQ(duplicates.size(), 1u);
+    EXPECT_EQ(duplicates.front()->msg.servId, batch.front()->msg.servId);
+    addUnread(resend, duplicates);
+    EXPECT_EQ(queryInt("SELECT unread_count FROM user_conversation WHERE " + where + std::to_string(b)), 3);
+}
+
+// WAL 重放或死信重投已提交的消息 ID 与存储的相同，同样按重复处理；与新消息、客户端重发混在同一批次时逐条区分。
+TEST_F(ConversationDaoBatchTest, ReplayCommittedRows) {
+    const std::string conv = c2cId(3);
+    const int a = BASE_UID + 6;
+    const int b = BASE_UID + 7;
+    exec("UPDATE user_conversation SET unread_count = 0 WHERE conv_id = '" + conv + "'");
+
+    std::vector<std::shared_ptr<ChatMsgNode>> committed{makeNode(conv, a, b), makeNode(conv, a, b)};
+    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+    ASSERT_TRUE(gDao->batchCreateMessages(committed, duplicates));
+    addUnread(committed, duplicates);
+
+    auto resent = std::make_shared<ChatMsgNode>(*committed[1]);
+    resent->msg.servId = gIdGen.next();
+    const auto fresh = makeNode(conv, a, b);
+    std::vector<std::shared_ptr<ChatMsgNode>> replay{
+        std::make_shared<ChatMsgNode>(*committed[0]), resent, fresh};
+    duplicates.clear();
+    ASSERT_TRUE(gDao->batchCreateMessages(replay, duplicates));
+    ASSERT_EQ(duplicates.size(), 2u);
+    EXPECT_TRUE(std::find(duplicates.begin(), duplicates.end(), fresh) == duplicates.end());
+    EXPECT_EQ(resent->msg.servId, committed[1]->msg.servId);
+    EXPECT_EQ(replay[0]->msg.servId, committed[0]->msg.servId);
+    addUnread(replay, duplicates);
+    EXPECT_EQ(queryInt("SELECT unread_count FROM user_conversation WHERE conv_id = '" + conv
+        + "' AND uid = " + std::to_string(b)), 3);
+    EXPECT_EQ(queryInt("SELECT last_msg_id FROM conversation WHERE conv_id = '" + conv + "'"),
+              fresh->msg.servId);
+}
+
+// 群聊：发送者自己不计未读，其余成员按本批消息数累加。
+TEST_F(ConversationDaoBatchTest, GroupUnreadExcludesSender) {
+    const std::string conv = groupId(1);
+    exec("UPDATE user_conversation SET unread_count = 0 WHERE conv_id = '" + conv + "'");
+
+    std::vector<std::shared_ptr<ChatMsgNode>> batch;
+    for (int i = 0; i < 4; i++) batch.push_back(makeNode(conv, BASE_UID + 1, 0));
+    batch.push_back(makeNode(conv, BASE_UID + 2, 0));
+    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+    ASSERT_TRUE(gDao->batchCreateMessages(batch, duplicates));
+    addUnread(batch, duplicates);
+
+    const auto unread = [&conv](const int uid) {
+        return queryInt("SELECT unread_count FROM user_conversation WHERE conv_id = '" + conv
+            + "' AND uid = " + std::to_string(uid));
+    };
+    EXPECT_EQ(unread(BASE_UID + 1), 1);
+    EXPECT_EQ(unread(BASE_UID + 2), 4);
+    EXPECT_EQ(unread(BASE_UID + 3), 5);
+}
+
+// 对账：按已读水位与已计入的最大消息 ID 重新计算，只覆盖偏差的成员。
+TEST_F(ConversationDaoBatchTest, ReconcileUnreadDrift) {
+    const std::string conv = groupId(2);
+    exec("UPDATE user_conversation SET unread_count = 0, last_read_msg_id = 0 WHERE conv_id = '" + conv + "'");
+    exec("DELETE FROM message WHERE conv_id = '" + conv + "'");
+
+    std::vector<std::shared_ptr<ChatMsgNode>> batch;
+    for (int i = 0; i < 3; i++) batch.push_back(makeNode(conv, BASE_UID + 1, 0));
+    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+    ASSERT_TRUE(gDao->batchCreateMessages(batch, duplicates));
+    addUnread(batch, duplicates);
+    // 模拟丢失的增量与重复累加
+    exec("UPDATE user_conversation SET unread_count = 7 WHERE conv_id = '" + conv + "' AND uid = "
+         + std::to_string(BASE_UID + 2));
+    exec("UPDATE user_conversation SET unread_count = 1 WHERE conv_id = '" + conv + "' AND uid = "
+         + std::to_string(BASE_UID + 3));
+
+    // 上界之后的消息尚未计入增量，不参与对账
+    std::vector<std::shared_ptr<ChatMsgNode>> later{makeNode(conv, BASE_UID + 1, 0)};
+    ASSERT_TRUE(gDao->batchCreateMessages(later, duplicates));
+
+    ConvUnreadDelta target;
+    target.convId = conv;
+    target.maxMsgId = batch.back()->msg.servId;
+    std::vector<UnreadCountFix> fixed;
+    ASSERT_TRUE(gDao->reconcileUnreadCounts({target}, gIdGen.workerId(), fixed));
+    ASSERT_EQ(fixed.size(), 2u);
+    for (const auto& fix : fixed) {
+        EXPECT_EQ(fix.unreadCount, 3);
+        EXPECT_EQ(fix.drift, fix.uid == BASE_UID + 2 ? 4 : -2);
+    }
+    const auto unread = [&conv](const int uid) {
+        return queryInt("SELECT unread_count FROM user_conversation WHERE conv_id = '" + conv
+            + "' AND uid = " + std::to_string(uid));
+    };
+    EXPECT_EQ(unread(BASE_UID + 1), 0);
+    EXPECT_EQ(unread(BASE_UID + 2), 3);
+    EXPECT_EQ(unread(BASE_UID + 3), 3);
+
+    fixed.clear();
+    ASSERT_TRUE(gDao->reconcileUnreadCounts({target}, gIdGen.workerId(), fixed));
+    EXPECT_TRUE(fixed.empty());
+}
+
+// 多台服务器写入同一会话：水位之后有其他机器号的消息时，对方的增量可能尚未写回，该成员不对账。
+TEST_F(ConversationDaoBatchTest, ReconcileSkipsOtherServerMessages) {
+    const std::string conv = groupId(3);
+    const int member = BASE_UID + 2;
+    exec("UPDATE user_conversation SET unread_count = 0, last_read_msg_id = 0 WHERE conv_id = '" + conv + "'");
+    exec("DELETE FROM message WHERE conv_id = '" + conv + "'");
+
+    std::vector<std::shared_ptr<ChatMsgNode>> batch;
+    for (int i = 0; i < 2; i++) batch.push_back(makeNode(conv, BASE_UID + 1, 0));
+    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+    ASSERT_TRUE(gDao->batchCreateMessages(batch, duplicates));
+    addUnread(batch, duplicates);
+
+    // 其他服务器的消息已落库，增量仍在对方的待写回表中
+    MessageIdGenerator peer(0);
+    auto remote = makeNode(conv, BASE_UID + 1, 0);
+    remote->msg.servId = peer.next();
+    std::vector<std::shared_ptr<ChatMsgNode>> remoteBatch{remote};
+    ASSERT_TRUE(gDao->batchCreateMessages(remoteBatch, duplicates));
+
+    ConvUnreadDelta target;
+    target.convId = conv;
+    target.maxMsgId = std::max(batch.back()->msg.servId, remote->msg.servId);
+    std::vector<UnreadCountFix> fixed;
+    ASSERT_TRUE(gDao->reconcileUnreadCounts({target}, gIdGen.workerId(), fixed));
+    EXPECT_TRUE(fixed.empty());
+    const auto unread = [&conv](const int uid) {
+        return queryInt("SELECT unread_count FROM user_conversation WHERE conv_id = '" + conv
+            + "' AND uid = " + std::to_string(uid));
+    };
+    EXPECT_EQ(unread(member), 2);
+
+    // 水位越过其他服务器的消息后恢复对账
+    exec("UPDATE user_conversation SET unread_count = 5, last_read_msg_id = " + std::to_string(target.maxMsgId)
+         + " WHERE conv_id = '" + conv + "' AND uid = " + std::to_string(member));
+    ASSERT_TRUE(gDao->reconcileUnreadCounts({target}, gIdGen.workerId(), fixed));
+    ASSERT_EQ(fixed.size(), 1u);
+    EXPECT_EQ(fixed[0].uid, member);
+    EXPECT_EQ(fixed[0].unreadCount, 0);
+    EXPECT_EQ(unread(member), 0);
+}
+
+// 已读水位与尚未写回的增量交错：重算未读数只计到已计入增量的消息，之后的由增量累加，不重复计数。
+// 水位之前的待写回增量由 CounterService 在重算前写回，这里只覆盖水位之后的部分。
+TEST_F(ConversationDaoBatchTest, ReadWatermarkWithPendingDelta) {
+    const std::string conv = c2cId(2);
+    const int a = BASE_UID + 4;
+    const int b = BASE_UID + 5;
+    exec("UPDATE user_conversation SET unread_count = 0, last_read_msg_id = 0 WHERE conv_id = '" + conv + "'");
+    exec("DELETE FROM message WHERE conv_id = '" + conv + "'");
+
+    std::vector<std::shared_ptr<ChatMsgNode>> counted;
+    for (int i = 0; i < 3; i++) counted.push_back(makeNode(conv, a, b));
+    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+    ASSERT_TRUE(gDao->batchCreateMessages(counted, duplicates));
+    addUnread(counted, duplicates);
+
+    // 已落库、增量尚未写回
+    std::vector<std::shared_ptr<ChatMsgNode>> pending{makeNode(conv, a, b), makeNode(conv, a, b)};
+    ASSERT_TRUE(gDao->batchCreateMessages(pending, duplicates));
+
+    MessageStatusWatermark mark;
+    mark.uid = b;
+    mark.convId = conv;
+    mark.status = static_cast<int8_t>(MessageStatus::IS_READ);
+    mark.lastMsgId = counted[1]->msg.servId;
+    mark.countedMsgId = pending.front()->msg.servId - 1;
+    ASSERT_TRUE(gDao->batchUpdateMessageStatus({mark}));
+
+    const auto unread = [&conv, b] {
+        return queryInt("SELECT unread_count FROM user_conversation WHERE conv_id = '" + conv
+            + "' AND uid = " + std::to_string(b));
+    };
+    EXPECT_EQ(unread(), 1);
+    addUnread(pending, duplicates);
+    EXPECT_EQ(unread(), 3);
+
+    // 没有待写回增量时不设上界
+    mark.lastMsgId = counted[2]->msg.servId;
+    mark.countedMsgId = std::numeric_limits<int64_t>::max();
+    ASSERT_TRUE(gDao->batchUpdateMessageStatus({mark}));
+    EXPECT_EQ(unread(), 2);
+}
+
+// 每批语句数只与批次大小相关，不随涉及的会话数增长；同时输出批次提交延迟。
+TEST_F(ConversationDaoBatchTest, StatementsPerBatch) {
+    constexpr int rounds = 20;
+    std::cout << "\n=== batchCreateMessages ===" << std::endl;
+    std::cout << "Batch | Convs | Stmts/batch | p50 (ms) | p99 (ms)" << std::endl;
+    std::cout << "------|-------|-------------|----------|---------" << std::endl;
+
+    for (const size_t size : {64, 256}) {
+        std::vector<double> stmtCounts;
+        for (const int convs : {1, 16, C2C_CONVS}) {
+            std::vector<double> latency;
+            const int64_t before = questions();
+            for (int r = 0; r < rounds; r++) {
+                auto batch = makeBatch(size, convs);
+                std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+                const auto start = std::chrono::steady_clock::now();
+                ASSERT_TRUE(gDao->batchCreateMessages(batch, duplicates));
+                latency.push_back(std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+            const double stmts = static_cast<double>(questions() - before - 1) / rounds;
+            stmtCounts.push_back(stmts);
+
+            std::sort(latency.begin(), latency.end());
+            std::cout << std::setw(5) << size << " | "
+                      << std::setw(5) << convs << " | "
+                      << std::setw(11) << std::fixed << std::setprecision(1) << stmts << " | "
+                      << std::setw(8) << std::setprecision(2) << latency[latency.size() / 2] << " | "
+                      << std::setw(8) << latency[latency.size() * 99 / 100] << std::endl;
+        }
+        // 其他连接的语句也会计入 Questions，留少量余量
+        EXPECT_LE(stmtCounts.back(), stmtCounts.front() + 1.0) << "batch=" << size;
+    }
+    std::cout << "=================================================\n" << std::endl;
+}
+
+// AIMD 批次大小对真实 MySQL 的反馈：另一个会话周期性锁住会话行模拟限速，
+// 限速期间批次缩小、提交耗时回落，解除后重新增长。
+TEST_F(ConversationDaoBatchTest, AdaptiveSizingUnderLockContention) {
+    constexpr int rounds = 60;
+    BatchSizeController::Bounds bounds;
+    bounds.minBatch = 16;
+    bounds.maxBatch = 1024;
+    bounds.initBatch = 256;
+    bounds.batchStep = 16;
+    bounds.minChunk = 10;
+    bounds.maxChunk = 500;
+    bounds.initChunk = 50;
+    bounds.chunkStep = 5;
+    bounds.targetLatency = std::chrono::milliseconds(20);
+    BatchSizeController sizer(bounds);
+
+    const auto run = [&sizer](const char* phase) {
+        std::vector<double> latency;
+        for (int r = 0; r < rounds; r++) {
+            auto batch = makeBatch(sizer.batchSize(), C2C_CONVS);
+            std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+            int deadlocks = 0;
+            const auto start = std::chrono::steady_clock::now();
+            const bool ok = gDao->batchCreateMessages(batch, duplicates, sizer.chunkSize(), deadlocks);
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+            sizer.onCommit(batch.size(), elapsed, deadlocks);
+            EXPECT_TRUE(ok);
+            latency.push_back(elapsed.count() / 1000.0);
+        }
+        std::sort(latency.begin(), latency.end());
+        std::cout << std::left << std::setw(10) << phase << " | " << std::right
+                  << std::setw(5) << sizer.batchSize() << " | "
+                  << std::setw(5) << sizer.chunkSize() << " | "
+                  << std::setw(8) << std::fixed << std::setprecision(2) << latency[latency.size() / 2] << " | "
+                  << std::setw(8) << latency[latency.size() * 99 / 100] << std::endl;
+        return sizer.batchSize();
+    };
+
+    std::cout << "\n=== AIMD Batch Sizing (local MySQL) ===" << std::endl;
+    std::cout << "Phase      | Batch | Chunk | p50 (ms) | p99 (ms)" << std::endl;
+    std::cout << "-----------|-------|-------|----------|---------" << std::endl;
+    const size_t normal = run("normal");
+
+    // 限速：持有全部测试会话的行锁 30ms，释放 10ms
+    std::atomic<bool> throttling{true};
+    std::thread throttle([&throttling] {
+        auto* driver = sql::mysql::get_mysql_driver_instance();
+        driver->threadInit();
+        try {
+            const auto conn = connect();
+            conn->setAutoCommit(false);
+            const std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+            while (throttling.load()) {
+                std::unique_ptr<sql::ResultSet>(stmt->executeQuery(
+                    "SELECT conv_id FROM conversation WHERE conv_id LIKE 'c2c\\_9900___\\_9900___' FOR UPDATE"));
+                std::this_thread::sleep_for(std::chrono::milliseconds(30));
+                conn->commit();
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        } catch (sql::SQLException& e) {
+            std::cerr << "[AdaptiveSizing] throttle error: " << e.what() << std::endl;
+        }
+        driver->threadEnd();
+    });
+    const size_t throttled = run("throttled");
+    throttling.store(false);
+    throttle.join();
+
+    run("recovered");
+    std::cout << "=================================================\n" << std::endl;
+
+    EXPECT_LE(throttled, normal);
+}
+
+// 热点会话并发写入：按 Session 路由时多个写入线程的批次都包含同一批热点会话，行锁冲突和死锁重试
+// 随之出现；按 conv_id 路由时每个会话只出现在一个线程的批次中，冲突消失。
+TEST_F(ConversationDaoBatchTest, HotConversationRouting) {
+    constexpr int writers = 4;
+    constexpr int hotConvs = 4;
+    constexpr int batchesPerWriter = 40;
+    constexpr size_t batchSize = 64;
+
+    struct Result {
+        int deadlocks = 0;
+        int failed = 0;
+        double seconds = 0;
+        std::vector<double> latency;
+    };
+    // convsOf(w) 返回写入线程 w 的批次涉及的会话
+    const auto run = [](const std::function<std::vector<int>(int)>& convsOf) {
+        Result result;
+        std::mutex mtx;
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+        for (int w = 0; w < writers; w++) {
+            threads.emplace_back([&, w] {
+                const auto convs = convsOf(w);
+                for (int b = 0; b < batchesPerWriter; b++) {
+                    std::vector<std::shared_ptr<ChatMsgNode>> batch;
+                    for (size_t i = 0; i < batchSize; i++) {
+                        const int c = convs[i % convs.size()];
+                        const int from = BASE_UID + 2 * c + static_cast<int>(i / convs.size() % 2);
+                        batch.push_back(makeNode(c2cId(c), from, from ^ 1));
+                    }
+                    std::vector<std::shared_ptr<ChatMsgNode>> duplicates;
+                    int deadlocks = 0;
+                    const auto t0 = std::chrono::steady_clock::now();
+                    const bool ok = gDao->batchCreateMessages(batch, duplicates, 50, deadlocks);
+                    const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - t0).count();
+                    std::lock_guard<std::mutex> lock(mtx);
+                    result.deadlocks += deadlocks;
+                    result.failed += ok ? 0 : 1;
+                    result.latency.push_back(ms);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::sort(result.latency.begin(), result.latency.end());
+        return result;
+    };
+
+    std::cout << "\n=== Hot Conversation Routing ===" << std::endl;
+    std::cout << "Routing | Deadlocks | Failed | msg/s  | p99 (ms)" << std::endl;
+    std::cout << "--------|-----------|--------|--------|---------" << std::endl;
+    const auto print = [](const char* routing, const Result& r) {
+        std::cout << std::left << std::setw(7) << routing << " | " << std::right
+                  << std::setw(9) << r.deadlocks << " | "
+                  << std::setw(6) << r.failed << " | "
+                  << std::setw(6) << std::fixed << std::setprecision(0)
+                  << writers * batchesPerWriter * batchSize / r.seconds << " | "
+                  << std::setw(8) << std::setprecision(2) << r.latency[r.latency.size() * 99 / 100] << std::endl;
+    };
+
+    // 按 Session 路由：每个线程的批次都覆盖全部热点会话
+    const auto bySession = run([](int) {
+        std::vector<int> convs;
+        for (int c = 0; c < hotConvs; c++) convs.push_back(c);
+        return convs;
+    });
+    print("session", bySession);
+
+    // 按 conv_id 路由：每个热点会话只归属一个线程
+    const auto byConv = run([](const int w) { return std::vector<int>{w % hotConvs}; });
+    print("conv_id", byConv);
+    std::cout << "=================================\n" << std::endl;
+
+    EXPECT_EQ(byConv.deadlocks, 0);
+    EXPECT_EQ(byConv.failed, 0);
+}
@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConversationListCache.h"
+#include "MessageIdGenerator.h"
+
+namespace {
+
+/// 内存中的 user_conversation JOIN conversation，按用户保存会话，统计列表查询和对方资料查询次数
+class FakeConversationTable {
+public:
+    void insert(const int uid, ConversationInfo info) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        info.uid = uid;
+        rows_[uid].push_back(std::move(info));
+    }
+
+    /// 冷加载：一次查询全部会话，对方资料只在此时逐个查询
+    bool selectAll(const int uid, std::vector<ConversationInfo>& result) {
+        queries_.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::sleep_for(latency_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            result = rows_[uid];
+        }
+        for (auto& info : result) {
+            peerLookups_.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(peerLatency_);
+            info.title = "peer_" + std::to_string(info.getOtherUid());
+        }
+        return true;
+    }
+
+    /// 原做法：JOIN 查询 LIMIT limit，再逐个会话查询对方资料
+    void selectPage(const int uid, const int limit, std::vector<ConversationInfo>& result) {
+        queries_.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::sleep_for(latency_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto& rows = rows_[uid];
+            result.assign(rows.begin(), rows.begin() + std::min<size_t>(limit, rows.size()));
+        }
+        for (auto& info : result) {
+            peerLookups_.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(peerLatency_);
+            info.title = "peer_" + std::to_string(info.getOtherUid());
+        }
+    }
+
+    ConversationListCache::loadHandler loader() {
+        return [this](const int uid, std::vector<ConversationInfo>& result) {
+            return selectAll(uid, result);
+        };
+    }
+
+    std::atomic<uint64_t> queries_{0};
+    std::atomic<uint64_t> peerLookups_{0};
+    std::chrono::microseconds latency_{0};
+    std::chrono::microseconds peerLatency_{0};
+
+private:
+    std::mutex mutex_;
+    std::map<int, std::vector<ConversationInfo>> rows_;
+};
+
+ConversationInfo makeConversation(const int uid, const int other, const int64_t lastMsgId) {
+    ConversationInfo info;
+    info.convType = static_cast<int8_t>(ConvType::PRIVATE_CHAT);
+    info.convId = "c2c_" + std::to_string(std::min(uid, other)) + "_" + std::to_string(std::max(uid, other));
+    info.lastMsgId = lastMsgId;
+    info.unreadCount = 0;
+    info.updateTime = "2026-10-18 00:00:00";
+    return info;
+}
+
+MessageInfo makeMessage(MessageIdGenerator& gen, const std::string& convId, const int fromUid, const int toUid) {
+    MessageInfo msg;
+    msg.servId = gen.next();
+    msg.convId = convId;
+    msg.fromUid = fromUid;
+    msg.toUid = toUid;
+    msg.type = 1;
+    msg.content = "hello";
+    return msg;
+}
+
+ConversationListCache::Options makeOptions() {
+    ConversationListCache::Options options;
+    options.ttl = std::chrono::hours(1);
+    return options;
+}
+
+/// 逐页拉取全部会话
+std::vector<ConversationInfo> fetchAll(ConversationListCache& cache, const int uid, const int limit) {
+    std::vector<ConversationInfo> all;
+    std::string cursor;
+    do {
+        std::vector<ConversationInfo> page;
+        std::string next;
+        EXPECT_TRUE(cache.fetch(uid, cursor, limit, page, next));
+        all.insert(all.end(), page.begin(), page.end());
+        cursor = next;
+    } while (!cursor.empty());
+    return all;
+}
+
+}  // namespace
+
+// 超过 50 个会话时按游标逐页拉取，按活跃时间倒序，不重复不遗漏，只加载一次。
+TEST(ConversationListCacheTest, CursorPagingBeyondFifty) {
+    MessageIdGenerator gen(1);
+    FakeConversationTable table;
+    for (int i = 0; i < 120; i++) {
+        table.insert(1, makeConversation(1, 100 + i, gen.next()));
+    }
+    ConversationListCache cache(makeOptions(), table.loader());
+
+    const auto all = fetchAll(cache, 1, 50);
+    ASSERT_EQ(all.size(), 120u);
+    EXPECT_TRUE(std::is_sorted(all.begin(), all.end(), [](const ConversationInfo& a, const ConversationInfo& b) {
+        return a.lastMsgId > b.lastMsgId;
+    }));
+    EXPECT_EQ(all.front().title.value_or(""), "peer_219");
+    EXPECT_EQ(table.queries_.load(), 1u);
+
+    std::vector<ConversationInfo> page;
+    std::string next;
+    EXPECT_FALSE(cache.fetch(1, "not-a-cursor", 50, page, next));
+}
+
+// 新消息原地更新：会话移到最前，接收方未读数加一，发送方不变；已读到最新一条时清零。
+TEST(ConversationListCacheTest, MessageMovesConversationToFront) {
+    MessageIdGenerator gen(1);
+    FakeConversationTable table;
+    for (int i = 0; i < 10; i++) {
+        table.insert(1, makeConversation(1, 100 + i, gen.next()));
+        table.insert(100 + i, makeConversation(100 + i, 1, 0));
+    }
+    ConversationListCache cache(makeOptions(), table.loader());
+    fetchAll(cache, 1, 50);
+    fetchAll(cache, 100, 50);
+
+    // 活跃时间精确到毫秒，同一毫秒内按 conv_id 排序
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    const auto msg = makeMessage(gen, "c2c_1_100", 100, 1);
+    cache.onMessage(1, msg);
+    cache.onMessage(100, msg);
+
+    std::vector<ConversationInfo> page;
+    std::string next;
+    ASSERT_TRUE(cache.fetch(1, "", 3, page, next));
+    ASSERT_EQ(page.front().convId, "c2c_1_100");
+    EXPECT_EQ(page.front().lastMsgId, msg.servId);
+    EXPECT_EQ(page.front().lastMsgContent.value_or(""), "hello");
+    EXPECT_EQ(page.front().unreadCount, 1);
+    EXPECT_FALSE(next.empty());
+
+    ASSERT_TRUE(cache.fetch(100, "", 3, page, next));
+    EXPECT_EQ(page.front().unreadCount, 0);
+
+    EXPECT_EQ(cache.onRead(1, "c2c_1_100", msg.servId, 1), 0);
+    EXPECT_EQ(cache.onRead(7, "c2c_1_100", msg.servId, 1), -1);
+    EXPECT_EQ(table.queries_.load(), 2u);
+}
+
+// 列表中没有的会话（新建的会话）无法原地更新，丢弃列表后重新加载；invalidate 同理。
+TEST(ConversationListCacheTest, UnknownConversationReloads) {
+    MessageIdGenerator gen(1);
+    FakeConversationTable table;
+    table.insert(1, makeConversation(1, 2, gen.next()));
+    ConversationListCache cache(makeOptions(), table.loader());
+    EXPECT_EQ(fetchAll(cache, 1, 50).size(), 1u);
+
+    table.insert(1, makeConversation(1, 3, 0));
+    cache.onMessage(1, makeMessage(gen, "c2c_1_3", 3, 1));
+    EXPECT_EQ(fetchAll(cache, 1, 50).size(), 2u);
+    EXPECT_EQ(table.queries_.load(), 2u);
+
+    cache.invalidate(1);
+    fetchAll(cache, 1, 50);
+    EXPECT_EQ(table.queries_.load(), 3u);
+    EXPECT_GE(cache.stats().drops, 2u);
+}
+
+// 打开应用拉取首页：原做法每次 JOIN 查询 + 逐个会话查询对方资料，对比会话列表缓存。
+// 列表查询按 300us、对方资料按 20us 模拟，分别测 20 / 200 / 1000 个会话。
+TEST(ConversationListCacheBench, FirstPageLatencyVsConversationCount) {
+    constexpr int users = 16;
+    constexpr int opensPerUser = 200;
+    constexpr int pageSize = 50;
+
+    struct Result {
+        uint64_t queries = 0;
+        uint64_t peerLookups = 0;
+        double p99 = 0;
+    };
+    const auto run = [&](const int convs, const bool cached) {
+        MessageIdGenerator gen(1);
+        FakeConversationTable table;
+        table.latency_ = std::chrono::microseconds(300);
+        table.peerLatency_ = std::chrono::microseconds(20);
+        for (int u = 0; u < users; u++) {
+            for (int c = 0; c < convs; c++) {
+                table.insert(u, makeConversation(u, 100000 + c, gen.next()));
+            }
+        }
+        ConversationListCache cache(makeOptions(), table.loader());
+
+        std::vector<double> latency;
+        std::mutex mtx;
+        std::vector<std::thread> threads;
+        for (int u = 0; u < users; u++) {
+            threads.emplace_back([&, u] {
+                std::vector<double> local;
+                for (int i = 0; i < opensPerUser; i++) {
+                    const auto t0 = std::chrono::steady_clock::now();
+                    std::vector<ConversationInfo> page;
+                    std::string next;
+                    if (cached) {
+                        EXPECT_TRUE(cache.fetch(u, "", pageSize, page, next));
+                    }
+                    else {
+                        table.selectPage(u, pageSize, page);
+                    }
+                    local.push_back(std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - t0).count());
+                    EXPECT_EQ(page.size(), static_cast<size_t>(std::min(convs, pageSize)));
+                }
+                std::lock_guard<std::mutex> lock(mtx);
+                latency.insert(latency.end(), local.begin(), local.end());
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        std::sort(latency.begin(), latency.end());
+        return Result{table.queries_.load(), table.peerLookups_.load(), latency[latency.size() * 99 / 100]};
+    };
+
+    std::cout << "\n=== Conversation List (first page) ===" << std::endl;
+    std::cout << "Convs | Mode  | list queries | peer lookups | p99 (us)" << std::endl;
+    std::cout << "------|-------|--------------|--------------|---------" << std::endl;
+    const auto print = [](const int convs, const char* mode, const Result& r) {
+        std::cout << std::setw(5) << convs << " | " << std::left << std::setw(5) << mode << std::right << " | "
+                  << std::setw(12) << r.queries << " | "
+                  << std::setw(12) << r.peerLookups << " | "
+                  << std::setw(8) << std::fixed << std::setprecision(1) << r.p99 << std::endl;
+    };
+    for (const int convs : {20, 200, 1000}) {
+        const auto direct = run(convs, false);
+        const auto cached = run(convs, true);
+        print(convs, "mysql", direct);
+        print(convs, "cache", cached);
+        EXPECT_EQ(cached.queries, static_cast<uint64_t>(users));
+        EXPECT_LT(cached.p99, direct.p99);
+    }
+    std::cout << "======================================\n" << std::endl;
+}
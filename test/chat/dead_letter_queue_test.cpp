@@ -0,0 +1,333 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DeadLetterQueue.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+std::shared_ptr<ChatMsgNode> makeNode(const int msgId) {
+    MessageInfo info;
+    info.fromUid = 1;
+    info.toUid = 2;
+    info.msgId = msgId;
+    info.type = 1;
+    info.convId = "c2c_1_2";
+    info.content = "m";
+    return std::make_shared<ChatMsgNode>(info, nullptr);
+}
+
+DeadLetterQueue::Batch makeBatch(const int first, const int count) {
+    DeadLetterQueue::Batch batch;
+    for (int i = first; i < first + count; i++) {
+        batch.push_back(makeNode(i));
+    }
+    return batch;
+}
+
+/// 等待条件成立，超时返回 false
+bool waitFor(const std::function<bool()>& pred, const std::chrono::milliseconds timeout = 5s) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+/// 重投回调：记录每次调用的批次和时间，按 accept 决定单条消息能否写入，整批全部可写入才成功
+class FakeRedeliver {
+public:
+    explicit FakeRedeliver(std::function<bool(int msgId)> accept) : accept_(std::move(accept)) {}
+
+    bool operator()(DeadLetterQueue::Batch& batch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        calls_.push_back(std::chrono::steady_clock::now());
+        const bool ok = std::all_of(batch.begin(), batch.end(), [this](const auto& node) {
+            return accept_(node->msg.msgId);
+        });
+        if (ok) {
+            for (const auto& node : batch) {
+                delivered_.push_back(node->msg.msgId);
+            }
+        }
+        else {
+            failed_.push_back(batch.size());
+        }
+        return ok;
+    }
+
+    void setAccept(std::function<bool(int msgId)> accept) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accept_ = std::move(accept);
+    }
+
+    std::vector<int> delivered() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return delivered_;
+    }
+
+    /// 每次失败的批次大小
+    std::vector<size_t> failed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return failed_;
+    }
+
+    std::vector<std::chrono::steady_clock::time_point> calls() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return calls_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::function<bool(int msgId)> accept_;
+    std::vector<int> delivered_;
+    std::vector<size_t> failed_;
+    std::vector<std::chrono::steady_clock::time_point> calls_;
+};
+
+class DeadLetterQueueTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = (std::filesystem::temp_directory_path() /
+            ("imserver_dlq_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+             ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir_);
+        // 未启动时入队也可能写溢出文件，目录提前建好
+        std::filesystem::create_directories(dir_);
+        options_.dir = dir_;
+        options_.retryBase = 5ms;
+        options_.retryMax = 40ms;
+        options_.maxAttempts = 3;
+        options_.reloadBatchSize = 2;
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    /// 一条测试消息计入内存预算的字节数
+    static size_t nodeBytes() {
+        return makeNode(0)->estimateBytes();
+    }
+
+    size_t lines(const std::string& file) const {
+        std::ifstream in(dir_ + "/" + file);
+        size_t count = 0;
+        for (std::string line; std::getline(in, line);) {
+            count++;
+        }
+        return count;
+    }
+
+    std::string dir_;
+    DeadLetterQueue::Options options_;
+};
+
+}  // namespace
+
+// MySQL 可用时失败的批次逐次对半拆分，其余消息全部写入，只有毒消息被隔离。
+TEST_F(DeadLetterQueueTest, BisectPoisonMessage) {
+    constexpr int POISON = 5;
+    DeadLetterQueue* queue = nullptr;
+    FakeRedeliver redeliver([&queue](const int msgId) {
+        if (msgId != POISON) {
+            return true;
+        }
+        // 其他写入持续成功，失败由这条消息本身引起
+        queue->onWriteSucceeded();
+        return false;
+    });
+    std::vector<int> poisoned;
+    std::mutex poisonMtx;
+    DeadLetterQueue dlq(options_,
+        [&redeliver](DeadLetterQueue::Batch& batch) { return redeliver(batch); },
+        [&](const std::shared_ptr<ChatMsgNode>& node) {
+            std::lock_guard<std::mutex> lock(poisonMtx);
+            poisoned.push_back(node->msg.msgId);
+        });
+    queue = &dlq;
+    ASSERT_TRUE(dlq.start());
+
+    dlq.add(makeBatch(0, 8));
+    ASSERT_TRUE(waitFor([&dlq] { return dlq.stats().poisoned == 1 && dlq.stats().depth == 0; }));
+    dlq.stop();
+
+    auto delivered = redeliver.delivered();
+    std::sort(delivered.begin(), delivered.end());
+    EXPECT_EQ(delivered, (std::vector<int>{0, 1, 2, 3, 4, 6, 7}));
+    EXPECT_EQ(poisoned, std::vector<int>{POISON});
+    EXPECT_EQ(dlq.stats().redelivered, 7u);
+    // 8 -> 4 -> 2 -> 1 逐次拆分，单条消息失败 maxAttempts 次后隔离
+    EXPECT_EQ(redeliver.failed(), (std::vector<size_t>{8, 4, 2, 1, 1, 1}));
+    EXPECT_EQ(lines("poison.log"), 1u);
+}
+
+// MySQL 整体不可用时重投间隔指数增长到上限，恢复后清零。
+TEST_F(DeadLetterQueueTest, BackoffWhileUnavailable) {
+    options_.retryBase = 10ms;
+    options_.retryMax = 80ms;
+    FakeRedeliver redeliver([](int) { return false; });
+    DeadLetterQueue dlq(options_,
+        [&redeliver](DeadLetterQueue::Batch& batch) { return redeliver(batch); }, nullptr);
+    ASSERT_TRUE(dlq.start());
+    dlq.add(makeBatch(0, 1));
+
+    // 10 -> 20 -> 40 -> 80，之后保持上限
+    ASSERT_TRUE(waitFor([&redeliver] { return redeliver.calls().size() >= 6; }));
+    EXPECT_EQ(dlq.stats().backoffMs, 80);
+    EXPECT_EQ(dlq.stats().poisoned, 0u);
+    const auto calls = redeliver.calls();
+    // 抖动范围为 0.5 ~ 1.5 倍，达到上限后的间隔不低于 40ms
+    EXPECT_GE(calls[5] - calls[4], 40ms);
+
+    redeliver.setAccept([](int) { return true; });
+    ASSERT_TRUE(waitFor([&dlq] { return dlq.stats().redelivered == 1; }, 2s));
+    EXPECT_EQ(dlq.stats().backoffMs, 0);
+    EXPECT_EQ(dlq.stats().depth, 0u);
+    dlq.stop();
+}
+
+// 内存超出预算后新批次写入溢出文件，内存队列降下来后按批读回重投，读完后删除文件。
+TEST_F(DeadLetterQueueTest, SpillBeyondMemoryBudget) {
+    options_.memoryBytes = 4 * nodeBytes();
+    FakeRedeliver redeliver([](int) { return true; });
+    DeadLetterQueue dlq(options_,
+        [&redeliver](DeadLetterQueue::Batch& batch) { return redeliver(batch); }, nullptr);
+
+    // 未启动重投线程，入队结果确定
+    dlq.add(makeBatch(0, 2));
+    dlq.add(makeBatch(2, 2));
+    dlq.add(makeBatch(4, 2));
+    // 溢出文件有积压时即使内存够用也写入文件，保持先后顺序
+    dlq.add(makeBatch(6, 1));
+    auto stats = dlq.stats();
+    EXPECT_EQ(stats.depth, 4u);
+    EXPECT_EQ(stats.memoryBytes, 4 * nodeBytes());
+    EXPECT_EQ(stats.spilled, 3u);
+    EXPECT_EQ(lines("spill.log"), 3u);
+
+    ASSERT_TRUE(dlq.start());
+    ASSERT_TRUE(waitFor([&dlq] { return dlq.stats().redelivered == 7; }));
+    dlq.stop();
+
+    EXPECT_EQ(redeliver.delivered(), (std::vector<int>{0, 1, 2, 3, 4, 5, 6}));
+    EXPECT_EQ(dlq.stats().spilled, 0u);
+    EXPECT_FALSE(std::filesystem::exists(dir_ + "/spill.log"));
+}
+
+// stop 时内存中的消息写入溢出文件；重启后从记录的读取位置继续，已读回并写入的消息不再重投。
+TEST_F(DeadLetterQueueTest, ReplayAfterRestart) {
+    options_.memoryBytes = 2 * nodeBytes();
+    options_.maxAttempts = 100;
+    {
+        FakeRedeliver redeliver([](const int msgId) { return msgId <= 2; });
+        DeadLetterQueue dlq(options_,
+            [&redeliver](DeadLetterQueue::Batch& batch) { return redeliver(batch); }, nullptr);
+        // 0、1 在内存中，2、3、4 溢出到文件
+        for (int i = 0; i < 5; i++) {
+            dlq.add(makeBatch(i, 1));
+        }
+        ASSERT_EQ(dlq.stats().spilled, 3u);
+        ASSERT_TRUE(dlq.start());
+
+        // 0、1 写入后读回 2、3 并记录读取位置，2 写入，3 一直失败
+        ASSERT_TRUE(waitFor([&redeliver] {
+            const auto delivered = redeliver.delivered();
+            return delivered.size() == 3 && redeliver.failed().size() >= 3;
+        }));
+        EXPECT_EQ(redeliver.delivered(), (std::vector<int>{0, 1, 2}));
+        EXPECT_EQ(dlq.stats().spilled, 1u);
+        dlq.stop();
+    }
+    EXPECT_TRUE(std::filesystem::exists(dir_ + "/spill.offset"));
+    EXPECT_EQ(lines("spill.log"), 4u);
+
+    FakeRedeliver redeliver([](int) { return true; });
+    DeadLetterQueue dlq(options_,
+        [&redeliver](DeadLetterQueue::Batch& batch) { return redeliver(batch); }, nullptr);
+    ASSERT_TRUE(dlq.start());
+    ASSERT_TRUE(waitFor([&dlq] { return dlq.stats().redelivered == 2; }));
+    dlq.stop();
+
+    // 4 仍在溢出文件中，3 在 stop 时追加到文件末尾
+    EXPECT_EQ(redeliver.delivered(), (std::vector<int>{4, 3}));
+    EXPECT_EQ(dlq.stats().spilled, 0u);
+}
+
+// 读回的消息写入成功之前不记录读取位置：此时进程崩溃，重启后从原位置重新读回，消息不丢失。
+TEST_F(DeadLetterQueueTest, OffsetWaitsForRedelivery) {
+    options_.memoryBytes = 2 * nodeBytes();
+    options_.maxAttempts = 100;
+    const std::string crashDir = dir_ + "_crash";
+    std::filesystem::remove_all(crashDir);
+    {
+        FakeRedeliver redeliver([](const int msgId) { return msgId < 2; });
+        DeadLetterQueue dlq(options_,
+            [&redeliver](DeadLetterQueue::Batch& batch) { return redeliver(batch); }, nullptr);
+        // 0、1 在内存中，2、3 溢出到文件
+        for (int i = 0; i < 4; i++) {
+            dlq.add(makeBatch(i, 1));
+        }
+        ASSERT_TRUE(dlq.start());
+        // 2、3 已读回但一直写入失败
+        ASSERT_TRUE(waitFor([&dlq, &redeliver] {
+            return dlq.stats().spilled == 0 && redeliver.failed().size() >= 3;
+        }));
+        EXPECT_EQ(redeliver.delivered(), (std::vector<int>{0, 1}));
+        // 复制此刻的目录作为崩溃现场
+        std::filesystem::copy(dir_, crashDir);
+        dlq.stop();
+    }
+
+    auto crashOptions = options_;
+    crashOptions.dir = crashDir;
+    FakeRedeliver redeliver([](int) { return true; });
+    DeadLetterQueue dlq(crashOptions,
+        [&redeliver](DeadLetterQueue::Batch& batch) { return redeliver(batch); }, nullptr);
+    ASSERT_TRUE(dlq.start());
+    ASSERT_TRUE(waitFor([&dlq] { return dlq.stats().redelivered == 2; }));
+    dlq.stop();
+    auto delivered = redeliver.delivered();
+    std::sort(delivered.begin(), delivered.end());
+    EXPECT_EQ(delivered, (std::vector<int>{2, 3}));
+    std::filesystem::remove_all(crashDir);
+}
+
+// 溢出的消息读回后保留写入方计入的内存预算字节数，由写入方在重投成功后归还。
+TEST_F(DeadLetterQueueTest, SpillKeepsBudgetCharge) {
+    options_.memoryBytes = nodeBytes();
+    std::mutex mtx;
+    std::vector<size_t> charged;
+    DeadLetterQueue dlq(options_, [&](DeadLetterQueue::Batch& batch) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const auto& node : batch) {
+            charged.push_back(node->mem_bytes);
+        }
+        return true;
+    }, nullptr);
+
+    for (int i = 0; i < 3; i++) {
+        auto batch = makeBatch(i, 1);
+        batch.front()->mem_bytes = 100 + i;
+        dlq.add(std::move(batch));
+    }
+    ASSERT_EQ(dlq.stats().spilled, 2u);
+    ASSERT_TRUE(dlq.start());
+    ASSERT_TRUE(waitFor([&dlq] { return dlq.stats().redelivered == 3; }));
+    dlq.stop();
+    EXPECT_EQ(charged, (std::vector<size_t>{100, 101, 102}));
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "FlushBuffer.h"
+
+namespace {
+
+std::shared_ptr<ChatMsgNode> makeNode(int producer, int seq) {
+    auto node = std::make_shared<ChatMsgNode>();
+    node->msg.fromUid = producer;
+    node->msg.msgId = seq;
+    return node;
+}
+
+/**
+ * 多个生产者并发 push，一个消费者不断 swap，返回每个生产者收到的消息序号（按消费顺序）。
+ * 作为 TSAN 压测入口：-DENABLE_TSAN=ON 构建后运行 --gtest_filter=FlushBuffer*
+ */
+std::vector<std::vector<int>> runProducers(FlushBuffer& buffer, int producers, int perProducer) {
+    std::vector<std::vector<int>> received(producers);
+    std::atomic<int> finished{0};
+
+    std::thread consumer([&] {
+        auto drain = [&] {
+            for (auto& node : buffer.swap()) {
+                received[node->msg.fromUid].push_back(node->msg.msgId);
+            }
+        };
+        while (finished.load(std::memory_order_acquire) < producers) {
+            drain();
+            std::this_thread::yield();
+        }
+        drain();
+    });
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < perProducer; i++) {
+                buffer.push(makeNode(p, i));
+            }
+            finished.fetch_add(1, std::memory_order_release);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    consumer.join();
+    return received;
+}
+
+}  // namespace
+
+// 单线程下 push 返回当前长度，swap 按推入顺序取出并清空缓冲区。
+TEST(FlushBufferTest, PushReturnsSizeAndSwapKeepsOrder) {
+    FlushBuffer buffer;
+    EXPECT_FALSE(buffer.hasData());
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(buffer.push(makeNode(0, i)), static_cast<size_t>(i + 1));
+    }
+    EXPECT_TRUE(buffer.hasData());
+
+    const uint64_t generation = buffer.generation();
+    auto nodes = buffer.swap();
+    ASSERT_EQ(nodes.size(), 5u);
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(nodes[i]->msg.msgId, i);
+    }
+    EXPECT_FALSE(buffer.hasData());
+    EXPECT_EQ(buffer.generation(), generation + 1);
+    EXPECT_TRUE(buffer.swap().empty());
+
+    // 取走后重新从 1 计数
+    EXPECT_EQ(buffer.push(makeNode(0, 5)), 1u);
+}
+
+// 并发 push 与 swap 交错：消息不丢不重，同一生产者的消息保持推入顺序。
+TEST(FlushBufferTest, ConcurrentProducersNoLossInOrder) {
+    constexpr int PRODUCERS = 8;
+    constexpr int PER_PRODUCER = 50000;
+
+    FlushBuffer buffer;
+    auto received = runProducers(buffer, PRODUCERS, PER_PRODUCER);
+
+    for (int p = 0; p < PRODUCERS; p++) {
+        ASSERT_EQ(received[p].size(), static_cast<size_t>(PER_PRODUCER)) << "producer=" << p;
+        for (int i = 0; i < PER_PRODUCER; i++) {
+            ASSERT_EQ(received[p][i], i) << "producer=" << p;
+        }
+    }
+    EXPECT_FALSE(buffer.hasData());
+}
+
+// 生产者扩展性：1 → 16 个生产者的总推入速率，消费者同时持续 swap。
+TEST(FlushBufferBench, ProducerScaling) {
+    constexpr int TOTAL = 400000;
+
+    std::cout << "\n=== FlushBuffer Producer Scaling ===" << std::endl;
+    std::cout << "Producers | Push/s (M) | ns/push" << std::endl;
+    std::cout << "----------|------------|--------" << std::endl;
+    for (int producers : {1, 2, 4, 8, 16}) {
+        FlushBuffer buffer;
+        const int perProducer = TOTAL / producers;
+        const auto start = std::chrono::steady_clock::now();
+        auto received = runProducers(buffer, producers, perProducer);
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t total = 0;
+        for (const auto& r : received) {
+            total += r.size();
+        }
+        EXPECT_EQ(total, static_cast<size_t>(perProducer) * producers);
+
+        std::cout << std::setw(9) << producers << " | "
+                  << std::setw(10) << std::fixed << std::setprecision(2) << total / sec / 1e6 << " | "
+                  << std::setw(6) << std::setprecision(0) << sec * 1e9 / total << std::endl;
+    }
+    std::cout << "====================================\n" << std::endl;
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "HistoryPage.h"
+
+using Direction = HistoryPage::Direction;
+using Range = std::pair<size_t, size_t>;
+
+TEST(HistoryPageTest, ParseAndSplit) {
+    Direction direction = Direction::AFTER;
+    EXPECT_TRUE(HistoryPage::parseDirection("before", direction));
+    EXPECT_EQ(direction, Direction::BEFORE);
+    EXPECT_TRUE(HistoryPage::parseDirection("around", direction));
+    EXPECT_EQ(direction, Direction::AROUND);
+    EXPECT_FALSE(HistoryPage::parseDirection("sideways", direction));
+    EXPECT_EQ(direction, Direction::AROUND);
+
+    EXPECT_EQ(HistoryPage::split(Direction::AFTER, 50), std::make_pair(0, 50));
+    EXPECT_EQ(HistoryPage::split(Direction::BEFORE, 50), std::make_pair(50, 0));
+    EXPECT_EQ(HistoryPage::split(Direction::AROUND, 51), std::make_pair(25, 26));
+}
+
+// 预算足够时整页保留；不足时向新翻页保留最早的一段，向旧翻页保留最新的一段。
+TEST(HistoryPageTest, FitKeepsCursorSide) {
+    const std::vector<size_t> sizes(10, 100);
+    EXPECT_EQ(HistoryPage::fit(sizes, Direction::AFTER, 0, 10000), Range(0, 10));
+    EXPECT_EQ(HistoryPage::fit(sizes, Direction::AFTER, 0, 350), Range(0, 3));
+    EXPECT_EQ(HistoryPage::fit(sizes, Direction::BEFORE, 0, 350), Range(7, 10));
+    EXPECT_EQ(HistoryPage::fit({}, Direction::AFTER, 0, 350), Range(0, 0));
+
+    // 单条超过预算时仍返回这一条，客户端才能继续翻页
+    EXPECT_EQ(HistoryPage::fit({500, 100}, Direction::AFTER, 0, 100), Range(0, 1));
+}
+
+// 跳转窗口从游标消息向两侧交替扩展；一侧到头后另一侧继续。
+TEST(HistoryPageTest, FitAroundAnchor) {
+    const std::vector<size_t> sizes(10, 100);
+    EXPECT_EQ(HistoryPage::fit(sizes, Direction::AROUND, 5, 300), Range(4, 7));
+    EXPECT_EQ(HistoryPage::fit(sizes, Direction::AROUND, 0, 300), Range(0, 3));
+    EXPECT_EQ(HistoryPage::fit(sizes, Direction::AROUND, 9, 300), Range(7, 10));
+    EXPECT_EQ(HistoryPage::fit(sizes, Direction::AROUND, 42, 300), Range(7, 10));
+
+    // 较大的一条挡住一侧时，另一侧继续扩展
+    EXPECT_EQ(HistoryPage::fit({100, 900, 100, 100, 100}, Direction::AROUND, 2, 400),
+              Range(2, 5));
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChatMsgNode.h"
+#include "MemoryBudget.h"
+
+// 低于软上限正常接收，超过软上限降速接收，超过硬上限拒绝且不计入。
+TEST(MemoryBudgetTest, SoftAndHardLimits) {
+    MemoryBudget budget(100, 200);
+    EXPECT_EQ(budget.tryAcquire(100), MemoryBudget::Admission::ACCEPT);
+    EXPECT_EQ(budget.tryAcquire(50), MemoryBudget::Admission::SOFT);
+    EXPECT_EQ(budget.tryAcquire(51), MemoryBudget::Admission::REJECT);
+    EXPECT_EQ(budget.usedBytes(), 150u);
+    EXPECT_EQ(budget.tryAcquire(50), MemoryBudget::Admission::SOFT);
+    EXPECT_EQ(budget.usedBytes(), 200u);
+
+    budget.release(150);
+    EXPECT_EQ(budget.tryAcquire(10), MemoryBudget::Admission::ACCEPT);
+
+    const auto stats = budget.stats();
+    EXPECT_EQ(stats.peakBytes, 200u);
+    EXPECT_EQ(stats.softAdmits, 2u);
+    EXPECT_EQ(stats.rejects, 1u);
+}
+
+// 硬上限为 0 时不限制，只做统计。
+TEST(MemoryBudgetTest, UnlimitedWhenHardIsZero) {
+    MemoryBudget budget(0, 0);
+    EXPECT_EQ(budget.tryAcquire(size_t{1} << 40), MemoryBudget::Admission::ACCEPT);
+    EXPECT_EQ(budget.stats().rejects, 0u);
+}
+
+// 估算值随消息内容增长，短字符串在 SSO 内不额外计数。
+TEST(MemoryBudgetTest, NodeEstimateTracksContent) {
+    MessageInfo small;
+    small.convId = "c2c_1_2";
+    small.content = "hi";
+    MessageInfo large = small;
+    large.content = std::string(4096, 'x');
+
+    const ChatMsgNode a(small, nullptr);
+    const ChatMsgNode b(large, nullptr);
+    EXPECT_GE(a.estimateBytes(), sizeof(ChatMsgNode));
+    EXPECT_GE(b.estimateBytes(), a.estimateBytes() + 4096);
+}
+
+// 模拟 MySQL 不可用：多个 IO 线程持续收消息而没有任何消息落库，内存停在硬上限以内，超出部分被拒绝；
+// 恢复后归还预算，重新接收。
+TEST(MemoryBudgetBench, BoundedDuringOutage) {
+    constexpr size_t soft = 1 << 20;
+    constexpr size_t hard = 2 << 20;
+    constexpr int producers = 4;
+    constexpr int perProducer = 20000;
+    MemoryBudget budget(soft, hard);
+
+    MessageInfo info;
+    info.convId = "c2c_9900000_9900001";
+    info.content = std::string(200, 'x');
+    std::vector<std::vector<std::shared_ptr<ChatMsgNode>>> held(producers);
+    std::atomic<uint64_t> accepted{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < perProducer; i++) {
+                auto node = std::make_shared<ChatMsgNode>(info, nullptr);
+                const size_t bytes = node->estimateBytes();
+                if (budget.tryAcquire(bytes) != MemoryBudget::Admission::REJECT) {
+                    node->mem_bytes = bytes;
+                    held[p].push_back(std::move(node));
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    const auto outage = budget.stats();
+
+    // 恢复：积压的消息落库后归还预算
+    for (auto& list : held) {
+        for (const auto& node : list) {
+            budget.release(node->mem_bytes);
+        }
+        list.clear();
+    }
+    const auto recovered = budget.tryAcquire(1024);
+
+    std::cout << "\n=== Memory Budget (MySQL outage) ===" << std::endl;
+    std::cout << "offered   : " << producers * perProducer << std::endl
+              << "accepted  : " << accepted.load() << " (soft " << outage.softAdmits << ")" << std::endl
+              << "rejected  : " << outage.rejects << std::endl
+              << "peak      : " << std::fixed << std::setprecision(2)
+              << outage.peakBytes / 1048576.0 << " MB (hard " << hard / 1048576.0 << " MB)" << std::endl;
+    std::cout << "====================================\n" << std::endl;
+
+    EXPECT_LE(outage.peakBytes, hard);
+    EXPECT_GT(outage.softAdmits, 0u);
+    EXPECT_EQ(accepted.load() + outage.rejects, static_cast<uint64_t>(producers * perProducer));
+    EXPECT_EQ(budget.usedBytes(), 1024u);
+    EXPECT_EQ(recovered, MemoryBudget::Admission::ACCEPT);
+}
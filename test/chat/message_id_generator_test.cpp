@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "MessageIdGenerator.h"
+
+namespace {
+constexpr int64_t NOW_MS = MessageIdGenerator::EPOCH_MS + 86400000LL;
+}  // namespace
+
+// 时间戳和机器号可以从 ID 中还原，同一毫秒内序号递增。
+TEST(MessageIdGeneratorTest, LayoutAndOrder) {
+    MessageIdGenerator gen(37);
+    const int64_t first = gen.nextAt(NOW_MS);
+    const int64_t second = gen.nextAt(NOW_MS);
+    const int64_t later = gen.nextAt(NOW_MS + 1);
+
+    EXPECT_GT(first, 0);
+    EXPECT_EQ(MessageIdGenerator::workerOf(first), 37);
+    EXPECT_EQ(MessageIdGenerator::timestampOf(first), NOW_MS);
+    EXPECT_EQ(second, first + 1);
+    EXPECT_GT(later, second);
+    EXPECT_EQ(MessageIdGenerator::timestampOf(later), NOW_MS + 1);
+}
+
+// 超出范围的机器号拒绝构造，不截断成其他服务器的机器号。
+TEST(MessageIdGeneratorTest, RejectsOutOfRangeWorkerId) {
+    EXPECT_THROW(MessageIdGenerator(MessageIdGenerator::MAX_WORKER_ID + 1), std::out_of_range);
+    EXPECT_THROW(MessageIdGenerator(-1), std::out_of_range);
+    EXPECT_EQ(MessageIdGenerator(MessageIdGenerator::MAX_WORKER_ID).workerId(), MessageIdGenerator::MAX_WORKER_ID);
+    EXPECT_EQ(MessageIdGenerator(0).workerId(), 0);
+}
+
+// 时钟回拨时沿用上次的时间继续递增，不产生重复 ID。
+TEST(MessageIdGeneratorTest, ClockRollbackStaysMonotonic) {
+    MessageIdGenerator gen(1);
+    const int64_t before = gen.nextAt(NOW_MS);
+    const int64_t rolledBack = gen.nextAt(NOW_MS - 5000);
+    EXPECT_GT(rolledBack, before);
+    EXPECT_EQ(MessageIdGenerator::timestampOf(rolledBack), NOW_MS);
+}
+
+// 同一毫秒内序号用尽时借用下一毫秒。
+TEST(MessageIdGeneratorTest, SequenceOverflowBorrowsNextMillisecond) {
+    MessageIdGenerator gen(2);
+    int64_t last = 0;
+    for (int i = 0; i < (1 << MessageIdGenerator::SEQUENCE_BITS) + 1; i++) {
+        const int64_t id = gen.nextAt(NOW_MS);
+        ASSERT_GT(id, last);
+        last = id;
+    }
+    EXPECT_EQ(MessageIdGenerator::timestampOf(last), NOW_MS + 1);
+    EXPECT_EQ(MessageIdGenerator::workerOf(last), 2);
+}
+
+// 多线程并发取号不重复，每个线程内严格递增。
+TEST(MessageIdGeneratorTest, ConcurrentUnique) {
+    constexpr int threads = 8;
+    constexpr int perThread = 20000;
+    MessageIdGenerator gen(MessageIdGenerator::MAX_WORKER_ID);
+    std::vector<std::vector<int64_t>> ids(threads);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&gen, &ids, t] {
+            ids[t].reserve(perThread);
+            for (int i = 0; i < perThread; i++) {
+                ids[t].push_back(gen.next());
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    std::unordered_set<int64_t> seen;
+    for (const auto& list : ids) {
+        EXPECT_TRUE(std::is_sorted(list.begin(), list.end()));
+        for (const auto id : list) {
+            EXPECT_EQ(MessageIdGenerator::workerOf(id), MessageIdGenerator::MAX_WORKER_ID);
+            seen.insert(id);
+        }
+    }
+    EXPECT_EQ(seen.size(), static_cast<size_t>(threads * perThread));
+}
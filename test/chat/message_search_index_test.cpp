@@ -0,0 +1,259 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MessageSearchIndex.h"
+
+namespace {
+
+class MessageSearchIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = (std::filesystem::temp_directory_path() /
+            ("imserver_search_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+             ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    MessageSearchIndex::Options options(const size_t maxSegments = 8) const {
+        MessageSearchIndex::Options options;
+        options.dir = dir_;
+        options.sealDocs = 1 << 20;
+        options.sealInterval = std::chrono::hours(1);
+        options.maxSegments = maxSegments;
+        return options;
+    }
+
+    static MessageInfo makeMessage(const int64_t servId, const std::string& convId, const std::string& content,
+                                   const int8_t type = 1) {
+        MessageInfo msg;
+        msg.servId = servId;
+        msg.convId = convId;
+        msg.fromUid = static_cast<int>(servId % 1000);
+        msg.type = type;
+        msg.content = content;
+        return msg;
+    }
+
+    static std::vector<int64_t> ids(const std::vector<MessageSearchIndex::Hit>& hits) {
+        std::vector<int64_t> result;
+        for (const auto& hit : hits) {
+            result.push_back(hit.msgId);
+        }
+        return result;
+    }
+
+    size_t segmentFiles() const {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(dir_)) {
+            count += entry.path().extension() == ".seg" ? 1 : 0;
+        }
+        return count;
+    }
+
+    std::string dir_;
+};
+
+}  // namespace
+
+// ASCII 按词转小写，中日韩文字切为单字 + 相邻二字，标点和 emoji 为分隔符。
+TEST_F(MessageSearchIndexTest, TokenizeMixedText) {
+    const auto terms = MessageSearchIndex::tokenize("Hello, 世界！iPhone15很好用 😀 ok");
+    const std::vector<std::string> expected{"hello", "世", "世界", "界", "iphone15", "很", "很好", "好", "好用",
+                                            "用", "ok"};
+    for (const auto& term : expected) {
+        EXPECT_NE(std::find(terms.begin(), terms.end(), term), terms.end()) << term;
+    }
+    EXPECT_EQ(terms.size(), expected.size());
+    EXPECT_TRUE(MessageSearchIndex::tokenize(" ，。!? ").empty());
+}
+
+// 内存段与只读段一起搜索：按 serverId 倒序，before 翻页，只查给定会话，二字不相邻的误命中被过滤。
+TEST_F(MessageSearchIndexTest, SearchAcrossSegmentsWithPaging) {
+    MessageSearchIndex index(options());
+    ASSERT_TRUE(index.start());
+    index.add(makeMessage(10, "c2c_1_2", "明天一起去看电影吧"));
+    index.add(makeMessage(11, "c2c_1_2", "电影票买好了"));
+    index.add(makeMessage(12, "c2c_1_3", "电影院见"));
+    index.add(makeMessage(13, "c2c_1_2", "[图片]电影", 2));
+    index.flush();
+    index.add(makeMessage(20, "c2c_1_2", "这部电影不错 Great MOVIE"));
+    index.add(makeMessage(21, "c2c_1_2", "电视上的影评"));
+
+    std::vector<MessageSearchIndex::Hit> hits;
+    ASSERT_TRUE(index.search({"c2c_1_2"}, "电影", 0, 10, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{20, 11, 10}));
+    EXPECT_EQ(hits.front().convId, "c2c_1_2");
+    EXPECT_EQ(hits.front().senderUid, 20);
+
+    ASSERT_TRUE(index.search({"c2c_1_2"}, "电影", 0, 2, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{20, 11}));
+    ASSERT_TRUE(index.search({"c2c_1_2"}, "电影", hits.back().msgId, 2, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{10}));
+
+    ASSERT_TRUE(index.search({"c2c_1_2", "c2c_1_3"}, "电影", 0, 10, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{20, 12, 11, 10}));
+
+    ASSERT_TRUE(index.search({"c2c_1_2"}, "movie 电影", 0, 10, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{20}));
+    ASSERT_TRUE(index.search({"c2c_1_2"}, "影", 0, 10, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{21, 20, 11, 10}));
+    ASSERT_TRUE(index.search({"c2c_1_2"}, "看电影吧", 0, 10, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{10}));
+    EXPECT_FALSE(index.search({"c2c_1_2"}, "！？", 0, 10, hits));
+    index.stop();
+}
+
+// 消息落库后才进入索引，晚到的旧消息会封存在更新的段中：各段 ID 范围交叠时不能因某段较旧就停止向前查。
+TEST_F(MessageSearchIndexTest, SearchOverlappingSegments) {
+    MessageSearchIndex index(options());
+    ASSERT_TRUE(index.start());
+    for (int64_t id = 500; id < 503; id++) {
+        index.add(makeMessage(id, "c2c_1_2", "会议改到下午"));
+    }
+    index.flush();
+    for (int64_t id = 100; id < 103; id++) {
+        index.add(makeMessage(id, "c2c_1_2", "会议纪要"));
+    }
+    index.flush();
+    for (int64_t id = 200; id < 203; id++) {
+        index.add(makeMessage(id, "c2c_1_2", "会议室订好了"));
+    }
+    index.flush();
+
+    std::vector<MessageSearchIndex::Hit> hits;
+    ASSERT_TRUE(index.search({"c2c_1_2"}, "会议", 0, 2, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{502, 501}));
+    ASSERT_TRUE(index.search({"c2c_1_2"}, "会议", 501, 4, hits));
+    EXPECT_EQ(ids(hits), (std::vector<int64_t>{500, 202, 201, 200}));
+    index.stop();
+}
+
+// 片段截取命中位置前后，按字符截断，不会切开多字节字符。
+TEST_F(MessageSearchIndexTest, SnippetAroundMatch) {
+    MessageSearchIndex index(options());
+    ASSERT_TRUE(index.start());
+    std::string content;
+    for (int i = 0; i < 40; i++) {
+        content += "前";
+    }
+    content += "关键词";
+    for (int i = 0; i < 80; i++) {
+        content += "后";
+    }
+    index.add(makeMessage(1, "g_1", content));
+
+    std::vector<MessageSearchIndex::Hit> hits;
+    ASSERT_TRUE(index.search({"g_1"}, "关键词", 0, 10, hits));
+    ASSERT_EQ(hits.size(), 1u);
+    std::string expected = "…";
+    for (int i = 0; i < 16; i++) {
+        expected += "前";
+    }
+    expected += "关键词";
+    for (int i = 0; i < 45; i++) {
+        expected += "后";
+    }
+    expected += "…";
+    EXPECT_EQ(hits[0].snippet, expected);
+    index.stop();
+}
+
+// stop 时封存内存段，新实例 mmap 加载段文件后结果不变；段数超限时合并，旧文件删除。
+TEST_F(MessageSearchIndexTest, PersistAndCompact) {
+    {
+        MessageSearchIndex index(options(2));
+        ASSERT_TRUE(index.start());
+        for (int round = 0; round < 5; round++) {
+            for (int i = 0; i < 20; i++) {
+                const int64_t id = round * 100 + i + 1;
+                index.add(makeMessage(id, "g_42", "round" + std::to_string(round) + " 周报 第" + std::to_string(i)));
+            }
+            index.flush();
+        }
+        const auto stats = index.stats();
+        EXPECT_EQ(stats.seals, 5u);
+        EXPECT_GE(stats.compactions, 1u);
+        EXPECT_LE(stats.segments, 2u);
+        index.add(makeMessage(1000, "g_42", "最后一条周报"));
+        index.stop();
+    }
+    EXPECT_LE(segmentFiles(), 3u);
+
+    MessageSearchIndex reopened(options(2));
+    ASSERT_TRUE(reopened.start());
+    std::vector<MessageSearchIndex::Hit> hits;
+    ASSERT_TRUE(reopened.search({"g_42"}, "周报", 0, 1000, hits));
+    ASSERT_EQ(hits.size(), 101u);
+    EXPECT_EQ(hits.front().msgId, 1000);
+    EXPECT_TRUE(std::is_sorted(hits.begin(), hits.end(), [](const auto& a, const auto& b) {
+        return a.msgId > b.msgId;
+    }));
+    ASSERT_TRUE(reopened.search({"g_42"}, "round3", 0, 1000, hits));
+    EXPECT_EQ(hits.size(), 20u);
+    ASSERT_TRUE(reopened.search({"g_43"}, "周报", 0, 1000, hits));
+    EXPECT_TRUE(hits.empty());
+    reopened.stop();
+}
+
+// 20 万条消息、200 个会话：用户在其 20 个会话中搜索一个词，统计首页耗时。
+TEST_F(MessageSearchIndexTest, BenchQueryLatency) {
+    constexpr int convs = 200;
+    constexpr int messages = 200000;
+    constexpr int queries = 2000;
+    const std::vector<std::string> vocabulary{"会议", "项目", "周报", "电影", "晚饭", "出差", "合同", "报销",
+                                              "deploy", "release", "bug", "review", "meeting", "lunch"};
+
+    MessageSearchIndex::Options opts = options();
+    opts.sealDocs = 4096;
+    MessageSearchIndex index(opts);
+    ASSERT_TRUE(index.start());
+    std::mt19937 rng(7);
+    for (int i = 1; i <= messages; i++) {
+        std::string content = "消息" + std::to_string(i);
+        for (int w = 0; w < 4; w++) {
+            content += " " + vocabulary[rng() % vocabulary.size()];
+        }
+        index.add(makeMessage(i, "g_" + std::to_string(i % convs), content));
+        if (i % 4096 == 0) {
+            index.flush();
+        }
+    }
+    index.flush();
+
+    std::vector<double> latency;
+    for (int q = 0; q < queries; q++) {
+        std::vector<std::string> userConvs;
+        for (int c = 0; c < 20; c++) {
+            userConvs.push_back("g_" + std::to_string((q + c * 7) % convs));
+        }
+        std::vector<MessageSearchIndex::Hit> hits;
+        const auto start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(index.search(userConvs, vocabulary[q % vocabulary.size()], 0, 20, hits));
+        latency.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        ASSERT_EQ(hits.size(), 20u);
+    }
+    std::sort(latency.begin(), latency.end());
+    const auto stats = index.stats();
+
+    std::cout << "\n=== Message search (200k messages, 20 convs/user) ===" << std::endl;
+    std::cout << "segments=" << stats.segments << " mb=" << std::fixed << std::setprecision(1)
+              << static_cast<double>(stats.segmentBytes) / (1024 * 1024)
+              << " p50(us)=" << latency[latency.size() / 2]
+              << " p99(us)=" << latency[latency.size() * 99 / 100] << std::endl;
+    std::cout << "=====================================================\n" << std::endl;
+
+    EXPECT_LT(latency[latency.size() * 99 / 100], 50000.0);
+    index.stop();
+}
@@ -0,0 +1,356 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MessageIdGenerator.h"
+#include "RecentMessageCache.h"
+
+namespace {
+
+/// 内存中的 message 表，按会话保存已落库的消息，统计查询次数，可设置每次查询的耗时
+class FakeMessageTable {
+public:
+    void insert(const MessageInfo& msg) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rows_[msg.convId.value()].push_back(msg);
+    }
+
+    bool selectRecent(const std::string& convId, const int limit, std::vector<MessageInfo>& result) {
+        queries_.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::sleep_for(latency_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto& rows = rows_[convId];
+        result.assign(rows.end() - std::min<size_t>(limit, rows.size()), rows.end());
+        return true;
+    }
+
+    std::vector<MessageInfo> selectSince(const std::string& convId, const int64_t since, const int limit) {
+        queries_.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::sleep_for(latency_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<MessageInfo> result;
+        for (const auto& row : rows_[convId]) {
+            if (row.servId > since && static_cast<int>(result.size()) < limit) {
+                result.push_back(row);
+            }
+        }
+        return result;
+    }
+
+    RecentMessageCache::loadHandler loader() {
+        return [this](const std::string& convId, const int limit, std::vector<MessageInfo>& result) {
+            return selectRecent(convId, limit, result);
+        };
+    }
+
+    std::atomic<uint64_t> queries_{0};
+    std::chrono::microseconds latency_{0};
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, std::vector<MessageInfo>> rows_;
+};
+
+MessageInfo makeMessage(MessageIdGenerator& gen, const std::string& convId, const std::string& content = "hello") {
+    MessageInfo msg;
+    msg.servId = gen.next();
+    msg.convId = convId;
+    msg.fromUid = 1;
+    msg.toUid = 2;
+    msg.content = content;
+    msg.createTime = "2026-10-18 00:00:00";
+    return msg;
+}
+
+RecentMessageCache::Options makeOptions(const size_t ringSize) {
+    RecentMessageCache::Options options;
+    options.ringSize = ringSize;
+    options.ttl = std::chrono::hours(1);
+    return options;
+}
+
+}  // namespace
+
+// 首次拉取加载最新一环，之后最新的页都由内存返回；早于水位的页交给 MySQL。
+TEST(RecentMessageCacheTest, LatestPageServedFromMemory) {
+    MessageIdGenerator gen(1);
+    FakeMessageTable table;
+    std::vector<MessageInfo> all;
+    for (int i = 0; i < 100; i++) {
+        all.push_back(makeMessage(gen, "c2c_1_2"));
+        table.insert(all.back());
+    }
+    RecentMessageCache cache(makeOptions(20), table.loader());
+
+    std::vector<MessageInfo> page;
+    ASSERT_TRUE(cache.fetch("c2c_1_2", all[89].servId, 20, page));
+    ASSERT_EQ(page.size(), 10u);
+    EXPECT_EQ(page.front().servId, all[90].servId);
+    EXPECT_EQ(page.back().servId, all[99].servId);
+
+    ASSERT_TRUE(cache.fetch("c2c_1_2", all[79].servId, 5, page));
+    EXPECT_EQ(page.size(), 5u);
+    EXPECT_EQ(page.front().servId, all[80].servId);
+    EXPECT_EQ(table.queries_.load(), 1u);
+
+    EXPECT_FALSE(cache.fetch("c2c_1_2", all[10].servId, 20, page));
+    EXPECT_EQ(table.queries_.load(), 1u);
+}
+
+// 尚未落库的消息与 MySQL 中的消息按 ID 合并，发送方立即能拉到自己的消息。
+TEST(RecentMessageCacheTest, ReadYourWritesBeforeFlush) {
+    MessageIdGenerator gen(1);
+    FakeMessageTable table;
+    for (int i = 0; i < 5; i++) {
+        table.insert(makeMessage(gen, "c2c_1_2"));
+    }
+    RecentMessageCache cache(makeOptions(20), table.loader());
+
+    // 写入缓存但 BatchWriter 还没刷写
+    const auto unflushed = makeMessage(gen, "c2c_1_2", "not yet in mysql");
+    cache.append(unflushed);
+
+    std::vector<MessageInfo> page;
+    ASSERT_TRUE(cache.fetch("c2c_1_2", 0, 50, page));
+    ASSERT_EQ(page.size(), 6u);
+    EXPECT_EQ(page.back().servId, unflushed.servId);
+    EXPECT_TRUE(std::is_sorted(page.begin(), page.end(),
+        [](const MessageInfo& a, const MessageInfo& b) { return a.servId < b.servId; }));
+
+    // 会话已加载后追加的消息直接可见
+    const auto next = makeMessage(gen, "c2c_1_2");
+    cache.append(next);
+    ASSERT_TRUE(cache.fetch("c2c_1_2", unflushed.servId, 50, page));
+    ASSERT_EQ(page.size(), 1u);
+    EXPECT_EQ(page.front().servId, next.servId);
+    EXPECT_EQ(table.queries_.load(), 1u);
+}
+
+// 过期后重新加载，环中尚未落库的消息保留；MySQL 中的版本覆盖缓存中的旧状态。
+TEST(RecentMessageCacheTest, ReloadKeepsUnflushedMessages) {
+    MessageIdGenerator gen(1);
+    FakeMessageTable table;
+    auto options = makeOptions(20);
+    options.ttl = std::chrono::milliseconds(0);
+    RecentMessageCache cache(options, table.loader());
+
+    auto flushed = makeMessage(gen, "group_1");
+    cache.append(flushed);
+    const auto unflushed = makeMessage(gen, "group_1");
+    cache.append(unflushed);
+    flushed.status = static_cast<int8_t>(MessageStatus::IS_READ);
+    table.insert(flushed);
+
+    std::vector<MessageInfo> page;
+    ASSERT_TRUE(cache.fetch("group_1", 0, 50, page));
+    ASSERT_EQ(page.size(), 2u);
+    EXPECT_EQ(page[0].status, static_cast<int8_t>(MessageStatus::IS_READ));
+    EXPECT_EQ(page[1].servId, unflushed.servId);
+    ASSERT_TRUE(cache.fetch("group_1", 0, 50, page));
+    EXPECT_EQ(page.size(), 2u);
+    EXPECT_EQ(table.queries_.load(), 2u);
+}
+
+// 总字节超过上限时按 LRU 淘汰整个会话，刚访问过的会话保留。
+TEST(RecentMessageCacheTest, EvictsLeastRecentlyUsedConversations) {
+    MessageIdGenerator gen(1);
+    FakeMessageTable table;
+    auto options = makeOptions(10);
+    options.maxBytes = 64 << 10;
+    RecentMessageCache cache(options, table.loader());
+
+    const std::string big(1024, 'x');
+    for (int c = 0; c < 500; c++) {
+        for (int i = 0; i < 10; i++) {
+            cache.append(makeMessage(gen, "c2c_" + std::to_string(c), big));
+        }
+    }
+    const auto stats = cache.stats();
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_LE(stats.bytes, options.maxBytes + 16 * 10 * (sizeof(MessageInfo) + big.size() * 2));
+    EXPECT_LT(stats.conversations, 500u);
+
+    // 最后写入的会话仍在缓存中（已追加但未加载，首次读取时加载一次）
+    std::vector<MessageInfo> page;
+    ASSERT_TRUE(cache.fetch("c2c_499", 0, 50, page));
+    EXPECT_EQ(page.size(), 10u);
+}
+
+// 向旧翻页：环中够一页时由内存返回；不足一页且更早的消息不在环中时交给 MySQL；会话全部在环中时不足一页也返回。
+TEST(RecentMessageCacheTest, BackwardPagingWithinRing) {
+    MessageIdGenerator gen(1);
+    FakeMessageTable table;
+    std::vector<MessageInfo> all;
+    for (int i = 0; i < 100; i++) {
+        all.push_back(makeMessage(gen, "c2c_1_2"));
+        table.insert(all.back());
+    }
+    RecentMessageCache cache(makeOptions(20), table.loader());
+
+    std::vector<MessageInfo> page;
+    ASSERT_TRUE(cache.fetchBefore("c2c_1_2", 0, 10, page));
+    ASSERT_EQ(page.size(), 10u);
+    EXPECT_EQ(page.front().servId, all[90].servId);
+    EXPECT_EQ(page.back().servId, all[99].servId);
+
+    ASSERT_TRUE(cache.fetchBefore("c2c_1_2", page.front().servId, 10, page));
+    ASSERT_EQ(page.size(), 10u);
+    EXPECT_EQ(page.front().servId, all[80].servId);
+    EXPECT_EQ(page.back().servId, all[89].servId);
+
+    EXPECT_FALSE(cache.fetchBefore("c2c_1_2", page.front().servId, 10, page));
+    EXPECT_EQ(table.queries_.load(), 1u);
+
+    FakeMessageTable small;
+    for (int i = 0; i < 5; i++) {
+        small.insert(makeMessage(gen, "c2c_1_3"));
+    }
+    RecentMessageCache smallCache(makeOptions(20), small.loader());
+    ASSERT_TRUE(smallCache.fetchBefore("c2c_1_3", 0, 10, page));
+    EXPECT_EQ(page.size(), 5u);
+}
+
+// 客户端重发的消息不会以新分配的 serverId 留在环中：收到时已在环中的沿用原 ID，
+// 落库时才发现的按已存储的 ID 修正；毒消息从环中删除。
+TEST(RecentMessageCacheTest, RetransmitAndPoisonLeaveNoPhantom) {
+    MessageIdGenerator gen(1);
+    FakeMessageTable table;
+    RecentMessageCache cache(makeOptions(20), table.loader());
+    const auto serverIds = [&cache]() {
+        std::vector<MessageInfo> page;
+        EXPECT_TRUE(cache.fetch("c2c_1_2", 0, 50, page));
+        std::vector<int64_t> ids;
+        for (const auto& m : page) {
+            ids.push_back(m.servId);
+        }
+        return ids;
+    };
+
+    auto original = makeMessage(gen, "c2c_1_2");
+    original.msgId = 7;
+    cache.append(original);
+    auto resent = original;
+    resent.servId = gen.next();
+    // 扇出前取出第一次的 serverId
+    int64_t found = 0;
+    EXPECT_TRUE(cache.findResent(resent, found));
+    EXPECT_EQ(found, original.servId);
+    cache.append(resent);
+    EXPECT_EQ(serverIds(), std::vector<int64_t>{original.servId});
+
+    // 第一次发送已落库但不在环中（其他服务器收到或已淘汰），重发的消息先以新 ID 进入环
+    auto stored = makeMessage(gen, "c2c_1_2");
+    stored.msgId = 8;
+    auto late = stored;
+    late.servId = gen.next();
+    cache.append(late);
+    EXPECT_EQ(serverIds(), (std::vector<int64_t>{original.servId, late.servId}));
+    // 落库时回查到已存储的 ID
+    late.servId = stored.servId;
+    cache.correct(late);
+    EXPECT_EQ(serverIds(), (std::vector<int64_t>{original.servId, stored.servId}));
+
+    auto poison = makeMessage(gen, "c2c_1_2");
+    poison.msgId = 9;
+    cache.append(poison);
+    cache.remove("c2c_1_2", poison.servId);
+    EXPECT_EQ(serverIds(), (std::vector<int64_t>{original.servId, stored.servId}));
+
+    // 其他发送方相同的客户端 msg_id 不受影响
+    auto other = makeMessage(gen, "c2c_1_2");
+    other.msgId = 7;
+    other.fromUid = 2;
+    EXPECT_FALSE(cache.findResent(other, found));
+    cache.append(other);
+    EXPECT_EQ(serverIds().size(), 3u);
+}
+
+// 多个读者同时打开同一会话时只加载一次。
+// 热点会话的历史拉取：每次查询 MySQL（原做法）对比最近消息缓存，MySQL 查询按 200us 模拟。
+TEST(RecentMessageCacheBench, HistoryPullQueryRateAndP99) {
+    constexpr int convs = 50;
+    constexpr int readers = 8;
+    constexpr int pullsPerReader = 2000;
+    constexpr int pageSize = 20;
+    MessageIdGenerator gen(1);
+    FakeMessageTable table;
+    table.latency_ = std::chrono::microseconds(200);
+    std::vector<int64_t> pageStart(convs);
+    for (int c = 0; c < convs; c++) {
+        for (int i = 0; i < 100; i++) {
+            table.insert(makeMessage(gen, "group_bench" + std::to_string(c)));
+            if (i == 100 - pageSize - 1) {
+                pageStart[c] = gen.next();
+            }
+        }
+    }
+
+    struct Result {
+        double seconds = 0;
+        uint64_t queries = 0;
+        std::vector<double> latency;
+    };
+    const auto run = [&](RecentMessageCache* cache) {
+        Result result;
+        std::mutex mtx;
+        const uint64_t before = table.queries_.load();
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int r = 0; r < readers; r++) {
+            threads.emplace_back([&, r] {
+                std::vector<double> local;
+                for (int i = 0; i < pullsPerReader; i++) {
+                    const int c = (r * convs / readers + i) % convs;
+                    const std::string convId = "group_bench" + std::to_string(c);
+                    const auto t0 = std::chrono::steady_clock::now();
+                    std::vector<MessageInfo> page;
+                    if (!cache || !cache->fetch(convId, pageStart[c], pageSize, page)) {
+                        page = table.selectSince(convId, pageStart[c], pageSize);
+                    }
+                    local.push_back(std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - t0).count());
+                    EXPECT_EQ(page.size(), static_cast<size_t>(pageSize));
+                }
+                std::lock_guard<std::mutex> lock(mtx);
+                result.latency.insert(result.latency.end(), local.begin(), local.end());
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.queries = table.queries_.load() - before;
+        std::sort(result.latency.begin(), result.latency.end());
+        return result;
+    };
+
+    const auto direct = run(nullptr);
+    RecentMessageCache cache(makeOptions(200), table.loader());
+    const auto cached = run(&cache);
+
+    std::cout << "\n=== History Pull (recent message cache) ===" << std::endl;
+    std::cout << "Mode   | MySQL queries | queries/s | p99 (us)" << std::endl;
+    std::cout << "-------|---------------|-----------|---------" << std::endl;
+    const auto print = [](const char* mode, const Result& r) {
+        std::cout << std::left << std::setw(6) << mode << " | " << std::right
+                  << std::setw(13) << r.queries << " | "
+                  << std::setw(9) << std::fixed << std::setprecision(0) << r.queries / r.seconds << " | "
+                  << std::setw(8) << std::setprecision(1) << r.latency[r.latency.size() * 99 / 100] << std::endl;
+    };
+    print("mysql", direct);
+    print("cache", cached);
+    std::cout << "===========================================\n" << std::endl;
+
+    EXPECT_EQ(direct.queries, static_cast<uint64_t>(readers * pullsPerReader));
+    EXPECT_EQ(cached.queries, static_cast<uint64_t>(convs));
+    EXPECT_LT(cached.latency[cached.latency.size() * 99 / 100], direct.latency[direct.latency.size() * 99 / 100]);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "UnreadDeltaTable.h"
+
+// 同一会话的多条消息合并为一条增量：成员未读 = 总数 - 自己发送的条数，按 conv_id 有序取出。
+TEST(UnreadDeltaTableTest, CoalescePerConversation) {
+    UnreadDeltaTable table;
+    table.add("g_9", 30, 1);
+    table.add("c2c_1_2", 10, 1);
+    table.add("c2c_1_2", 12, 2);
+    table.add("c2c_1_2", 11, 1);
+    table.add("g_9", 31, 2);
+    table.add("g_9", 32, 3);
+    EXPECT_EQ(table.convs(), 2u);
+    EXPECT_EQ(table.messages(), 6u);
+    EXPECT_TRUE(table.contains("g_9"));
+    int64_t first = 0;
+    ASSERT_TRUE(table.minMsgId("c2c_1_2", first));
+    EXPECT_EQ(first, 10);
+    EXPECT_FALSE(table.minMsgId("g_10", first));
+
+    const auto deltas = table.drain();
+    ASSERT_EQ(deltas.size(), 2u);
+    EXPECT_EQ(deltas[0].convId, "c2c_1_2");
+    EXPECT_EQ(deltas[0].total, 3);
+    EXPECT_EQ(deltas[0].maxMsgId, 12);
+    EXPECT_EQ(deltas[0].minMsgId, 10);
+    EXPECT_EQ(deltas[0].unreadFor(1), 1);
+    EXPECT_EQ(deltas[0].unreadFor(2), 2);
+    EXPECT_EQ(deltas[1].convId, "g_9");
+    EXPECT_EQ(deltas[1].unreadFor(3), 2);
+    EXPECT_EQ(deltas[1].unreadFor(4), 3);
+
+    EXPECT_EQ(table.convs(), 0u);
+    EXPECT_EQ(table.messages(), 0u);
+    EXPECT_FALSE(table.contains("g_9"));
+}
+
+// 写入失败的增量放回后与期间新增的合并，计数不丢失也不重复。
+TEST(UnreadDeltaTableTest, MergeFailedBatch) {
+    UnreadDeltaTable table;
+    table.add("g_1", 5, 1);
+    table.add("g_2", 6, 2);
+    auto failed = table.drain();
+
+    table.add("g_1", 7, 2);
+    table.add("g_3", 8, 3);
+    table.merge(std::move(failed));
+    EXPECT_EQ(table.convs(), 3u);
+    EXPECT_EQ(table.messages(), 4u);
+
+    const auto deltas = table.drain();
+    ASSERT_EQ(deltas.size(), 3u);
+    EXPECT_EQ(deltas[0].convId, "g_1");
+    EXPECT_EQ(deltas[0].total, 2);
+    EXPECT_EQ(deltas[0].maxMsgId, 7);
+    EXPECT_EQ(deltas[0].minMsgId, 5);
+    EXPECT_EQ(deltas[0].unreadFor(1), 1);
+    EXPECT_EQ(deltas[0].unreadFor(2), 1);
+    EXPECT_EQ(deltas[1].convId, "g_2");
+    EXPECT_EQ(deltas[1].unreadFor(2), 0);
+    EXPECT_EQ(deltas[2].convId, "g_3");
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "ConfigMgr.h"
+#include "MysqlPool.h"
+
+// MysqlPool 预处理语句缓存测试，直连 test/config.ini 中的 MySQL，不可达时跳过。
+namespace {
+
+constexpr const char* POINT_QUERY = "SELECT uid, unread_count FROM user_conversation WHERE uid = ? AND conv_id = ?";
+
+class MysqlPoolTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        gSkip = false;
+        auto& config = ConfigMgr::getInstance();
+        gUrl = config["Mysql"]["Host"] + ":" + config["Mysql"]["Port"];
+        gUser = config["Mysql"]["User"];
+        gPassword = config["Mysql"]["Password"];
+        gSchema = config["Mysql"]["Schema"];
+        try {
+            // MysqlPool 建连失败时池为空，getConnect 会一直等待，先单独探测
+            std::unique_ptr<sql::Connection> probe(
+                sql::mysql::get_mysql_driver_instance()->connect("tcp://" + gUrl, gUser, gPassword));
+        } catch (sql::SQLException& e) {
+            gSkip = true;
+            std::cerr << "[MysqlPoolTest] MySQL unavailable: " << e.what() << std::endl;
+        }
+    }
+
+    void SetUp() override {
+        if (gSkip) {
+            GTEST_SKIP() << "MySQL unavailable";
+        }
+        pool_ = std::make_unique<MysqlPool>(gUrl, gUser, gPassword, gSchema, 2);
+    }
+
+    void TearDown() override {
+        if (pool_) {
+            pool_->close();
+        }
+    }
+
+    static inline bool gSkip = false;
+    static inline std::string gUrl;
+    static inline std::string gUser;
+    static inline std::string gPassword;
+    static inline std::string gSchema;
+    std::unique_ptr<MysqlPool> pool_;
+};
+
+}  // namespace
+
+// 相同 SQL 复用缓存的语句，重连后缓存清空并透明地重新预处理。
+TEST_F(MysqlPoolTest, CachedStatementReusedAndRepreparedAfterReset) {
+    auto conn = pool_->getConnect();
+    ASSERT_NE(conn, nullptr);
+
+    const auto first = conn->prepare(POINT_QUERY);
+    const auto second = conn->prepare(POINT_QUERY);
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(conn->cachedStatements(), 1u);
+
+    conn->reset(sql::mysql::get_mysql_driver_instance()->connect("tcp://" + gUrl, gUser, gPassword));
+    conn->conn_->setSchema(gSchema);
+    EXPECT_EQ(conn->cachedStatements(), 0u);
+
+    const auto again = conn->prepare(POINT_QUERY);
+    again->setInt(1, -1);
+    again->setString(2, "");
+    const std::unique_ptr<sql::ResultSet> res(again->executeQuery());
+    EXPECT_FALSE(res->next());
+    EXPECT_EQ(conn->cachedStatements(), 1u);
+
+    pool_->returnConnect(std::move(conn));
+}
+
+// 缓存条数有上限，淘汰最久未用的语句，被淘汰的语句在调用方手里仍可用。
+TEST_F(MysqlPoolTest, CacheEvictsLeastRecentlyUsed) {
+    auto conn = pool_->getConnect();
+    ASSERT_NE(conn, nullptr);
+
+    const auto oldest = conn->prepare("SELECT 0");
+    for (size_t i = 1; i <= MYSQL_STMT_CACHE_SIZE; i++) {
+        conn->prepare("SELECT " + std::to_string(i));
+    }
+    EXPECT_EQ(conn->cachedStatements(), MYSQL_STMT_CACHE_SIZE);
+    EXPECT_NE(conn->prepare("SELECT 0").get(), oldest.get());
+
+    const std::unique_ptr<sql::ResultSet> res(oldest->executeQuery());
+    ASSERT_TRUE(res->next());
+    EXPECT_EQ(res->getInt(1), 0);
+
+    pool_->returnConnect(std::move(conn));
+}
+
+// 预热后每条连接都已缓存给定语句。
+TEST_F(MysqlPoolTest, WarmUpPreparesOnEveryConnection) {
+    pool_->warmUp({POINT_QUERY, "SELECT 1"});
+
+    auto a = pool_->getConnect();
+    auto b = pool_->getConnect();
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(a->cachedStatements(), 2u);
+    EXPECT_EQ(b->cachedStatements(), 2u);
+    pool_->returnConnect(std::move(a));
+    pool_->returnConnect(std::move(b));
+}
+
+// 单条点查的耗时：每次 prepareStatement（原做法）对比语句缓存。
+TEST_F(MysqlPoolTest, PreparedStatementCacheLatency) {
+    constexpr int iterations = 2000;
+    auto conn = pool_->getConnect();
+    ASSERT_NE(conn, nullptr);
+
+    const auto run = [&conn](const bool cached) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            std::shared_ptr<sql::PreparedStatement> stmt = cached
+                ? conn->prepare(POINT_QUERY)
+                : std::shared_ptr<sql::PreparedStatement>(conn->conn_->prepareStatement(POINT_QUERY));
+            stmt->setInt(1, i);
+            stmt->setString(2, "c2c_bench");
+            const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            while (res->next()) {
+            }
+        }
+        return std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count() / iterations;
+    };
+
+    run(true);  // 预热服务端缓冲
+    const double uncachedUs = run(false);
+    const double cachedUs = run(true);
+
+    std::cout << "\n=== Prepared Statement Cache ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "prepare per query : " << uncachedUs << " us/query" << std::endl
+              << "cached statement  : " << cachedUs << " us/query" << std::endl
+              << "speedup           : " << std::setprecision(2) << uncachedUs / cachedUs << "x" << std::endl;
+    std::cout << "================================\n" << std::endl;
+
+    EXPECT_LT(cachedUs, uncachedUs);
+    pool_->returnConnect(std::move(conn));
+}
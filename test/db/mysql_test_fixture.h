@@ -0,0 +1,94 @@
+#ifndef IMSERVER_MYSQL_TEST_FIXTURE_H
+#define IMSERVER_MYSQL_TEST_FIXTURE_H
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "ConfigMgr.h"
+#include "MysqlPool.h"
+
+/**
+ * DAO 级测试的公共夹具：直连 test/config.ini 中的 MySQL，不可达时整组跳过。
+ * 探测连接 gProbe 用于准备和校验数据，被测 DAO 在连接成功后创建。
+ */
+template <typename Dao>
+class MysqlDaoTest : public ::testing::Test {
+protected:
+    /// 连接 MySQL 并执行 prepare（清理残留、写入测试数据），失败时整组跳过
+    static void setUpSuite(const std::function<void()>& prepare) {
+        gSkip = false;
+        try {
+            gProbe = connect();
+            prepare();
+        } catch (sql::SQLException& e) {
+            gSkip = true;
+            gProbe.reset();
+            std::cerr << "[" << suiteName() << "] MySQL unavailable: " << e.what() << std::endl;
+            return;
+        }
+        gDao = std::make_unique<Dao>();
+    }
+
+    /// 释放 DAO，执行 cleanup 删除测试数据后断开
+    static void tearDownSuite(const std::function<void()>& cleanup) {
+        gDao.reset();
+        if (gProbe) {
+            try {
+                cleanup();
+            } catch (sql::SQLException& e) {
+                std::cerr << "[" << suiteName() << "] cleanup error: " << e.what() << std::endl;
+            }
+            gProbe.reset();
+        }
+    }
+
+    void SetUp() override {
+        if (gSkip) {
+            GTEST_SKIP() << "MySQL unavailable";
+        }
+    }
+
+    /// 新建一条直连，其他线程使用时须先调用 driver->threadInit()
+    static std::unique_ptr<sql::Connection> connect() {
+        auto& config = ConfigMgr::getInstance();
+        std::unique_ptr<sql::Connection> conn(sql::mysql::get_mysql_driver_instance()->connect(
+            "tcp://" + config["Mysql"]["Host"] + ":" + config["Mysql"]["Port"],
+            config["Mysql"]["User"], config["Mysql"]["Password"]));
+        conn->setSchema(config["Mysql"]["Schema"]);
+        return conn;
+    }
+
+    static void exec(const std::string& sql) {
+        const std::unique_ptr<sql::Statement> stmt(gProbe->createStatement());
+        stmt->execute(sql);
+    }
+
+    static int64_t queryInt(const std::string& sql) {
+        const std::unique_ptr<sql::Statement> stmt(gProbe->createStatement());
+        const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(sql));
+        return res->next() ? res->getInt64(1) : -1;
+    }
+
+    /// 服务端累计执行的语句数，差值减去本条 SHOW 即为期间执行的语句数
+    static int64_t questions() {
+        const std::unique_ptr<sql::Statement> stmt(gProbe->createStatement());
+        const std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SHOW GLOBAL STATUS LIKE 'Questions'"));
+        return res->next() ? std::stoll(res->getString(2)) : 0;
+    }
+
+    static inline bool gSkip = false;
+    static inline std::unique_ptr<sql::Connection> gProbe;
+    static inline std::unique_ptr<Dao> gDao;
+
+private:
+    static std::string suiteName() {
+        const auto* suite = ::testing::UnitTest::GetInstance()->current_test_suite();
+        return suite ? suite->name() : "MysqlDaoTest";
+    }
+};
+
+#endif //IMSERVER_MYSQL_TEST_FIXTURE_H
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "db/mysql_test_fixture.h"
+#include "db/mysql/dao/UserInfoDao.h"
+
+// selectUserBaseInfos 的 DAO 级测试，直连 test/config.ini 中的 MySQL，不可达时跳过。
+namespace {
+
+constexpr int BASE_UID = 9910000;
+constexpr int USERS = 300;
+
+class UserInfoDaoBatchTest : public MysqlDaoTest<UserInfoDao> {
+protected:
+    static void SetUpTestSuite() {
+        setUpSuite([] {
+            cleanup();
+            seed();
+        });
+    }
+
+    static void TearDownTestSuite() {
+        tearDownSuite(cleanup);
+    }
+
+    static void seed() {
+        std::string sql = "INSERT INTO user (uid, name, email, pwd, salt, avatar_url) VALUES ";
+        for (int i = 0; i < USERS; i++) {
+            const std::string uid = std::to_string(BASE_UID + i);
+            sql += (i == 0 ? "(" : ",(") + uid + ",'bench_" + uid + "','bench_" + uid + "@test','x','x','avatar_"
+                + uid + "')";
+        }
+        exec(sql);
+    }
+
+    static void cleanup() {
+        exec("DELETE FROM user WHERE uid BETWEEN " + std::to_string(BASE_UID) + " AND "
+            + std::to_string(BASE_UID + USERS - 1));
+    }
+};
+
+}  // namespace
+
+// 跨分块查询：存在的用户全部返回且字段完整，不存在的 uid 不返回，空输入不查询。
+TEST_F(UserInfoDaoBatchTest, ReturnsExistingAcrossChunks) {
+    std::vector<int> uids;
+    for (int i = USERS - 1; i >= 0; i--) {
+        uids.push_back(BASE_UID + i);
+    }
+    uids.push_back(BASE_UID + USERS + 1);
+    uids.push_back(BASE_UID - 1);
+
+    std::vector<UserBaseInfo> result;
+    ASSERT_TRUE(gDao->selectUserBaseInfos(uids, result));
+    ASSERT_EQ(result.size(), static_cast<size_t>(USERS));
+    std::unordered_set<int> seen;
+    for (const auto& info : result) {
+        EXPECT_TRUE(seen.insert(info.uid).second);
+        EXPECT_EQ(info.name.value_or(""), "bench_" + std::to_string(info.uid));
+        EXPECT_EQ(info.avatarUrl.value_or(""), "avatar_" + std::to_string(info.uid));
+    }
+
+    result.clear();
+    const int64_t before = questions();
+    ASSERT_TRUE(gDao->selectUserBaseInfos({}, result));
+    EXPECT_TRUE(result.empty());
+    EXPECT_LE(questions() - before - 1, 0);
+}
+
+// 50 个用户的列表：逐个查询与一次 IN 查询的语句数和延迟对比。
+TEST_F(UserInfoDaoBatchTest, BatchVsPerUser) {
+    constexpr int listSize = 50;
+    constexpr int rounds = 20;
+    std::vector<int> uids;
+    for (int i = 0; i < listSize; i++) {
+        uids.push_back(BASE_UID + i * 5);
+    }
+
+    const auto measure = [&](const auto& load) {
+        std::vector<double> latency;
+        const int64_t before = questions();
+        for (int r = 0; r < rounds; r++) {
+            const auto start = std::chrono::steady_clock::now();
+            load();
+            latency.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(latency.begin(), latency.end());
+        return std::make_pair(static_cast<double>(questions() - before - 1) / rounds,
+                              latency[latency.size() * 99 / 100]);
+    };
+    const auto perUser = measure([&] {
+        for (const int uid : uids) {
+            UserBaseInfo info;
+            info.uid = uid;
+            ASSERT_TRUE(gDao->selectUserBaseInfo(info));
+        }
+    });
+    const auto batch = measure([&] {
+        std::vector<UserBaseInfo> result;
+        ASSERT_TRUE(gDao->selectUserBaseInfos(uids, result));
+        ASSERT_EQ(result.size(), static_cast<size_t>(listSize));
+    });
+
+    std::cout << "\n=== User base info (50-item list) ===" << std::endl;
+    std::cout << "Mode     | Stmts/list | p99 (ms)" << std::endl;
+    std::cout << "---------|------------|---------" << std::endl;
+    for (const auto& [mode, r] : {std::make_pair("per-user", perUser), std::make_pair("batch", batch)}) {
+        std::cout << std::left << std::setw(8) << mode << std::right << " | "
+                  << std::setw(10) << std::fixed << std::setprecision(1) << r.first << " | "
+                  << std::setw(8) << std::setprecision(2) << r.second << std::endl;
+    }
+    std::cout << "=====================================\n" << std::endl;
+
+    // 其他连接的语句也会计入 Questions，留少量余量
+    EXPECT_LE(batch.first, 2.0);
+    EXPECT_LT(batch.first, perUser.first);
+}
@@ -4,6 +4,7 @@
 #include <iostream>
 
 #define MAX_SEND_QUEUE 1024
+#define MAX_PERSIST_PENDING 65536
 
 ChatTestClient::~ChatTestClient() {
     close();
@@ -48,6 +49,14 @@ bool ChatTestClient::sendChatMsg(int toUid, const std::string& content) {
     body["content_type"] = 1; // 文本消息
     body["status"] = 0; // 已发送
     body["msg_id"] = sent_ + 1; // 消息序号
+    {
+        std::lock_guard<std::mutex> lock(persistMtx_);
+        // 回推丢失（如写入失败进入死信）的消息不会被取走，积压过多时整体丢弃
+        if (persistPending_.size() >= MAX_PERSIST_PENDING) {
+            persistPending_.clear();
+        }
+        persistPending_[body["msg_id"].asInt64()] = std::chrono::steady_clock::now();
+    }
     asyncSend(static_cast<uint16_t>(MessageID::ID_CHAT_MSG_REQ), body);
     return true;
 }
@@ -126,6 +135,7 @@ void ChatTestClient::asyncRecv() {
             memcpy(&msgLen, node + HEAD_MSG_ID_LEN, HEAD_MSG_SIZE_LEN);
             msgLen = net::detail::socket_ops::network_to_host_short(msgLen);
 
+            recvMsgId_ = msgId;
             asyncReadBody(msgLen);
         } catch (std::exception& e) {
             std::cout << e.what() << std::endl;
@@ -143,10 +153,34 @@ void ChatTestClient::asyncReadBody(uint16_t size) {
         }
         
         recv_++;
+        if (recvMsgId_ == static_cast<uint16_t>(MessageID::ID_NOTIFY_MSG_RESULT)) {
+            recordPersisted(size);
+        }
         readCallback_(shared_from_this());
     });
 }
 
+void ChatTestClient::recordPersisted(uint16_t size) {
+    Json::Value body;
+    Json::Reader reader;
+    if (!reader.parse(buffer_, buffer_ + size, body) || !body.isMember("msg_id")) {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point sendTime;
+    {
+        std::lock_guard<std::mutex> lock(persistMtx_);
+        auto it = persistPending_.find(body["msg_id"].asInt64());
+        if (it == persistPending_.end()) {
+            return;
+        }
+        sendTime = it->second;
+        persistPending_.erase(it);
+    }
+    metrics_->persistLatency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - sendTime).count());
+}
+
 void ChatTestClient::asyncReadFull(std::uint16_t totalLen, 
                     const std::function<void(const boost::system::error_code &, std::uint16_t)> &callback)
 {
@@ -8,6 +8,7 @@
 #include <optional>
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <atomic>
 #include <memory>
 #include <json/json.h>
@@ -86,6 +87,8 @@ private:
 
     void asyncRecv();
     void asyncReadBody(uint16_t size);
+    /// 收到落库回推时记录该消息的持久化延迟
+    void recordPersisted(uint16_t size);
     void asyncReadFull(std::uint16_t totalLen,
         const std::function<void(const boost::system::error_code&, std::uint16_t)>& callback);
     void asyncReadSome(std::uint16_t readLen, std::uint16_t totalLen,
@@ -103,6 +106,10 @@ private:
     std::chrono::steady_clock::time_point serialize_end_time_;
 
     char buffer_[MAX_BUFFER_SIZE];
+    uint16_t recvMsgId_ = 0;
+
+    std::mutex persistMtx_;
+    std::unordered_map<int64_t, std::chrono::steady_clock::time_point> persistPending_;  ///< msg_id -> 发送时间
 
     int uid_ = 0;
     std::string email_;
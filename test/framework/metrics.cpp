@@ -55,6 +55,8 @@ std::string Metrics::summary() const {
                 std::chrono::steady_clock::now() - startTime).count()))
         << " p50=" << latency.percentile(0.5) << "us"
         << " p99=" << latency.percentile(0.99) << "us"
+        << " persist_p50=" << persistLatency.percentile(0.5) << "us"
+        << " persist_p99=" << persistLatency.percentile(0.99) << "us"
         << " err=" << std::setprecision(3) << errors.errorRate() * 100 << "%";
     return oss.str();
 }
@@ -65,6 +67,9 @@ Json::Value Metrics::toJson() const {
     root["p50_us"] = latency.percentile(0.5);
     root["p99_us"] = latency.percentile(0.99);
     root["avg_us"] = latency.avg();
+    root["persist_count"] = static_cast<Json::UInt64>(persistLatency.count());
+    root["persist_p50_us"] = persistLatency.percentile(0.5);
+    root["persist_p99_us"] = persistLatency.percentile(0.99);
     root["errors"] = static_cast<Json::UInt64>(errors.failed());
     root["error_rate"] = errors.errorRate();
     return root;
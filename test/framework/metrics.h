@@ -1,6 +1,7 @@
 #ifndef IMSERVER_METRICS_H
 #define IMSERVER_METRICS_H
 
+#include <atomic>
 #include <cstdint>
 #include <chrono>
 #include <vector>
@@ -54,6 +55,7 @@ private:
 
 struct Metrics {
     LatencyHistogram latency;
+    LatencyHistogram persistLatency;    // 发送到收到落库回推 (ID_NOTIFY_MSG_RESULT) 的端到端延迟，需服务端开启 NotifyPersisted
     ThroughputCounter throughput;
     ErrorCounter errors;
     std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
@@ -61,6 +63,7 @@ struct Metrics {
     // NOTE: Metrics is not assignable (atomics); use reset() to clear
     void reset() {
         latency.reset();
+        persistLatency.reset();
         throughput.reset();
         errors.reset();
         startTime = std::chrono::steady_clock::now();
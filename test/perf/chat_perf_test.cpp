@@ -5,7 +5,7 @@
 
 class PerfTest : public IntegrationTestBase {};
 
-// 阶梯施压：记录每个并发台阶的 QPS / P50 / P99
+// 阶梯施压：记录每个并发台阶的 QPS / P50 / P99 / 落库延迟
 TEST_F(PerfTest, RampUp) {
     auto& config = ConfigMgr::getInstance();
     PerfSuite::Config cfg;
@@ -21,6 +21,8 @@ TEST_F(PerfTest, RampUp) {
                   << " qps=" << r.qps
                   << " p50=" << r.p50_us << "us"
                   << " p99=" << r.p99_us << "us"
+                  << " persist_p50=" << r.persist_p50_us << "us"
+                  << " persist_p99=" << r.persist_p99_us << "us"
                   << " err=" << r.errorRate * 100 << "%\n";
     }
 }
@@ -100,6 +100,8 @@ static PerfLevel runLevel(std::vector<std::shared_ptr<ChatTestClient>>& clients,
     lvl.clientCount = clientCount;
     lvl.p50_us = metrics->latency.percentile(0.5);
     lvl.p99_us = metrics->latency.percentile(0.99);
+    lvl.persist_p50_us = metrics->persistLatency.percentile(0.5);
+    lvl.persist_p99_us = metrics->persistLatency.percentile(0.99);
     lvl.errorRate = metrics->errors.errorRate();
     lvl.qps = stepSec > 0
         ? static_cast<double>(metrics->throughput.total()) / stepSec
@@ -11,6 +11,8 @@ struct PerfLevel {
     double qps;
     int64_t p50_us;
     int64_t p99_us;
+    int64_t persist_p50_us;   // 发送到落库回推的端到端延迟
+    int64_t persist_p99_us;
     double errorRate;
 };
 
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <grpcpp/grpcpp.h>
+
+#include "message.grpc.pb.h"
+#include "ServiceConnPool.h"
+#include "CircuitBreaker.h"
+
+using message::LoginReq;
+using message::LoginRsp;
+using message::StatusService;
+
+using namespace std::chrono_literals;
+
+namespace {
+
+/**
+ * @brief 进程内假 StatusService：可注入延迟和不可用错误，统计实际到达的调用数。
+ */
+class FakeStatusService final : public StatusService::Service {
+public:
+    grpc::Status Login(grpc::ServerContext* context, const LoginReq* request, LoginRsp* response) override {
+        calls.fetch_add(1);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs.load());
+        while (std::chrono::steady_clock::now() < deadline && !context->IsCancelled()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        if (unavailable.load()) {
+            return {grpc::StatusCode::UNAVAILABLE, "fake unavailable"};
+        }
+        response->set_uid(request->uid());
+        response->set_token(request->token());
+        return grpc::Status::OK;
+    }
+
+    std::atomic<int> calls{0};
+    std::atomic<int> delayMs{0};
+    std::atomic<bool> unavailable{false};
+};
+
+using StatusPool = ServiceConnPool<StatusService>;
+
+class ServiceConnPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port_);
+        builder.RegisterService(&service_);
+        server_ = builder.BuildAndStart();
+        ASSERT_NE(server_, nullptr);
+        ASSERT_GT(port_, 0);
+    }
+
+    void TearDown() override {
+        pool_.reset();
+        server_->Shutdown(std::chrono::system_clock::now() + 1s);
+    }
+
+    void makePool(const RpcOptions& options) {
+        pool_ = std::make_unique<StatusPool>("127.0.0.1", std::to_string(port_), options);
+    }
+
+    grpc::Status login(const int uid, LoginRsp& reply) const {
+        LoginReq request;
+        request.set_uid(uid);
+        request.set_token("token_" + std::to_string(uid));
+        return pool_->call([&request](StatusPool::AsyncStub* stub, grpc::ClientContext* context,
+            LoginRsp* response, const StatusPool::Callback& done) {
+            stub->Login(context, &request, response, done);
+        }, reply);
+    }
+
+    FakeStatusService service_;
+    std::unique_ptr<grpc::Server> server_;
+    int port_ = 0;
+    std::unique_ptr<StatusPool> pool_;
+};
+
+}  // namespace
+
+// 熔断器状态机：连续失败打开，冷却后只放行一个探测，探测成功关闭。
+TEST(CircuitBreakerTest, OpensAfterThresholdAndHalfOpenProbe) {
+    CircuitBreaker::Options options;
+    options.failureThreshold = 3;
+    options.openDuration = 50ms;
+    CircuitBreaker breaker(options);
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(breaker.allowRequest());
+        breaker.onFailure();
+    }
+    EXPECT_EQ(breaker.state(), CircuitBreaker::State::OPEN);
+    EXPECT_FALSE(breaker.allowRequest());
+
+    std::this_thread::sleep_for(60ms);
+    EXPECT_TRUE(breaker.allowRequest());    // 半开探测
+    EXPECT_FALSE(breaker.allowRequest());   // 探测期间其余请求拒绝
+    EXPECT_EQ(breaker.state(), CircuitBreaker::State::HALF_OPEN);
+
+    breaker.onSuccess();
+    EXPECT_EQ(breaker.state(), CircuitBreaker::State::CLOSED);
+    EXPECT_TRUE(breaker.allowRequest());
+}
+
+// 探测失败立即重新打开。
+TEST(CircuitBreakerTest, FailedProbeReopens) {
+    CircuitBreaker::Options options;
+    options.failureThreshold = 1;
+    options.openDuration = 30ms;
+    CircuitBreaker breaker(options);
+
+    ASSERT_TRUE(breaker.allowRequest());
+    breaker.onFailure();
+    std::this_thread::sleep_for(40ms);
+    ASSERT_TRUE(breaker.allowRequest());
+    breaker.onFailure();
+    EXPECT_EQ(breaker.state(), CircuitBreaker::State::OPEN);
+    EXPECT_FALSE(breaker.allowRequest());
+}
+
+// 放行后未发出的请求归还探测名额，半开状态不会因此卡住。
+TEST(CircuitBreakerTest, CancelledProbeFreesSlot) {
+    CircuitBreaker::Options options;
+    options.failureThreshold = 1;
+    options.openDuration = 30ms;
+    CircuitBreaker breaker(options);
+
+    ASSERT_TRUE(breaker.allowRequest());
+    breaker.onFailure();
+    std::this_thread::sleep_for(40ms);
+    ASSERT_TRUE(breaker.allowRequest());
+    EXPECT_FALSE(breaker.allowRequest());
+    breaker.cancelRequest();
+    EXPECT_EQ(breaker.state(), CircuitBreaker::State::HALF_OPEN);
+    EXPECT_TRUE(breaker.allowRequest());
+}
+
+TEST_F(ServiceConnPoolTest, CallSucceeds) {
+    makePool(RpcOptions{});
+    LoginRsp reply;
+    const auto status = login(42, reply);
+    ASSERT_TRUE(status.ok()) << status.error_message();
+    EXPECT_EQ(reply.uid(), 42);
+    EXPECT_EQ(reply.token(), "token_42");
+}
+
+// 对端挂起时调用在 deadline 内返回，不会无限阻塞调用方。
+TEST_F(ServiceConnPoolTest, DeadlineBoundsHungPeer) {
+    RpcOptions options;
+    options.callTimeout = 100ms;
+    makePool(options);
+    service_.delayMs = 2000;
+
+    LoginRsp reply;
+    const auto start = std::chrono::steady_clock::now();
+    const auto status = login(1, reply);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::DEADLINE_EXCEEDED);
+    EXPECT_LT(elapsed, 1s);
+}
+
+// 在途调用占满时，获取许可最多等待 acquireTimeout。
+TEST_F(ServiceConnPoolTest, AcquireWaitIsBounded) {
+    RpcOptions options;
+    options.maxInflight = 1;
+    options.acquireTimeout = 20ms;
+    options.callTimeout = 500ms;
+    makePool(options);
+    service_.delayMs = 300;
+
+    std::atomic<bool> firstDone{false};
+    LoginReq request;
+    request.set_uid(1);
+    pool_->asyncCall<LoginRsp>([&request](StatusPool::AsyncStub* stub, grpc::ClientContext* context,
+        LoginRsp* response, const StatusPool::Callback& done) {
+        stub->Login(context, &request, response, done);
+    }, [&firstDone](const grpc::Status&, const LoginRsp&) {
+        firstDone = true;
+    });
+
+    LoginRsp reply;
+    const auto start = std::chrono::steady_clock::now();
+    const auto status = login(2, reply);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::UNAVAILABLE);
+    EXPECT_LT(elapsed, 200ms);
+
+    while (!firstDone) {
+        std::this_thread::sleep_for(5ms);
+    }
+}
+
+// 对端持续不可用：熔断后快速失败且不再打到对端，冷却后半开探测恢复。
+TEST_F(ServiceConnPoolTest, BreakerFailsFastAndRecovers) {
+    RpcOptions options;
+    options.breaker.failureThreshold = 3;
+    options.breaker.openDuration = 100ms;
+    makePool(options);
+    service_.unavailable = true;
+
+    LoginRsp reply;
+    for (int i = 0; i < 3; i++) {
+        EXPECT_FALSE(login(i, reply).ok());
+    }
+    EXPECT_EQ(pool_->breakerState(), CircuitBreaker::State::OPEN);
+
+    const int callsWhenOpen = service_.calls.load();
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(login(i, reply).error_code(), grpc::StatusCode::UNAVAILABLE);
+    }
+    EXPECT_EQ(service_.calls.load(), callsWhenOpen);
+
+    service_.unavailable = false;
+    std::this_thread::sleep_for(120ms);
+    EXPECT_TRUE(login(7, reply).ok());
+    EXPECT_EQ(service_.calls.load(), callsWhenOpen + 1);
+    EXPECT_EQ(pool_->breakerState(), CircuitBreaker::State::CLOSED);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include "stress_fixture.h"
+#include "stress_connection_pool.h"
+#include "report_output.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <unordered_map>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+/**
+ * @brief 场景 6: 跨服投递吞吐
+ *
+ * 目标: 测量 ChatServer 之间的消息投递吞吐 (服务器间批量投递流 DeliverStream)
+ *
+ * 策略:
+ *   1. 账号由 StatusServer 分配到多台 ChatServer，按登录端口分组
+ *   2. 每个客户端只向其他服务器上的用户发消息，所有推送都要跨服
+ *   3. 阶梯增加发送速率，统计接收方每秒收到的推送数和 RSP RTT
+ *
+ * 前后对比: 分别以 PeerStreamEnabled = true / false 启动 ChatServer 运行本场景，
+ * 对比输出的跨服吞吐，以及服务端日志中 [perf] utilization 和 [peer_stream] 指标。
+ * 少于两台 ChatServer 时跳过。
+ */
+
+class ClusterDeliveryTest : public StressTestFixture {
+protected:
+    static constexpr int TARGET = 2000;
+    static constexpr int STABILIZE_SECONDS = 15;
+    static constexpr double DELIVERY_THRESHOLD = 0.95;   // 跨服推送到达率下限
+};
+
+TEST_F(ClusterDeliveryTest, CrossServerThroughput) {
+    auto accounts = takeAccounts(TARGET);
+    ASSERT_GE(static_cast<int>(accounts.size()), TARGET);
+
+    // 按登录的 ChatServer 端口分组
+    std::map<int, std::vector<int>> uidsByServer;
+    std::unordered_map<int, int> serverOfUid;
+    for (const auto& acct : accounts) {
+        uidsByServer[acct.port].push_back(acct.uid);
+        serverOfUid[acct.uid] = acct.port;
+    }
+    if (uidsByServer.size() < 2) {
+        GTEST_SKIP() << "Cluster scenario requires at least 2 ChatServers, got " << uidsByServer.size();
+    }
+
+    int ioCount = std::max(4, static_cast<int>(std::thread::hardware_concurrency()) - 2);
+    StressConnectionPool pool(ioCount);
+    ReportOutput report("Cluster_2K");
+
+    pool.addAndConnect(accounts, 200, 200ms);
+
+    auto deadline = std::chrono::steady_clock::now() + 30s;
+    while (pool.onlineCount() < TARGET * 0.95) {
+        if (std::chrono::steady_clock::now() > deadline) break;
+        std::this_thread::sleep_for(200ms);
+    }
+
+    std::cout << "\n=== Cluster_2K: " << pool.onlineCount() << " connections online on "
+              << uidsByServer.size() << " servers ===" << std::endl;
+    for (const auto& [port, uids] : uidsByServer) {
+        std::cout << "  ChatServer :" << port << " -> " << uids.size() << " users" << std::endl;
+    }
+
+    int rates[] = {1, 5, 10, 20, 50};
+    double maxCrossServerRate = 0;
+    double lastDeliveryRatio = 0;
+
+    std::cout << "\n=== Cross-Server Delivery (2K connections) ===" << std::endl;
+    std::cout << "Rate | Sent/s | Deliver/s | Delivery | P50(us) | P99(us)" << std::endl;
+    std::cout << "-----|--------|-----------|----------|---------|--------" << std::endl;
+
+    int t = 0;
+    for (int rate : rates) {
+        auto online = pool.getOnlineClients();
+        for (auto& c : online) {
+            // 接收方为其他服务器上的全部用户
+            std::vector<int> targets;
+            for (const auto& [port, uids] : uidsByServer) {
+                if (port != serverOfUid[c->uid()]) {
+                    targets.insert(targets.end(), uids.begin(), uids.end());
+                }
+            }
+            c->startMsgRateTo(rate, std::move(targets));
+        }
+
+        auto& m = pool.metrics();
+        uint64_t sentBefore = m.chat_msg_sent.load();
+        uint64_t notifyBefore = m.chat_notify_recv.load();
+        std::this_thread::sleep_for(std::chrono::seconds(STABILIZE_SECONDS));
+
+        for (auto& c : online) {
+            c->stopMsgRate();
+        }
+        // 等待在途推送到达
+        std::this_thread::sleep_for(1s);
+
+        uint64_t sent = m.chat_msg_sent.load() - sentBefore;
+        uint64_t delivered = m.chat_notify_recv.load() - notifyBefore;
+        double sentPerSec = static_cast<double>(sent) / STABILIZE_SECONDS;
+        double deliverPerSec = static_cast<double>(delivered) / STABILIZE_SECONDS;
+        lastDeliveryRatio = sent > 0 ? static_cast<double>(delivered) / sent : 0;
+
+        int64_t p50 = m.rtt_hist.percentile(0.5);
+        int64_t p99 = m.rtt_hist.percentile(0.99);
+        m.rtt_hist.reset();
+
+        t += STABILIZE_SECONDS;
+        report.tick(m, pool.onlineCount(), t);
+
+        std::cout << std::setw(4) << rate << " | "
+                  << std::setw(6) << std::fixed << std::setprecision(0) << sentPerSec << " | "
+                  << std::setw(9) << deliverPerSec << " | "
+                  << std::setprecision(4) << lastDeliveryRatio << " | "
+                  << std::setw(7) << p50 << " | "
+                  << std::setw(7) << p99 << std::endl;
+
+        if (lastDeliveryRatio < DELIVERY_THRESHOLD) {
+            std::cout << "Delivery ratio below " << DELIVERY_THRESHOLD << ", stop ramping" << std::endl;
+            break;
+        }
+        maxCrossServerRate = deliverPerSec;
+    }
+
+    std::cout << "================================================\n" << std::endl;
+
+    auto& m = pool.metrics();
+    report.summary(m, TARGET, 0);
+    report.saveCsv("cluster_2k_report.csv");
+
+    std::cout << "\n=== Cluster_2K Result ===" << std::endl;
+    std::cout << "Max cross-server delivery: " << std::setprecision(0) << maxCrossServerRate << " msg/s" << std::endl;
+    std::cout << "Compare with server logs: [perf] utilization, [peer_stream] avg_batch / avg_ack" << std::endl;
+    std::cout << "================================\n" << std::endl;
+
+    // 最低档位下跨服推送必须基本全部到达
+    EXPECT_GT(maxCrossServerRate, 0);
+
+    pool.gracefulShutdown();
+}
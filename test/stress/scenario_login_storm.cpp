@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include "stress_fixture.h"
+#include "stress_connection_pool.h"
+#include "report_output.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+/**
+ * @brief 场景 7: 登录风暴 — 重启后全量重连的积压清空时间
+ *
+ * 目标: 模拟 ChatServer 重启后所有客户端同时重连，测量登录积压清空所需时间
+ *
+ * 策略:
+ *   1. 阶梯增加同时重连的客户端数 (1K → 2K → 4K → 8K)，每档全部连接在同一时刻发起
+ *   2. 收到 CHAT_LOGIN_BUSY 的客户端保持连接，按 retry_after_ms 重试登录
+ *   3. 记录在线数达到 95% / 100% 的耗时、登录 RTT 和被准入拒绝的次数
+ *   4. 每档结束后断开全部连接，下一档重新发起风暴
+ *
+ * 前后对比: 分别以 LoginAdmissionEnabled = true / false 启动 ChatServer 运行本场景，
+ * 对比各档的清空耗时，以及服务端日志中 [login] limit / avg_ms 和 [perf] utilization。
+ */
+
+class LoginStormTest : public StressTestFixture {
+protected:
+    static constexpr int MAX_TARGET = 8000;
+    static constexpr int CLEAR_TIMEOUT_SECONDS = 60;
+    static constexpr double CLEAR_THRESHOLD = 0.95;   // 在线率达到该比例视为积压基本清空
+};
+
+TEST_F(LoginStormTest, ReconnectStormRamp) {
+    auto accounts = takeAccounts(MAX_TARGET);
+    ASSERT_FALSE(accounts.empty());
+
+    int ioCount = std::max(4, static_cast<int>(std::thread::hardware_concurrency()) - 2);
+    ReportOutput report("LoginStorm");
+
+    int steps[] = {1000, 2000, 4000, 8000};
+    int firstStepClearMs = -1;
+    int t = 0;
+
+    std::cout << "\n=== Login Storm: Reconnect Backlog Clear Time ===" << std::endl;
+    std::cout << "Target | Online | Clear95(ms) | Clear100(ms) | Busy  | P50(us) | P99(us)" << std::endl;
+    std::cout << "-------|--------|-------------|--------------|-------|---------|--------" << std::endl;
+
+    for (int target : steps) {
+        if (target > static_cast<int>(accounts.size())) {
+            std::cout << "Not enough accounts for target=" << target << ", stop ramping" << std::endl;
+            break;
+        }
+        std::vector<TestAccount> stepAccounts(accounts.begin(), accounts.begin() + target);
+
+        StressConnectionPool pool(ioCount);
+        auto start = std::chrono::steady_clock::now();
+        // 全部连接在同一批发起，模拟重启后的同时重连
+        pool.addAndConnect(stepAccounts, target, 0ms);
+
+        int clear95Ms = -1;
+        int clear100Ms = -1;
+        auto deadline = start + std::chrono::seconds(CLEAR_TIMEOUT_SECONDS);
+        while (std::chrono::steady_clock::now() < deadline) {
+            int online = pool.onlineCount();
+            int elapsedMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            if (clear95Ms < 0 && online >= target * CLEAR_THRESHOLD) {
+                clear95Ms = elapsedMs;
+            }
+            if (online >= target) {
+                clear100Ms = elapsedMs;
+                break;
+            }
+            std::this_thread::sleep_for(20ms);
+        }
+
+        auto& m = pool.metrics();
+        int64_t p50 = m.rtt_hist.percentile(0.5);
+        int64_t p99 = m.rtt_hist.percentile(0.99);
+        t += (clear100Ms >= 0 ? clear100Ms : CLEAR_TIMEOUT_SECONDS * 1000) / 1000 + 1;
+        report.tick(m, pool.onlineCount(), t);
+
+        std::cout << std::setw(6) << target << " | "
+                  << std::setw(6) << pool.onlineCount() << " | "
+                  << std::setw(11) << clear95Ms << " | "
+                  << std::setw(12) << clear100Ms << " | "
+                  << std::setw(5) << m.login_busy.load() << " | "
+                  << std::setw(7) << p50 << " | "
+                  << std::setw(7) << p99 << std::endl;
+
+        if (firstStepClearMs < 0) {
+            firstStepClearMs = clear95Ms;
+        }
+        pool.gracefulShutdown();
+
+        if (clear95Ms < 0) {
+            std::cout << "Backlog not cleared within " << CLEAR_TIMEOUT_SECONDS << "s, stop ramping" << std::endl;
+            break;
+        }
+        // 等待服务端处理完下线
+        std::this_thread::sleep_for(3s);
+    }
+
+    std::cout << "================================================\n" << std::endl;
+    report.saveCsv("login_storm_report.csv");
+
+    std::cout << "Compare runs with LoginAdmissionEnabled = true / false: Clear95 / Clear100 per step," << std::endl;
+    std::cout << "and server logs: [login] limit / queued / avg_ms, [perf] utilization" << std::endl;
+
+    // 最低档位的积压必须在超时内清空
+    EXPECT_GE(firstStepClearMs, 0);
+}
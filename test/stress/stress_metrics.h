@@ -19,6 +19,7 @@ public:
     std::atomic<uint64_t> connect_timeout{0};
     std::atomic<uint64_t> handshake_success{0};
     std::atomic<uint64_t> handshake_failed{0};
+    std::atomic<uint64_t> login_busy{0};         // 登录被准入控制拒绝 (CHAT_LOGIN_BUSY) 的次数
 
     // === 消息指标 ===
     std::atomic<uint64_t> msg_sent{0};
@@ -31,6 +32,7 @@ public:
     std::atomic<uint64_t> friend_apply_recv{0};
     std::atomic<uint64_t> user_search_sent{0};
     std::atomic<uint64_t> user_search_recv{0};
+    std::atomic<uint64_t> chat_notify_recv{0};   // 接收方收到的聊天推送 (ID_NOTIFY_CHAT_MSG)
 
     // === 连接维持 ===
     std::atomic<uint64_t> disconnect_{0};
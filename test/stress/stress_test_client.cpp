@@ -12,6 +12,7 @@ StressTestClient::StressTestClient(net::io_context& io, StressMetrics* metrics)
     , deadline_timer_(io)
     , heartbeat_timer_(io)
     , send_timer_(io)
+    , login_retry_timer_(io)
     , metrics_(metrics)
     , lastActive_(std::chrono::steady_clock::now()) {
 }
@@ -90,6 +91,15 @@ void StressTestClient::doLogin() {
     asyncSend(static_cast<uint16_t>(MessageID::ID_CHAT_LOGIN), body);
 }
 
+void StressTestClient::scheduleLoginRetry(int retryAfterMs) {
+    login_retry_timer_.expires_after(std::chrono::milliseconds(retryAfterMs));
+    login_retry_timer_.async_wait([self = shared_from_this()](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted) return;
+        if (self->state_.load() != ClientState::HANDSHAKING) return;
+        self->doLogin();
+    });
+}
+
 void StressTestClient::asyncSend(uint16_t msgId, const Json::Value& body) {
     std::string frame = encode(msgId, body);
 
@@ -267,6 +277,8 @@ void StressTestClient::onReadBodyDone(const boost::system::error_code& ec, uint1
                 metrics_->friend_apply_recv++;
             else if (currentMsgId_ == static_cast<uint16_t>(MessageID::ID_USER_SEARCH_RSP))
                 metrics_->user_search_recv++;
+            else if (currentMsgId_ == static_cast<uint16_t>(MessageID::ID_NOTIFY_CHAT_MSG))
+                metrics_->chat_notify_recv++;
         }
         handleMessage(currentMsgId_, body);
     }
@@ -289,6 +301,10 @@ void StressTestClient::handleMessage(uint16_t msgId, const Json::Value& body) {
                 while (current > peak && !metrics_->peak_online.compare_exchange_weak(peak, current)) {}
             }
             scheduleHeartbeat();
+        } else if (error == static_cast<int>(ErrorCodes::CHAT_LOGIN_BUSY)) {
+            // 登录准入拒绝：保持连接，按服务端给出的间隔重试
+            if (metrics_) metrics_->login_busy++;
+            scheduleLoginRetry(body["retry_after_ms"].asInt());
         } else {
             state_.store(ClientState::DISCONNECTED);
             if (metrics_) metrics_->handshake_failed++;
@@ -330,10 +346,22 @@ void StressTestClient::startMsgRate(int msg_per_sec, int min_uid, int max_uid) {
     scheduleSend();
 }
 
+void StressTestClient::startMsgRateTo(int msg_per_sec, std::vector<int> targets) {
+    if (msg_per_sec <= 0 || targets.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(targetsMtx_);
+        targets_ = std::move(targets);
+    }
+    msg_rate_per_sec_.store(msg_per_sec);
+    scheduleSend();
+}
+
 void StressTestClient::stopMsgRate() {
     msg_rate_per_sec_.store(0);
     send_timer_.cancel();
     mixed_mode_.store(false);
+    std::lock_guard<std::mutex> lock(targetsMtx_);
+    targets_.clear();
 }
 
 void StressTestClient::startMixedMsgRate(int msg_per_sec, int min_uid, int max_uid,
@@ -370,6 +398,16 @@ void StressTestClient::sendTimerHandler() {
     int rate = msg_rate_per_sec_.load();
     if (rate <= 0) return;
 
+    {
+        std::lock_guard<std::mutex> lock(targetsMtx_);
+        if (!targets_.empty()) {
+            std::uniform_int_distribution<size_t> idxDist(0, targets_.size() - 1);
+            sendChatMsg(targets_[idxDist(rng_)], "cluster");
+            scheduleSend();
+            return;
+        }
+    }
+
     int minUid = target_min_uid_.load();
     int maxUid = target_max_uid_.load();
     if (maxUid > minUid) {
@@ -412,6 +450,7 @@ void StressTestClient::close() {
 
     deadline_timer_.cancel();
     heartbeat_timer_.cancel();
+    login_retry_timer_.cancel();
 
     boost::system::error_code ec;
     socket_.shutdown(tcp::socket::shutdown_both, ec);
@@ -9,6 +9,7 @@
 #include <queue>
 #include <random>
 #include <string>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <json/json.h>
@@ -50,6 +51,8 @@ public:
 
     /** @brief 启动定频消息发送 (msg_per_sec 条/秒, 目标 uid 范围为 [min_uid, max_uid]) */
     void startMsgRate(int msg_per_sec, int min_uid, int max_uid);
+    /** @brief 启动定频消息发送，接收方从 targets 中随机选取 (用于跨服投递场景) */
+    void startMsgRateTo(int msg_per_sec, std::vector<int> targets);
     /** @brief 停止定频消息发送 */
     void stopMsgRate();
     /** @brief 启动混合消息定频发送 (聊天/好友申请/用户搜索按比例混合) */
@@ -74,6 +77,8 @@ private:
     void onReadBodyDone(const boost::system::error_code& ec, uint16_t bytes, uint16_t bodyLen);
 
     void doLogin();
+    /** @brief 服务端登录过载时按 retry_after_ms 延迟重发登录 */
+    void scheduleLoginRetry(int retryAfterMs);
     void handleMessage(uint16_t msgId, const Json::Value& body);
     void updateActiveTime();
     void sendTimerHandler();
@@ -87,6 +92,7 @@ private:
     net::steady_timer deadline_timer_;
     net::steady_timer heartbeat_timer_;
     net::steady_timer send_timer_;
+    net::steady_timer login_retry_timer_;
 
     std::atomic<ClientState> state_{ClientState::DISCONNECTED};
     int uid_ = 0;
@@ -118,6 +124,8 @@ private:
     std::atomic<int> target_min_uid_{0};
     std::atomic<int> target_max_uid_{0};
     std::mt19937 rng_{std::random_device{}()};
+    std::vector<int> targets_;     // 非空时优先从中选取接收方
+    std::mutex targetsMtx_;
 
     // 混合消息发送控制
     std::atomic<bool> mixed_mode_{false};